@@ -346,12 +346,15 @@ inline bool operator == (const Value& lhs, const Value& rhs)
 }
 
 
-inline std::ostream& operator << (std::ostream& out, const String& string)
+namespace internal {
+
+// Writes the string quoted and escaped, see 'operator << (String)'.
+inline std::ostream& quote(std::ostream& out, const std::string& string)
 {
   // TODO(benh): This escaping DOES NOT handle unicode, it encodes as ASCII.
   // See RFC4627 for the JSON string specificiation.
   out << "\"";
-  foreach (unsigned char c, string.value) {
+  foreach (unsigned char c, string) {
     switch (c) {
       case '"':  out << "\\\""; break;
       case '\\': out << "\\\\"; break;
@@ -383,6 +386,14 @@ inline std::ostream& operator << (std::ostream& out, const String& string)
   return out;
 }
 
+} // namespace internal {
+
+
+inline std::ostream& operator << (std::ostream& out, const String& string)
+{
+  return internal::quote(out, string.value);
+}
+
 
 inline std::ostream& operator << (std::ostream& out, const Number& number)
 {
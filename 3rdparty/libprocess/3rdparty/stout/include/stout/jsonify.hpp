@@ -0,0 +1,209 @@
+/**
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *  http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef __STOUT_JSONIFY__
+#define __STOUT_JSONIFY__
+
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <stout/json.hpp>
+
+namespace JSON {
+
+// Writers which emit JSON directly into an output stream as fields
+// and elements get added, rather than first building a tree of
+// JSON::Values which then gets stringified. This avoids allocating a
+// node for every field, which matters for large documents, e.g., the
+// state of a cluster with many tasks.
+//
+// Nested objects and arrays get written by passing a function which
+// takes the writer for the nested object or array, e.g.:
+//
+//   std::string json = JSON::jsonify([&](JSON::ObjectWriter* writer) {
+//     writer->field("name", name);
+//     writer->field("tasks", [&](JSON::ArrayWriter* writer) {
+//       foreach (const Task& task, tasks) {
+//         writer->element([&](JSON::ObjectWriter* writer) {
+//           writer->field("id", task.id());
+//         });
+//       }
+//     });
+//   });
+//
+// Strings and numbers are written exactly like the corresponding
+// JSON::String and JSON::Number, and a JSON::Value can be written as
+// is. Note that, unlike for a JSON::Object, fields are written in the
+// order they get added and duplicate keys are not detected.
+class ObjectWriter
+{
+public:
+  explicit ObjectWriter(std::ostream* _stream)
+    : stream(_stream), empty(true)
+  {
+    *stream << "{";
+  }
+
+  ~ObjectWriter()
+  {
+    *stream << "}";
+  }
+
+  template <typename T>
+  void field(const std::string& key, const T& value);
+
+private:
+  ObjectWriter(const ObjectWriter&);
+  ObjectWriter& operator = (const ObjectWriter&);
+
+  std::ostream* stream;
+  bool empty;
+};
+
+
+class ArrayWriter
+{
+public:
+  explicit ArrayWriter(std::ostream* _stream)
+    : stream(_stream), empty(true)
+  {
+    *stream << "[";
+  }
+
+  ~ArrayWriter()
+  {
+    *stream << "]";
+  }
+
+  template <typename T>
+  void element(const T& value);
+
+private:
+  ArrayWriter(const ArrayWriter&);
+  ArrayWriter& operator = (const ArrayWriter&);
+
+  std::ostream* stream;
+  bool empty;
+};
+
+
+namespace internal {
+
+inline void write(std::ostream* stream, bool value)
+{
+  *stream << (value ? "true" : "false");
+}
+
+
+inline void write(std::ostream* stream, const std::string& value)
+{
+  quote(*stream, value);
+}
+
+
+inline void write(std::ostream* stream, const char* value)
+{
+  quote(*stream, value);
+}
+
+
+// All numbers are written as doubles, like a JSON::Number.
+template <typename T>
+typename std::enable_if<std::is_arithmetic<T>::value>::type write(
+    std::ostream* stream,
+    const T& value)
+{
+  *stream << std::setprecision(std::numeric_limits<double>::digits10)
+          << static_cast<double>(value);
+}
+
+
+inline void write(std::ostream* stream, const Value& value)
+{
+  *stream << value;
+}
+
+
+template <typename F>
+auto write(std::ostream* stream, const F& f)
+  -> decltype(f(std::declval<ObjectWriter*>()))
+{
+  ObjectWriter writer(stream);
+  return f(&writer);
+}
+
+
+template <typename F>
+auto write(std::ostream* stream, const F& f)
+  -> decltype(f(std::declval<ArrayWriter*>()))
+{
+  ArrayWriter writer(stream);
+  return f(&writer);
+}
+
+} // namespace internal {
+
+
+template <typename T>
+void ObjectWriter::field(const std::string& key, const T& value)
+{
+  if (!empty) {
+    *stream << ",";
+  }
+
+  empty = false;
+
+  internal::quote(*stream, key) << ":";
+  internal::write(stream, value);
+}
+
+
+template <typename T>
+void ArrayWriter::element(const T& value)
+{
+  if (!empty) {
+    *stream << ",";
+  }
+
+  empty = false;
+
+  internal::write(stream, value);
+}
+
+
+// Writes the JSON into the stream, where 'value' is anything that a
+// field or an element can be, e.g., a function taking an ObjectWriter.
+template <typename T>
+void jsonify(std::ostream* stream, const T& value)
+{
+  internal::write(stream, value);
+}
+
+
+// Returns the JSON as a string, see above.
+template <typename T>
+std::string jsonify(const T& value)
+{
+  std::ostringstream out;
+  jsonify(&out, value);
+  return out.str();
+}
+
+} // namespace JSON {
+
+#endif // __STOUT_JSONIFY__
@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/json.hpp>
+#include <stout/jsonify.hpp>
+#include <stout/stringify.hpp>
+
+using std::string;
+using std::vector;
+
+
+TEST(JsonifyTest, Scalars)
+{
+  EXPECT_EQ("true", JSON::jsonify(true));
+  EXPECT_EQ("false", JSON::jsonify(false));
+  EXPECT_EQ("\"string\"", JSON::jsonify("string"));
+  EXPECT_EQ("\"string\"", JSON::jsonify(string("string")));
+  EXPECT_EQ("null", JSON::jsonify(JSON::Value(JSON::Null())));
+
+  // Strings and numbers should be formatted like the JSON::Values.
+  string binary("\"\\/\b\f\n\r\t\x00\x19 !#[]\x7F\xFF", 17);
+  EXPECT_EQ(stringify(JSON::String(binary)), JSON::jsonify(binary));
+
+  EXPECT_EQ(stringify(JSON::Number(1234567890.12345)),
+            JSON::jsonify(1234567890.12345));
+  EXPECT_EQ("-1", JSON::jsonify(-1));
+  EXPECT_EQ("42", JSON::jsonify(uint64_t(42)));
+}
+
+
+TEST(JsonifyTest, Nested)
+{
+  vector<int> numbers = {1, 2, 3};
+
+  const string json = JSON::jsonify([&](JSON::ObjectWriter* writer) {
+    writer->field("name", "foo");
+    writer->field("active", true);
+    writer->field("numbers", [&](JSON::ArrayWriter* writer) {
+      foreach (int number, numbers) {
+        writer->element(number);
+      }
+    });
+    writer->field("empty", [](JSON::ObjectWriter* writer) {});
+    writer->field("objects", [](JSON::ArrayWriter* writer) {
+      writer->element([](JSON::ObjectWriter* writer) {
+        writer->field("key", "value");
+      });
+      writer->element([](JSON::ArrayWriter* writer) {});
+    });
+  });
+
+  EXPECT_EQ(
+      "{"
+      "\"name\":\"foo\","
+      "\"active\":true,"
+      "\"numbers\":[1,2,3],"
+      "\"empty\":{},"
+      "\"objects\":[{\"key\":\"value\"},[]]"
+      "}",
+      json);
+
+  // The JSON should be the same as that of the equivalent JSON::Value.
+  JSON::Object object;
+  object.values["name"] = "foo";
+  object.values["active"] = true;
+  object.values["numbers"] = JSON::Array();
+  object.values["empty"] = JSON::Object();
+
+  JSON::Array array;
+  array.values = {1, 2, 3};
+  object.values["numbers"] = array;
+
+  JSON::Object key;
+  key.values["key"] = "value";
+
+  array.values = {key, JSON::Array()};
+  object.values["objects"] = array;
+
+  Try<JSON::Value> parse = JSON::parse(json);
+  ASSERT_SOME(parse);
+
+  EXPECT_EQ(JSON::Value(object), parse.get());
+}
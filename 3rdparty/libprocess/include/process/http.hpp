@@ -163,6 +163,11 @@ public:
     // was unable to continue reading!
     Future<Nothing> readerClosed();
 
+    // Returns the number of bytes written to the pipe that have not
+    // been read yet, which allows a writer to detect a reader that
+    // doesn't "keep up" (see above).
+    size_t size() const;
+
   private:
     friend class Pipe;
 
@@ -186,7 +191,8 @@ public:
 private:
   struct Data
   {
-    Data() : lock(0), readEnd(Reader::OPEN), writeEnd(Writer::OPEN) {}
+    Data()
+      : lock(0), readEnd(Reader::OPEN), writeEnd(Writer::OPEN), size(0) {}
 
     // Rather than use a process to serialize access to the pipe's
     // internal data we use a low-level "lock" which we acquire and
@@ -203,6 +209,9 @@ private:
     // empty strings as they serve as a signal for end-of-file.
     std::queue<std::string> writes;
 
+    // The total size of the unread writes.
+    size_t size;
+
     // Signals when the read-end is closed before the write-end.
     Promise<Nothing> readerClosure;
 
@@ -240,7 +249,9 @@ struct Response
   // already specified.
   //
   // PATH: Attempts to perform a 'sendfile' operation on the file
-  // found at 'path'.
+  // found at 'path'. A successful response honors the 'Range' (and
+  // 'If-Range') header of the request, sending only the requested
+  // byte ranges of the file (see RFC 7233).
   //
   // PIPE: Splices data from the Pipe 'reader' using a "chunked"
   // 'Transfer-Encoding'. The writer uses a Pipe::Writer to
@@ -323,6 +334,15 @@ struct Accepted : Response
 };
 
 
+struct NotModified : Response
+{
+  NotModified()
+  {
+    status = "304 Not Modified";
+  }
+};
+
+
 struct TemporaryRedirect : Response
 {
   explicit TemporaryRedirect(const std::string& url)
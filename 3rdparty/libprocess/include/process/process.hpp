@@ -239,6 +239,12 @@ private:
   // Active references.
   int refs;
 
+  // Index of the worker thread this process last ran on (or was last
+  // enqueued for), used by the ProcessManager to keep a process on
+  // the same run queue when work stealing is enabled. Negative if the
+  // process has not yet been assigned a worker.
+  int worker;
+
   // Process PID.
   UPID pid;
 };
@@ -1,7 +1,10 @@
 #ifndef __PROCESS_SOCKET_HPP__
 #define __PROCESS_SOCKET_HPP__
 
+#include <sys/uio.h> // For iovec.
+
 #include <memory>
+#include <vector>
 
 #include <process/address.hpp>
 #include <process/future.hpp>
@@ -68,6 +71,14 @@ public:
     virtual Future<size_t> send(const char* data, size_t size) = 0;
     virtual Future<size_t> sendfile(int fd, off_t offset, size_t size) = 0;
 
+    // Sends (some of) the data of the specified buffers in order,
+    // like 'send' but without requiring the buffers to be contiguous
+    // (i.e., a scatter-gather write). Returns the number of bytes
+    // sent, which may be less than the total size of the buffers.
+    // The default implementation only sends the first buffer, so
+    // implementations should override this to write them all at once.
+    virtual Future<size_t> sendv(const std::vector<iovec>& buffers);
+
     // An overload of 'recv', receives data based on the specified
     // 'size' parameter:
     //
@@ -157,6 +168,11 @@ public:
     return impl->sendfile(fd, offset, size);
   }
 
+  Future<size_t> sendv(const std::vector<iovec>& buffers) const
+  {
+    return impl->sendv(buffers);
+  }
+
   Future<std::string> recv(const Option<ssize_t>& size)
   {
     return impl->recv(size);
@@ -18,17 +18,17 @@
 
 #include "event_loop.hpp"
 #include "synchronized.hpp"
+#include "timer_wheel.hpp"
 
 using std::list;
-using std::map;
 using std::set;
 
 namespace process {
 
-// We store the timers in a map of lists indexed by the timeout of the
-// timer so that we can have two timers that have the same timeout. We
-// exploit that the map is SORTED!
-static map<Time, list<Timer>>* timers = new map<Time, list<Timer>>();
+// We store the timers in a hierarchical timing wheel so that adding
+// and canceling a timer (e.g., for every 'delay') is O(1), see
+// TimerWheel for details.
+static TimerWheel* timers = new TimerWheel();
 static synchronizable(timers) = SYNCHRONIZED_INITIALIZER_RECURSIVE;
 
 
@@ -38,7 +38,7 @@ static synchronizable(timers) = SYNCHRONIZED_INITIALIZER_RECURSIVE;
 // likely change.
 namespace clock {
 
-map<ProcessBase*, Time>* currents = new map<ProcessBase*, Time>();
+std::map<ProcessBase*, Time>* currents = new std::map<ProcessBase*, Time>();
 
 Time* initial = new Time(Time::epoch());
 Time* current = new Time(Time::epoch());
@@ -63,32 +63,29 @@ lambda::function<void(const list<Timer>&)>* callback =
 set<Time>* ticks = new set<Time>();
 
 
-// Helper for determining the time when the next timer elapses,
-// or None if no timers are pending, or the clock is paused and no
-// timers are expired. Note that we don't manipulate 'timers' directly
-// so that it's clear from the callsite that the use of 'timers' is
-// within a 'synchronized' block.
-//
-// TODO(benh): Create a generic 'Timers' abstraction which hides this
-// and more away (i.e., all manipulations of 'timers' below).
-Option<Time> next(const map<Time, list<Timer>>& timers)
+// Helper for determining the time when the next timer elapses (or
+// possibly a bit earlier, see TimerWheel::next), or None if no timers
+// are pending, or the clock is paused and no timers are expired. Note
+// that we don't manipulate 'timers' directly so that it's clear from
+// the callsite that the use of 'timers' is within a 'synchronized'
+// block.
+Option<Time> next(TimerWheel* timers)
 {
-  if (!timers.empty()) {
-    Time first = timers.begin()->first;
-
-    // If the clock is paused and no timers are expired, the
-    // timers cannot fire until the clock is advanced, so we
-    // return None() here. Note that we pass NULL to ensure
-    // that this looks at the global clock, since this can be
-    // called from a Process context through Clock::timer.
-    if (Clock::paused() && first > Clock::now(NULL)) {
-      return None();
-    }
-
-    return first;
+  // Note that we pass NULL to ensure that this looks at the global
+  // clock, since this can be called from a Process context through
+  // Clock::timer.
+  const Time now = Clock::now(NULL);
+
+  const Option<Time> first = timers->next(now);
+
+  // If the clock is paused and no timers are expired, the timers
+  // cannot fire until the clock is advanced, so we return None()
+  // here. Note that TimerWheel::next is exact for expired timers.
+  if (first.isSome() && Clock::paused() && first.get() > now) {
+    return None();
   }
 
-  return None();
+  return first;
 }
 
 
@@ -102,7 +99,7 @@ void tick(const Time& time);
 // a 'synchronized' block.
 // TODO(bmahler): Consider taking an optional 'now' to avoid
 // excessive syscalls via Clock::now(NULL).
-void scheduleTick(const map<Time, list<Timer>>& timers, set<Time>* ticks)
+void scheduleTick(TimerWheel* timers, set<Time>* ticks)
 {
   // Determine when the next 'tick' should fire.
   const Option<Time> next = clock::next(timers);
@@ -134,30 +131,18 @@ void tick(const Time& time)
 
     VLOG(3) << "Handling timers up to " << now;
 
-    foreachkey (const Time& timeout, *timers) {
-      if (timeout > now) {
-        break;
-      }
-
-      VLOG(3) << "Have timeout(s) at " << timeout;
+    timedout = timers->expire(now);
 
-      // Need to toggle 'settling' so that we don't prematurely say
-      // we're settled until after the timers are executed below,
-      // outside of the critical section.
-      if (clock::paused) {
-        clock::settling = true;
-      }
-
-      foreach (const Timer& timer, (*timers)[timeout]) {
-        timedout.push_back(timer);
-      }
+    // Need to toggle 'settling' so that we don't prematurely say
+    // we're settled until after the timers are executed below,
+    // outside of the critical section.
+    if (clock::paused && !timedout.empty()) {
+      clock::settling = true;
     }
 
-    // Now erase the range of timers that timed out.
-    timers->erase(timers->begin(), timers->upper_bound(now));
-
     // Okay, so the timeout for the next timer should not have fired.
-    CHECK(timers->empty() || (timers->begin()->first > now));
+    const Option<Time> first = timers->next(now);
+    CHECK(first.isNone() || first.get() > now);
 
     // Remove this tick from the scheduled 'ticks', it may have
     // been removed already if the clock was paused / manipulated
@@ -165,7 +150,7 @@ void tick(const Time& time)
     ticks->erase(time);
 
     // Schedule another "tick" if necessary.
-    scheduleTick(*timers, ticks);
+    scheduleTick(timers, ticks);
   }
 
   (*clock::callback)(timedout);
@@ -174,11 +159,12 @@ void tick(const Time& time)
   // that will expire before the paused time and we've finished
   // executing expired timers.
   synchronized (timers) {
-    if (clock::paused &&
-        (timers->size() == 0 ||
-         timers->begin()->first > *clock::current)) {
-      VLOG(3) << "Clock has settled";
-      clock::settling = false;
+    if (clock::paused) {
+      const Option<Time> first = timers->next(*clock::current);
+      if (first.isNone() || first.get() > *clock::current) {
+        VLOG(3) << "Clock has settled";
+        clock::settling = false;
+      }
     }
   }
 }
@@ -234,7 +220,8 @@ Timer Clock::timer(
   static uint64_t id = 1; // Start at 1 since Timer() instances use id 0.
 
   // Assumes Clock::now() does Clock::now(__process__).
-  Timeout timeout = Timeout::in(duration);
+  const Time now = Clock::now();
+  Timeout timeout = Timeout(now + duration);
 
   UPID pid = __process__ != NULL ? __process__->self() : UPID();
 
@@ -245,17 +232,13 @@ Timer Clock::timer(
 
   // Add the timer.
   synchronized (timers) {
-    if (timers->size() == 0 ||
-        timer.timeout().time() < timers->begin()->first) {
-      // Need to interrupt the loop to update/set timer repeat.
-      (*timers)[timer.timeout().time()].push_back(timer);
+    timers->add(timer, now);
 
-      // Schedule another "tick" if necessary.
-      clock::scheduleTick(*timers, clock::ticks);
-    } else {
-      // Timer repeat is adequate, just add the timeout.
-      CHECK(timers->size() >= 1);
-      (*timers)[timer.timeout().time()].push_back(timer);
+    // Schedule another "tick" if necessary, i.e., if this timer
+    // might fire before any of the currently scheduled 'ticks'.
+    if (clock::ticks->empty() ||
+        timer.timeout().time() < *clock::ticks->begin()) {
+      clock::scheduleTick(timers, clock::ticks);
     }
   }
 
@@ -265,22 +248,11 @@ Timer Clock::timer(
 
 bool Clock::cancel(const Timer& timer)
 {
-  bool canceled = false;
   synchronized (timers) {
-    // Check if the timeout is still pending, and if so, erase it. In
-    // addition, erase an empty list if we just removed the last
-    // timeout.
-    Time time = timer.timeout().time();
-    if (timers->count(time) > 0) {
-      canceled = true;
-      (*timers)[time].remove(timer);
-      if ((*timers)[time].empty()) {
-        timers->erase(time);
-      }
-    }
+    return timers->cancel(timer);
   }
 
-  return canceled;
+  UNREACHABLE();
 }
 
 
@@ -329,7 +301,7 @@ void Clock::resume()
       clock::currents->clear();
 
       // Schedule another "tick" if necessary.
-      clock::scheduleTick(*timers, clock::ticks);
+      clock::scheduleTick(timers, clock::ticks);
     }
   }
 }
@@ -347,7 +319,7 @@ void Clock::advance(const Duration& duration)
       // Schedule another "tick" if necessary. Only "ticks" that
       // fire immediately will be scheduled here, since the clock
       // is paused.
-      clock::scheduleTick(*timers, clock::ticks);
+      clock::scheduleTick(timers, clock::ticks);
     }
   }
 }
@@ -384,7 +356,7 @@ void Clock::update(const Time& time)
         // Schedule another "tick" if necessary. Only "ticks" that
         // fire immediately will be scheduled here, since the clock
         // is paused.
-        clock::scheduleTick(*timers, clock::ticks);
+        clock::scheduleTick(timers, clock::ticks);
       }
     }
   }
@@ -421,11 +393,12 @@ bool Clock::settled()
   synchronized (timers) {
     CHECK(clock::paused);
 
+    const Option<Time> first = timers->next(*clock::current);
+
     if (clock::settling) {
       VLOG(3) << "Clock still not settled";
       return false;
-    } else if (timers->size() == 0 ||
-               timers->begin()->first > *clock::current) {
+    } else if (first.isNone() || first.get() > *clock::current) {
       VLOG(3) << "Clock is settled";
       return true;
     }
@@ -4,8 +4,14 @@
 #include <stdint.h>
 #include <time.h>
 
+#include <sys/uio.h> // For iovec.
+
 #include <map>
+#include <memory>
 #include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
 
 #include <process/http.hpp>
 #include <process/process.hpp>
@@ -30,7 +36,8 @@ class Encoder
 public:
   enum Kind {
     DATA,
-    FILE
+    FILE,
+    IOVEC
   };
 
   explicit Encoder(const network::Socket& _s) : s(_s) {}
@@ -91,11 +98,97 @@ private:
 };
 
 
-class MessageEncoder : public DataEncoder
+// An encoder for a sequence of buffers which get sent using a single
+// scatter-gather write (see Socket::sendv) rather than first getting
+// copied into one contiguous buffer. This avoids copying large bodies,
+// e.g., serialized protobufs, just to add the HTTP framing.
+class IOVecEncoder : public Encoder
+{
+public:
+  explicit IOVecEncoder(const network::Socket& s)
+    : Encoder(s), size(0), index(0) {}
+
+  virtual ~IOVecEncoder() {}
+
+  virtual Kind kind() const
+  {
+    return Encoder::IOVEC;
+  }
+
+  virtual std::vector<iovec> next(size_t* length)
+  {
+    std::vector<iovec> result;
+
+    // Skip the buffers (and the part of a buffer) already sent.
+    size_t offset = 0;
+    foreach (const iovec& buffer, buffers) {
+      if (offset + buffer.iov_len > index) {
+        const size_t skip = index > offset ? index - offset : 0;
+
+        iovec remaining;
+        remaining.iov_base = static_cast<char*>(buffer.iov_base) + skip;
+        remaining.iov_len = buffer.iov_len - skip;
+        result.push_back(remaining);
+      }
+
+      offset += buffer.iov_len;
+    }
+
+    *length = size - index;
+    index = size;
+    return result;
+  }
+
+  virtual void backup(size_t length)
+  {
+    if (index >= length) {
+      index -= length;
+    }
+  }
+
+  virtual size_t remaining() const
+  {
+    return size - index;
+  }
+
+protected:
+  // Appends a buffer to be sent. The data is not copied, so it must
+  // stay valid (and unchanged) for the lifetime of the encoder.
+  void append(const std::string& data)
+  {
+    if (!data.empty()) {
+      iovec buffer;
+      buffer.iov_base = const_cast<char*>(data.data());
+      buffer.iov_len = data.size();
+      buffers.push_back(buffer);
+      size += data.size();
+    }
+  }
+
+private:
+  std::vector<iovec> buffers;
+  size_t size;
+  size_t index;
+};
+
+
+class MessageEncoder : public IOVecEncoder
 {
 public:
   MessageEncoder(const network::Socket& s, Message* _message)
-    : DataEncoder(s, encode(_message)), message(_message) {}
+    : IOVecEncoder(s),
+      message(_message),
+      header(encodeHeader(_message)),
+      trailer(encodeTrailer(_message))
+  {
+    // The body is sent straight out of the message (which we own)
+    // rather than being copied into the HTTP request.
+    append(header);
+    if (message != NULL) {
+      append(message->body);
+    }
+    append(trailer);
+  }
 
   virtual ~MessageEncoder()
   {
@@ -105,6 +198,19 @@ public:
   }
 
   static std::string encode(Message* message)
+  {
+    std::string result = encodeHeader(message);
+
+    if (message != NULL) {
+      result += message->body;
+    }
+
+    return result + encodeTrailer(message);
+  }
+
+private:
+  // Returns the HTTP request up to the (chunked) body.
+  static std::string encodeHeader(Message* message)
   {
     std::ostringstream out;
 
@@ -128,10 +234,6 @@ public:
       if (message->body.size() > 0) {
         out << "Transfer-Encoding: chunked\r\n\r\n"
             << std::hex << message->body.size() << "\r\n";
-        out.write(message->body.data(), message->body.size());
-        out << "\r\n"
-            << "0\r\n"
-            << "\r\n";
       } else {
         out << "\r\n";
       }
@@ -140,23 +242,72 @@ public:
     return out.str();
   }
 
-private:
+  // Returns the rest of the HTTP request after the body.
+  static std::string encodeTrailer(Message* message)
+  {
+    if (message != NULL && message->body.size() > 0) {
+      return "\r\n"
+             "0\r\n"
+             "\r\n";
+    }
+
+    return "";
+  }
+
   Message* message;
+  const std::string header;
+  const std::string trailer;
 };
 
 
-class HttpResponseEncoder : public DataEncoder
+class HttpResponseEncoder : public IOVecEncoder
 {
 public:
+  // NOTE: The response is taken by value so that callers can move it
+  // in, in which case its body is moved (rather than copied) into the
+  // encoder. The body is then sent from there as a separate buffer
+  // so that it's not copied into the encoded response either.
   HttpResponseEncoder(
       const network::Socket& s,
-      const http::Response& response,
+      http::Response response,
       const http::Request& request)
-    : DataEncoder(s, encode(response, request)) {}
+    : IOVecEncoder(s)
+  {
+    // Only a response of type "body" has a body to send.
+    if (response.type == http::Response::BODY) {
+      body = std::move(response.body);
+    }
+
+    encode(response, request, &header, &body);
+    append(header);
+    append(body);
+  }
 
   static std::string encode(
       const http::Response& response,
       const http::Request& request)
+  {
+    std::string header;
+    std::string body;
+
+    if (response.type == http::Response::BODY) {
+      body = response.body;
+    }
+
+    encode(response, request, &header, &body);
+    return header + body;
+  }
+
+private:
+  // Encodes the status line and headers of the response into
+  // 'header'. The body of the response is expected in 'body', which
+  // gets compressed and/or truncated in place as needed. NOTE: The
+  // response's own body is not used since it may have been moved.
+  static void encode(
+      const http::Response& response,
+      const http::Request& request,
+      std::string* header,
+      std::string* body)
   {
     std::ostringstream out;
 
@@ -184,18 +335,16 @@ public:
     headers["Date"] = date;
 
     // Should we compress this response?
-    std::string body = response.body;
-
     if (response.type == http::Response::BODY &&
-        response.body.length() >= GZIP_MINIMUM_BODY_LENGTH &&
+        body->length() >= GZIP_MINIMUM_BODY_LENGTH &&
         !headers.contains("Content-Encoding") &&
         request.accepts("gzip")) {
-      Try<std::string> compressed = gzip::compress(body);
+      Try<std::string> compressed = gzip::compress(*body);
       if (compressed.isError()) {
         LOG(WARNING) << "Failed to gzip response body: " << compressed.error();
       } else {
-        body = compressed.get();
-        headers["Content-Length"] = stringify(body.length());
+        *body = compressed.get();
+        headers["Content-Length"] = stringify(body->length());
         headers["Content-Encoding"] = "gzip";
       }
     }
@@ -211,38 +360,62 @@ public:
       out << "Content-Length: 0\r\n";
     } else if (response.type == http::Response::BODY &&
                !headers.contains("Content-Length")) {
-      out << "Content-Length: " << body.size() << "\r\n";
+      out << "Content-Length: " << body->size() << "\r\n";
     }
 
     // Use a CRLF to mark end of headers.
     out << "\r\n";
 
-    // Add the body if necessary.
+    *header = out.str();
+
+    // If the Content-Length header was supplied, only send as much of
+    // the body as the length specifies.
     if (response.type == http::Response::BODY) {
-      // If the Content-Length header was supplied, only write as much data
-      // as the length specifies.
       Result<uint32_t> length = numify<uint32_t>(headers.get("Content-Length"));
-      if (length.isSome() && length.get() <= body.length()) {
-        out.write(body.data(), length.get());
-      } else {
-        out.write(body.data(), body.size());
+      if (length.isSome() && length.get() <= body->length()) {
+        body->resize(length.get());
       }
     }
-
-    return out.str();
   }
+
+  std::string header;
+  std::string body;
 };
 
 
 class FileEncoder : public Encoder
 {
 public:
-  FileEncoder(const network::Socket& s, int _fd, size_t _size)
-    : Encoder(s), fd(_fd), size(_size), index(0) {}
+  // Sends 'size' bytes of the file starting at 'offset'. Note that
+  // the file descriptor is closed once the encoder is deleted.
+  FileEncoder(
+      const network::Socket& s,
+      int fd,
+      size_t size,
+      off_t offset = 0)
+    : Encoder(s), file(own(fd)), end(offset + size), index(offset) {}
+
+  // Sends 'size' bytes of a file that is shared with other encoders
+  // (e.g., when sending multiple ranges of the same file), which gets
+  // closed once the last of them is deleted. This is safe since the
+  // sends don't depend on (nor change) the offset of the file.
+  FileEncoder(
+      const network::Socket& s,
+      const std::shared_ptr<int>& _file,
+      size_t size,
+      off_t offset)
+    : Encoder(s), file(_file), end(offset + size), index(offset) {}
+
+  virtual ~FileEncoder() {}
 
-  virtual ~FileEncoder()
+  // Returns a file descriptor to be shared by encoders, which gets
+  // closed once the last reference to it goes away.
+  static std::shared_ptr<int> own(int fd)
   {
-    os::close(fd);
+    return std::shared_ptr<int>(new int(fd), [](int* fd) {
+      os::close(*fd);
+      delete fd;
+    });
   }
 
   virtual Kind kind() const
@@ -253,10 +426,10 @@ public:
   virtual int next(off_t* offset, size_t* length)
   {
     off_t temp = index;
-    index = size;
+    index = end;
     *offset = temp;
-    *length = size - temp;
-    return fd;
+    *length = end - temp;
+    return *file;
   }
 
   virtual void backup(size_t length)
@@ -268,12 +441,12 @@ public:
 
   virtual size_t remaining() const
   {
-    return size - index;
+    return end - index;
   }
 
 private:
-  int fd;
-  size_t size;
+  std::shared_ptr<int> file;
+  off_t end;
   off_t index;
 };
 
@@ -185,6 +185,7 @@ Future<string> Pipe::Reader::read()
       future = Failure("closed");
     } else if (!data->writes.empty()) {
       future = data->writes.front();
+      data->size -= data->writes.front().size();
       data->writes.pop();
     } else if (data->writeEnd == Writer::CLOSED) {
       future = ""; // End-of-file.
@@ -215,6 +216,7 @@ bool Pipe::Reader::close()
       while (!data->writes.empty()) {
         data->writes.pop();
       }
+      data->size = 0;
 
       // Extract the pending reads so we can fail them.
       std::swap(data->reads, reads);
@@ -258,6 +260,7 @@ bool Pipe::Writer::write(const string& s)
       if (!s.empty()) {
         if (data->reads.empty()) {
           data->writes.push(s);
+          data->size += s.size();
         } else {
           read = data->reads.front();
           data->reads.pop();
@@ -341,6 +344,20 @@ Future<Nothing> Pipe::Writer::readerClosed()
 }
 
 
+size_t Pipe::Writer::size() const
+{
+  size_t size;
+
+  process::internal::acquire(&data->lock);
+  {
+    size = data->size;
+  }
+  process::internal::release(&data->lock);
+
+  return size;
+}
+
+
 namespace path {
 
 Try<hashmap<string, string>> parse(const string& pattern, const string& path)
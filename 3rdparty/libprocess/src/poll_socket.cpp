@@ -1,4 +1,11 @@
+#include <limits.h> // For IOV_MAX.
+#include <string.h>
+
 #include <netinet/tcp.h>
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <vector>
 
 #include <process/io.hpp>
 #include <process/network.hpp>
@@ -8,6 +15,7 @@
 #include "poll_socket.hpp"
 
 using std::string;
+using std::vector;
 
 namespace process {
 namespace network {
@@ -196,6 +204,50 @@ Future<size_t> socket_send_file(int s, int fd, off_t offset, size_t size)
   }
 }
 
+
+Future<size_t> socket_send_buffers(int s, const vector<iovec>& buffers)
+{
+  CHECK(!buffers.empty());
+
+  // NOTE: We use 'sendmsg' rather than 'writev' so that we can pass
+  // MSG_NOSIGNAL, like we do for 'send' above. Any buffers beyond
+  // IOV_MAX just get sent by a subsequent call.
+  struct msghdr message;
+  memset(&message, 0, sizeof(message));
+  message.msg_iov = const_cast<iovec*>(buffers.data());
+  message.msg_iovlen = std::min(buffers.size(), static_cast<size_t>(IOV_MAX));
+
+  while (true) {
+    ssize_t length = sendmsg(s, &message, MSG_NOSIGNAL);
+
+    if (length < 0 && (errno == EINTR)) {
+      // Interrupted, try again now.
+      continue;
+    } else if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      // Might block, try again later.
+      return io::poll(s, io::WRITE)
+        .then(lambda::bind(&internal::socket_send_buffers, s, buffers));
+    } else if (length <= 0) {
+      // Socket error or closed.
+      if (length < 0) {
+        const char* error = strerror(errno);
+        VLOG(1) << "Socket error while sending: " << error;
+      } else {
+        VLOG(1) << "Socket closed while sending";
+      }
+      if (length == 0) {
+        return length;
+      } else {
+        return Failure(ErrnoError("Socket sendmsg failed"));
+      }
+    } else {
+      CHECK(length > 0);
+
+      return length;
+    }
+  }
+}
+
 } // namespace internal {
 
 
@@ -212,5 +264,12 @@ Future<size_t> PollSocketImpl::sendfile(int fd, off_t offset, size_t size)
     .then(lambda::bind(&internal::socket_send_file, get(), fd, offset, size));
 }
 
+
+Future<size_t> PollSocketImpl::sendv(const vector<iovec>& buffers)
+{
+  return io::poll(get(), io::WRITE)
+    .then(lambda::bind(&internal::socket_send_buffers, get(), buffers));
+}
+
 } // namespace network {
 } // namespace process {
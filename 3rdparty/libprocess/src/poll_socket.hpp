@@ -1,4 +1,5 @@
 #include <memory>
+#include <vector>
 
 #include <process/socket.hpp>
 
@@ -23,6 +24,7 @@ public:
   virtual Future<size_t> recv(char* data, size_t size);
   virtual Future<size_t> send(const char* data, size_t size);
   virtual Future<size_t> sendfile(int fd, off_t offset, size_t size);
+  virtual Future<size_t> sendv(const std::vector<iovec>& buffers);
 };
 
 } // namespace network {
@@ -39,6 +39,7 @@
 #include <sstream>
 #include <stack>
 #include <stdexcept>
+#include <utility>
 #include <vector>
 
 #include <process/address.hpp>
@@ -53,6 +54,7 @@
 #include <process/gc.hpp>
 #include <process/help.hpp>
 #include <process/id.hpp>
+#include <process/internal.hpp>
 #include <process/io.hpp>
 #include <process/logging.hpp>
 #include <process/mime.hpp>
@@ -70,11 +72,13 @@
 #include <stout/foreach.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/os.hpp>
 #include <stout/strings.hpp>
 #include <stout/thread.hpp>
 #include <stout/unreachable.hpp>
+#include <stout/uuid.hpp>
 
 #include "config.hpp"
 #include "decoder.hpp"
@@ -105,6 +109,7 @@ using std::find;
 using std::list;
 using std::map;
 using std::ostream;
+using std::ostringstream;
 using std::pair;
 using std::queue;
 using std::set;
@@ -178,6 +183,18 @@ private:
   // Handles stream based responses.
   void stream(const Request& request, const Future<string>& chunk);
 
+  // Reads the next chunk of a stream based response.
+  void read(const Request& request);
+
+  // Sends the byte ranges of the file (of 'size' bytes) requested
+  // via the 'Range' header of the request, taking ownership of 'fd'.
+  void sendfile(
+      Response response,
+      const Request& request,
+      int fd,
+      size_t size,
+      const vector<pair<size_t, size_t>>& ranges);
+
   Socket socket; // Wrap the socket to keep it from getting closed.
 
   // Describes a queue "item" that wraps the future to the response
@@ -215,6 +232,30 @@ private:
 };
 
 
+// Encodes a chunk of a stream based response, providing a future
+// which is satisfied once the chunk is no longer queued for sending,
+// i.e., once it has been sent or the socket has been closed.
+class ChunkEncoder : public DataEncoder
+{
+public:
+  ChunkEncoder(const Socket& socket, const string& data)
+    : DataEncoder(socket, data) {}
+
+  virtual ~ChunkEncoder()
+  {
+    promise.set(Nothing());
+  }
+
+  Future<Nothing> sent()
+  {
+    return promise.future();
+  }
+
+private:
+  Promise<Nothing> promise;
+};
+
+
 // Helper for creating routes without a process.
 // TODO(benh): Move this into route.hpp.
 class Route
@@ -278,7 +319,7 @@ public:
   PID<HttpProxy> proxy(const Socket& socket);
 
   void send(Encoder* encoder, bool persist);
-  void send(const Response& response,
+  void send(Response response,
             const Request& request,
             const Socket& socket);
   void send(Message* message);
@@ -341,7 +382,12 @@ private:
 class ProcessManager
 {
 public:
-  explicit ProcessManager(const string& delegate);
+  // Creates a process manager that schedules processes across
+  // 'workers' worker threads. If 'stealing' is true each worker
+  // thread gets its own bounded run queue and idle workers steal
+  // processes from the others, otherwise all worker threads share a
+  // single run queue.
+  ProcessManager(const string& delegate, int workers, bool stealing);
   ~ProcessManager();
 
   ProcessReference use(const UPID& pid);
@@ -368,7 +414,7 @@ public:
   bool wait(const UPID& pid);
 
   void enqueue(ProcessBase* process);
-  ProcessBase* dequeue();
+  ProcessBase* dequeue(int worker);
 
   void settle();
 
@@ -376,6 +422,22 @@ public:
   Future<Response> __processes__(const Request&);
 
 private:
+  // Run queue of a single worker thread. We use a spinlock (see
+  // process/internal.hpp) rather than a mutex since the critical
+  // sections are only a handful of instructions long.
+  struct RunQueue
+  {
+    RunQueue() : lock(0) {}
+
+    deque<ProcessBase*> processes;
+    int lock;
+  };
+
+  // Helpers for removing a process from a per worker run queue,
+  // returns NULL if the queue is empty.
+  ProcessBase* pop(RunQueue* queue);
+  ProcessBase* steal(RunQueue* queue);
+
   // Delegate process name to receive root HTTP requests.
   const string delegate;
 
@@ -386,18 +448,47 @@ private:
   // Gates for waiting threads (protected by synchronizable(processes)).
   map<ProcessBase*, Gate*> gates;
 
-  // Queue of runnable processes (implemented using list).
+  // Queue of runnable processes (implemented using list). When work
+  // stealing is enabled this only holds the processes that did not
+  // fit in their worker's bounded run queue.
   list<ProcessBase*> runq;
   synchronizable(runq);
 
-  // Number of running processes, to support Clock::settle operation.
+  // Whether or not to use the per worker run queues below.
+  const bool stealing;
+
+  // Per worker run queues (empty if work stealing is disabled).
+  vector<RunQueue*> runqs;
+
+  // Used to distribute processes that have never been run across
+  // the worker run queues.
+  unsigned int next;
+
+  // Number of processes that are either enqueued or running, to
+  // support Clock::settle operation. A process is counted from when
+  // it gets enqueued until its worker thread stops running it, so
+  // moving a process between run queues (or from a run queue to a
+  // worker) never makes it look like we've settled.
   int running;
 };
 
 
+// Maximum number of processes in a per worker run queue, any further
+// processes get put on the shared run queue instead. This bounds the
+// amount of work that can pile up behind a single (possibly busy)
+// worker thread before other workers get a chance to run it.
+static const size_t RUNQ_CAPACITY = 1024;
+
+
 // Unique id that can be assigned to each process.
 static uint32_t __id__ = 0;
 
+// Maximum number of byte ranges that a request for a file can ask
+// for, any 'Range' header asking for more gets ignored (i.e., the
+// whole file is sent). This bounds the work (and number of parts)
+// that a single request can cause (see CVE-2011-3192).
+static const size_t MAX_RANGES = 100;
+
 // Server socket listen backlog.
 static const int LISTEN_BACKLOG = 500000;
 
@@ -592,11 +683,14 @@ void decode_recv(
 
 void* schedule(void* arg)
 {
+  // The index of this worker thread (see 'initialize').
+  const int worker = static_cast<int>(reinterpret_cast<intptr_t>(arg));
+
   do {
-    ProcessBase* process = process_manager->dequeue();
+    ProcessBase* process = process_manager->dequeue(worker);
     if (process == NULL) {
       Gate::state_t old = gate->approach();
-      process = process_manager->dequeue();
+      process = process_manager->dequeue(worker);
       if (process == NULL) {
         gate->arrive(old); // Wait at gate if idle.
         continue;
@@ -729,10 +823,6 @@ void initialize(const string& delegate)
   signal(SIGPIPE, SIG_IGN);
 #endif // __sun__
 
-  // Create a new ProcessManager and SocketManager.
-  process_manager = new ProcessManager(delegate);
-  socket_manager = new SocketManager();
-
   // Setup processing threads.
   // We create no fewer than 8 threads because some tests require
   // more worker threads than 'sysconf(_SC_NPROCESSORS_ONLN)' on
@@ -745,9 +835,33 @@ void initialize(const string& delegate)
   // threads.
   long cpus = std::max(8L, sysconf(_SC_NPROCESSORS_ONLN));
 
+  char* value;
+
+  // Allow the number of worker threads to be overridden, e.g., for
+  // benchmarking the scheduler at different levels of parallelism.
+  value = getenv("LIBPROCESS_NUM_WORKER_THREADS");
+  if (value != NULL) {
+    Try<long> workers = numify<long>(value);
+    if (workers.isError() || workers.get() <= 0) {
+      LOG(FATAL) << "LIBPROCESS_NUM_WORKER_THREADS=" << value
+                 << " is not a valid number of worker threads";
+    }
+    cpus = workers.get();
+  }
+
+  // Per worker thread run queues with work stealing are used unless
+  // explicitly disabled, in which case all worker threads share a
+  // single (globally locked) run queue.
+  bool stealing = os::getenv("LIBPROCESS_DISABLE_WORK_STEALING", false) != "1";
+
+  // Create a new ProcessManager and SocketManager.
+  process_manager = new ProcessManager(delegate, cpus, stealing);
+  socket_manager = new SocketManager();
+
   for (int i = 0; i < cpus; i++) {
     pthread_t thread; // For now, not saving handles on our threads.
-    if (pthread_create(&thread, NULL, schedule, NULL) != 0) {
+    void* worker = reinterpret_cast<void*>(static_cast<intptr_t>(i));
+    if (pthread_create(&thread, NULL, schedule, worker) != 0) {
       LOG(FATAL) << "Failed to initialize, pthread_create";
     }
   }
@@ -778,8 +892,6 @@ void initialize(const string& delegate)
 
   __address__ = Address::LOCALHOST_ANY();
 
-  char* value;
-
   // Check environment for ip.
   value = getenv("LIBPROCESS_IP");
   if (value != NULL) {
@@ -1008,6 +1120,230 @@ void HttpProxy::waited(const Future<Response>& future)
 }
 
 
+namespace internal {
+
+// A byte range of a file, as the offset of its first and last byte.
+typedef pair<size_t, size_t> Range;
+
+
+// Returns the time formatted as an HTTP date (see RFC 7231 7.1.1.1).
+string date(time_t time)
+{
+  tm tm_;
+  PCHECK(gmtime_r(&time, &tm_) != NULL)
+    << "Failed to convert the time to a tm struct using gmtime_r()";
+
+  char date[256];
+  strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm_);
+  return date;
+}
+
+
+// Returns a strong entity tag for the version of the file described
+// by 's'. A file that is modified without changing its size within
+// the resolution of its modification time is not detected, but the
+// same holds for the 'Last-Modified' header.
+string etag(const struct stat& s)
+{
+  ostringstream out;
+  out << "\"" << std::hex << s.st_ino << "-" << s.st_size << "-"
+      << s.st_mtime << "\"";
+  return out.str();
+}
+
+
+// Parses a non-negative decimal number, which unlike 'numify' rejects
+// signs and whitespace.
+Option<size_t> number(const string& s)
+{
+  if (s.empty() || s.find_first_not_of("0123456789") != string::npos) {
+    return None();
+  }
+
+  Try<size_t> result = numify<size_t>(s);
+  if (result.isError()) {
+    return None();
+  }
+
+  return result.get();
+}
+
+
+// Returns the byte ranges requested by the value of a 'Range' header
+// (see RFC 7233 2.1) for a file of 'size' bytes, sorted by offset and
+// with overlapping or adjacent ranges coalesced. The ranges that
+// start beyond the end of the file are dropped, hence no ranges are
+// returned if none of them can be satisfied. Returns an error if the
+// header is malformed or asks for more than MAX_RANGES ranges, in
+// which case it should be ignored.
+Try<vector<Range>> ranges(const string& header, size_t size)
+{
+  const string unit = "bytes=";
+
+  if (!strings::startsWith(header, unit)) {
+    return Error("Expecting a range of '" + unit + "'");
+  }
+
+  const vector<string> tokens =
+    strings::tokenize(header.substr(unit.size()), ",");
+
+  if (tokens.size() > MAX_RANGES) {
+    return Error(
+        "Too many ranges (" + stringify(tokens.size()) + " > " +
+        stringify(MAX_RANGES) + ")");
+  }
+
+  vector<Range> ranges;
+
+  foreach (const string& token, tokens) {
+    const string spec = strings::trim(token);
+
+    if (spec.empty()) {
+      continue; // The grammar allows for empty list elements.
+    }
+
+    size_t index = spec.find('-');
+    if (index == string::npos) {
+      return Error("Invalid range '" + spec + "'");
+    }
+
+    Option<size_t> first = number(spec.substr(0, index));
+    Option<size_t> last = number(spec.substr(index + 1));
+
+    if (index == 0) {
+      // A suffix range, i.e., the last 'last' bytes of the file.
+      if (last.isNone()) {
+        return Error("Invalid suffix range '" + spec + "'");
+      } else if (last.get() > 0 && size > 0) {
+        ranges.push_back(
+            Range(size - std::min(last.get(), size), size - 1));
+      }
+    } else if (first.isNone() ||
+               (index + 1 < spec.size() && last.isNone()) ||
+               (last.isSome() && last.get() < first.get())) {
+      return Error("Invalid range '" + spec + "'");
+    } else if (first.get() < size) {
+      ranges.push_back(Range(
+          first.get(),
+          last.isSome() ? std::min(last.get(), size - 1) : size - 1));
+    }
+  }
+
+  std::sort(ranges.begin(), ranges.end());
+
+  vector<Range> coalesced;
+  foreach (const Range& range, ranges) {
+    if (!coalesced.empty() && range.first <= coalesced.back().second + 1) {
+      coalesced.back().second =
+        std::max(coalesced.back().second, range.second);
+    } else {
+      coalesced.push_back(range);
+    }
+  }
+
+  return coalesced;
+}
+
+} // namespace internal {
+
+
+void HttpProxy::sendfile(
+    Response response,
+    const Request& request,
+    int fd,
+    size_t size,
+    const vector<internal::Range>& ranges)
+{
+  if (ranges.empty()) {
+    os::close(fd);
+
+    Response unsatisfiable;
+    unsatisfiable.status = http::statuses[416];
+    unsatisfiable.headers["Content-Range"] = "bytes */" + stringify(size);
+
+    socket_manager->send(unsatisfiable, request, socket);
+    return;
+  }
+
+  response.status = http::statuses[206];
+
+  if (ranges.size() == 1) {
+    const internal::Range& range = ranges.front();
+    const size_t length = range.second - range.first + 1;
+
+    response.headers["Content-Range"] =
+      "bytes " + stringify(range.first) + "-" + stringify(range.second) +
+      "/" + stringify(size);
+    response.headers["Content-Length"] = stringify(length);
+
+    VLOG(1) << "Sending bytes " << range.first << "-" << range.second
+            << " of file at '" << response.path << "'";
+
+    socket_manager->send(
+        new HttpResponseEncoder(socket, response, request),
+        true);
+
+    // Note the file descriptor gets closed by FileEncoder.
+    socket_manager->send(
+        new FileEncoder(socket, fd, length, range.first),
+        request.keepAlive);
+    return;
+  }
+
+  // Multiple ranges are sent as a "multipart/byteranges" body (see
+  // RFC 7233 4.1), where every part is sent from the same file
+  // descriptor which gets closed once the last part is done.
+  const std::shared_ptr<int> file = FileEncoder::own(fd);
+
+  const string boundary = UUID::random().toString();
+
+  const Option<string> type = response.headers.get("Content-Type");
+
+  vector<string> headers;
+  size_t length = 0;
+
+  foreach (const internal::Range& range, ranges) {
+    ostringstream out;
+    out << "\r\n--" << boundary << "\r\n";
+    if (type.isSome()) {
+      out << "Content-Type: " << type.get() << "\r\n";
+    }
+    out << "Content-Range: bytes " << range.first << "-" << range.second
+        << "/" << size << "\r\n\r\n";
+
+    headers.push_back(out.str());
+    length += out.str().size() + range.second - range.first + 1;
+  }
+
+  const string trailer = "\r\n--" + boundary + "--\r\n";
+  length += trailer.size();
+
+  response.headers["Content-Type"] =
+    "multipart/byteranges; boundary=" + boundary;
+  response.headers["Content-Length"] = stringify(length);
+
+  VLOG(1) << "Sending " << ranges.size() << " ranges of file at '"
+          << response.path << "'";
+
+  socket_manager->send(
+      new HttpResponseEncoder(socket, response, request),
+      true);
+
+  for (size_t i = 0; i < ranges.size(); i++) {
+    socket_manager->send(new DataEncoder(socket, headers[i]), true);
+    socket_manager->send(
+        new FileEncoder(
+            socket,
+            file,
+            ranges[i].second - ranges[i].first + 1,
+            ranges[i].first),
+        true);
+  }
+
+  socket_manager->send(new DataEncoder(socket, trailer), request.keepAlive);
+}
+
+
 bool HttpProxy::process(const Future<Response>& future, const Request& request)
 {
   if (!future.isReady()) {
@@ -1046,6 +1382,35 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
         VLOG(1) << "Returning '404 Not Found' for directory '" << path << "'";
         socket_manager->send(NotFound(), request, socket);
       } else {
+        // Advertise that byte ranges of the file can be requested, and
+        // provide validators for clients to resume transfers with.
+        response.headers["Accept-Ranges"] = "bytes";
+        response.headers["Last-Modified"] = internal::date(s.st_mtime);
+        response.headers["ETag"] = internal::etag(s);
+
+        // Only a successful response is subject to the 'Range' header,
+        // which is ignored if it's malformed or if the 'If-Range'
+        // validator doesn't match the current version of the file.
+        Option<string> range = request.headers.get("Range");
+        Option<string> ifRange = request.headers.get("If-Range");
+
+        if (range.isSome() &&
+            response.status == http::statuses[200] &&
+            (ifRange.isNone() ||
+             ifRange.get() == response.headers["ETag"] ||
+             ifRange.get() == response.headers["Last-Modified"])) {
+          Try<vector<internal::Range>> ranges =
+            internal::ranges(range.get(), s.st_size);
+
+          if (ranges.isError()) {
+            VLOG(1) << "Ignoring 'Range' header for path '" << path
+                    << "': " << ranges.error();
+          } else {
+            sendfile(response, request, fd, s.st_size, ranges.get());
+            return true; // All done, can process next request.
+          }
+        }
+
         // While the user is expected to properly set a 'Content-Type'
         // header, we fill in (or overwrite) 'Content-Length' header.
         stringstream out;
@@ -1053,6 +1418,7 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
         response.headers["Content-Length"] = out.str();
 
         if (s.st_size == 0) {
+          os::close(fd);
           socket_manager->send(response, request, socket);
           return true; // All done, can process next request.
         }
@@ -1096,7 +1462,7 @@ bool HttpProxy::process(const Future<Response>& future, const Request& request)
 
     return false; // Streaming, don't process next response (yet)!
   } else {
-    socket_manager->send(response, request, socket);
+    socket_manager->send(std::move(response), request, socket);
   }
 
   return true; // All done, can process next response.
@@ -1124,16 +1490,24 @@ void HttpProxy::stream(
       out << std::hex << chunk.get().size() << "\r\n";
       out << chunk.get();
       out << "\r\n";
-
-      // Keep reading.
-      reader.read()
-        .onAny(defer(self(), &Self::stream, request, lambda::_1));
     }
 
-    // Always persist the connection when streaming is not finished.
-    socket_manager->send(
-        new DataEncoder(socket, out.str()),
-        finished ? request.keepAlive : true);
+    if (finished) {
+      socket_manager->send(
+          new DataEncoder(socket, out.str()),
+          request.keepAlive);
+    } else {
+      // Keep reading, but only once this chunk has been sent so that
+      // the data a slow client can't keep up with stays in the pipe,
+      // where the writer can notice it (see Pipe::Writer::size).
+      ChunkEncoder* encoder = new ChunkEncoder(socket, out.str());
+
+      encoder->sent()
+        .onAny(defer(self(), &Self::read, request));
+
+      // Always persist the connection when streaming is not finished.
+      socket_manager->send(encoder, true);
+    }
   } else if (chunk.isFailed()) {
     VLOG(1) << "Failed to read from stream: " << chunk.failure();
     // TODO(bmahler): Have to close connection if headers were sent!
@@ -1154,6 +1528,17 @@ void HttpProxy::stream(
 }
 
 
+void HttpProxy::read(const Request& request)
+{
+  // The pipe is gone if the response was aborted in the meantime.
+  if (pipe.isSome()) {
+    http::Pipe::Reader reader = pipe.get();
+    reader.read()
+      .onAny(defer(self(), &Self::stream, request, lambda::_1));
+  }
+}
+
+
 SocketManager::SocketManager()
 {
   synchronizer(this) = SYNCHRONIZED_INITIALIZER_RECURSIVE;
@@ -1375,6 +1760,19 @@ void send(Encoder* encoder, Socket* socket)
             size));
       break;
     }
+    case Encoder::IOVEC: {
+      size_t size;
+      const vector<iovec> buffers =
+        reinterpret_cast<IOVecEncoder*>(encoder)->next(&size);
+      socket->sendv(buffers)
+        .onAny(lambda::bind(
+            &internal::_send,
+            lambda::_1,
+            socket,
+            encoder,
+            size));
+      break;
+    }
   }
 }
 
@@ -1447,7 +1845,7 @@ void SocketManager::send(Encoder* encoder, bool persist)
 
 
 void SocketManager::send(
-    const Response& response,
+    Response response,
     const Request& request,
     const Socket& socket)
 {
@@ -1461,7 +1859,8 @@ void SocketManager::send(
     }
   }
 
-  send(new HttpResponseEncoder(socket, response, request), persist);
+  // The response is moved into the encoder to avoid copying its body.
+  send(new HttpResponseEncoder(socket, std::move(response), request), persist);
 }
 
 
@@ -1837,11 +2236,25 @@ void SocketManager::exited(ProcessBase* process)
 }
 
 
-ProcessManager::ProcessManager(const string& _delegate)
-  : delegate(_delegate)
+ProcessManager::ProcessManager(
+    const string& _delegate,
+    int workers,
+    bool _stealing)
+  : delegate(_delegate),
+    stealing(_stealing)
 {
+  CHECK_GT(workers, 0);
+
   synchronizer(processes) = SYNCHRONIZED_INITIALIZER_RECURSIVE;
   synchronizer(runq) = SYNCHRONIZED_INITIALIZER_RECURSIVE;
+
+  if (stealing) {
+    for (int i = 0; i < workers; i++) {
+      runqs.push_back(new RunQueue());
+    }
+  }
+
+  next = 0;
   running = 0;
   __sync_synchronize(); // Ensure write to 'running' visible in other threads.
 }
@@ -1862,6 +2275,10 @@ ProcessManager::~ProcessManager()
       process::wait(process);
     }
   } while (process != NULL);
+
+  foreach (RunQueue* queue, runqs) {
+    delete queue;
+  }
 }
 
 
@@ -2367,23 +2784,44 @@ bool ProcessManager::wait(const UPID& pid)
       // Check if it is runnable in order to donate this thread.
       if (process->state == ProcessBase::BOTTOM ||
           process->state == ProcessBase::READY) {
-        synchronized (runq) {
-          list<ProcessBase*>::iterator it =
-            find(runq.begin(), runq.end(), process);
-          if (it != runq.end()) {
-            // Found it! Remove it from the run queue since we'll be
-            // donating our thread and also increment 'running' before
-            // leaving this 'runq' protected critical section so that
-            // everyone that is waiting for the processes to settle
-            // continue to wait (otherwise they could see nothing in
-            // 'runq' and 'running' equal to 0 between when we exit
-            // this critical section and increment 'running').
-            runq.erase(it);
-            __sync_fetch_and_add(&running, 1);
-          } else {
-            // Another thread has resumed the process ...
-            process = NULL;
+        bool found = false;
+
+        // When work stealing, a runnable process is either on the
+        // run queue of the worker it was last enqueued for or, if
+        // that run queue was full, on the shared run queue.
+        if (stealing && process->worker >= 0) {
+          RunQueue* queue = runqs[process->worker];
+          internal::acquire(&queue->lock);
+          {
+            deque<ProcessBase*>::iterator it = find(
+                queue->processes.begin(), queue->processes.end(), process);
+            if (it != queue->processes.end()) {
+              queue->processes.erase(it);
+              found = true;
+            }
           }
+          internal::release(&queue->lock);
+        }
+
+        if (!found) {
+          synchronized (runq) {
+            list<ProcessBase*>::iterator it =
+              find(runq.begin(), runq.end(), process);
+            if (it != runq.end()) {
+              runq.erase(it);
+              found = true;
+            }
+          }
+        }
+
+        // Found it! We removed it from the run queue since we'll be
+        // donating our thread. Note that 'running' still accounts for
+        // the process (it was incremented when the process was
+        // enqueued) so everyone that is waiting for the processes to
+        // settle will continue to wait.
+        if (!found) {
+          // Another thread has resumed the process ...
+          process = NULL;
         }
       } else {
         // Process is not runnable, so no need to donate ...
@@ -2423,12 +2861,44 @@ void ProcessManager::enqueue(ProcessBase* process)
 
   // TODO(benh): Check and see if this process has it's own thread. If
   // it does, push it on that threads runq, and wake up that thread if
-  // it's not running. Otherwise, check and see which thread this
-  // process was last running on, and put it on that threads runq.
+  // it's not running.
+
+  // Account for the process before it becomes visible on a run queue
+  // so that we never appear settled while it's waiting to be run
+  // (see 'running').
+  __sync_fetch_and_add(&running, 1);
+
+  bool enqueued = false;
+
+  if (stealing) {
+    // Keep the process on the run queue of the worker it was last
+    // run on. A process that has never run gets put on the run queue
+    // of the process that is enqueueing it (e.g., the one spawning
+    // it) if there is one, otherwise we spread them out.
+    if (process->worker < 0) {
+      if (__process__ != NULL && __process__->worker >= 0) {
+        process->worker = __process__->worker;
+      } else {
+        process->worker = __sync_fetch_and_add(&next, 1) % runqs.size();
+      }
+    }
+
+    RunQueue* queue = runqs[process->worker];
+    internal::acquire(&queue->lock);
+    {
+      if (queue->processes.size() < RUNQ_CAPACITY) {
+        queue->processes.push_back(process);
+        enqueued = true;
+      }
+    }
+    internal::release(&queue->lock);
+  }
 
-  synchronized (runq) {
-    CHECK(find(runq.begin(), runq.end(), process) == runq.end());
-    runq.push_back(process);
+  if (!enqueued) {
+    synchronized (runq) {
+      CHECK(find(runq.begin(), runq.end(), process) == runq.end());
+      runq.push_back(process);
+    }
   }
 
   // Wake up the processing thread if necessary.
@@ -2436,22 +2906,47 @@ void ProcessManager::enqueue(ProcessBase* process)
 }
 
 
-ProcessBase* ProcessManager::dequeue()
+ProcessBase* ProcessManager::dequeue(int worker)
 {
-  // TODO(benh): Remove a process from this thread's runq. If there
-  // are no processes to run, and this is not a dedicated thread, then
-  // steal one from another threads runq.
+  // TODO(benh): If this is a dedicated thread, only run processes
+  // from this thread's runq.
 
   ProcessBase* process = NULL;
 
-  synchronized (runq) {
-    if (!runq.empty()) {
-      process = runq.front();
-      runq.pop_front();
-      // Increment the running count of processes in order to support
-      // the Clock::settle() operation (this must be done atomically
-      // with removing the process from the runq).
-      __sync_fetch_and_add(&running, 1);
+  if (stealing) {
+    CHECK_GE(worker, 0);
+    CHECK_LT(worker, (int) runqs.size());
+
+    process = pop(runqs[worker]);
+
+    // Try the shared run queue next (it only contains the processes
+    // that overflowed their worker's run queue).
+    if (process == NULL) {
+      synchronized (runq) {
+        if (!runq.empty()) {
+          process = runq.front();
+          runq.pop_front();
+        }
+      }
+    }
+
+    // Otherwise, try and steal a process from another worker. We
+    // start at our neighbor so that idle workers don't all go after
+    // the same victim.
+    for (size_t i = 1; process == NULL && i < runqs.size(); i++) {
+      process = steal(runqs[(worker + i) % runqs.size()]);
+    }
+
+    // The process now has an affinity for this worker.
+    if (process != NULL) {
+      process->worker = worker;
+    }
+  } else {
+    synchronized (runq) {
+      if (!runq.empty()) {
+        process = runq.front();
+        runq.pop_front();
+      }
     }
   }
 
@@ -2459,6 +2954,42 @@ ProcessBase* ProcessManager::dequeue()
 }
 
 
+ProcessBase* ProcessManager::pop(RunQueue* queue)
+{
+  ProcessBase* process = NULL;
+
+  internal::acquire(&queue->lock);
+  {
+    if (!queue->processes.empty()) {
+      process = queue->processes.front();
+      queue->processes.pop_front();
+    }
+  }
+  internal::release(&queue->lock);
+
+  return process;
+}
+
+
+ProcessBase* ProcessManager::steal(RunQueue* queue)
+{
+  ProcessBase* process = NULL;
+
+  // We steal from the back of the queue, i.e., the process that has
+  // most recently been enqueued, leaving the front to the owner.
+  internal::acquire(&queue->lock);
+  {
+    if (!queue->processes.empty()) {
+      process = queue->processes.back();
+      queue->processes.pop_back();
+    }
+  }
+  internal::release(&queue->lock);
+
+  return process;
+}
+
+
 void ProcessManager::settle()
 {
   bool done = true;
@@ -2600,6 +3131,8 @@ ProcessBase::ProcessBase(const string& id)
 
   refs = 0;
 
+  worker = -1;
+
   pid.id = id != "" ? id : ID::generate();
   pid.address = __address__;
 
@@ -193,5 +193,14 @@ Future<Nothing> Socket::Impl::send(const std::string& _data)
 }
 
 
+Future<size_t> Socket::Impl::sendv(const std::vector<iovec>& buffers)
+{
+  CHECK(!buffers.empty());
+
+  return send(static_cast<const char*>(buffers[0].iov_base),
+              buffers[0].iov_len);
+}
+
+
 } // namespace network {
 } // namespace process {
@@ -20,22 +20,35 @@
 
 #include <gmock/gmock.h>
 
+#include <unistd.h>
+
+#include <algorithm>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
 #include <vector>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
 #include <process/owned.hpp>
 #include <process/process.hpp>
+#include <process/socket.hpp>
+#include <process/timer.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/gtest.hpp>
 #include <stout/hashset.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
+
+#include "encoder.hpp"
 
 using namespace process;
 
@@ -46,11 +59,20 @@ using std::ostringstream;
 using std::string;
 using std::vector;
 
+// The path of this binary, which some benchmarks run again in order
+// to measure with a different libprocess configuration.
+static string binary;
+
 int main(int argc, char** argv)
 {
+  binary = argv[0];
+
   // Initialize Google Mock/Test.
   testing::InitGoogleMock(&argc, argv);
 
+  // Initialize libprocess.
+  process::initialize();
+
   // Add the libprocess test event listeners.
   ::testing::TestEventListeners& listeners =
     ::testing::UnitTest::GetInstance()->listeners();
@@ -291,6 +313,156 @@ TEST(Process, Process_BENCHMARK_ClientServer)
 }
 
 
+// A process that replies to every 'ping' message with a 'pong'.
+class PongerProcess : public Process<PongerProcess>
+{
+protected:
+  virtual void initialize()
+  {
+    install("ping", &PongerProcess::ping);
+  }
+
+private:
+  void ping(const UPID& from, const string& body)
+  {
+    send(from, "pong", body.c_str(), body.size());
+  }
+};
+
+
+// A process that sends a fixed number of 'ping' messages to a ponger,
+// one at a time, and completes 'done' when all of them were answered.
+class PingerProcess : public Process<PingerProcess>
+{
+public:
+  PingerProcess(const UPID& _ponger, size_t _messages)
+    : ponger(_ponger), messages(_messages), responses(0) {}
+
+  Future<Nothing> done() { return promise.future(); }
+
+protected:
+  virtual void initialize()
+  {
+    install("pong", &PingerProcess::pong);
+
+    send(ponger, "ping");
+  }
+
+private:
+  void pong(const UPID& from, const string& body)
+  {
+    if (++responses == messages) {
+      promise.set(Nothing());
+    } else {
+      send(ponger, "ping");
+    }
+  }
+
+  const UPID ponger;
+  const size_t messages;
+  size_t responses;
+  Promise<Nothing> promise;
+};
+
+
+// Measures the local message throughput of the scheduler using the
+// worker threads that libprocess was initialized with, i.e., as
+// configured through LIBPROCESS_NUM_WORKER_THREADS and
+// LIBPROCESS_DISABLE_WORK_STEALING. There are twice as many busy
+// pinger/ponger pairs as there are worker threads, so that all of
+// them are kept busy and processes need to be balanced across them.
+TEST(Process, Process_BENCHMARK_RunQueueThroughputWorkers)
+{
+  const size_t messages = 50000;
+
+  long workers = std::max(8L, sysconf(_SC_NPROCESSORS_ONLN));
+
+  const string value = os::getenv("LIBPROCESS_NUM_WORKER_THREADS", false);
+  if (!value.empty()) {
+    Try<long> number = numify<long>(value);
+    ASSERT_SOME(number);
+    workers = number.get();
+  }
+
+  const long pairs = 2 * workers;
+
+  vector<Owned<PongerProcess>> pongers;
+  vector<Owned<PingerProcess>> pingers;
+
+  for (long i = 0; i < pairs; i++) {
+    pongers.push_back(Owned<PongerProcess>(new PongerProcess()));
+    spawn(pongers.back().get());
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  list<Future<Nothing>> futures;
+  foreach (const Owned<PongerProcess>& ponger, pongers) {
+    pingers.push_back(
+        Owned<PingerProcess>(new PingerProcess(ponger->self(), messages)));
+    futures.push_back(pingers.back()->done());
+    spawn(pingers.back().get());
+  }
+
+  AWAIT_READY_FOR(collect(futures), Minutes(5));
+
+  Duration elapsed = watch.elapsed();
+
+  // Each round trip consists of a 'ping' and a 'pong' message.
+  double throughput = (2 * messages * pairs) / elapsed.secs();
+
+  cout << workers << " worker(s), " << pairs << " pair(s): "
+       << throughput << " messages / sec" << endl;
+
+  foreach (const Owned<PingerProcess>& pinger, pingers) {
+    terminate(*pinger);
+    wait(*pinger);
+  }
+
+  foreach (const Owned<PongerProcess>& ponger, pongers) {
+    terminate(*ponger);
+    wait(*ponger);
+  }
+}
+
+
+// Compares the local message throughput of the scheduler with per
+// worker run queues and work stealing against a single shared run
+// queue, for an increasing number of worker threads. Since
+// libprocess can only be initialized once, this runs the benchmark
+// above in a separate instance of this binary for each configuration.
+TEST(Process, Process_BENCHMARK_RunQueueThroughput)
+{
+  const long cpus = std::max(8L, sysconf(_SC_NPROCESSORS_ONLN));
+
+  for (long workers = 1; workers <= cpus; workers *= 2) {
+    foreach (bool stealing, vector<bool>({true, false})) {
+      ostringstream output;
+
+      Try<int> status = os::shell(
+          &output,
+          "LIBPROCESS_NUM_WORKER_THREADS=%ld "
+          "LIBPROCESS_DISABLE_WORK_STEALING=%d "
+          "%s --gtest_filter=%s 2>/dev/null",
+          workers,
+          stealing ? 0 : 1,
+          binary.c_str(),
+          "Process.Process_BENCHMARK_RunQueueThroughputWorkers");
+
+      ASSERT_SOME_EQ(0, status);
+
+      foreach (const string& line, strings::tokenize(output.str(), "\n")) {
+        if (strings::contains(line, "messages / sec")) {
+          cout << (stealing ? "work stealing: " : "shared run queue: ")
+               << line << endl;
+        }
+      }
+    }
+  }
+}
+
+
 class LinkerProcess : public Process<LinkerProcess>
 {
 public:
@@ -372,3 +544,131 @@ TEST(Process, Process_BENCHMARK_LargeNumberOfLinks)
     delete process;
   }
 }
+
+
+// Measures the cost of creating and canceling a large number of timers
+// with varied timeouts, e.g., as done by the timeouts of requests
+// which usually complete (and cancel their timeout) before expiring.
+TEST(Process, Process_BENCHMARK_TimerChurn)
+{
+  const size_t timers = 200000;
+
+  for (size_t pending = 0; pending <= 100000; pending += 50000) {
+    // Keep some long-lived timers pending while churning.
+    vector<Timer> longLived;
+    for (size_t i = 0; i < pending; i++) {
+      longLived.push_back(
+          Clock::timer(Hours(1) + Milliseconds(i), []() {}));
+    }
+
+    Stopwatch watch;
+    watch.start();
+
+    // Spread the timeouts over a minute, in no particular order.
+    vector<Timer> created;
+    created.reserve(timers);
+    for (size_t i = 0; i < timers; i++) {
+      Duration timeout = Seconds(10) + Milliseconds((i * 7919) % 60000);
+      created.push_back(Clock::timer(timeout, []() {}));
+    }
+
+    foreach (const Timer& timer, created) {
+      ASSERT_TRUE(Clock::cancel(timer));
+    }
+
+    Duration elapsed = watch.elapsed();
+
+    cout << "Created and canceled " << timers << " timers with "
+         << pending << " pending in " << elapsed << endl;
+
+    foreach (const Timer& timer, longLived) {
+      Clock::cancel(timer);
+    }
+  }
+}
+
+
+// A process that counts the messages (and bytes) it receives.
+class SinkProcess : public Process<SinkProcess>
+{
+public:
+  explicit SinkProcess(size_t _messages)
+    : messages(_messages), received(0) {}
+
+  Future<Nothing> done() { return promise.future(); }
+
+protected:
+  virtual void initialize()
+  {
+    install("message", &SinkProcess::message);
+  }
+
+private:
+  void message(const UPID& from, const string& body)
+  {
+    if (++received == messages) {
+      promise.set(Nothing());
+    }
+  }
+
+  const size_t messages;
+  size_t received;
+  Promise<Nothing> promise;
+};
+
+
+// Measures the throughput of sending large messages to a process over
+// a socket, encoding and sending each message the same way that
+// libprocess does for remote messages.
+TEST(Process, Process_BENCHMARK_LargeMessages)
+{
+  const Bytes total = Megabytes(512);
+
+  vector<Bytes> sizes = {Kilobytes(64), Megabytes(1), Megabytes(16)};
+
+  foreach (const Bytes& size, sizes) {
+    const size_t messages = total.bytes() / size.bytes();
+
+    SinkProcess sink(messages);
+    spawn(sink);
+
+    Try<network::Socket> create = network::Socket::create();
+    ASSERT_SOME(create);
+
+    network::Socket socket = create.get();
+
+    AWAIT_READY(socket.connect(sink.self().address));
+
+    const string body(size.bytes(), '1');
+
+    Stopwatch watch;
+    watch.start();
+
+    for (size_t i = 0; i < messages; i++) {
+      Message* message = new Message();
+      message->name = "message";
+      message->to = sink.self();
+      message->body = body;
+
+      MessageEncoder encoder(socket, message);
+
+      while (encoder.remaining() > 0) {
+        size_t length;
+        Future<size_t> sent = socket.sendv(encoder.next(&length));
+        AWAIT_READY(sent);
+        ASSERT_GT(sent.get(), 0u);
+        encoder.backup(length - sent.get());
+      }
+    }
+
+    AWAIT_READY_FOR(sink.done(), Minutes(5));
+
+    Duration elapsed = watch.elapsed();
+
+    cout << messages << " messages of " << size << ": "
+         << total.megabytes() / elapsed.secs() << " MB / sec" << endl;
+
+    terminate(sink);
+    wait(sink);
+  }
+}
@@ -90,3 +90,54 @@ TEST(Encoder, AcceptableEncodings)
       << gzipRequest.headers.get("Accept-Encoding").get() << "'";
   }
 }
+
+
+TEST(Encoder, Message)
+{
+  Try<network::Socket> socket = network::Socket::create();
+  ASSERT_SOME(socket);
+
+  Message* message = new Message();
+  message->name = "name";
+  message->from = UPID("from", net::IP(INADDR_LOOPBACK), 1234);
+  message->to = UPID("to", net::IP(INADDR_LOOPBACK), 5678);
+  message->body = string(4096, 'x');
+
+  const string encoded = MessageEncoder::encode(message);
+
+  // The encoder owns the message.
+  MessageEncoder encoder(socket.get(), message);
+  ASSERT_EQ(encoded.size(), encoder.remaining());
+
+  // The buffers should contain the same data as 'encode', without
+  // the body having been copied out of the message.
+  size_t length;
+  vector<iovec> buffers = encoder.next(&length);
+  ASSERT_EQ(3u, buffers.size());
+  EXPECT_EQ(message->body.data(), buffers[1].iov_base);
+
+  string data;
+  foreach (const iovec& buffer, buffers) {
+    data.append(static_cast<const char*>(buffer.iov_base), buffer.iov_len);
+  }
+
+  EXPECT_EQ(encoded, data);
+  EXPECT_EQ(encoded.size(), length);
+  EXPECT_EQ(0u, encoder.remaining());
+
+  // Now pretend that only part of the body got sent.
+  const size_t sent = buffers[0].iov_len + 100;
+  encoder.backup(length - sent);
+  ASSERT_EQ(encoded.size() - sent, encoder.remaining());
+
+  buffers = encoder.next(&length);
+  ASSERT_EQ(2u, buffers.size());
+
+  data.clear();
+  foreach (const iovec& buffer, buffers) {
+    data.append(static_cast<const char*>(buffer.iov_base), buffer.iov_len);
+  }
+
+  EXPECT_EQ(encoded.substr(sent), data);
+  EXPECT_EQ(encoded.size() - sent, length);
+}
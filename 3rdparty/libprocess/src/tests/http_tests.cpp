@@ -6,6 +6,7 @@
 #include <netinet/tcp.h>
 
 #include <string>
+#include <vector>
 
 #include <process/future.hpp>
 #include <process/gmock.hpp>
@@ -20,6 +21,7 @@
 #include <stout/nothing.hpp>
 #include <stout/os.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 
 #include "encoder.hpp"
 
@@ -30,6 +32,7 @@ using process::http::URL;
 using process::network::Socket;
 
 using std::string;
+using std::vector;
 
 using testing::_;
 using testing::Assign;
@@ -201,10 +204,12 @@ TEST(HTTP, PipeEOF)
 
   // After a 'write' a call to 'read' should be completed immediately.
   ASSERT_TRUE(writer.write("world"));
+  EXPECT_EQ(5u, writer.size());
 
   read = reader.read();
   ASSERT_TRUE(read.isReady());
   EXPECT_EQ("world", read.get());
+  EXPECT_EQ(0u, writer.size());
 
   // Close the write end of the pipe and ensure the remaining
   // data can be read.
@@ -273,10 +278,13 @@ TEST(HTTP, PipeReaderCloses)
   EXPECT_TRUE(writer.write("hello"));
   EXPECT_TRUE(writer.write("world"));
 
+  EXPECT_EQ(10u, writer.size());
+
   // The writer should discover the closure.
   Future<Nothing> closed = writer.readerClosed();
   EXPECT_TRUE(reader.close());
   EXPECT_TRUE(closed.isReady());
+  EXPECT_EQ(0u, writer.size());
 
   // The read end is closed, subsequent reads will fail.
   AWAIT_FAILED(reader.read());
@@ -510,6 +518,183 @@ http::Response validatePost(const http::Request& request)
 }
 
 
+// Tests that a streamed response is only read from its pipe as fast
+// as the client receives it, leaving the rest in the pipe.
+TEST(HTTP, StreamingBackpressure)
+{
+  Http http;
+
+  http::Pipe pipe;
+  http::OK ok;
+  ok.type = http::Response::PIPE;
+  ok.reader = pipe.reader();
+
+  Future<Nothing> request;
+  EXPECT_CALL(*http.process, pipe(_))
+    .WillOnce(DoAll(FutureSatisfy(&request),
+                    Return(ok)));
+
+  Try<Socket> create = Socket::create();
+  ASSERT_SOME(create);
+
+  Socket socket = create.get();
+
+  AWAIT_READY(socket.connect(http.process->self().address));
+
+  std::ostringstream out;
+  out << "GET /" << http.process->self().id << "/pipe"
+      << " HTTP/1.1\r\n"
+      << "\r\n";
+
+  AWAIT_READY(socket.send(out.str()));
+  AWAIT_READY(request);
+
+  // Write far more than the socket buffers can hold without the
+  // client ever reading from the socket.
+  http::Pipe::Writer writer = pipe.writer();
+
+  const string chunk(1024 * 1024, 'x');
+  for (int i = 0; i < 64; i++) {
+    EXPECT_TRUE(writer.write(chunk));
+  }
+
+  os::sleep(Milliseconds(100));
+
+  EXPECT_LT(32 * chunk.size(), writer.size());
+
+  // The pipe gets closed once the client disconnects.
+  ::shutdown(socket.get(), SHUT_RDWR);
+
+  AWAIT_READY(writer.readerClosed());
+}
+
+
+TEST(HTTP, PathRange)
+{
+  Http http;
+
+  Try<string> path = os::mktemp();
+  ASSERT_SOME(path);
+  ASSERT_SOME(os::write(path.get(), "0123456789"));
+
+  http::OK ok;
+  ok.type = http::Response::PATH;
+  ok.path = path.get();
+  ok.headers["Content-Type"] = "text/plain";
+
+  EXPECT_CALL(*http.process, get(_))
+    .WillRepeatedly(Return(ok));
+
+  // Without a 'Range' header the whole file is sent.
+  Future<http::Response> response = http::get(http.process->self(), "get");
+
+  AWAIT_READY(response);
+  ASSERT_EQ(http::statuses[200], response.get().status);
+  EXPECT_EQ("0123456789", response.get().body);
+  EXPECT_SOME_EQ("bytes", response.get().headers.get("Accept-Ranges"));
+  ASSERT_SOME(response.get().headers.get("ETag"));
+
+  const string etag = response.get().headers.get("ETag").get();
+
+  // A single range.
+  hashmap<string, string> headers;
+  headers["Range"] = "bytes=2-4";
+
+  response = http::get(http.process->self(), "get", None(), headers);
+
+  AWAIT_READY(response);
+  ASSERT_EQ(http::statuses[206], response.get().status);
+  EXPECT_EQ("234", response.get().body);
+  EXPECT_SOME_EQ("bytes 2-4/10", response.get().headers.get("Content-Range"));
+
+  // A suffix range beyond the size of the file is truncated.
+  headers["Range"] = "bytes=-20";
+
+  response = http::get(http.process->self(), "get", None(), headers);
+
+  AWAIT_READY(response);
+  ASSERT_EQ(http::statuses[206], response.get().status);
+  EXPECT_EQ("0123456789", response.get().body);
+  EXPECT_SOME_EQ("bytes 0-9/10", response.get().headers.get("Content-Range"));
+
+  // Overlapping ranges are coalesced, leaving a multipart response.
+  headers["Range"] = "bytes=7-, 0-1, 1-2";
+
+  response = http::get(http.process->self(), "get", None(), headers);
+
+  AWAIT_READY(response);
+  ASSERT_EQ(http::statuses[206], response.get().status);
+  ASSERT_SOME(response.get().headers.get("Content-Type"));
+
+  const string type = response.get().headers.get("Content-Type").get();
+  const string prefix = "multipart/byteranges; boundary=";
+  ASSERT_TRUE(strings::startsWith(type, prefix));
+
+  const string boundary = type.substr(prefix.size());
+
+  EXPECT_EQ(
+      "\r\n--" + boundary + "\r\n"
+      "Content-Type: text/plain\r\n"
+      "Content-Range: bytes 0-2/10\r\n"
+      "\r\n"
+      "012"
+      "\r\n--" + boundary + "\r\n"
+      "Content-Type: text/plain\r\n"
+      "Content-Range: bytes 7-9/10\r\n"
+      "\r\n"
+      "789"
+      "\r\n--" + boundary + "--\r\n",
+      response.get().body);
+
+  // A range that can't be satisfied.
+  headers["Range"] = "bytes=10-";
+
+  response = http::get(http.process->self(), "get", None(), headers);
+
+  AWAIT_READY(response);
+  ASSERT_EQ(http::statuses[416], response.get().status);
+  EXPECT_SOME_EQ("bytes */10", response.get().headers.get("Content-Range"));
+
+  // A malformed range is ignored.
+  headers["Range"] = "bytes=4-2";
+
+  response = http::get(http.process->self(), "get", None(), headers);
+
+  AWAIT_READY(response);
+  ASSERT_EQ(http::statuses[200], response.get().status);
+  EXPECT_EQ("0123456789", response.get().body);
+
+  // Asking for too many ranges is ignored as well.
+  headers["Range"] = "bytes=" + strings::join(",", vector<string>(1000, "0-"));
+
+  response = http::get(http.process->self(), "get", None(), headers);
+
+  AWAIT_READY(response);
+  ASSERT_EQ(http::statuses[200], response.get().status);
+  EXPECT_EQ("0123456789", response.get().body);
+
+  // The range is only sent if the file hasn't changed.
+  headers["Range"] = "bytes=2-4";
+  headers["If-Range"] = etag;
+
+  response = http::get(http.process->self(), "get", None(), headers);
+
+  AWAIT_READY(response);
+  ASSERT_EQ(http::statuses[206], response.get().status);
+  EXPECT_EQ("234", response.get().body);
+
+  headers["If-Range"] = "\"stale\"";
+
+  response = http::get(http.process->self(), "get", None(), headers);
+
+  AWAIT_READY(response);
+  ASSERT_EQ(http::statuses[200], response.get().status);
+  EXPECT_EQ("0123456789", response.get().body);
+
+  ASSERT_SOME(os::rm(path.get()));
+}
+
+
 TEST(HTTP, Post)
 {
   Http http;
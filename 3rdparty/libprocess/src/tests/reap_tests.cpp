@@ -3,6 +3,15 @@
 
 #include <sys/wait.h>
 
+#ifdef __linux__
+#include <sys/syscall.h>
+
+// pidfd_open(2) might not be known to the system headers yet.
+#ifndef __NR_pidfd_open
+#define __NR_pidfd_open 434
+#endif
+#endif // __linux__
+
 #include <gtest/gtest.h>
 
 #include <process/clock.hpp>
@@ -177,3 +186,51 @@ TEST(Reap, TerminatedChildProcess)
 
   Clock::resume();
 }
+
+
+// Checks that a child process is reaped as soon as it terminates
+// when pidfds are supported, i.e., without waiting for the reaper's
+// next poll. The clock is paused so that the reaper never polls.
+TEST(Reap, ChildProcessWithoutPolling)
+{
+  ASSERT_TRUE(GTEST_IS_THREADSAFE);
+
+  bool pidfds = false;
+
+#ifdef __linux__
+  int fd = ::syscall(__NR_pidfd_open, ::getpid(), 0);
+  if (fd >= 0) {
+    ::close(fd);
+    pidfds = true;
+  }
+#endif // __linux__
+
+  Clock::pause();
+
+  // The child process sleeps and will be killed by the parent.
+  Try<ProcessTree> tree = Fork(None(),
+                               Exec("sleep 10"))();
+
+  ASSERT_SOME(tree);
+  pid_t child = tree.get();
+
+  Future<Option<int> > status = process::reap(child);
+
+  EXPECT_EQ(0, kill(child, SIGKILL));
+
+  if (!pidfds) {
+    // Without pidfds the child only gets reaped by polling.
+    while (status.isPending()) {
+      Clock::advance(MAX_REAP_INTERVAL());
+      Clock::settle();
+    }
+  }
+
+  AWAIT_READY(status);
+
+  ASSERT_SOME(status.get());
+  ASSERT_TRUE(WIFSIGNALED(status.get().get()));
+  ASSERT_EQ(SIGKILL, WTERMSIG(status.get().get()));
+
+  Clock::resume();
+}
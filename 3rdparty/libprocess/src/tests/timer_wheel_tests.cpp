@@ -0,0 +1,311 @@
+#include <stdint.h>
+
+#include <gtest/gtest.h>
+
+#include <gmock/gmock.h>
+
+#include <list>
+#include <vector>
+
+#include <process/clock.hpp>
+#include <process/future.hpp>
+#include <process/gtest.hpp>
+#include <process/time.hpp>
+#include <process/timer.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/gtest.hpp>
+#include <stout/nothing.hpp>
+
+#include "timer_wheel.hpp"
+
+using namespace process;
+
+using std::list;
+using std::vector;
+
+
+// The wheel turns in ticks of 1ms, and a slot at level 'k' spans
+// 256^k ticks. These durations each place a timer on a different
+// level of the wheel (or beyond it) when the wheel is at the start
+// of a slot of the highest level (see TimerWheelTest::SetUp).
+static const Duration LEVEL0 = Milliseconds(100);
+static const Duration LEVEL1 = Seconds(10);
+static const Duration LEVEL2 = Minutes(10);
+static const Duration LEVEL3 = Hours(10);
+static const Duration DISTANT = Days(60);
+
+
+class TimerWheelTest : public ::testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    Clock::pause();
+
+    // Move the clock to the start of a slot of the highest level, so
+    // that the levels of the timers (and their cascades) don't depend
+    // on the time the test happens to run at.
+    const int64_t span = Milliseconds(int64_t(1) << 32).ns();
+    const int64_t slots = (Clock::now() - Time::epoch()).ns() / span + 1;
+
+    Clock::update(Time::epoch() + Nanoseconds(slots * span));
+
+    start = Clock::now();
+  }
+
+  virtual void TearDown()
+  {
+    Clock::resume();
+  }
+
+  // Returns a timer that expires 'duration' from now. The timer is
+  // canceled with the Clock right away, since the tests add it to
+  // their own wheel.
+  static Timer timer(const Duration& duration)
+  {
+    Timer timer = Clock::timer(duration, []() {});
+    Clock::cancel(timer);
+    return timer;
+  }
+
+  Time start;
+};
+
+
+// Tests that the timers on each of the levels (and beyond) get
+// cascaded down and expire at exactly their timeouts.
+TEST_F(TimerWheelTest, Cascade)
+{
+  TimerWheel wheel;
+
+  vector<Timer> timers;
+  timers.push_back(timer(LEVEL0));
+  timers.push_back(timer(LEVEL1));
+  timers.push_back(timer(LEVEL2));
+  timers.push_back(timer(LEVEL3));
+  timers.push_back(timer(DISTANT));
+  timers.push_back(timer(DISTANT + LEVEL3));
+
+  foreach (const Timer& timer, timers) {
+    wheel.add(timer, start);
+  }
+
+  foreach (const Timer& timer, timers) {
+    const Time timeout = timer.timeout().time();
+
+    // The earliest timeout is never overestimated.
+    Option<Time> next = wheel.next(timeout - Milliseconds(1));
+    ASSERT_SOME(next);
+    EXPECT_LE(next.get(), timeout);
+
+    EXPECT_TRUE(wheel.expire(timeout - Nanoseconds(1)).empty());
+
+    list<Timer> expired = wheel.expire(timeout);
+    ASSERT_EQ(1u, expired.size());
+    EXPECT_EQ(timer, expired.front());
+  }
+
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_NONE(wheel.next(start + DISTANT + LEVEL3));
+}
+
+
+// Tests that turning the wheel across all of its levels at once
+// expires the timers in the order of their timeouts.
+TEST_F(TimerWheelTest, Jump)
+{
+  TimerWheel wheel;
+
+  vector<Timer> timers;
+  timers.push_back(timer(LEVEL0));
+  timers.push_back(timer(LEVEL1));
+  timers.push_back(timer(LEVEL2));
+  timers.push_back(timer(LEVEL3));
+  timers.push_back(timer(DISTANT));
+
+  // Add the timers from the latest to the earliest timeout.
+  for (size_t i = timers.size(); i > 0; i--) {
+    wheel.add(timers[i - 1], start);
+  }
+
+  list<Timer> expired = wheel.expire(start + DISTANT);
+  ASSERT_EQ(timers.size(), expired.size());
+  EXPECT_EQ(timers, vector<Timer>(expired.begin(), expired.end()));
+
+  EXPECT_TRUE(wheel.empty());
+}
+
+
+// Tests that a timer within the current tick only expires once its
+// exact timeout has elapsed, and that the earliest timeout is exact
+// for such timers.
+TEST_F(TimerWheelTest, Due)
+{
+  TimerWheel wheel;
+
+  Timer timer1 = timer(LEVEL1 + Microseconds(500));
+  Timer timer2 = timer(LEVEL1 + Microseconds(800));
+
+  wheel.add(timer1, start);
+  wheel.add(timer2, start);
+
+  // Turn the wheel to the tick of both timers.
+  EXPECT_TRUE(wheel.expire(start + LEVEL1).empty());
+
+  EXPECT_SOME_EQ(timer1.timeout().time(), wheel.next(start + LEVEL1));
+
+  list<Timer> expired = wheel.expire(timer1.timeout().time());
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(timer1, expired.front());
+
+  EXPECT_SOME_EQ(
+      timer2.timeout().time(),
+      wheel.next(timer1.timeout().time()));
+
+  expired = wheel.expire(timer2.timeout().time());
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(timer2, expired.front());
+}
+
+
+// Tests canceling timers before and after they got cascaded, as well
+// as due and distant timers.
+TEST_F(TimerWheelTest, Cancel)
+{
+  TimerWheel wheel;
+
+  Timer timer1 = timer(LEVEL2);
+  Timer timer2 = timer(LEVEL2);
+  Timer timer3 = timer(LEVEL2 + Microseconds(500));
+  Timer timer4 = timer(LEVEL2 + Microseconds(800));
+  Timer timer5 = timer(DISTANT);
+
+  wheel.add(timer1, start);
+  wheel.add(timer2, start);
+  wheel.add(timer3, start);
+  wheel.add(timer4, start);
+  wheel.add(timer5, start);
+
+  // Before the cascade.
+  EXPECT_TRUE(wheel.cancel(timer1));
+  EXPECT_FALSE(wheel.cancel(timer1));
+
+  // Turning the wheel to just before the timeouts cascades the
+  // timers down to the lowest level.
+  EXPECT_TRUE(wheel.expire(start + LEVEL2 - Milliseconds(1)).empty());
+
+  EXPECT_TRUE(wheel.cancel(timer2));
+  EXPECT_FALSE(wheel.cancel(timer2));
+
+  // Now 'timer3' and 'timer4' are due, and a canceled due timer must
+  // not be reported as the earliest timeout anymore.
+  EXPECT_TRUE(wheel.expire(start + LEVEL2).empty());
+  EXPECT_SOME_EQ(timer3.timeout().time(), wheel.next(start + LEVEL2));
+
+  EXPECT_TRUE(wheel.cancel(timer3));
+  EXPECT_SOME_EQ(timer4.timeout().time(), wheel.next(start + LEVEL2));
+
+  list<Timer> expired = wheel.expire(timer4.timeout().time());
+  ASSERT_EQ(1u, expired.size());
+  EXPECT_EQ(timer4, expired.front());
+
+  // Only the distant timer is left.
+  Option<Time> next = wheel.next(timer4.timeout().time());
+  ASSERT_SOME(next);
+  EXPECT_LE(next.get(), timer5.timeout().time());
+
+  EXPECT_TRUE(wheel.cancel(timer5));
+  EXPECT_FALSE(wheel.cancel(timer5));
+
+  EXPECT_TRUE(wheel.empty());
+  EXPECT_NONE(wheel.next(timer4.timeout().time()));
+  EXPECT_TRUE(wheel.expire(start + DISTANT).empty());
+}
+
+
+// Tests that timers with equal timeouts expire together in the order
+// they were created, even when they were placed on different levels.
+TEST_F(TimerWheelTest, EqualTimeouts)
+{
+  TimerWheel wheel;
+
+  Timer timer1 = timer(LEVEL2);
+  wheel.add(timer1, start);
+
+  Clock::advance(LEVEL2 - LEVEL0);
+
+  const Time now = Clock::now();
+
+  Timer timer2 = timer(LEVEL0);
+  Timer timer3 = timer(LEVEL0);
+
+  ASSERT_EQ(timer1.timeout().time(), timer2.timeout().time());
+  ASSERT_EQ(timer1.timeout().time(), timer3.timeout().time());
+
+  wheel.add(timer3, now);
+  wheel.add(timer2, now);
+
+  EXPECT_TRUE(wheel.expire(start + LEVEL2 - Nanoseconds(1)).empty());
+
+  list<Timer> expired = wheel.expire(start + LEVEL2);
+  ASSERT_EQ(3u, expired.size());
+  EXPECT_EQ(timer1, expired.front());
+  expired.pop_front();
+  EXPECT_EQ(timer2, expired.front());
+  expired.pop_front();
+  EXPECT_EQ(timer3, expired.front());
+}
+
+
+// Tests that advancing the (paused) Clock fires the timers on each
+// of the levels of the wheel, and only those that have expired.
+TEST_F(TimerWheelTest, ClockAdvance)
+{
+  Promise<Nothing> promises[6];
+
+  Clock::timer(LEVEL0, [&promises]() { promises[0].set(Nothing()); });
+  Clock::timer(LEVEL1, [&promises]() { promises[1].set(Nothing()); });
+  Clock::timer(LEVEL2, [&promises]() { promises[2].set(Nothing()); });
+  Clock::timer(LEVEL3, [&promises]() { promises[3].set(Nothing()); });
+  Clock::timer(DISTANT, [&promises]() { promises[4].set(Nothing()); });
+
+  Timer canceled =
+    Clock::timer(LEVEL3, [&promises]() { promises[5].set(Nothing()); });
+
+  Clock::advance(LEVEL1);
+
+  AWAIT_READY(promises[0].future());
+  AWAIT_READY(promises[1].future());
+
+  Clock::settle();
+  EXPECT_TRUE(promises[2].future().isPending());
+
+  Clock::update(start + LEVEL2);
+
+  AWAIT_READY(promises[2].future());
+
+  // By now the timers on the highest level have been cascaded down,
+  // and canceling one of them keeps it from firing.
+  Clock::update(start + LEVEL3 - Minutes(1));
+  EXPECT_TRUE(Clock::cancel(canceled));
+
+  Clock::update(start + LEVEL3 - Milliseconds(1));
+  Clock::settle();
+  EXPECT_TRUE(promises[3].future().isPending());
+
+  Clock::advance(Milliseconds(1));
+
+  AWAIT_READY(promises[3].future());
+
+  Clock::settle();
+  EXPECT_TRUE(promises[4].future().isPending());
+
+  Clock::update(start + DISTANT);
+
+  AWAIT_READY(promises[4].future());
+
+  Clock::settle();
+  EXPECT_TRUE(promises[5].future().isPending());
+}
@@ -0,0 +1,350 @@
+#ifndef __PROCESS_TIMER_WHEEL_HPP__
+#define __PROCESS_TIMER_WHEEL_HPP__
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <unordered_map>
+
+#include <process/time.hpp>
+#include <process/timer.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/option.hpp>
+
+namespace process {
+
+// A hierarchical timing wheel (see "Hashed and Hierarchical Timing
+// Wheels" by Varghese and Lauck) which stores the pending timers of
+// the Clock. Adding and canceling a timer is O(1) and expiring timers
+// is O(1) per timer, plus a bounded amount of work per elapsed tick.
+//
+// Time is divided into ticks (see 'resolution'). Each of the LEVELS
+// levels of the wheel has SLOTS slots, where a slot at level 'k' spans
+// SLOTS^k ticks. A timer goes into the lowest level that can hold it
+// given the current tick, and gets "cascaded" into the lower levels
+// as the wheel turns. Timers that expire further out than the highest
+// level can hold are kept aside until they can be placed. Once the
+// tick of a timer has been reached it's kept on a 'due' list until
+// its (exact) timeout has elapsed, so that timers still expire at
+// exactly their timeouts, e.g., when the Clock is paused and advanced.
+//
+// NOTE: This is not thread-safe, the Clock synchronizes all access.
+class TimerWheel
+{
+public:
+  TimerWheel()
+    : current(0),
+      horizon(std::numeric_limits<int64_t>::max()),
+      wheeled(0)
+  {
+    for (int level = 0; level < LEVELS; level++) {
+      counts[level] = 0;
+    }
+  }
+
+  bool empty() const
+  {
+    return locations.empty();
+  }
+
+  // Adds the timer, where 'now' is the time the timer was created.
+  // We turn the wheel up to 'now' first so that the timer is placed
+  // relative to the current time (this is cheap when the wheel has
+  // already been turned, or there are no timers).
+  void add(const Timer& timer, const Time& now)
+  {
+    advance(tick(now));
+
+    Location& location = locations[timer.id];
+    std::list<Timer>* timers = place(timer, &location.level);
+    location.timers = timers;
+    location.timer = timers->insert(timers->end(), timer);
+  }
+
+  // Returns true if the timer was pending (and is now canceled).
+  bool cancel(const Timer& timer)
+  {
+    Locations::iterator location = locations.find(timer.id);
+
+    if (location == locations.end()) {
+      return false;
+    }
+
+    if (location->second.level >= 0) {
+      wheeled--;
+      counts[location->second.level]--;
+    }
+
+    std::list<Timer>* timers = location->second.timers;
+
+    timers->erase(location->second.timer);
+    locations.erase(location);
+
+    // The due timers are those within the current tick, so there are
+    // few enough of them to determine the earliest timeout again. We
+    // must not leave a canceled timeout behind here, since it could
+    // make the (paused) Clock wait for a timer that will never fire.
+    if (timers == &due) {
+      deadline = None();
+      for (std::list<Timer>::const_iterator timer = due.begin();
+           timer != due.end();
+           ++timer) {
+        deadline = earliest(deadline, timer->timeout().time());
+      }
+    }
+
+    // NOTE: Otherwise 'horizon' is left as is, i.e., as a lower bound,
+    // which at most turns the wheel a little earlier than necessary.
+    if (distant.empty()) {
+      horizon = std::numeric_limits<int64_t>::max();
+    }
+
+    return true;
+  }
+
+  // Removes and returns the timers that have expired as of 'now', in
+  // the order of their timeouts (and then of their creation).
+  std::list<Timer> expire(const Time& now)
+  {
+    advance(tick(now));
+
+    std::list<Timer> expired;
+
+    // Since we're walking the due timers anyway, we also determine
+    // the (exact) earliest timeout of the ones that remain.
+    deadline = None();
+
+    std::list<Timer>::iterator it = due.begin();
+    while (it != due.end()) {
+      std::list<Timer>::iterator timer = it++;
+      if (timer->timeout().time() <= now) {
+        locations.erase(timer->id);
+        expired.splice(expired.end(), due, timer);
+      } else {
+        deadline = earliest(deadline, timer->timeout().time());
+      }
+    }
+
+    expired.sort(before);
+
+    return expired;
+  }
+
+  // Returns a lower bound for the earliest timeout of all pending
+  // timers, or None if there are no pending timers. This is exact if
+  // the earliest timeout is not after 'now' (or within its tick).
+  Option<Time> next(const Time& now)
+  {
+    if (empty()) {
+      return None();
+    }
+
+    advance(tick(now));
+
+    Option<Time> result = deadline;
+
+    if (!distant.empty()) {
+      result = earliest(result, time(horizon));
+    }
+
+    // The timers in a slot expire no earlier than the first tick
+    // that the slot spans, which is always after the current tick.
+    for (int level = 0; level < LEVELS; level++) {
+      if (counts[level] == 0) {
+        continue;
+      }
+
+      const int shift = level * BITS;
+
+      for (int64_t offset = 1; offset <= SLOTS; offset++) {
+        int64_t index = (current >> shift) + offset;
+        if (!slots[level][index & MASK].empty()) {
+          result = earliest(result, time(index << shift));
+          break;
+        }
+      }
+    }
+
+    return result;
+  }
+
+private:
+  static const int BITS = 8;
+  static const int64_t SLOTS = 1 << BITS;
+  static const int64_t MASK = SLOTS - 1;
+  static const int LEVELS = 4;
+
+  // NOTE: With a resolution of 1ms the wheel spans about 49 days.
+  static int64_t resolution()
+  {
+    return Milliseconds(1).ns();
+  }
+
+  static int64_t tick(const Time& time)
+  {
+    return std::max(time.duration().ns(), int64_t(0)) / resolution();
+  }
+
+  static Time time(int64_t tick)
+  {
+    return Time::epoch() + Nanoseconds(tick * resolution());
+  }
+
+  static Option<Time> earliest(const Option<Time>& time, const Time& that)
+  {
+    return time.isSome() && time.get() <= that ? time.get() : that;
+  }
+
+  static bool before(const Timer& left, const Timer& right)
+  {
+    if (left.timeout().time() == right.timeout().time()) {
+      return left.id < right.id;
+    }
+    return left.timeout().time() < right.timeout().time();
+  }
+
+  // The list a pending timer is on and where, so that it can be
+  // canceled (and cascaded) in O(1).
+  struct Location
+  {
+    std::list<Timer>* timers;
+    std::list<Timer>::iterator timer;
+    int level; // Or -1 if it's not on the wheel.
+  };
+
+  // NOTE: We use a std::unordered_map rather than a hashmap since
+  // this is on the path of every timer and it's measurably faster.
+  typedef std::unordered_map<uint64_t, Location> Locations;
+
+  // Moves the (pending) timer to the appropriate list.
+  void reinsert(std::list<Timer>* from, std::list<Timer>::iterator timer)
+  {
+    Location& location = locations[timer->id];
+
+    if (location.level >= 0) {
+      wheeled--;
+      counts[location.level]--;
+    }
+
+    std::list<Timer>* timers = place(*timer, &location.level);
+    timers->splice(timers->end(), *from, timer);
+    location.timers = timers;
+  }
+
+  // Returns the list that the timer belongs on given the current
+  // tick and updates the level (and the counts) accordingly.
+  std::list<Timer>* place(const Timer& timer, int* level)
+  {
+    const int64_t expires = tick(timer.timeout().time());
+
+    if (expires <= current) {
+      *level = -1;
+      deadline = earliest(deadline, timer.timeout().time());
+      return &due;
+    }
+
+    const int64_t delta = expires - current;
+
+    for (int k = 0; k < LEVELS; k++) {
+      if (delta < (int64_t(1) << ((k + 1) * BITS))) {
+        *level = k;
+        wheeled++;
+        counts[k]++;
+        return &slots[k][(expires >> (k * BITS)) & MASK];
+      }
+    }
+
+    *level = -1;
+    horizon = std::min(horizon, expires);
+    return &distant;
+  }
+
+  // Turns the wheel up to (and including) the specified tick.
+  void advance(int64_t target)
+  {
+    while (current < target) {
+      if (wheeled == 0) {
+        // Nothing to cascade or expire, jump straight to the target.
+        current = target;
+        break;
+      }
+
+      // Skip over the ticks for which there is nothing to cascade
+      // or expire, i.e., up to just before the next cascade from the
+      // lowest level that has any timers.
+      int level = 0;
+      while (counts[level] == 0) {
+        level++;
+      }
+
+      if (level > 0) {
+        const int shift = level * BITS;
+        const int64_t next = ((current >> shift) + 1) << shift;
+        current = std::min(target, next - 1);
+        if (current == target) {
+          break;
+        }
+      }
+
+      current++;
+
+      // Cascade the slots of the higher levels that we've turned to,
+      // starting with the highest since its timers might end up in
+      // the slot of a lower level that we're about to cascade.
+      for (int k = LEVELS - 1; k > 0; k--) {
+        const int shift = k * BITS;
+        if ((current & ((int64_t(1) << shift) - 1)) == 0) {
+          cascade(&slots[k][(current >> shift) & MASK]);
+        }
+      }
+
+      cascade(&slots[0][current & MASK]);
+    }
+
+    // Now place the distant timers if any of them have come within
+    // range of the wheel.
+    if (horizon - current < (int64_t(1) << (LEVELS * BITS))) {
+      std::list<Timer> timers;
+      timers.splice(timers.end(), distant);
+      horizon = std::numeric_limits<int64_t>::max();
+      cascade(&timers);
+    }
+  }
+
+  void cascade(std::list<Timer>* timers)
+  {
+    std::list<Timer>::iterator it = timers->begin();
+    while (it != timers->end()) {
+      reinsert(timers, it++);
+    }
+  }
+
+  // The last tick that the wheel has been turned to.
+  int64_t current;
+
+  std::list<Timer> slots[LEVELS][SLOTS];
+  std::list<Timer> due;
+  std::list<Timer> distant;
+
+  // The earliest timeout of the due timers (if any), and the earliest
+  // tick of the distant timers (if any), so that 'next' doesn't need
+  // to walk the lists. The latter may be too early after a distant
+  // timer has been canceled.
+  Option<Time> deadline;
+  int64_t horizon;
+
+  // The number of timers on the wheel (i.e., not due or distant),
+  // in total and by level.
+  size_t wheeled;
+  size_t counts[LEVELS];
+
+  // The location of each pending timer, by timer id.
+  Locations locations;
+};
+
+} // namespace process {
+
+#endif // __PROCESS_TIMER_WHEEL_HPP__
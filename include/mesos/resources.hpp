@@ -278,11 +278,22 @@ private:
   // ensure this is warranted.
   bool _contains(const Resource& that) const;
 
+  // Similar to 'operator += (const Resource&)' and 'operator -=
+  // (const Resource&)' but these skip the validity and emptiness
+  // checks, e.g., when 'that' is taken from another Resources.
+  void _add(const Resource& that);
+  void _subtract(const Resource& that);
+
   // Similar to the public 'find', but only for a single Resource
   // object. The target resource may span multiple roles, so this
   // returns Resources.
   Option<Resources> find(const Resource& target) const;
 
+  // NOTE: The resources are kept as protobufs since they're exposed
+  // as such through the iterators and the conversion operators. A
+  // flat representation (e.g., interned names and roles with inline
+  // scalars) would need to be converted back to protobufs whenever
+  // they're accessed, which requires changing those interfaces first.
   google::protobuf::RepeatedPtrField<Resource> resources;
 };
 
@@ -21,7 +21,12 @@
 
 #include <mesos/resources.hpp>
 
+#include <process/http.hpp>
+
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
+#include <stout/jsonify.hpp>
+#include <stout/lambda.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stringify.hpp>
 
@@ -30,6 +35,7 @@
 
 #include "messages/messages.hpp"
 
+using std::string;
 using std::vector;
 
 namespace mesos {
@@ -206,5 +212,241 @@ JSON::Object model(
 }
 
 
+// Returns true if there is a later element with the same name, in
+// which case a JSON::Object (as built by 'model') would have
+// overwritten the value for the earlier one.
+template <typename Iterator>
+static bool overwritten(Iterator it, Iterator end)
+{
+  for (Iterator later = it + 1; later != end; ++later) {
+    if (later->name() == it->name()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+void json(JSON::ObjectWriter* writer, const Resources& resources)
+{
+  // Like 'model', always include the cpus, mem and disk.
+  const string names[] = {"cpus", "mem", "disk"};
+  foreach (const string& name, names) {
+    bool found = false;
+    foreach (const Resource& resource, resources) {
+      if (resource.name() == name) {
+        found = true;
+        break;
+      }
+    }
+
+    if (!found) {
+      writer->field(name, 0);
+    }
+  }
+
+  for (Resources::const_iterator it = resources.begin();
+       it != resources.end();
+       ++it) {
+    if (overwritten(it, resources.end())) {
+      continue;
+    }
+
+    switch (it->type()) {
+      case Value::SCALAR:
+        writer->field(it->name(), it->scalar().value());
+        break;
+      case Value::RANGES:
+        writer->field(it->name(), stringify(it->ranges()));
+        break;
+      case Value::SET:
+        writer->field(it->name(), stringify(it->set()));
+        break;
+      default:
+        LOG(FATAL) << "Unexpected Value type: " << it->type();
+    }
+  }
+}
+
+
+void json(JSON::ObjectWriter* writer, const Attributes& attributes)
+{
+  for (Attributes::const_iterator it = attributes.begin();
+       it != attributes.end();
+       ++it) {
+    if (overwritten(it, attributes.end())) {
+      continue;
+    }
+
+    switch (it->type()) {
+      case Value::SCALAR:
+        writer->field(it->name(), it->scalar().value());
+        break;
+      case Value::RANGES:
+        writer->field(it->name(), stringify(it->ranges()));
+        break;
+      case Value::SET:
+        writer->field(it->name(), stringify(it->set()));
+        break;
+      case Value::TEXT:
+        writer->field(it->name(), it->text().value());
+        break;
+      default:
+        LOG(FATAL) << "Unexpected Value type: " << it->type();
+        break;
+    }
+  }
+}
+
+
+static void json(JSON::ObjectWriter* writer, const TaskStatus& status)
+{
+  writer->field("state", TaskState_Name(status.state()));
+  writer->field("timestamp", status.timestamp());
+}
+
+
+static void json(JSON::ObjectWriter* writer, const Labels& labels)
+{
+  // NOTE: The labels are small so we just write them as modeled.
+  writer->field("labels", [&](JSON::ArrayWriter* writer) {
+    foreach (const Label& label, labels.labels()) {
+      writer->element(JSON::Protobuf(label));
+    }
+  });
+}
+
+
+// Writes the fields of the task for which 'selected' holds.
+static void json(
+    JSON::ObjectWriter* writer,
+    const Task& task,
+    const lambda::function<bool(const string&)>& selected)
+{
+  if (selected("id")) {
+    writer->field("id", task.task_id().value());
+  }
+
+  if (selected("name")) {
+    writer->field("name", task.name());
+  }
+
+  if (selected("framework_id")) {
+    writer->field("framework_id", task.framework_id().value());
+  }
+
+  if (selected("executor_id")) {
+    writer->field(
+        "executor_id",
+        task.has_executor_id() ? task.executor_id().value() : "");
+  }
+
+  if (selected("slave_id")) {
+    writer->field("slave_id", task.slave_id().value());
+  }
+
+  if (selected("state")) {
+    writer->field("state", TaskState_Name(task.state()));
+  }
+
+  if (selected("resources")) {
+    writer->field("resources", [&](JSON::ObjectWriter* writer) {
+      json(writer, Resources(task.resources()));
+    });
+  }
+
+  if (selected("statuses")) {
+    writer->field("statuses", [&](JSON::ArrayWriter* writer) {
+      foreach (const TaskStatus& status, task.statuses()) {
+        writer->element([&](JSON::ObjectWriter* writer) {
+          json(writer, status);
+        });
+      }
+    });
+  }
+
+  if (selected("labels")) {
+    json(writer, task.labels());
+  }
+
+  if (selected("discovery") && task.has_discovery()) {
+    writer->field("discovery", JSON::Protobuf(task.discovery()));
+  }
+}
+
+
+void json(JSON::ObjectWriter* writer, const Task& task)
+{
+  json(writer, task, [](const string&) { return true; });
+}
+
+
+void json(
+    JSON::ObjectWriter* writer,
+    const Task& task,
+    const hashset<string>& fields)
+{
+  json(writer, task, [&](const string& field) {
+    return fields.contains(field);
+  });
+}
+
+
+void json(
+    JSON::ObjectWriter* writer,
+    const TaskInfo& task,
+    const FrameworkID& frameworkId,
+    const TaskState& state,
+    const vector<TaskStatus>& statuses)
+{
+  writer->field("id", task.task_id().value());
+  writer->field("name", task.name());
+  writer->field("framework_id", frameworkId.value());
+  writer->field(
+      "executor_id",
+      task.has_executor() ? task.executor().executor_id().value() : "");
+  writer->field("slave_id", task.slave_id().value());
+  writer->field("state", TaskState_Name(state));
+
+  writer->field("resources", [&](JSON::ObjectWriter* writer) {
+    json(writer, Resources(task.resources()));
+  });
+
+  writer->field("statuses", [&](JSON::ArrayWriter* writer) {
+    foreach (const TaskStatus& status, statuses) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        json(writer, status);
+      });
+    }
+  });
+
+  json(writer, task.labels());
+
+  if (task.has_discovery()) {
+    writer->field("discovery", JSON::Protobuf(task.discovery()));
+  }
+}
+
+
+process::http::Response jsonResponse(
+    const string& json,
+    const Option<string>& jsonp)
+{
+  process::http::OK response;
+  response.headers["Content-Type"] = "application/json";
+
+  if (jsonp.isSome()) {
+    response.headers["Content-Type"] = "text/javascript";
+    response.body = jsonp.get() + "(" + json + ");";
+  } else {
+    response.body = json;
+  }
+
+  response.headers["Content-Length"] = stringify(response.body.size());
+
+  return response;
+}
+
+
 }  // namespace internal {
 }  // namespace mesos {
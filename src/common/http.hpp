@@ -19,11 +19,17 @@
 #ifndef __COMMON_HTTP_HPP__
 #define __COMMON_HTTP_HPP__
 
+#include <string>
 #include <vector>
 
 #include <mesos/mesos.hpp>
 
+#include <process/http.hpp>
+
+#include <stout/hashset.hpp>
 #include <stout/json.hpp>
+#include <stout/jsonify.hpp>
+#include <stout/option.hpp>
 
 namespace mesos {
 
@@ -47,6 +53,35 @@ JSON::Object model(
     const TaskState& state,
     const std::vector<TaskStatus>& statuses);
 
+
+// These write the same JSON as the corresponding 'model' functions
+// above but directly into the writer, which avoids building (and
+// then stringifying) a JSON::Object for every task of a large state.
+void json(JSON::ObjectWriter* writer, const Resources& resources);
+void json(JSON::ObjectWriter* writer, const Attributes& attributes);
+void json(JSON::ObjectWriter* writer, const Task& task);
+void json(
+    JSON::ObjectWriter* writer,
+    const TaskInfo& task,
+    const FrameworkID& frameworkId,
+    const TaskState& state,
+    const std::vector<TaskStatus>& statuses);
+
+// Writes only the given (top-level) fields of the task, e.g., 'id'
+// and 'state', skipping the (costly) rest.
+void json(
+    JSON::ObjectWriter* writer,
+    const Task& task,
+    const hashset<std::string>& fields);
+
+
+// Returns a '200 OK' response for the already stringified JSON (e.g.,
+// see JSON::jsonify), wrapped in the JSONP callback if provided. This
+// is the equivalent of process::http::OK(JSON::Value, Option<string>).
+process::http::Response jsonResponse(
+    const std::string& json,
+    const Option<std::string>& jsonp);
+
 } // namespace internal {
 } // namespace mesos {
 
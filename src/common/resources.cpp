@@ -110,8 +110,9 @@ bool operator != (const Resource& left, const Resource& right)
 // namespaces (e.g., across slave). Consider adding a warning.
 static bool addable(const Resource& left, const Resource& right)
 {
-  return left.name() == right.name() &&
-    left.type() == right.type() &&
+  // NOTE: We compare the type first since it's the cheapest.
+  return left.type() == right.type() &&
+    left.name() == right.name() &&
     left.role() == right.role() &&
     !left.disk().has_persistence() &&
     !right.disk().has_persistence();
@@ -130,8 +131,8 @@ static bool addable(const Resource& left, const Resource& right)
 // subtraction if they are equal.
 static bool subtractable(const Resource& left, const Resource& right)
 {
-  if (left.name() != right.name() ||
-      left.type() != right.type() ||
+  if (left.type() != right.type() ||
+      left.name() != right.name() ||
       left.role() != right.role()) {
     return false;
   }
@@ -458,17 +459,41 @@ Resources::Resources(
 
 bool Resources::contains(const Resources& that) const
 {
+  // Since the Resource objects within Resources can't be added
+  // together, each of the Resource objects in 'that' can be
+  // subtracted from at most one of ours, unless it has DiskInfo
+  // (e.g., the same persistent volume might be in 'that' twice). In
+  // the common case we thus don't need to keep track of what remains
+  // and can avoid copying these Resources.
+  bool disk = false;
+  foreach (const Resource& resource, that.resources) {
+    if (resource.has_disk()) {
+      disk = true;
+      break;
+    }
+  }
+
+  if (!disk) {
+    foreach (const Resource& resource, that.resources) {
+      if (!_contains(resource)) {
+        return false;
+      }
+    }
+
+    return true;
+  }
+
   Resources remaining = *this;
 
   foreach (const Resource& resource, that.resources) {
-    // NOTE: We use _contains because Resources only contain valid
-    // Resource objects, and we don't want the performance hit of the
-    // validity check.
+    // NOTE: We use _contains and _subtract because Resources only
+    // contain valid Resource objects, and we don't want the
+    // performance hit of the validity check.
     if (!remaining._contains(resource)) {
       return false;
     }
 
-    remaining -= resource;
+    remaining._subtract(resource);
   }
 
   return true;
@@ -490,7 +515,7 @@ Resources Resources::filter(
   Resources result;
   foreach (const Resource& resource, resources) {
     if (predicate(resource)) {
-      result += resource;
+      result._add(resource);
     }
   }
   return result;
@@ -503,7 +528,7 @@ hashmap<string, Resources> Resources::reserved() const
 
   foreach (const Resource& resource, resources) {
     if (isReserved(resource)) {
-      result[resource.role()] += resource;
+      result[resource.role()]._add(resource);
     }
   }
 
@@ -511,15 +536,31 @@ hashmap<string, Resources> Resources::reserved() const
 }
 
 
+// NOTE: We don't use 'filter' for the following since these are
+// called for every slave in each allocation and constructing a
+// lambda::function for the predicate is comparatively expensive.
+
 Resources Resources::reserved(const string& role) const
 {
-  return filter(lambda::bind(isReserved, lambda::_1, role));
+  Resources result;
+  foreach (const Resource& resource, resources) {
+    if (isReserved(resource, role)) {
+      result._add(resource);
+    }
+  }
+  return result;
 }
 
 
 Resources Resources::unreserved() const
 {
-  return filter(isUnreserved);
+  Resources result;
+  foreach (const Resource& resource, resources) {
+    if (isUnreserved(resource)) {
+      result._add(resource);
+    }
+  }
+  return result;
 }
 
 
@@ -823,6 +864,44 @@ bool Resources::_contains(const Resource& that) const
 }
 
 
+void Resources::_add(const Resource& that)
+{
+  foreach (Resource& resource, resources) {
+    if (addable(resource, that)) {
+      resource += that;
+      return;
+    }
+  }
+
+  // Cannot be combined with any existing Resource object.
+  resources.Add()->CopyFrom(that);
+}
+
+
+void Resources::_subtract(const Resource& that)
+{
+  for (int i = 0; i < resources.size(); i++) {
+    Resource* resource = resources.Mutable(i);
+
+    if (subtractable(*resource, that)) {
+      *resource -= that;
+
+      // Remove the resource if it becomes zero or negative. Note
+      // that subtracting a valid range or set always leaves a valid
+      // range or set, so we only need to check the scalars rather
+      // than validating the whole resource.
+      if (isEmpty(*resource) ||
+          (resource->type() == Value::SCALAR &&
+           resource->scalar().value() < 0)) {
+        resources.DeleteSubrange(i, 1);
+      }
+
+      break;
+    }
+  }
+}
+
+
 /////////////////////////////////////////////////
 // Overloaded operators.
 /////////////////////////////////////////////////
@@ -865,19 +944,7 @@ Resources Resources::operator + (const Resources& that) const
 Resources& Resources::operator += (const Resource& that)
 {
   if (validate(that).isNone() && !isEmpty(that)) {
-    bool found = false;
-    foreach (Resource& resource, resources) {
-      if (addable(resource, that)) {
-        resource += that;
-        found = true;
-        break;
-      }
-    }
-
-    // Cannot be combined with any existing Resource object.
-    if (!found) {
-      resources.Add()->CopyFrom(that);
-    }
+    _add(that);
   }
 
   return *this;
@@ -886,8 +953,10 @@ Resources& Resources::operator += (const Resource& that)
 
 Resources& Resources::operator += (const Resources& that)
 {
+  // NOTE: We use _add because Resources only contain valid and
+  // non-empty Resource objects (see above).
   foreach (const Resource& resource, that.resources) {
-    *this += resource;
+    _add(resource);
   }
 
   return *this;
@@ -913,22 +982,7 @@ Resources Resources::operator - (const Resources& that) const
 Resources& Resources::operator -= (const Resource& that)
 {
   if (validate(that).isNone() && !isEmpty(that)) {
-    for (int i = 0; i < resources.size(); i++) {
-      Resource* resource = resources.Mutable(i);
-
-      if (subtractable(*resource, that)) {
-        *resource -= that;
-
-        // Remove the resource if it becomes invalid or zero. We need
-        // to do the validation because we want to strip negative
-        // scalar Resource object.
-        if (validate(*resource).isSome() || isEmpty(*resource)) {
-          resources.DeleteSubrange(i, 1);
-        }
-
-        break;
-      }
-    }
+    _subtract(that);
   }
 
   return *this;
@@ -937,8 +991,10 @@ Resources& Resources::operator -= (const Resource& that)
 
 Resources& Resources::operator -= (const Resources& that)
 {
+  // NOTE: We use _subtract because Resources only contain valid and
+  // non-empty Resource objects (see above).
   foreach (const Resource& resource, that.resources) {
-    *this -= resource;
+    _subtract(resource);
   }
 
   return *this;
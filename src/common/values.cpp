@@ -18,7 +18,10 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <iostream>
+#include <limits>
+#include <utility>
 #include <vector>
 
 #include <glog/logging.h>
@@ -35,6 +38,7 @@
 using std::max;
 using std::min;
 using std::ostream;
+using std::pair;
 using std::string;
 using std::vector;
 
@@ -194,45 +198,41 @@ static void add(Value::Ranges* result, int64_t begin, int64_t end)
 } // namespace ranges {
 
 
-// Coalesce the given 'range' into already coalesced 'ranges'.
-static void coalesce(Value::Ranges* ranges, const Value::Range& range)
+// Coalesce the given 'uranges' into 'ranges', neither of which needs
+// to be coalesced already. Rather than merging in one range at a time
+// (which copies all of the ranges for each one) we sort all of the
+// ranges by their beginning and then merge them in a single pass.
+static void coalesce(Value::Ranges* ranges, const Value::Ranges& uranges)
 {
-  // Note that we assume that ranges has already been coalesced.
-
-  Value::Ranges result;
-  Value::Range temp = range;
+  vector<pair<uint64_t, uint64_t> > sorted;
+  sorted.reserve(ranges->range_size() + uranges.range_size());
 
-  for (int i = 0; i < ranges->range_size(); i++) {
-    const Value::Range& current = ranges->range(i);
+  foreach (const Value::Range& range, ranges->range()) {
+    sorted.push_back(std::make_pair(range.begin(), range.end()));
+  }
 
-    // Check if current and range overlap. Note, we only need to
-    // compare with range and not with temp to check for overlap
-    // because we expect ranges to be coalesced to begin with!
-    if (current.begin() <= range.end() + 1 &&
-        current.end() >= range.begin() - 1) {
-      // current:   |   |
-      // range:       |   |
-      // range:   |   |
-      // Update temp with new boundaries.
-      temp.set_begin(min(temp.begin(), min(range.begin(), current.begin())));
-      temp.set_end(max(temp.end(), max(range.end(), current.end())));
-    } else { // No overlap.
-      result.add_range()->MergeFrom(current);
-    }
+  foreach (const Value::Range& range, uranges.range()) {
+    sorted.push_back(std::make_pair(range.begin(), range.end()));
   }
 
-  result.add_range()->MergeFrom(temp);
-  *ranges = result;
-}
+  std::sort(sorted.begin(), sorted.end());
 
+  ranges->clear_range();
 
-// Coalesce the given un-coalesced 'uranges' into already coalesced 'ranges'.
-static void coalesce(Value::Ranges* ranges, const Value::Ranges& uranges)
-{
-  // Note that we assume that ranges has already been coalesced.
+  Value::Range* current = NULL;
 
-  for (int i = 0; i < uranges.range_size(); i++) {
-    coalesce(ranges, uranges.range(i));
+  for (size_t i = 0; i < sorted.size(); i++) {
+    // Merge the range into the current one if they overlap or are
+    // adjacent, being careful not to overflow.
+    if (current != NULL &&
+        (current->end() == std::numeric_limits<uint64_t>::max() ||
+         sorted[i].first <= current->end() + 1)) {
+      current->set_end(max(current->end(), sorted[i].second));
+    } else {
+      current = ranges->add_range();
+      current->set_begin(sorted[i].first);
+      current->set_end(sorted[i].second);
+    }
   }
 }
 
@@ -392,14 +392,7 @@ Value::Ranges operator - (const Value::Ranges& left, const Value::Ranges& right)
 
 Value::Ranges& operator += (Value::Ranges& left, const Value::Ranges& right)
 {
-  Value::Ranges temp;
-
-  coalesce(&temp, left);
-
-  left = temp;
-
   coalesce(&left, right);
-
   return left;
 }
 
@@ -0,0 +1,901 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <process/collect.hpp>
+#include <process/defer.hpp>
+#include <process/delay.hpp>
+#include <process/dispatch.hpp>
+#include <process/id.hpp>
+#include <process/network.hpp>
+#include <process/process.hpp>
+#include <process/socket.hpp>
+
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/lambda.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "docker/engine.hpp"
+
+using namespace process;
+
+using process::network::Socket;
+
+using std::list;
+using std::string;
+using std::vector;
+
+// Maximum number of idle connections to the daemon that are kept
+// around to be reused by later requests.
+static const size_t MAX_IDLE_CONNECTIONS = 8;
+
+// Time to wait before subscribing to the daemon's events again after
+// the event stream broke (or couldn't be set up).
+static const Duration EVENTS_RETRY_INTERVAL = Seconds(1);
+
+
+Future<Owned<DockerEngineProcess::Connection> > DockerEngineProcess::connect(
+    const string& socket)
+{
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+
+  if (socket.size() >= sizeof(address.sun_path)) {
+    return Failure("Socket path '" + socket + "' is too long");
+  }
+
+  strncpy(address.sun_path, socket.c_str(), sizeof(address.sun_path) - 1);
+
+  Try<int> s = network::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (s.isError()) {
+    return Failure("Failed to create socket: " + s.error());
+  }
+
+  Try<Nothing> nonblock = os::nonblock(s.get());
+  if (nonblock.isError()) {
+    os::close(s.get());
+    return Failure("Failed to create socket, nonblock: " + nonblock.error());
+  }
+
+  Try<Nothing> cloexec = os::cloexec(s.get());
+  if (cloexec.isError()) {
+    os::close(s.get());
+    return Failure("Failed to create socket, cloexec: " + cloexec.error());
+  }
+
+  // NOTE: Connecting a unix socket completes (or fails) immediately,
+  // even if the socket is non-blocking.
+  if (::connect(s.get(), (struct sockaddr*) &address, sizeof(address)) < 0) {
+    ErrnoError error("Failed to connect to '" + socket + "'");
+    os::close(s.get());
+    return Failure(error.message);
+  }
+
+  Try<Socket> connected = Socket::create(Socket::DEFAULT_KIND(), s.get());
+  if (connected.isError()) {
+    os::close(s.get());
+    return Failure("Failed to create socket: " + connected.error());
+  }
+
+  return Owned<Connection>(new Connection(connected.get()));
+}
+
+
+// Parses the status line and headers at the front of 'buffer'.
+// Returns None if they haven't been received completely yet,
+// otherwise removes them from 'buffer'.
+Try<Option<DockerEngineProcess::Response> > DockerEngineProcess::parse(
+    string* buffer)
+{
+  size_t end = buffer->find("\r\n\r\n");
+  if (end == string::npos) {
+    return None();
+  }
+
+  vector<string> lines = strings::tokenize(buffer->substr(0, end), "\r\n");
+  if (lines.empty()) {
+    return Error("Missing status line");
+  }
+
+  // For example: 'HTTP/1.1 200 OK'.
+  vector<string> status = strings::tokenize(lines[0], " ");
+  if (status.size() < 2 || !strings::startsWith(status[0], "HTTP/")) {
+    return Error("Malformed status line '" + lines[0] + "'");
+  }
+
+  Try<int> code = numify<int>(status[1]);
+  if (code.isError()) {
+    return Error("Malformed status code '" + status[1] + "'");
+  }
+
+  Response response;
+  response.code = code.get();
+
+  for (size_t i = 1; i < lines.size(); i++) {
+    size_t colon = lines[i].find(':');
+    if (colon == string::npos) {
+      return Error("Malformed header '" + lines[i] + "'");
+    }
+
+    const string name = strings::trim(lines[i].substr(0, colon));
+    const string value = strings::trim(lines[i].substr(colon + 1));
+
+    response.headers[strings::lower(name)] = value;
+  }
+
+  buffer->erase(0, end + 4);
+
+  return response;
+}
+
+
+// Decodes the chunk at the front of 'buffer' of a body that uses
+// 'Transfer-Encoding: chunked'. Returns None if the chunk hasn't been
+// received completely yet, otherwise removes it from 'buffer' and
+// returns its data, which is empty for the last chunk.
+// NOTE: Trailers after the last chunk are not supported, the daemon
+// doesn't send any.
+Try<Option<string> > DockerEngineProcess::decode(string* buffer)
+{
+  size_t end = buffer->find("\r\n");
+  if (end == string::npos) {
+    return None();
+  }
+
+  // The size is in hex and may be followed by chunk extensions.
+  const string line = buffer->substr(0, end);
+  const string hex = strings::trim(line.substr(0, line.find(';')));
+
+  char* last = NULL;
+  size_t size = ::strtoul(hex.c_str(), &last, 16);
+  if (hex.empty() || *last != '\0') {
+    return Error("Malformed chunk size '" + line + "'");
+  }
+
+  if (buffer->size() < end + 2 + size + 2) {
+    return None();
+  }
+
+  if (buffer->compare(end + 2 + size, 2, "\r\n") != 0) {
+    return Error("Missing CRLF after chunk");
+  }
+
+  const string data = buffer->substr(end + 2, size);
+  buffer->erase(0, end + 2 + size + 2);
+
+  return data;
+}
+
+
+// Decodes the body at the front of 'buffer' of the response with the
+// specified head. Returns None if the body hasn't been received
+// completely yet (which for a body that is delimited by closing the
+// connection is until EOF), otherwise removes it from 'buffer'.
+Try<Option<string> > DockerEngineProcess::decode(
+    const Response& head,
+    string* buffer)
+{
+  if ((head.code >= 100 && head.code < 200) ||
+      head.code == 204 ||
+      head.code == 304) {
+    return string();
+  }
+
+  Option<string> encoding = head.headers.get("transfer-encoding");
+  if (encoding.isSome() && strings::lower(encoding.get()) == "chunked") {
+    // Only consume the chunks once all of them have been received.
+    string chunks = *buffer;
+    string body;
+
+    while (true) {
+      Try<Option<string> > chunk = decode(&chunks);
+      if (chunk.isError()) {
+        return Error(chunk.error());
+      } else if (chunk.get().isNone()) {
+        return None();
+      } else if (chunk.get().get().empty()) {
+        *buffer = chunks;
+        return body;
+      }
+
+      body += chunk.get().get();
+    }
+  }
+
+  Option<string> length = head.headers.get("content-length");
+  if (length.isSome()) {
+    Try<size_t> size = numify<size_t>(length.get());
+    if (size.isError()) {
+      return Error("Malformed content length '" + length.get() + "'");
+    } else if (buffer->size() < size.get()) {
+      return None();
+    }
+
+    const string body = buffer->substr(0, size.get());
+    buffer->erase(0, size.get());
+
+    return body;
+  }
+
+  return None();
+}
+
+
+template <typename T>
+Future<T> DockerEngineProcess::failure(
+    const string& request,
+    const Response& response)
+{
+  return Failure(
+      "Failed to '" + request + "': status = " + stringify(response.code) +
+      " body = " + strings::trim(response.body));
+}
+
+
+void DockerEngineProcess::initialize()
+{
+  subscribe();
+}
+
+
+void DockerEngineProcess::finalize()
+{
+  if (receiving.isSome()) {
+    Future<string> future = receiving.get();
+    future.discard();
+  }
+}
+
+
+Future<DockerEngineProcess::Response> DockerEngineProcess::request(
+    const string& method,
+    const string& path)
+{
+  // NOTE: Container names and IDs don't need to be escaped in 'path'.
+  string request = method + " " + path + " HTTP/1.1\r\n";
+  request += "Host: docker\r\n";
+
+  if (method != "GET") {
+    request += "Content-Length: 0\r\n";
+  }
+
+  request += "\r\n";
+
+  VLOG(1) << "Requesting '" << method << " " << path << "' from the "
+          << "Docker daemon at '" << socket << "'";
+
+  if (connections.empty()) {
+    return connect(socket)
+      .then(defer(self(), &Self::_request, lambda::_1, request, false));
+  }
+
+  Owned<Connection> connection = connections.front();
+  connections.pop_front();
+
+  return _request(connection, request, true);
+}
+
+
+Future<DockerEngineProcess::Response> DockerEngineProcess::_request(
+    const Owned<Connection>& connection,
+    const string& request,
+    bool reused)
+{
+  connection->received = false;
+
+  Future<Response> response = connection->socket.send(request)
+    .then(defer(self(), &Self::receive, connection))
+    .then(defer(self(), &Self::body, connection, lambda::_1));
+
+  if (!reused) {
+    return response;
+  }
+
+  // The daemon may have closed the idle connection by now, in which
+  // case the request is sent again on a new connection.
+  return response
+    .repair(defer(self(), &Self::__request, request, connection, lambda::_1));
+}
+
+
+Future<DockerEngineProcess::Response> DockerEngineProcess::__request(
+    const string& request,
+    const Owned<Connection>& connection,
+    const Future<Response>& response)
+{
+  if (connection->received) {
+    return response;
+  }
+
+  return connect(socket)
+    .then(defer(self(), &Self::_request, lambda::_1, request, false));
+}
+
+
+Future<DockerEngineProcess::Response> DockerEngineProcess::receive(
+    const Owned<Connection>& connection)
+{
+  Try<Option<Response> > head = parse(&connection->buffer);
+  if (head.isError()) {
+    return Failure("Failed to parse response: " + head.error());
+  } else if (head.get().isSome()) {
+    return head.get().get();
+  }
+
+  return connection->socket.recv(None())
+    .then(defer(self(), &Self::_receive, connection, lambda::_1));
+}
+
+
+Future<DockerEngineProcess::Response> DockerEngineProcess::_receive(
+    const Owned<Connection>& connection,
+    const string& data)
+{
+  if (data.empty()) {
+    return Failure("Connection closed by the Docker daemon");
+  }
+
+  connection->received = true;
+  connection->buffer += data;
+
+  return receive(connection);
+}
+
+
+Future<DockerEngineProcess::Response> DockerEngineProcess::body(
+    const Owned<Connection>& connection,
+    const Response& head)
+{
+  Try<Option<string> > body = decode(head, &connection->buffer);
+  if (body.isError()) {
+    return Failure("Failed to decode response: " + body.error());
+  } else if (body.get().isSome()) {
+    Response response = head;
+    response.body = body.get().get();
+    release(connection, response);
+    return response;
+  }
+
+  return connection->socket.recv(None())
+    .then(defer(self(), &Self::_body, connection, head, lambda::_1));
+}
+
+
+Future<DockerEngineProcess::Response> DockerEngineProcess::_body(
+    const Owned<Connection>& connection,
+    const Response& head,
+    const string& data)
+{
+  if (data.empty()) {
+    // The body is delimited by EOF unless its length is known.
+    if (head.headers.contains("transfer-encoding") ||
+        head.headers.contains("content-length")) {
+      return Failure("Connection closed by the Docker daemon");
+    }
+
+    Response response = head;
+    response.body = connection->buffer;
+    return response;
+  }
+
+  connection->buffer += data;
+
+  return body(connection, head);
+}
+
+
+void DockerEngineProcess::release(
+    const Owned<Connection>& connection,
+    const Response& response)
+{
+  Option<string> close = response.headers.get("connection");
+  if (close.isSome() && strings::lower(close.get()) == "close") {
+    return;
+  }
+
+  if (connection->buffer.empty() &&
+      connections.size() < MAX_IDLE_CONNECTIONS) {
+    connections.push_back(connection);
+  }
+}
+
+
+Future<string> DockerEngineProcess::version()
+{
+  return request("GET", "/version")
+    .then(defer(self(), &Self::_version, lambda::_1));
+}
+
+
+Future<string> DockerEngineProcess::_version(const Response& response)
+{
+  if (response.code != 200) {
+    return failure<string>("GET /version", response);
+  }
+
+  Try<JSON::Object> json = JSON::parse<JSON::Object>(response.body);
+  if (json.isError()) {
+    return Failure("Failed to parse JSON: " + json.error());
+  }
+
+  Result<JSON::String> version = json.get().find<JSON::String>("Version");
+  if (!version.isSome()) {
+    return Failure("Unable to find Version");
+  }
+
+  return version.get().value;
+}
+
+
+Future<Nothing> DockerEngineProcess::stop(
+    const string& container,
+    const Duration& timeout,
+    bool remove)
+{
+  int timeoutSecs = (int) timeout.secs();
+  if (timeoutSecs < 0) {
+    return Failure("A negative timeout can not be applied to docker stop: " +
+                   stringify(timeoutSecs));
+  }
+
+  return request(
+      "POST",
+      "/containers/" + container + "/stop?t=" + stringify(timeoutSecs))
+    .then(defer(self(), &Self::_stop, container, remove, lambda::_1));
+}
+
+
+Future<Nothing> DockerEngineProcess::_stop(
+    const string& container,
+    bool remove,
+    const Response& response)
+{
+  evict(container);
+
+  // The daemon responds with 304 if the container wasn't running.
+  bool stopped = response.code == 204 || response.code == 304;
+
+  if (remove) {
+    return rm(container, !stopped);
+  } else if (!stopped) {
+    return failure<Nothing>("POST /containers/" + container + "/stop",
+                            response);
+  }
+
+  return Nothing();
+}
+
+
+Future<Nothing> DockerEngineProcess::rm(const string& container, bool force)
+{
+  return request(
+      "DELETE",
+      "/containers/" + container + (force ? "?force=1" : ""))
+    .then(defer(self(), &Self::_rm, container, lambda::_1));
+}
+
+
+Future<Nothing> DockerEngineProcess::_rm(
+    const string& container,
+    const Response& response)
+{
+  evict(container);
+
+  if (response.code != 204) {
+    return failure<Nothing>("DELETE /containers/" + container, response);
+  }
+
+  return Nothing();
+}
+
+
+Future<Docker::Container> DockerEngineProcess::inspect(const string& container)
+{
+  Option<string> id = lookup(container);
+  if (id.isSome()) {
+    return containers.get(id.get()).get();
+  }
+
+  return request("GET", "/containers/" + container + "/json")
+    .then(defer(self(), &Self::_inspect, container, generation, lambda::_1));
+}
+
+
+Future<Docker::Container> DockerEngineProcess::_inspect(
+    const string& container,
+    uint64_t _generation,
+    const Response& response)
+{
+  if (response.code != 200) {
+    return failure<Docker::Container>(
+        "GET /containers/" + container + "/json", response);
+  }
+
+  Try<JSON::Object> json = JSON::parse<JSON::Object>(response.body);
+  if (json.isError()) {
+    return Failure("Failed to parse JSON: " + json.error());
+  }
+
+  Try<Docker::Container> inspected = Docker::Container::create(json.get());
+  if (inspected.isError()) {
+    return Failure("Unable to create container: " + inspected.error());
+  }
+
+  // Only running containers are cached: their pid can't change
+  // without the daemon sending an event for them.
+  if (subscribed &&
+      generation == _generation &&
+      inspected.get().pid.isSome()) {
+    const string& id = inspected.get().id;
+    containers.put(id, inspected.get());
+    ids.put(strings::remove(inspected.get().name, "/", strings::PREFIX), id);
+  }
+
+  return inspected.get();
+}
+
+
+Future<list<Docker::Container> > DockerEngineProcess::ps(
+    bool all,
+    const Option<string>& prefix)
+{
+  return request("GET", string("/containers/json") + (all ? "?all=1" : ""))
+    .then(defer(self(), &Self::_ps, prefix, lambda::_1));
+}
+
+
+Future<list<Docker::Container> > DockerEngineProcess::_ps(
+    const Option<string>& prefix,
+    const Response& response)
+{
+  if (response.code != 200) {
+    return failure<list<Docker::Container> >("GET /containers/json", response);
+  }
+
+  Try<JSON::Array> json = JSON::parse<JSON::Array>(response.body);
+  if (json.isError()) {
+    return Failure("Failed to parse JSON: " + json.error());
+  }
+
+  list<Future<Docker::Container> > futures;
+
+  foreach (const JSON::Value& value, json.get().values) {
+    if (!value.is<JSON::Object>()) {
+      return Failure("Expecting an array of objects");
+    }
+
+    const JSON::Object& object = value.as<JSON::Object>();
+
+    Result<JSON::String> id = object.find<JSON::String>("Id");
+    if (!id.isSome()) {
+      return Failure("Unable to find Id in container");
+    }
+
+    // Like with the CLI, the first name is matched against 'prefix'.
+    Result<JSON::String> name = object.find<JSON::String>("Names[0]");
+    if (!name.isSome()) {
+      return Failure("Unable to find Names in container");
+    }
+
+    if (prefix.isNone() ||
+        strings::startsWith(
+            strings::remove(name.get().value, "/", strings::PREFIX),
+            prefix.get())) {
+      futures.push_back(inspect(id.get().value));
+    }
+  }
+
+  return collect(futures);
+}
+
+
+void DockerEngineProcess::subscribe()
+{
+  connect(socket)
+    .then(defer(self(), &Self::_subscribe, lambda::_1))
+    .onAny(defer(self(), &Self::___subscribe, lambda::_1));
+}
+
+
+Future<Nothing> DockerEngineProcess::_subscribe(
+    const Owned<Connection>& connection)
+{
+  const string request = "GET /events HTTP/1.1\r\nHost: docker\r\n\r\n";
+
+  return connection->socket.send(request)
+    .then(defer(self(), &Self::receive, connection))
+    .then(defer(self(), &Self::__subscribe, connection, lambda::_1));
+}
+
+
+Future<Nothing> DockerEngineProcess::__subscribe(
+    const Owned<Connection>& connection,
+    const Response& response)
+{
+  if (response.code != 200) {
+    return failure<Nothing>("GET /events", response);
+  }
+
+  Option<string> encoding = response.headers.get("transfer-encoding");
+  if (encoding.isNone() || strings::lower(encoding.get()) != "chunked") {
+    return Failure("Expecting a chunked event stream");
+  }
+
+  VLOG(1) << "Subscribed to events of the Docker daemon at '"
+          << socket << "'";
+
+  // An inspect that started before the subscription might have
+  // missed an event for its container, so it must not be cached.
+  subscribed = true;
+  pending.clear();
+  generation++;
+
+  events(connection);
+
+  return Nothing();
+}
+
+
+void DockerEngineProcess::___subscribe(const Future<Nothing>& future)
+{
+  if (!future.isReady()) {
+    unsubscribe(future.isFailed() ? future.failure() : "discarded");
+  }
+}
+
+
+void DockerEngineProcess::events(const Owned<Connection>& connection)
+{
+  // NOTE: We don't chain the receives since the event stream never
+  // ends and the chain of futures would grow with every event.
+  receiving = connection->socket.recv(None());
+
+  receiving.get()
+    .onAny(defer(self(), &Self::_events, connection, lambda::_1));
+}
+
+
+void DockerEngineProcess::_events(
+    const Owned<Connection>& connection,
+    const Future<string>& data)
+{
+  receiving = None();
+
+  if (!data.isReady()) {
+    unsubscribe(data.isFailed() ? data.failure() : "discarded");
+    return;
+  } else if (data.get().empty()) {
+    unsubscribe("Connection closed by the Docker daemon");
+    return;
+  }
+
+  connection->buffer += data.get();
+
+  while (true) {
+    Try<Option<string> > chunk = decode(&connection->buffer);
+    if (chunk.isError()) {
+      unsubscribe("Failed to decode events: " + chunk.error());
+      return;
+    } else if (chunk.get().isNone()) {
+      break;
+    } else if (chunk.get().get().empty()) {
+      unsubscribe("Event stream ended");
+      return;
+    }
+
+    pending += chunk.get().get();
+  }
+
+  size_t newline;
+  while ((newline = pending.find('\n')) != string::npos) {
+    const string line = strings::trim(pending.substr(0, newline));
+    pending.erase(0, newline + 1);
+
+    if (!line.empty()) {
+      event(line);
+    }
+  }
+
+  events(connection);
+}
+
+
+void DockerEngineProcess::event(const string& line)
+{
+  Try<JSON::Object> json = JSON::parse<JSON::Object>(line);
+  if (json.isError()) {
+    LOG(WARNING) << "Failed to parse event from the Docker daemon at '"
+                 << socket << "': " << json.error();
+    return;
+  }
+
+  Result<JSON::String> status = json.get().find<JSON::String>("status");
+  Result<JSON::String> id = json.get().find<JSON::String>("id");
+
+  if (!status.isSome() || !id.isSome()) {
+    return;
+  }
+
+  // These are the events after which the pid of a container is
+  // different (or gone).
+  if (status.get().value == "start" ||
+      status.get().value == "restart" ||
+      status.get().value == "die" ||
+      status.get().value == "destroy") {
+    VLOG(1) << "Docker container '" << id.get().value << "' received event '"
+            << status.get().value << "'";
+
+    evict(id.get().value);
+  }
+}
+
+
+void DockerEngineProcess::unsubscribe(const string& message)
+{
+  if (subscribed) {
+    LOG(WARNING) << "Lost the event stream of the Docker daemon at '"
+                 << socket << "': " << message;
+  } else {
+    VLOG(1) << "Failed to subscribe to events of the Docker daemon at '"
+            << socket << "': " << message;
+  }
+
+  // Without events the cached containers can't be trusted anymore.
+  subscribed = false;
+  containers.clear();
+  ids.clear();
+  generation++;
+
+  delay(EVENTS_RETRY_INTERVAL, self(), &Self::subscribe);
+}
+
+
+Option<string> DockerEngineProcess::lookup(const string& container)
+{
+  if (containers.contains(container)) {
+    return container;
+  }
+
+  return ids.get(strings::remove(container, "/", strings::PREFIX));
+}
+
+
+void DockerEngineProcess::evict(const string& container)
+{
+  Option<string> id = lookup(container);
+  if (id.isSome()) {
+    ids.erase(strings::remove(
+        containers.get(id.get()).get().name, "/", strings::PREFIX));
+    containers.erase(id.get());
+  }
+
+  generation++;
+}
+
+
+Try<Docker*> DockerEngine::create(
+    const string& path,
+    const string& socket,
+    bool validate)
+{
+  if (validate) {
+    // The docker CLI is still used for 'run', 'logs' and 'pull'.
+    Try<Docker*> docker = Docker::create(path, validate);
+    if (docker.isError()) {
+      return Error(docker.error());
+    }
+
+    delete docker.get();
+  }
+
+  DockerEngine* engine = new DockerEngine(path, socket);
+
+  if (!validate) {
+    return engine;
+  }
+
+  Future<string> version =
+    dispatch(engine->process.get(), &DockerEngineProcess::version);
+
+  if (!version.await(Seconds(5))) {
+    delete engine;
+    return Error("Timed out waiting for the version of the Docker daemon "
+                 "at '" + socket + "'");
+  } else if (version.isFailed()) {
+    delete engine;
+    return Error("Failed to get the version of the Docker daemon at '" +
+                 socket + "': " + version.failure());
+  }
+
+  vector<string> parts = strings::split(version.get(), ".");
+  Try<int> major = numify<int>(parts[0]);
+  if (major.isError()) {
+    delete engine;
+    return Error("Failed to parse Docker major version '" + parts[0] + "'");
+  } else if (major.get() < 1) {
+    delete engine;
+    return Error("Insufficient version of Docker! Please upgrade to >= 1.0.0");
+  }
+
+  return engine;
+}
+
+
+DockerEngine::DockerEngine(const string& path, const string& socket)
+  : Docker(path),
+    process(new DockerEngineProcess(socket))
+{
+  spawn(process.get());
+}
+
+
+DockerEngine::~DockerEngine()
+{
+  terminate(process.get());
+  process::wait(process.get());
+}
+
+
+Future<Nothing> DockerEngine::stop(
+    const string& container,
+    const Duration& timeout,
+    bool remove) const
+{
+  return dispatch(
+      process.get(),
+      &DockerEngineProcess::stop,
+      container,
+      timeout,
+      remove);
+}
+
+
+Future<Nothing> DockerEngine::rm(const string& container, bool force) const
+{
+  return dispatch(process.get(), &DockerEngineProcess::rm, container, force);
+}
+
+
+Future<Docker::Container> DockerEngine::inspect(const string& container) const
+{
+  return dispatch(process.get(), &DockerEngineProcess::inspect, container);
+}
+
+
+Future<list<Docker::Container> > DockerEngine::ps(
+    bool all,
+    const Option<string>& prefix) const
+{
+  return dispatch(process.get(), &DockerEngineProcess::ps, all, prefix);
+}
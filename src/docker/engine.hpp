@@ -0,0 +1,299 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __DOCKER_ENGINE_HPP__
+#define __DOCKER_ENGINE_HPP__
+
+#include <stdint.h>
+
+#include <list>
+#include <string>
+
+#include <process/future.hpp>
+#include <process/id.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+#include <process/socket.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+#include "docker/docker.hpp"
+
+// Forward declaration.
+class DockerEngineProcess;
+
+
+// Abstraction for working with Docker that talks to the Docker
+// daemon's remote API over its unix socket rather than forking the
+// docker CLI for every call.
+//
+// Connections to the daemon are kept alive and reused between
+// requests. The engine also subscribes to the daemon's event stream
+// and caches the containers it has inspected while they are running,
+// so that repeated inspects (e.g., for every resource usage check)
+// don't need to reach the daemon at all. A cached container is
+// dropped when the daemon reports that it died, (re)started or was
+// removed, and the whole cache is dropped whenever the event stream
+// is not connected.
+//
+// Only 'stop', 'rm', 'inspect' and 'ps' go through the remote API;
+// 'run', 'logs' and 'pull' still use the docker CLI at 'path' since
+// they depend on the CLI's handling of the user's docker config and
+// of the log streams.
+class DockerEngine : public Docker
+{
+public:
+  // Create the engine for the daemon listening on the specified unix
+  // socket, and optionally validate both docker and the daemon.
+  static Try<Docker*> create(
+      const std::string& path,
+      const std::string& socket,
+      bool validate = true);
+
+  virtual ~DockerEngine();
+
+  // Performs 'POST /containers/CONTAINER/stop?t=TIMEOUT'. See
+  // Docker::stop for the semantics of 'timeout' and 'remove'.
+  virtual process::Future<Nothing> stop(
+      const std::string& container,
+      const Duration& timeout = Seconds(0),
+      bool remove = false) const;
+
+  // Performs 'DELETE /containers/CONTAINER(?force=1)'.
+  virtual process::Future<Nothing> rm(
+      const std::string& container,
+      bool force = false) const;
+
+  // Performs 'GET /containers/CONTAINER/json', unless the container
+  // is cached.
+  virtual process::Future<Container> inspect(
+      const std::string& container) const;
+
+  // Performs 'GET /containers/json(?all=1)' and inspects the
+  // containers whose names start with 'prefix'.
+  virtual process::Future<std::list<Container> > ps(
+      bool all = false,
+      const Option<std::string>& prefix = None()) const;
+
+private:
+  DockerEngine(const std::string& path, const std::string& socket);
+
+  DockerEngine(const DockerEngine&);
+  DockerEngine& operator = (const DockerEngine&);
+
+  process::Owned<DockerEngineProcess> process;
+};
+
+
+class DockerEngineProcess : public process::Process<DockerEngineProcess>
+{
+public:
+  explicit DockerEngineProcess(const std::string& _socket)
+    : ProcessBase(process::ID::generate("docker-engine")),
+      socket(_socket),
+      subscribed(false),
+      generation(0) {}
+
+  virtual ~DockerEngineProcess() {}
+
+  // DockerEngine implementation.
+  process::Future<std::string> version();
+
+  process::Future<Nothing> stop(
+      const std::string& container,
+      const Duration& timeout,
+      bool remove);
+
+  process::Future<Nothing> rm(const std::string& container, bool force);
+
+  process::Future<Docker::Container> inspect(const std::string& container);
+
+  process::Future<std::list<Docker::Container> > ps(
+      bool all,
+      const Option<std::string>& prefix);
+
+  // A connection to the daemon.
+  struct Connection
+  {
+    explicit Connection(const process::network::Socket& _socket)
+      : socket(_socket), received(false) {}
+
+    process::network::Socket socket;
+
+    // Data received from the daemon that hasn't been parsed yet.
+    std::string buffer;
+
+    // Whether any data has been received for the current request.
+    bool received;
+  };
+
+  // A response from the daemon, with lower case header names.
+  struct Response
+  {
+    int code;
+    hashmap<std::string, std::string> headers;
+    std::string body;
+  };
+
+  // Subscribes to the daemon's events via 'GET /events', which
+  // responds with an endless chunked body of JSON encoded events
+  // separated by newlines.
+  //
+  // NOTE: These are public so that tests can wait for the engine to
+  // be subscribed (i.e., '__subscribe') or to have received events
+  // (i.e., '_events') using FUTURE_DISPATCH.
+  void subscribe();
+
+  process::Future<Nothing> _subscribe(
+      const process::Owned<Connection>& connection);
+
+  process::Future<Nothing> __subscribe(
+      const process::Owned<Connection>& connection,
+      const Response& response);
+
+  void ___subscribe(const process::Future<Nothing>& future);
+
+  void events(const process::Owned<Connection>& connection);
+
+  void _events(
+      const process::Owned<Connection>& connection,
+      const process::Future<std::string>& data);
+
+protected:
+  virtual void initialize();
+  virtual void finalize();
+
+private:
+  static process::Future<process::Owned<Connection> > connect(
+      const std::string& socket);
+
+  static Try<Option<Response> > parse(std::string* buffer);
+  static Try<Option<std::string> > decode(std::string* buffer);
+
+  static Try<Option<std::string> > decode(
+      const Response& head,
+      std::string* buffer);
+
+  template <typename T>
+  static process::Future<T> failure(
+      const std::string& request,
+      const Response& response);
+
+  // Sends the request 'METHOD PATH' (without a body) on an idle
+  // connection, or a new one if there aren't any, and returns the
+  // complete response.
+  process::Future<Response> request(
+      const std::string& method,
+      const std::string& path);
+
+  process::Future<Response> _request(
+      const process::Owned<Connection>& connection,
+      const std::string& request,
+      bool reused);
+
+  process::Future<Response> __request(
+      const std::string& request,
+      const process::Owned<Connection>& connection,
+      const process::Future<Response>& response);
+
+  // Receives the status line and headers of a response.
+  process::Future<Response> receive(
+      const process::Owned<Connection>& connection);
+
+  process::Future<Response> _receive(
+      const process::Owned<Connection>& connection,
+      const std::string& data);
+
+  // Receives the body of the response with the specified head.
+  process::Future<Response> body(
+      const process::Owned<Connection>& connection,
+      const Response& head);
+
+  process::Future<Response> _body(
+      const process::Owned<Connection>& connection,
+      const Response& head,
+      const std::string& data);
+
+  // Makes the connection available to later requests, unless the
+  // daemon is going to close it.
+  void release(
+      const process::Owned<Connection>& connection,
+      const Response& response);
+
+  process::Future<std::string> _version(const Response& response);
+
+  process::Future<Nothing> _stop(
+      const std::string& container,
+      bool remove,
+      const Response& response);
+
+  process::Future<Nothing> _rm(
+      const std::string& container,
+      const Response& response);
+
+  process::Future<Docker::Container> _inspect(
+      const std::string& container,
+      uint64_t generation,
+      const Response& response);
+
+  process::Future<std::list<Docker::Container> > _ps(
+      const Option<std::string>& prefix,
+      const Response& response);
+
+  void event(const std::string& line);
+  void unsubscribe(const std::string& message);
+
+  // Returns the ID of the cached container with the specified ID or
+  // name, if any.
+  Option<std::string> lookup(const std::string& container);
+
+  // Removes the specified container from the cache, and makes sure
+  // that inspects which are currently in progress won't cache it.
+  void evict(const std::string& container);
+
+  const std::string socket;
+
+  // Idle connections to the daemon.
+  std::list<process::Owned<Connection> > connections;
+
+  // Whether we are currently receiving the daemon's events.
+  bool subscribed;
+
+  // The pending receive on the event stream, if any.
+  Option<process::Future<std::string> > receiving;
+
+  // Events received from the daemon that aren't complete yet.
+  std::string pending;
+
+  // Running containers that were inspected while subscribed to the
+  // daemon's events, keyed by ID, and the IDs of these containers
+  // keyed by name (without the leading '/').
+  hashmap<std::string, Docker::Container> containers;
+  hashmap<std::string, std::string> ids;
+
+  // Incremented whenever a container may have changed (or the event
+  // stream was (re)established), so that an inspect that was already
+  // in progress at that time doesn't cache a stale container.
+  uint64_t generation;
+};
+
+#endif // __DOCKER_ENGINE_HPP__
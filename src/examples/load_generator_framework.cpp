@@ -19,15 +19,18 @@
 #include <iostream>
 #include <string>
 
+#include <mesos/resources.hpp>
 #include <mesos/scheduler.hpp>
 
 #include <process/defer.hpp>
 #include <process/process.hpp>
 #include <process/timeout.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/numify.hpp>
 #include <stout/os.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 
 #include "logging/flags.hpp"
@@ -127,13 +130,28 @@ private:
 };
 
 
+// The resources of each task launched to generate status updates.
+const string TASK_RESOURCES = "cpus:0.1;mem:32";
+
+
 // This scheduler does one thing: generating network traffic towards
-// the master.
+// the master. Either by reconciling at the specified rate, or (if
+// 'tasks' is set) by launching short-lived tasks in all the offered
+// resources, to measure the throughput of the acknowledgements of
+// their status updates.
 class LoadGeneratorScheduler : public Scheduler
 {
 public:
-  LoadGeneratorScheduler(double _qps, const Option<Duration>& _duration)
-    : generator(NULL), qps(_qps), duration(_duration) {}
+  LoadGeneratorScheduler(
+      double _qps,
+      const Option<Duration>& _duration,
+      bool _tasks)
+    : generator(NULL),
+      qps(_qps),
+      duration(_duration),
+      tasks(_tasks),
+      launched(0),
+      acknowledged(0) {}
 
   virtual ~LoadGeneratorScheduler()
   {
@@ -146,7 +164,10 @@ public:
   {
     LOG(INFO) << "Registered with " << masterInfo.pid();
 
-    if (generator == NULL) {
+    if (tasks) {
+      LOG(INFO) << "Launching tasks to generate status updates";
+      watch.start();
+    } else if (generator == NULL) {
       LOG(INFO) << "Starting LoadGenerator at QPS: " << qps;
 
       generator = new LoadGenerator(driver, qps, duration);
@@ -159,7 +180,7 @@ public:
   {
     LOG(INFO) << "Reregistered with " << masterInfo.pid();
 
-    if (generator == NULL) {
+    if (!tasks && generator == NULL) {
       LOG(INFO) << "Starting LoadGenerator at QPS: " << qps;
       generator = new LoadGenerator(driver, qps, duration);
     }
@@ -179,6 +200,11 @@ public:
       SchedulerDriver* driver,
       const vector<Offer>& offers)
   {
+    if (tasks) {
+      launch(driver, offers);
+      return;
+    }
+
     LOG(INFO) << "Received " << offers.size()
               << " resource offers. Declining them";
 
@@ -195,7 +221,32 @@ public:
 
   virtual void offerRescinded(SchedulerDriver*, const OfferID&) {}
 
-  virtual void statusUpdate(SchedulerDriver*, const TaskStatus&) {}
+  virtual void statusUpdate(SchedulerDriver* driver, const TaskStatus& status)
+  {
+    // Only the updates with a 'uuid' get acknowledged (implicitly,
+    // by the driver once this returns).
+    if (!tasks || !status.has_uuid()) {
+      return;
+    }
+
+    acknowledged++;
+
+    Duration elapsed = watch.elapsed();
+
+    if (acknowledged % 10000 == 0 ||
+        (duration.isSome() && elapsed >= duration.get())) {
+      LOG(INFO) << "LoadGenerator acknowledged " << acknowledged
+                << " status updates of " << launched << " tasks in "
+                << elapsed << " (throughput = "
+                << (acknowledged / elapsed.secs())
+                << " acknowledgements/sec)";
+    }
+
+    if (duration.isSome() && elapsed >= duration.get()) {
+      LOG(INFO) << "Stopping scheduler driver";
+      driver->stop();
+    }
+  }
 
   virtual void frameworkMessage(
       SchedulerDriver*,
@@ -219,9 +270,37 @@ public:
   }
 
 private:
+  void launch(SchedulerDriver* driver, const vector<Offer>& offers)
+  {
+    const Resources resources = Resources::parse(TASK_RESOURCES).get();
+
+    foreach (const Offer& offer, offers) {
+      Resources remaining = offer.resources();
+
+      vector<TaskInfo> infos;
+      while (remaining.contains(resources)) {
+        TaskInfo task;
+        task.set_name("Load Generator Task " + stringify(launched));
+        task.mutable_task_id()->set_value(stringify(launched++));
+        task.mutable_slave_id()->CopyFrom(offer.slave_id());
+        task.mutable_resources()->CopyFrom(resources);
+        task.mutable_command()->set_value("true");
+
+        infos.push_back(task);
+        remaining -= resources;
+      }
+
+      driver->launchTasks(offer.id(), infos);
+    }
+  }
+
   LoadGenerator* generator;
   const double qps;
   const Option<Duration> duration;
+  const bool tasks;
+  int launched;
+  int acknowledged;
+  Stopwatch watch;
 };
 
 
@@ -257,7 +336,8 @@ public:
 
     add(&Flags::qps,
         "qps",
-        "Required. Generate load at this specified rate (queries per second).\n"
+        "Required (unless --tasks). Generate load at this specified rate\n"
+        "(queries per second).\n"
         "Note that this rate is an upper bound and the real rate may be less.\n"
         "Also, setting the qps too high can cause the local machine to run\n"
         "out of ephemeral ports during master failover (if scheduler driver\n"
@@ -271,6 +351,16 @@ public:
         "Without this option this framework would keep generating load\n"
         "forever as long as it is connected to the master");
 
+    add(&Flags::tasks,
+        "tasks",
+        "Set to 'true' to generate load by launching short-lived tasks\n"
+        "(in all the offered resources, " + TASK_RESOURCES + " each) instead\n"
+        "of reconciling, and to report the throughput of the\n"
+        "acknowledgements of their status updates. To batch up the\n"
+        "acknowledgements in the scheduler driver, see\n"
+        "MESOS_ACKNOWLEDGEMENT_BATCH_INTERVAL",
+        false);
+
     add(&Flags::help,
         "help",
         "Print this help message",
@@ -281,6 +371,7 @@ public:
   string principal;
   Option<string> secret;
   bool authenticate;
+  bool tasks;
   bool help;
   Option<double> qps;
   Option<Duration> duration;
@@ -317,18 +408,21 @@ int main(int argc, char** argv)
     EXIT(1) << "Missing required option --master. See --help";
   }
 
-  if (flags.qps.isNone()) {
-    EXIT(1) << "Missing required option --qps. See --help";
-  }
+  if (!flags.tasks) {
+    if (flags.qps.isNone()) {
+      EXIT(1) << "Missing required option --qps. See --help";
+    }
 
-  if (flags.qps.get() <= 0) {
-    EXIT(1) << "--qps needs to be greater than zero";
+    if (flags.qps.get() <= 0) {
+      EXIT(1) << "--qps needs to be greater than zero";
+    }
   }
 
   // We want the logger to catch failure signals.
   mesos::internal::logging::initialize(argv[0], flags, true);
 
-  LoadGeneratorScheduler scheduler(flags.qps.get(), flags.duration);
+  LoadGeneratorScheduler scheduler(
+      flags.qps.get(0), flags.duration, flags.tasks);
 
   FrameworkInfo framework;
   framework.set_user(""); // Have Mesos fill in the current user.
@@ -1,5 +1,9 @@
 #include <unistd.h>
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
 #include <sys/stat.h>
 
 #include <algorithm>
@@ -9,14 +13,19 @@
 
 #include <boost/shared_array.hpp>
 
+#include <process/defer.hpp>
 #include <process/deferred.hpp> // TODO(benh): This is required by Clang.
+#include <process/delay.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
 #include <process/http.hpp>
 #include <process/io.hpp>
 #include <process/mime.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/duration.hpp>
 #include <stout/error.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/json.hpp>
@@ -43,8 +52,10 @@ using process::http::BadRequest;
 using process::http::InternalServerError;
 using process::http::NotFound;
 using process::http::OK;
+using process::http::Pipe;
 using process::http::Response;
 using process::http::Request;
+using process::http::ServiceUnavailable;
 
 using std::list;
 using std::map;
@@ -54,10 +65,24 @@ using std::vector;
 namespace mesos {
 namespace internal {
 
+// How often a followed file is checked for appended data when it
+// can't be watched with inotify.
+const Duration FOLLOW_POLL_INTERVAL = Seconds(1);
+
+// Maximum amount of data that is buffered for a follower (i.e.,
+// written to the response but not yet sent to the client) before
+// streaming more of the file gets paused.
+const Bytes FOLLOW_MAX_BUFFERED = Megabytes(1);
+
+// How often streaming to a follower is resumed while its buffer is
+// full.
+const Duration FOLLOW_BUFFERED_INTERVAL = Milliseconds(100);
+
+
 class FilesProcess : public Process<FilesProcess>
 {
 public:
-  FilesProcess();
+  explicit FilesProcess(const Option<size_t>& maxFollowers);
 
   // Files implementation.
   Future<Nothing> attach(const string& path, const string& name);
@@ -65,6 +90,7 @@ public:
 
 protected:
   virtual void initialize();
+  virtual void finalize();
 
 private:
   // Resolves the virtual path to an actual path.
@@ -92,15 +118,71 @@ private:
   //   path: The directory to browse. Required.
   Future<Response> download(const Request& request);
 
+  // Streams the contents of a file, and then the data appended to
+  // it until it is removed or renamed, using a chunked response.
+  // Requests have the following parameters:
+  //   path: The file to follow. Required.
+  //   offset: The offset to start streaming from. Defaults to the
+  //           end of the file.
+  Future<Response> follow(const Request& request);
+
   // Returns the internal virtual path mapping.
   Future<Response> debug(const Request& request);
 
+  // A client following a file. The file is kept open for the
+  // lifetime of the follower.
+  struct Follower
+  {
+    Follower(int _fd, const Option<int>& _inotify, off_t _offset,
+             const Pipe::Writer& _writer)
+      : fd(_fd),
+        inotify(_inotify),
+        offset(_offset),
+        writer(_writer),
+        done(false) {}
+
+    const int fd;
+
+    // Notifies when the file is modified, removed or renamed. If
+    // None, the file is polled for appended data instead.
+    const Option<int> inotify;
+
+    off_t offset;
+    Pipe::Writer writer;
+
+    // Pending wait for the file to change.
+    Future<short> changed;
+
+    // Whether the file was renamed (or removed), i.e., the response
+    // gets closed once the rest of the file has been streamed.
+    bool done;
+  };
+
+  // Writes the next chunk of the data appended to the file since the
+  // last time to the follower. Continues with the next chunk in a
+  // subsequent turn of the actor (once the follower has consumed
+  // enough of what's buffered) until the end of the file is reached,
+  // and then waits for the file to change.
+  void stream(uint64_t id);
+
+  // Invoked when the inotify file descriptor is readable.
+  void changed(uint64_t id);
+
+  // Stops following, closing the files and the response.
+  void unfollow(uint64_t id);
+
   hashmap<string, string> paths;
+
+  const Option<size_t> maxFollowers;
+  hashmap<uint64_t, Owned<Follower>> followers;
+  uint64_t nextFollowerId;
 };
 
 
-FilesProcess::FilesProcess()
-  : ProcessBase("files")
+FilesProcess::FilesProcess(const Option<size_t>& _maxFollowers)
+  : ProcessBase("files"),
+    maxFollowers(_maxFollowers),
+    nextFollowerId(0)
 {}
 
 
@@ -109,10 +191,19 @@ void FilesProcess::initialize()
   route("/browse.json", None(), &FilesProcess::browse);
   route("/read.json", None(), &FilesProcess::read);
   route("/download.json", None(), &FilesProcess::download);
+  route("/follow", None(), &FilesProcess::follow);
   route("/debug.json", None(), &FilesProcess::debug);
 }
 
 
+void FilesProcess::finalize()
+{
+  foreach (uint64_t id, followers.keys()) {
+    unfollow(id);
+  }
+}
+
+
 Future<Nothing> FilesProcess::attach(const string& path, const string& name)
 {
   Result<string> result = os::realpath(path);
@@ -369,6 +460,235 @@ Future<Response> FilesProcess::download(const Request& request)
 }
 
 
+Future<Response> FilesProcess::follow(const Request& request)
+{
+  Option<string> path = request.query.get("path");
+
+  if (!path.isSome() || path.get().empty()) {
+    return BadRequest("Expecting 'path=value' in query.\n");
+  }
+
+  Option<off_t> offset = None();
+
+  if (request.query.get("offset").isSome()) {
+    Try<off_t> result = numify<off_t>(request.query.get("offset").get());
+    if (result.isError()) {
+      return BadRequest("Failed to parse offset: " + result.error() + ".\n");
+    } else if (result.get() < 0) {
+      return BadRequest("Expecting a non-negative offset.\n");
+    }
+    offset = result.get();
+  }
+
+  Result<string> resolvedPath = resolve(path.get());
+
+  if (resolvedPath.isError()) {
+    return BadRequest(resolvedPath.error() + ".\n");
+  } else if (!resolvedPath.isSome()) {
+    return NotFound();
+  }
+
+  // Don't follow directories.
+  if (os::stat::isdir(resolvedPath.get())) {
+    return BadRequest("Cannot follow a directory.\n");
+  }
+
+  if (maxFollowers.isSome() && followers.size() >= maxFollowers.get()) {
+    return ServiceUnavailable(
+        "Too many followers (" + stringify(maxFollowers.get()) + ").\n");
+  }
+
+  Try<int> fd = os::open(resolvedPath.get(), O_RDONLY | O_CLOEXEC);
+
+  if (fd.isError()) {
+    string error = strings::format("Failed to open file at '%s': %s",
+        resolvedPath.get(), fd.error()).get();
+    LOG(WARNING) << error;
+    return InternalServerError(error + ".\n");
+  }
+
+  if (offset.isNone()) {
+    off_t size = lseek(fd.get(), 0, SEEK_END);
+
+    if (size == -1) {
+      string error = strings::format("Failed to seek file at '%s': %s",
+          resolvedPath.get(), strerror(errno)).get();
+      LOG(WARNING) << error;
+      os::close(fd.get());
+      return InternalServerError(error + ".\n");
+    }
+
+    offset = size;
+  }
+
+  Option<int> inotify = None();
+
+#ifdef __linux__
+  int inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  if (inotifyFd < 0) {
+    PLOG(WARNING) << "Failed to initialize inotify, polling '"
+                  << resolvedPath.get() << "' instead";
+  } else if (inotify_add_watch(
+                 inotifyFd,
+                 resolvedPath.get().c_str(),
+                 IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF) < 0) {
+    PLOG(WARNING) << "Failed to watch '" << resolvedPath.get()
+                  << "' with inotify, polling it instead";
+    os::close(inotifyFd);
+  } else {
+    inotify = inotifyFd;
+  }
+#endif // __linux__
+
+  Pipe pipe;
+
+  const uint64_t id = nextFollowerId++;
+
+  followers[id] = Owned<Follower>(
+      new Follower(fd.get(), inotify, offset.get(), pipe.writer()));
+
+  // Stop following once the client disconnects.
+  pipe.writer().readerClosed()
+    .onAny(defer(self(), &Self::unfollow, id));
+
+  stream(id);
+
+  OK response;
+  response.type = response.PIPE;
+  response.reader = pipe.reader();
+  response.headers["Content-Type"] = "text/plain";
+
+  return response;
+}
+
+
+void FilesProcess::stream(uint64_t id)
+{
+  if (!followers.contains(id)) {
+    return;
+  }
+
+  Owned<Follower> follower = followers[id];
+
+  // Start over if the file was truncated (e.g., rotated in place).
+  struct stat s;
+  if (fstat(follower->fd, &s) == 0 && s.st_size < follower->offset) {
+    follower->offset = 0;
+  }
+
+  // Don't read any more of the file until the follower catches up,
+  // otherwise a slow client would have us buffer the whole file.
+  if (follower->writer.size() >= FOLLOW_MAX_BUFFERED.bytes()) {
+    delay(FOLLOW_BUFFERED_INTERVAL, self(), &Self::stream, id);
+    return;
+  }
+
+  const size_t length = sysconf(_SC_PAGE_SIZE) * 16;
+  boost::shared_array<char> data(new char[length]);
+
+  ssize_t size;
+  do {
+    size = ::pread(follower->fd, data.get(), length, follower->offset);
+  } while (size < 0 && errno == EINTR);
+
+  if (size < 0) {
+    follower->writer.fail("Failed to read file: " + string(strerror(errno)));
+    unfollow(id);
+    return;
+  } else if (size > 0) {
+    if (!follower->writer.write(string(data.get(), size))) {
+      unfollow(id);
+      return;
+    }
+
+    follower->offset += size;
+
+    // Stream the next chunk in a subsequent turn so that other
+    // followers (and requests) get a chance in between.
+    dispatch(self(), &Self::stream, id);
+    return;
+  }
+
+  // Nothing more can be appended once the file is removed or renamed.
+  // Note that inotify only reports the removal of a file once it's no
+  // longer open, but the change of its link count is reported right
+  // away.
+  if (follower->done ||
+      (fstat(follower->fd, &s) == 0 && s.st_nlink == 0)) {
+    unfollow(id);
+    return;
+  }
+
+  // Wait for more data.
+  if (follower->inotify.isSome()) {
+    follower->changed = io::poll(follower->inotify.get(), io::READ);
+    follower->changed
+      .onAny(defer(self(), &Self::changed, id));
+  } else {
+    delay(FOLLOW_POLL_INTERVAL, self(), &Self::stream, id);
+  }
+}
+
+
+void FilesProcess::changed(uint64_t id)
+{
+  if (!followers.contains(id)) {
+    return;
+  }
+
+#ifdef __linux__
+  Owned<Follower> follower = followers[id];
+
+  // Drain the inotify events, looking for the renaming of the file,
+  // after which no more data is expected to be appended to it. The
+  // rest of the file still gets streamed before closing the response,
+  // see stream().
+  char buffer[4096]
+    __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+  while (true) {
+    ssize_t length = ::read(follower->inotify.get(), buffer, sizeof(buffer));
+
+    if (length <= 0) {
+      break;
+    }
+
+    for (char* event = buffer; event < buffer + length;) {
+      const struct inotify_event* e = (const struct inotify_event*) event;
+
+      if (e->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+        follower->done = true;
+      }
+
+      event += sizeof(struct inotify_event) + e->len;
+    }
+  }
+#endif // __linux__
+
+  stream(id);
+}
+
+
+void FilesProcess::unfollow(uint64_t id)
+{
+  if (!followers.contains(id)) {
+    return;
+  }
+
+  Owned<Follower> follower = followers[id];
+  followers.erase(id);
+
+  follower->changed.discard();
+  follower->writer.close();
+
+  os::close(follower->fd);
+  if (follower->inotify.isSome()) {
+    os::close(follower->inotify.get());
+  }
+}
+
+
 Future<Response> FilesProcess::debug(const Request& request)
 {
   JSON::Object object;
@@ -446,9 +766,9 @@ Result<string> FilesProcess::resolve(const string& path)
 }
 
 
-Files::Files()
+Files::Files(const Option<size_t>& maxFollowers)
 {
-  process = new FilesProcess();
+  process = new FilesProcess(maxFollowers);
   spawn(process);
 }
 
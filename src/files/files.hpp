@@ -31,7 +31,9 @@
 
 #include <stout/format.hpp>
 #include <stout/json.hpp>
+#include <stout/none.hpp>
 #include <stout/nothing.hpp>
+#include <stout/option.hpp>
 #include <stout/path.hpp>
 
 namespace mesos {
@@ -47,10 +49,14 @@ class FilesProcess;
 // reading of any files and directories it contains. The "mounting" of
 // paths to names enables us to do a form of chrooting for better
 // security and isolation of files.
+//
+// Files may also be "followed" (like 'tail -f'), in which case the
+// data appended to them is streamed to the client. If 'maxFollowers'
+// is given, at most that many files may be followed concurrently.
 class Files
 {
 public:
-  Files();
+  explicit Files(const Option<size_t>& maxFollowers = None());
   ~Files();
 
   // Returns the result of trying to attach the specified path
@@ -16,6 +16,9 @@
  * limitations under the License.
  */
 
+#include <unistd.h>
+
+#include <list>
 #include <string>
 
 #include <mesos/mesos.hpp>
@@ -42,6 +45,7 @@ using mesos::fetcher::FetcherInfo;
 using std::cerr;
 using std::cout;
 using std::endl;
+using std::list;
 using std::string;
 
 
@@ -254,6 +258,78 @@ Try<string> fetch(
 }
 
 
+// Fetch URI into the directory of a cache entry. The URI gets fetched
+// into a temporary directory first which is then renamed, so that
+// the directory only exists once the fetched file is complete.
+Try<Nothing> download(
+    const string& uri,
+    const string& cacheDirectory,
+    const Option<std::string>& frameworksHome)
+{
+  const string temporary = cacheDirectory + ".tmp";
+
+  Try<Nothing> mkdir = os::mkdir(temporary);
+  if (mkdir.isError()) {
+    return Error("Failed to create '" + temporary + "': " + mkdir.error());
+  }
+
+  Try<string> fetched = fetch(uri, temporary, frameworksHome);
+  if (fetched.isError()) {
+    return Error(fetched.error());
+  }
+
+  Try<Nothing> rename = os::rename(temporary, cacheDirectory);
+  if (rename.isError()) {
+    return Error("Failed to rename '" + temporary + "' to '" +
+                 cacheDirectory + "': " + rename.error());
+  }
+
+  LOG(INFO) << "Cached URI '" << uri << "' in '" << cacheDirectory << "'";
+
+  return Nothing();
+}
+
+
+// Hard link (or copy, e.g., if the cache is on another file system)
+// the file from the directory of a cache entry into directory.
+Try<string> retrieve(const string& cacheDirectory, const string& directory)
+{
+  Try<list<string>> files = os::ls(cacheDirectory);
+  if (files.isError()) {
+    return Error("Failed to list '" + cacheDirectory + "': " + files.error());
+  } else if (files.get().size() != 1) {
+    return Error("Expecting exactly one file in '" + cacheDirectory + "'");
+  }
+
+  const string cached = path::join(cacheDirectory, files.get().front());
+  const string path = path::join(directory, files.get().front());
+
+  if (os::exists(path)) {
+    Try<Nothing> rm = os::rm(path);
+    if (rm.isError()) {
+      return Error("Failed to remove '" + path + "': " + rm.error());
+    }
+  }
+
+  if (::link(cached.c_str(), path.c_str()) == 0) {
+    LOG(INFO) << "Linked cached resource '" << cached
+              << "' to '" << path << "'";
+    return path;
+  }
+
+  LOG(INFO) << "Failed to link cached resource '" << cached << "' to '"
+            << path << "', copying it instead: " << strerror(errno);
+
+  int status = os::system("cp '" + cached + "' '" + path + "'");
+  if (status != 0) {
+    return Error("Failed to copy '" + cached + "': Exit status " +
+                 stringify(status));
+  }
+
+  return path;
+}
+
+
 int main(int argc, char* argv[])
 {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
@@ -301,12 +377,44 @@ int main(int argc, char* argv[])
     frameworksHome = fetcherInfo.get().frameworks_home();
   }
 
+  // Without items all URIs bypass the cache.
+  google::protobuf::RepeatedPtrField<FetcherInfo::Item> items =
+    fetcherInfo.get().items();
+
+  if (items.size() == 0) {
+    foreach (const CommandInfo::URI& uri, commandInfo.uris()) {
+      FetcherInfo::Item* item = items.Add();
+      item->mutable_uri()->CopyFrom(uri);
+      item->set_action(FetcherInfo::BYPASS_CACHE);
+    }
+  }
+
   // Fetch each URI to a local file, chmod, then chown if a user is provided.
-  foreach (const CommandInfo::URI& uri, commandInfo.uris()) {
-    // Fetch the URI to a local file.
-    Try<string> fetched = fetch(uri.value(), directory, frameworksHome);
+  foreach (const FetcherInfo::Item& item, items) {
+    const CommandInfo::URI& uri = item.uri();
+
+    // Fetch the URI to a local file, via the cache if requested.
+    Try<string> fetched = Error("Unknown action");
+
+    switch (item.action()) {
+      case FetcherInfo::BYPASS_CACHE:
+        fetched = fetch(uri.value(), directory, frameworksHome);
+        break;
+      case FetcherInfo::DOWNLOAD_AND_CACHE: {
+        Try<Nothing> downloaded =
+          download(uri.value(), item.cache_directory(), frameworksHome);
+        fetched = downloaded.isError()
+          ? Error(downloaded.error())
+          : retrieve(item.cache_directory(), directory);
+        break;
+      }
+      case FetcherInfo::RETRIEVE_FROM_CACHE:
+        fetched = retrieve(item.cache_directory(), directory);
+        break;
+    }
+
     if (fetched.isError()) {
-      EXIT(1) << "Failed to fetch: " << uri.value();
+      EXIT(1) << "Failed to fetch " << uri.value() << ": " << fetched.error();
     }
 
     // Chmod the fetched URI if it's executable, else assume it's an archive
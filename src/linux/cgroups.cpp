@@ -74,6 +74,7 @@ using std::map;
 using std::ofstream;
 using std::ostream;
 using std::ostringstream;
+using std::pair;
 using std::set;
 using std::string;
 using std::vector;
@@ -1836,20 +1837,17 @@ Future<bool> _cleanup(const string& hierarchy)
 }
 
 
-Try<hashmap<string, uint64_t> > stat(
-    const string& hierarchy,
-    const string& cgroup,
-    const string& file)
-{
-  Try<string> contents = cgroups::read(hierarchy, cgroup, file);
-
-  if (contents.isError()) {
-    return Error(contents.error());
-  }
+namespace internal {
 
+// Parses the contents of a stat file, i.e., lines of the form
+// "%s %llu".
+static Try<hashmap<string, uint64_t> > stat(
+    const string& file,
+    const string& contents)
+{
   hashmap<string, uint64_t> result;
 
-  foreach (const string& line, strings::split(contents.get(), "\n")) {
+  foreach (const string& line, strings::split(contents, "\n")) {
     // Skip empty lines.
     if (strings::trim(line).empty()) {
       continue;
@@ -1872,6 +1870,191 @@ Try<hashmap<string, uint64_t> > stat(
   return result;
 }
 
+} // namespace internal {
+
+
+Try<hashmap<string, uint64_t> > stat(
+    const string& hierarchy,
+    const string& cgroup,
+    const string& file)
+{
+  Try<string> contents = cgroups::read(hierarchy, cgroup, file);
+
+  if (contents.isError()) {
+    return Error(contents.error());
+  }
+
+  return internal::stat(file, contents.get());
+}
+
+
+Handle::Handle(const string& _hierarchy, const string& _cgroup)
+  : hierarchy(_hierarchy),
+    cgroup(_cgroup),
+    verified(false) {}
+
+
+Handle::~Handle()
+{
+  close();
+}
+
+
+Option<Error> Handle::verify()
+{
+  if (!verified) {
+    Option<Error> error = cgroups::verify(hierarchy, cgroup);
+    if (error.isSome()) {
+      return error;
+    }
+
+    verified = true;
+  }
+
+  return None();
+}
+
+
+Try<string> Handle::read(const string& control)
+{
+  if (!readFds.contains(control)) {
+    Option<Error> error = verify();
+    if (error.isSome()) {
+      return error.get();
+    }
+
+    const string path = path::join(hierarchy, cgroup, control);
+
+    Try<int> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd.isError()) {
+      return Error("Failed to open file " + path + ": " + fd.error());
+    }
+
+    readFds[control] = fd.get();
+  }
+
+  const int fd = readFds[control];
+
+  // Control files are generated by the kernel on each read from the
+  // beginning of the file, hence we read until EOF using pread(2)
+  // rather than relying on the file size.
+  string result;
+  char buffer[4096];
+  off_t offset = 0;
+
+  while (true) {
+    ssize_t length = ::pread(fd, buffer, sizeof(buffer), offset);
+
+    if (length < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      ErrnoError error(
+          "Failed to read file " + path::join(hierarchy, cgroup, control));
+
+      // Reopen the control file on the next read.
+      os::close(fd);
+      readFds.erase(control);
+
+      return error;
+    } else if (length == 0) {
+      break;
+    }
+
+    result.append(buffer, length);
+    offset += length;
+  }
+
+  return result;
+}
+
+
+Try<hashmap<string, uint64_t> > Handle::stat(const string& file)
+{
+  Try<string> contents = read(file);
+
+  if (contents.isError()) {
+    return Error(contents.error());
+  }
+
+  return internal::stat(file, contents.get());
+}
+
+
+Try<Nothing> Handle::write(const string& control, const string& value)
+{
+  if (!writeFds.contains(control)) {
+    Option<Error> error = verify();
+    if (error.isSome()) {
+      return error.get();
+    }
+
+    const string path = path::join(hierarchy, cgroup, control);
+
+    Try<int> fd = os::open(path, O_WRONLY | O_CLOEXEC);
+    if (fd.isError()) {
+      return Error("Failed to open file " + path + ": " + fd.error());
+    }
+
+    writeFds[control] = fd.get();
+  }
+
+  const int fd = writeFds[control];
+
+  // The kernel handles each write(2) to a control file as a whole,
+  // hence the value is written in one go from the beginning of the
+  // file. NOTE: cgroups convention does not append a endln!
+  ssize_t length;
+  do {
+    length = ::pwrite(fd, value.data(), value.size(), 0);
+  } while (length < 0 && errno == EINTR);
+
+  if (length < 0 || static_cast<size_t>(length) != value.size()) {
+    ErrnoError error(
+        "Failed to write file " + path::join(hierarchy, cgroup, control));
+
+    // Reopen the control file on the next write.
+    os::close(fd);
+    writeFds.erase(control);
+
+    return error;
+  }
+
+  return Nothing();
+}
+
+
+Try<Nothing> Handle::write(const vector<pair<string, string> >& values)
+{
+  typedef pair<string, string> Value;
+  foreach (const Value& value, values) {
+    Try<Nothing> write = Handle::write(value.first, value.second);
+
+    if (write.isError()) {
+      return Error(
+          "Failed to write '" + value.first + "': " + write.error());
+    }
+  }
+
+  return Nothing();
+}
+
+
+void Handle::close()
+{
+  foreachvalue (int fd, readFds) {
+    os::close(fd);
+  }
+
+  foreachvalue (int fd, writeFds) {
+    os::close(fd);
+  }
+
+  readFds.clear();
+  writeFds.clear();
+}
+
 
 namespace internal {
 
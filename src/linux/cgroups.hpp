@@ -24,6 +24,7 @@
 
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <sys/types.h>
@@ -33,6 +34,7 @@
 
 #include <stout/bytes.hpp>
 #include <stout/duration.hpp>
+#include <stout/error.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
@@ -388,6 +390,69 @@ Try<hashmap<std::string, uint64_t> > stat(
     const std::string& file);
 
 
+// A handle on a cgroup under a given hierarchy, for reading and
+// writing its control files repeatedly. Unlike cgroups::read and
+// cgroups::write, which verify the hierarchy (parsing /proc/mounts)
+// and open the control file on every call, the handle verifies the
+// hierarchy and the cgroup once, and keeps the control files it reads
+// open, so that re-reading them (e.g., 'memory.stat', 'cpuacct.stat'
+// and 'cpu.stat' on every resource usage collection) is a single
+// pread(2).
+// NOTE: The handle should be closed before the cgroup is destroyed,
+// so as not to keep open files of a removed cgroup around.
+class Handle
+{
+public:
+  // @param   hierarchy   Path to the hierarchy root.
+  // @param   cgroup      Path to the cgroup relative to the hierarchy root.
+  Handle(const std::string& hierarchy, const std::string& cgroup);
+  ~Handle();
+
+  // Read a control file, which is kept open for subsequent reads.
+  // @param   control     Name of the control file.
+  // @return  The value read from the control file.
+  Try<std::string> read(const std::string& control);
+
+  // Returns the stat information from the given file (see
+  // cgroups::stat), which is kept open for subsequent reads.
+  // @param   file        The stat file to read from. (Ex: "memory.stat").
+  Try<hashmap<std::string, uint64_t> > stat(const std::string& file);
+
+  // Write a control file, which is kept open for subsequent writes.
+  // @param   control     Name of the control file.
+  // @param   value       Value to be written.
+  // @return  Some if the operation succeeds.
+  //          Error if the operation fails.
+  Try<Nothing> write(const std::string& control, const std::string& value);
+
+  // Write the control files in order, stopping at the first failure.
+  // @param   values      Pairs of the control file and the value.
+  // @return  Some if all the writes succeed.
+  //          Error if any of the writes fails.
+  Try<Nothing> write(
+      const std::vector<std::pair<std::string, std::string> >& values);
+
+  // Close all the control files kept open.
+  void close();
+
+private:
+  Handle(const Handle&);
+  Handle& operator = (const Handle&);
+
+  // Verifies the hierarchy and the cgroup, once.
+  Option<Error> verify();
+
+  const std::string hierarchy;
+  const std::string cgroup;
+
+  bool verified;
+
+  // Control files kept open for reading and for writing.
+  hashmap<std::string, int> readFds;
+  hashmap<std::string, int> writeFds;
+};
+
+
 // Cpu controls.
 namespace cpu {
 
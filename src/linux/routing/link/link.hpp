@@ -113,6 +113,12 @@ Try<bool> setMTU(const std::string& link, unsigned int mtu);
 // Returns the statistics of the link.
 Result<hashmap<std::string, uint64_t>> statistics(const std::string& link);
 
+
+// Returns the statistics of all the links indexed by link name. This
+// only takes a single dump of the links from the kernel and should
+// be preferred over calling the above for each of many links.
+Try<hashmap<std::string, hashmap<std::string, uint64_t>>> statistics();
+
 } // namespace link {
 } // namespace routing {
 
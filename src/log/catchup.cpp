@@ -18,14 +18,22 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <list>
+#include <set>
+#include <utility>
+#include <vector>
 
 #include <process/collect.hpp>
 #include <process/id.hpp>
 #include <process/process.hpp>
 #include <process/timer.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 
 #include "log/catchup.hpp"
@@ -36,6 +44,9 @@
 using namespace process;
 
 using std::list;
+using std::pair;
+using std::set;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -167,6 +178,246 @@ static Future<uint64_t> catchup(
 }
 
 
+// The maximum number of positions that are read from another replica
+// with a single request during catch-up.
+static const uint64_t READ_POSITIONS = 1024;
+
+// The size at which a replica stops adding actions to a response.
+static const Bytes READ_SIZE = Megabytes(4);
+
+// The maximum number of reads (including persisting what was read)
+// that are in flight at a time during catch-up.
+static const size_t MAX_READS_IN_FLIGHT = 4;
+
+
+// Catches-up a set of log positions in the local replica by reading
+// the actions that have already been learned at those positions from
+// the other replicas in the network, which is much cheaper than
+// running Paxos for each position. The positions are split into
+// ranges that are read from the other replicas in a round robin
+// fashion, several ranges at a time, and the actions in each range
+// are persisted in the local replica with a single write. A range
+// that could not be read (e.g., because the replica is not VOTING or
+// the read timed out) is simply skipped: every position that is
+// still missing afterwards gets filled by the bulk catch-up below.
+class ReadCatchUpProcess : public Process<ReadCatchUpProcess>
+{
+public:
+  ReadCatchUpProcess(
+      const Shared<Replica>& _replica,
+      const Shared<Network>& _network,
+      const IntervalSet<uint64_t>& _positions,
+      const Duration& _timeout)
+    : ProcessBase(ID::generate("log-read-catch-up")),
+      replica(_replica),
+      network(_network),
+      positions(_positions),
+      timeout(_timeout),
+      next(0),
+      learned(0) {}
+
+  virtual ~ReadCatchUpProcess() {}
+
+  Future<Nothing> future() { return promise.future(); }
+
+protected:
+  virtual void initialize()
+  {
+    // Stop when no one cares.
+    promise.future().onDiscard(lambda::bind(
+        static_cast<void(*)(const UPID&, bool)>(terminate), self(), true));
+
+    stopwatch.start();
+
+    foreach (const Interval<uint64_t>& interval, positions) {
+      for (uint64_t from = interval.lower();
+           from < interval.upper();
+           from += READ_POSITIONS) {
+        uint64_t to = std::min(from + READ_POSITIONS, interval.upper()) - 1;
+        ranges.push_back(std::make_pair(from, to));
+      }
+    }
+
+    members = network->members();
+    members.onAny(defer(self(), &Self::_initialize));
+  }
+
+  virtual void finalize()
+  {
+    members.discard();
+
+    foreachvalue (Future<Nothing> reading, readings) {
+      reading.discard();
+    }
+
+    // TODO(benh): Discard our promise only after all 'readings' have
+    // completed (ready, failed, or discarded).
+    promise.discard();
+  }
+
+private:
+  static void timedout(Future<ReadResponse> reading)
+  {
+    reading.discard();
+  }
+
+  void _initialize()
+  {
+    // The future 'members' can only be discarded in 'finalize'.
+    CHECK(!members.isDiscarded());
+
+    if (members.isReady()) {
+      foreach (const UPID& pid, members.get()) {
+        if (pid != replica->pid()) {
+          peers.push_back(pid);
+        }
+      }
+    }
+
+    if (peers.empty()) {
+      LOG(INFO) << "No other replicas to read positions from";
+      ranges.clear();
+    }
+
+    read();
+  }
+
+  void read()
+  {
+    while (!ranges.empty() && readings.size() < MAX_READS_IN_FLIGHT) {
+      const pair<uint64_t, uint64_t> range = ranges.front();
+      ranges.pop_front();
+
+      const UPID& pid = peers[next++ % peers.size()];
+
+      ReadRequest request;
+      request.set_from(range.first);
+      request.set_to(range.second);
+      request.set_bytes(READ_SIZE.bytes());
+
+      Future<ReadResponse> reading = protocol::read(pid, request);
+
+      Clock::timer(timeout, lambda::bind(&Self::timedout, reading));
+
+      readings[range.first] = reading
+        .then(defer(self(), &Self::learn, range.second, lambda::_1));
+
+      readings[range.first]
+        .onAny(defer(self(), &Self::_read, range.first, range.second));
+    }
+
+    if (ranges.empty() && readings.empty()) {
+      Duration elapsed = stopwatch.elapsed();
+
+      LOG(INFO) << "Read " << learned << " learned positions ("
+                << size << ") from other replicas in " << elapsed
+                << " (" << learned / std::max(elapsed.secs(), 1e-9)
+                << " positions/sec, "
+                << size / std::max(elapsed.secs(), 1e-9) << "/sec)";
+
+      promise.set(Nothing());
+      terminate(self());
+    }
+  }
+
+  Future<Nothing> learn(uint64_t to, const ReadResponse& response)
+  {
+    if (!response.okay()) {
+      return Failure("Replica is not VOTING");
+    }
+
+    // Read the rest of the range later if the response got cut short
+    // because of its size.
+    if (response.has_to() && response.to() < to) {
+      ranges.push_front(std::make_pair(response.to() + 1, to));
+    }
+
+    if (response.actions_size() == 0) {
+      return Nothing();
+    }
+
+    list<Action> actions;
+    foreach (const Action& action, response.actions()) {
+      actions.push_back(action);
+      size += action.ByteSize();
+    }
+
+    learned += actions.size();
+
+    return replica->learn(actions)
+      .then(lambda::bind(&Self::_learn, lambda::_1));
+  }
+
+  static Future<Nothing> _learn(bool learned)
+  {
+    if (!learned) {
+      return Failure("Failed to persist the learned actions");
+    }
+
+    return Nothing();
+  }
+
+  void _read(uint64_t from, uint64_t to)
+  {
+    CHECK(readings.contains(from));
+
+    Future<Nothing> reading = readings[from];
+    readings.erase(from);
+
+    if (!reading.isReady()) {
+      LOG(INFO) << "Unable to read positions " << from << " -> " << to
+                << " from other replicas: "
+                << (reading.isFailed() ? reading.failure() : "discarded")
+                << ", leaving them to be filled";
+    }
+
+    read();
+  }
+
+  const Shared<Replica> replica;
+  const Shared<Network> network;
+  const IntervalSet<uint64_t> positions;
+  const Duration timeout;
+
+  // The ranges [from, to] that are still to be read.
+  std::deque<pair<uint64_t, uint64_t> > ranges;
+
+  // The replicas to read from, and the one to read the next range.
+  vector<UPID> peers;
+  size_t next;
+
+  // The ranges being read, keyed by their first positions.
+  hashmap<uint64_t, Future<Nothing> > readings;
+
+  // Statistics for the reads.
+  Stopwatch stopwatch;
+  uint64_t learned;
+  Bytes size;
+
+  process::Promise<Nothing> promise;
+  Future<set<UPID> > members;
+};
+
+
+static Future<Nothing> read(
+    const Shared<Replica>& replica,
+    const Shared<Network>& network,
+    const IntervalSet<uint64_t>& positions,
+    const Duration& timeout)
+{
+  ReadCatchUpProcess* process =
+    new ReadCatchUpProcess(
+        replica,
+        network,
+        positions,
+        timeout);
+
+  Future<Nothing> future = process->future();
+  spawn(process, true);
+  return future;
+}
+
+
 // TODO(jieyu): Our current implementation catches-up each position in
 // the set sequentially. In the future, we may want to parallelize it
 // to improve the performance. Also, we may want to implement rate
@@ -310,18 +561,17 @@ static Future<Nothing> catchup(
 }
 
 
-/////////////////////////////////////////////////
-// Public interfaces below.
-/////////////////////////////////////////////////
-
-
-Future<Nothing> catchup(
+// Continuations of the public 'catchup' below, which fill the
+// positions that are still missing in the local replica after reading
+// the learned positions from other replicas.
+static Future<Nothing> __catchup(
     size_t quorum,
     const Shared<Replica>& replica,
     const Shared<Network>& network,
     const Option<uint64_t>& proposal,
     const IntervalSet<uint64_t>& positions,
-    const Duration& timeout)
+    const Duration& timeout,
+    const IntervalSet<uint64_t>& missing)
 {
   // Necessary to disambiguate overloaded functions.
   Future<Nothing> (*f)(
@@ -332,9 +582,15 @@ Future<Nothing> catchup(
       const Interval<uint64_t>& positions,
       const Duration& timeout) = &catchup;
 
+  IntervalSet<uint64_t> remaining = positions;
+  remaining &= missing;
+
+  LOG(INFO) << "Filling " << remaining.size() << " positions that could"
+            << " not be read from other replicas";
+
   Future<Nothing> future = Nothing();
 
-  foreach (const Interval<uint64_t>& interval, positions) {
+  foreach (const Interval<uint64_t>& interval, remaining) {
     future = future.then(
         lambda::bind(
             f,
@@ -349,6 +605,62 @@ Future<Nothing> catchup(
   return future;
 }
 
+
+static Future<Nothing> _catchup(
+    size_t quorum,
+    const Shared<Replica>& replica,
+    const Shared<Network>& network,
+    const Option<uint64_t>& proposal,
+    const IntervalSet<uint64_t>& positions,
+    const Duration& timeout)
+{
+  // The range [from, to] that covers all positions.
+  uint64_t from = positions.begin()->lower();
+  uint64_t to = positions.rbegin()->upper() - 1;
+
+  return replica->missing(from, to)
+    .then(lambda::bind(
+        &__catchup,
+        quorum,
+        replica,
+        network,
+        proposal,
+        positions,
+        timeout,
+        lambda::_1));
+}
+
+
+/////////////////////////////////////////////////
+// Public interfaces below.
+/////////////////////////////////////////////////
+
+
+Future<Nothing> catchup(
+    size_t quorum,
+    const Shared<Replica>& replica,
+    const Shared<Network>& network,
+    const Option<uint64_t>& proposal,
+    const IntervalSet<uint64_t>& positions,
+    const Duration& timeout)
+{
+  if (positions.empty()) {
+    return Nothing();
+  }
+
+  // Read what other replicas have already learned first, and then
+  // fill whatever is still missing using Paxos.
+  return read(replica, network, positions, timeout)
+    .then(lambda::bind(
+        &_catchup,
+        quorum,
+        replica,
+        network,
+        proposal,
+        positions,
+        timeout));
+}
+
 } // namespace log {
 } // namespace internal {
 } // namespace mesos {
@@ -19,14 +19,18 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <deque>
 
 #include <mesos/type_utils.hpp>
 
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/id.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <stout/foreach.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/none.hpp>
 
 #include "log/catchup.hpp"
@@ -37,6 +41,7 @@
 
 using namespace process;
 
+using std::deque;
 using std::string;
 
 namespace mesos {
@@ -49,11 +54,13 @@ public:
   CoordinatorProcess(
       size_t _quorum,
       const Shared<Replica>& _replica,
-      const Shared<Network>& _network)
+      const Shared<Network>& _network,
+      size_t _window)
     : ProcessBase(ID::generate("log-coordinator")),
       quorum(_quorum),
       replica(_replica),
       network(_network),
+      window(_window),
       state(INITIAL),
       proposal(0),
       index(0) {}
@@ -70,7 +77,15 @@ protected:
   virtual void finalize()
   {
     electing.discard();
-    writing.discard();
+
+    foreachvalue (Future<Option<uint64_t> > future, writes) {
+      future.discard();
+    }
+
+    while (!queued.empty()) {
+      queued.front()->promise.discard();
+      queued.pop_front();
+    }
   }
 
 private:
@@ -94,22 +109,40 @@ private:
   // Writing related functions.  //
   /////////////////////////////////
 
+  // A write that is waiting for room in the window. The position of
+  // the action is only assigned once the write is started.
+  struct Pending
+  {
+    explicit Pending(const Action& _action) : action(_action) {}
+
+    Action action;
+    process::Promise<Option<uint64_t> > promise;
+  };
+
   Future<Option<uint64_t> > write(const Action& action);
+  Future<Option<uint64_t> > _write(Action action);
+  void writeQueued();
   Future<WriteResponse> runWritePhase(const Action& action);
   Future<Option<uint64_t> > checkWritePhase(
       const Action& action,
       const WriteResponse& response);
   Future<Nothing> runLearnPhase(const Action& action);
   Future<bool> checkLearnPhase(const Action& action);
-  Future<Option<uint64_t> > updateIndexAfterWritten(bool missing);
-  void writingFinished();
-  void writingFailed();
-  void writingAborted();
+  Future<Option<uint64_t> > updateIndexAfterWritten(
+      const Action& action,
+      bool missing);
+  void writingFinished(uint64_t position, const Option<uint64_t>& written);
+  void writingFailed(uint64_t position);
+  void writingAborted(uint64_t position);
+  void writingDemoted();
 
   const size_t quorum;
   const Shared<Replica> replica;
   const Shared<Network> network;
 
+  // The maximum number of writes that can be in flight at a time.
+  const size_t window;
+
   // The current state of the coordinator. A coordinator needs to be
   // elected first to perform append and truncate operations. If one
   // tries to do an append or a truncate while the coordinator is not
@@ -117,7 +150,8 @@ private:
   // coordinator does not declare itself as elected until it wins the
   // election and has filled all existing positions. A coordinator is
   // put in electing state after it decides to go for an election and
-  // before it is elected.
+  // before it is elected. An elected coordinator is in writing state
+  // as long as it has at least one write in flight.
   enum {
     INITIAL,
     ELECTING,
@@ -132,7 +166,15 @@ private:
   uint64_t index;
 
   Future<Option<uint64_t> > electing;
-  Future<Option<uint64_t> > writing;
+
+  // The writes in flight, keyed by their positions. Writes that were
+  // started before the coordinator got demoted stay here until they
+  // complete.
+  hashmap<uint64_t, Future<Option<uint64_t> > > writes;
+
+  // The writes waiting for room in the window, in the order in which
+  // they were issued.
+  deque<Owned<Pending> > queued;
 };
 
 
@@ -149,6 +191,10 @@ Future<Option<uint64_t> > CoordinatorProcess::elect()
     return index - 1; // The last learned position!
   } else if (state == WRITING) {
     return Failure("Coordinator already elected, and is currently writing");
+  } else if (!writes.empty()) {
+    // The coordinator got demoted but some writes are still in
+    // flight, a new election needs to wait for them to finish.
+    return Failure("Coordinator is currently writing");
   }
 
   CHECK_EQ(state, INITIAL);
@@ -299,12 +345,9 @@ Future<Option<uint64_t> > CoordinatorProcess::append(const string& bytes)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
-  action.set_position(index);
   action.set_promised(proposal);
   action.set_performed(proposal);
   action.set_type(Action::APPEND);
@@ -319,12 +362,9 @@ Future<Option<uint64_t> > CoordinatorProcess::truncate(uint64_t to)
 {
   if (state == INITIAL || state == ELECTING) {
     return None();
-  } else if (state == WRITING) {
-    return Failure("Coordinator is currently writing");
   }
 
   Action action;
-  action.set_position(index);
   action.set_promised(proposal);
   action.set_performed(proposal);
   action.set_type(Action::TRUNCATE);
@@ -337,24 +377,72 @@ Future<Option<uint64_t> > CoordinatorProcess::truncate(uint64_t to)
 
 Future<Option<uint64_t> > CoordinatorProcess::write(const Action& action)
 {
+  CHECK(state == ELECTED || state == WRITING);
+  CHECK(action.has_performed() && action.has_type());
+
+  if (writes.size() < window) {
+    return _write(action);
+  }
+
+  VLOG(2) << "Coordinator queueing " << action.type() << " action since "
+          << writes.size() << " writes are in flight";
+
+  Owned<Pending> pending(new Pending(action));
+  queued.push_back(pending);
+
+  return pending->promise.future();
+}
+
+
+Future<Option<uint64_t> > CoordinatorProcess::_write(Action action)
+{
+  CHECK(state == ELECTED || state == WRITING);
+  CHECK_LT(writes.size(), window);
+
+  action.set_position(index++);
+
   LOG(INFO) << "Coordinator attempting to write " << action.type()
             << " action at position " << action.position();
 
-  CHECK_EQ(state, ELECTED);
-  CHECK(action.has_performed() && action.has_type());
-
   state = WRITING;
 
-  writing = runWritePhase(action)
-    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1))
-    .onReady(defer(self(), &Self::writingFinished))
-    .onFailed(defer(self(), &Self::writingFailed))
-    .onDiscarded(defer(self(), &Self::writingAborted));
+  Future<Option<uint64_t> > writing = runWritePhase(action)
+    .then(defer(self(), &Self::checkWritePhase, action, lambda::_1));
+
+  writes[action.position()] = writing;
+
+  writing
+    .onReady(defer(self(),
+                   &Self::writingFinished,
+                   action.position(),
+                   lambda::_1))
+    .onFailed(defer(self(), &Self::writingFailed, action.position()))
+    .onDiscarded(defer(self(), &Self::writingAborted, action.position()));
 
   return writing;
 }
 
 
+void CoordinatorProcess::writeQueued()
+{
+  while (!queued.empty() && writes.size() < window) {
+    CHECK(state == ELECTED || state == WRITING);
+
+    Owned<Pending> pending = queued.front();
+    queued.pop_front();
+
+    if (pending->promise.future().hasDiscard()) {
+      pending->promise.discard();
+      continue;
+    }
+
+    // NOTE: Associating also propagates a discard of the queued
+    // future to the write.
+    pending->promise.associate(_write(pending->action));
+  }
+}
+
+
 Future<WriteResponse> CoordinatorProcess::runWritePhase(const Action& action)
 {
   return log::write(quorum, network, proposal, action);
@@ -366,16 +454,16 @@ Future<Option<uint64_t> > CoordinatorProcess::checkWritePhase(
     const WriteResponse& response)
 {
   if (!response.okay()) {
-    // Received a NACK. Save the proposal number.
-    CHECK_LE(proposal, response.proposal());
-    proposal = response.proposal();
+    // Received a NACK. Save the proposal number. Note that another
+    // write in flight might have already raised it.
+    proposal = std::max(proposal, response.proposal());
 
     return None();
   }
 
   return runLearnPhase(action)
     .then(defer(self(), &Self::checkLearnPhase, action))
-    .then(defer(self(), &Self::updateIndexAfterWritten, lambda::_1));
+    .then(defer(self(), &Self::updateIndexAfterWritten, action, lambda::_1));
 }
 
 
@@ -395,38 +483,68 @@ Future<bool> CoordinatorProcess::checkLearnPhase(const Action& action)
 
 
 Future<Option<uint64_t> > CoordinatorProcess::updateIndexAfterWritten(
+    const Action& action,
     bool missing)
 {
   CHECK(!missing) << "Not expecting local replica to be missing position "
-                  << index << " after the writing is done";
+                  << action.position() << " after the writing is done";
 
-  return index++;
+  // The index was already advanced when the write was started.
+  return action.position();
 }
 
 
-void CoordinatorProcess::writingFinished()
+void CoordinatorProcess::writingFinished(
+    uint64_t position,
+    const Option<uint64_t>& written)
 {
-  CHECK_EQ(state, WRITING);
-  state = ELECTED;
+  CHECK(writes.contains(position));
+  writes.erase(position);
+
+  if (written.isNone()) {
+    // The write was rejected, i.e., another coordinator got elected.
+    // Every other write with this proposal will be rejected as well.
+    writingDemoted();
+  } else if (state == WRITING && writes.empty()) {
+    state = ELECTED;
+  }
+
+  writeQueued();
 }
 
 
-void CoordinatorProcess::writingFailed()
+void CoordinatorProcess::writingFailed(uint64_t position)
 {
-  CHECK_EQ(state, WRITING);
-  state = INITIAL;
+  CHECK(writes.contains(position));
+  writes.erase(position);
+
+  writingDemoted();
 }
 
 
-void CoordinatorProcess::writingAborted()
+void CoordinatorProcess::writingAborted(uint64_t position)
 {
-  CHECK_EQ(state, WRITING);
+  CHECK(writes.contains(position));
+  writes.erase(position);
 
   // Demote the coordinator if a write operation is discarded since we
   // don't actually know the write was successful or not and we really
   // need to "catch-up" that position before we try and do another
   // write (see MESOS-1038 for more details).
+  writingDemoted();
+}
+
+
+void CoordinatorProcess::writingDemoted()
+{
   state = INITIAL;
+
+  // A demoted coordinator returns none for every write that has not
+  // been started yet, just like for any subsequent write.
+  while (!queued.empty()) {
+    queued.front()->promise.set(Option<uint64_t>::none());
+    queued.pop_front();
+  }
 }
 
 
@@ -438,9 +556,12 @@ void CoordinatorProcess::writingAborted()
 Coordinator::Coordinator(
     size_t quorum,
     const Shared<Replica>& replica,
-    const Shared<Network>& network)
+    const Shared<Network>& network,
+    size_t window)
 {
-  process = new CoordinatorProcess(quorum, replica, network);
+  CHECK_GT(window, 0u) << "Expecting a window of at least one write";
+
+  process = new CoordinatorProcess(quorum, replica, network, window);
   spawn(process);
 }
 
@@ -42,10 +42,14 @@ class CoordinatorProcess;
 class Coordinator
 {
 public:
+  // Creates a coordinator that keeps at most 'window' writes (appends
+  // or truncates) in flight at a time. Writes beyond the window are
+  // queued and started, in order, as earlier writes complete.
   Coordinator(
       size_t _quorum,
       const process::Shared<Replica>& _replica,
-      const process::Shared<Network>& _network);
+      const process::Shared<Network>& _network,
+      size_t _window = 1);
 
   ~Coordinator();
 
@@ -62,7 +66,19 @@ public:
 
   // Appends the specified bytes to the end of the log. Returns the
   // position of the appended entry if the operation succeeds or none
-  // if the coordinator was demoted.
+  // if the coordinator was demoted. Positions are assigned in the
+  // order in which writes are issued, but with a window larger than
+  // one the writes may complete out of order. Once any write fails,
+  // gets discarded or is rejected by the replicas, the coordinator is
+  // demoted and all queued writes return none.
+  //
+  // NOTE: With a window larger than one, writes at later positions
+  // that were already in flight can still get committed after an
+  // earlier write failed, leaving the earlier position to be filled
+  // in (e.g., with a NOP) by the next elected coordinator. Callers
+  // must therefore treat the failure of any write as fatal for the
+  // writer: they can't retry just the failed write, and must not
+  // assume that the writes issued after it did not get committed.
   process::Future<Option<uint64_t> > append(const std::string& bytes);
 
   // Removes all log entries preceding the log entry at the given
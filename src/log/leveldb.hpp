@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 
+#include <list>
+
 #include <stout/option.hpp>
 
 #include "log/storage.hpp"
@@ -41,9 +43,14 @@ public:
   virtual Try<State> restore(const std::string& path);
   virtual Try<Nothing> persist(const Metadata& metadata);
   virtual Try<Nothing> persist(const Action& action);
+  virtual Try<Nothing> persist(const std::list<Action>& actions);
   virtual Try<Action> read(uint64_t position);
 
 private:
+  // Deletes the positions up to (but excluding) 'to' once a truncate
+  // action has been learned.
+  void truncate(uint64_t to);
+
   leveldb::DB* db;
 
   // First position still in leveldb, used during truncation.
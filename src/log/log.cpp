@@ -154,7 +154,7 @@ private:
 class LogWriterProcess : public Process<LogWriterProcess>
 {
 public:
-  explicit LogWriterProcess(Log* log);
+  LogWriterProcess(Log* log, size_t window);
 
   Future<Option<Log::Position> > start();
   Future<Option<Log::Position> > append(const string& bytes);
@@ -183,6 +183,7 @@ private:
 
   const size_t quorum;
   const Shared<Network> network;
+  const size_t window;
 
   Future<Shared<Replica> > recovering;
   list<process::Promise<Nothing>*> promises;
@@ -567,10 +568,11 @@ Log::Position LogReaderProcess::position(uint64_t value)
 /////////////////////////////////////////////////
 
 
-LogWriterProcess::LogWriterProcess(Log* log)
+LogWriterProcess::LogWriterProcess(Log* log, size_t _window)
   : ProcessBase(ID::generate("log-writer")),
     quorum(log->process->quorum),
     network(log->process->network),
+    window(_window),
     recovering(dispatch(log->process, &LogProcess::recover)),
     coordinator(NULL),
     error(None()) {}
@@ -656,7 +658,7 @@ Future<Option<Log::Position> > LogWriterProcess::_start()
 
   CHECK_READY(recovering);
 
-  coordinator = new Coordinator(quorum, recovering.get(), network);
+  coordinator = new Coordinator(quorum, recovering.get(), network, window);
 
   LOG(INFO) << "Attempting to start the writer";
 
@@ -835,9 +837,9 @@ Future<Log::Position> Log::Reader::ending()
 /////////////////////////////////////////////////
 
 
-Log::Writer::Writer(Log* log)
+Log::Writer::Writer(Log* log, size_t window)
 {
-  process = new LogWriterProcess(log);
+  process = new LogWriterProcess(log, window);
   spawn(process);
 }
 
@@ -157,8 +157,11 @@ public:
     // one writer (local or remote) can be valid at any point in
     // time. A writer becomes invalid if either Writer::append or
     // Writer::truncate return None, in which case, the writer (or
-    // another writer) must be restarted.
-    explicit Writer(Log* log);
+    // another writer) must be restarted. Up to 'window' appends and
+    // truncates can be in flight at a time, further ones are queued
+    // until earlier ones complete (see Coordinator::append for what a
+    // failure means when more than one is in flight).
+    explicit Writer(Log* log, size_t window = 1);
     ~Writer();
 
     // Attempts to get a promise (from the log's replicas) for
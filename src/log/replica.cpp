@@ -53,6 +53,7 @@ namespace protocol {
 Protocol<PromiseRequest, PromiseResponse> promise;
 Protocol<WriteRequest, WriteResponse> write;
 Protocol<RecoverRequest, RecoverResponse> recover;
+Protocol<ReadRequest, ReadResponse> read;
 
 } // namespace protocol {
 
@@ -102,6 +103,10 @@ public:
   // the disk. Returns true on success and false otherwise.
   bool update(const Metadata::Status& status);
 
+  // Persists the specified learned actions with a single write.
+  // Returns true on success and false otherwise.
+  bool learn(const list<Action>& actions);
+
 private:
   // Handles a request from a proposer to promise not to accept writes
   // from any other proposer with lower proposal number.
@@ -113,6 +118,9 @@ private:
   // Handles a request from a recover process.
   void recover(const RecoverRequest& request);
 
+  // Handles a request from a catch-up process for learned actions.
+  void read(const ReadRequest& request);
+
   // Handles a message notifying of a learned action.
   void learned(const Action& action);
 
@@ -120,6 +128,10 @@ private:
   // specified argument. Returns true on success and false otherwise.
   bool persist(const Action& action);
 
+  // Helper routine that updates the cached positions (i.e., begin,
+  // end, holes and unlearned) after an action has been persisted.
+  void persisted(const Action& action);
+
   // Helper routines that update metadata corresponding to the
   // specified argument. The update will be persisted on the disk.
   // Returns true on success and false otherwise.
@@ -169,6 +181,11 @@ ReplicaProcess::ReplicaProcess(const string& path)
   install<RecoverRequest>(
       &ReplicaProcess::recover);
 
+  // Need to disambiguate overloaded function.
+  void (ReplicaProcess::*read)(const ReadRequest&) = &ReplicaProcess::read;
+
+  install<ReadRequest>(read);
+
   install<LearnedMessage>(
       &ReplicaProcess::learned,
       &LearnedMessage::action);
@@ -653,6 +670,77 @@ void ReplicaProcess::recover(const RecoverRequest& request)
 }
 
 
+void ReplicaProcess::read(const ReadRequest& request)
+{
+  // Only a VOTING replica knows that its learned actions (and its
+  // beginning position) are up to date enough to be served.
+  if (status() != Metadata::VOTING) {
+    LOG(INFO) << "Replica rejecting read request as it is in "
+              << status() << " status";
+
+    ReadResponse response;
+    response.set_okay(false);
+    reply(response);
+    return;
+  }
+
+  LOG(INFO) << "Replica received read request for positions "
+            << request.from() << " -> " << request.to();
+
+  ReadResponse response;
+  response.set_okay(true);
+
+  size_t size = 0;
+  uint64_t position = request.from();
+
+  for (; position <= request.to() && position <= end; position++) {
+    if (request.has_bytes() &&
+        response.actions_size() > 0 &&
+        size >= request.bytes()) {
+      break;
+    }
+
+    if (position < begin) {
+      // Tell the reader that truncated positions are learned no-ops,
+      // for the same reasons as in 'promise' above.
+      Action* action = response.add_actions();
+      action->set_position(position);
+      action->set_promised(promised());
+      action->set_performed(promised());
+      action->set_learned(true);
+      action->set_type(Action::NOP);
+      action->mutable_nop()->MergeFrom(Action::Nop());
+      size += action->ByteSize();
+      continue;
+    }
+
+    Result<Action> result = read(position);
+
+    if (result.isError()) {
+      LOG(ERROR) << "Error getting log record at " << position
+                 << ": " << result.error();
+
+      // Let the reader fall back to filling these positions.
+      response.Clear();
+      response.set_okay(false);
+      reply(response);
+      return;
+    } else if (result.isSome() &&
+               result.get().has_learned() &&
+               result.get().learned()) {
+      response.add_actions()->CopyFrom(result.get());
+      size += result.get().ByteSize();
+    }
+  }
+
+  // The positions past our end are not known here, but they are
+  // covered by this response anyway (i.e., none of them is learned).
+  response.set_to(position > end ? request.to() : position - 1);
+
+  reply(response);
+}
+
+
 void ReplicaProcess::learned(const Action& action)
 {
   LOG(INFO) << "Replica received learned notice for position "
@@ -667,6 +755,36 @@ void ReplicaProcess::learned(const Action& action)
 }
 
 
+bool ReplicaProcess::learn(const list<Action>& actions)
+{
+  // Skip the actions at truncated positions (i.e., an action that
+  // was read after the truncation was learned).
+  list<Action> learned;
+  foreach (const Action& action, actions) {
+    CHECK(action.has_learned() && action.learned());
+
+    if (action.position() >= begin) {
+      learned.push_back(action);
+    }
+  }
+
+  Try<Nothing> persisted = storage->persist(learned);
+
+  if (persisted.isError()) {
+    LOG(ERROR) << "Error writing to log: " << persisted.error();
+    return false;
+  }
+
+  LOG(INFO) << "Persisted " << learned.size() << " learned actions";
+
+  foreach (const Action& action, learned) {
+    this->persisted(action);
+  }
+
+  return true;
+}
+
+
 bool ReplicaProcess::persist(const Action& action)
 {
   Try<Nothing> persisted = storage->persist(action);
@@ -678,6 +796,14 @@ bool ReplicaProcess::persist(const Action& action)
 
   LOG(INFO) << "Persisted action at " << action.position();
 
+  this->persisted(action);
+
+  return true;
+}
+
+
+void ReplicaProcess::persisted(const Action& action)
+{
   // No longer a hole here (if there even was one).
   holes -= action.position();
 
@@ -712,8 +838,6 @@ bool ReplicaProcess::persist(const Action& action)
 
   // And update the end position.
   end = std::max(end, action.position());
-
-  return true;
 }
 
 
@@ -816,6 +940,12 @@ Future<bool> Replica::update(const Metadata::Status& status)
 }
 
 
+Future<bool> Replica::learn(const list<Action>& actions) const
+{
+  return dispatch(process, &ReplicaProcess::learn, actions);
+}
+
+
 PID<ReplicaProcess> Replica::pid() const
 {
   return process->self();
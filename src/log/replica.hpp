@@ -42,6 +42,7 @@ namespace protocol {
 extern Protocol<PromiseRequest, PromiseResponse> promise;
 extern Protocol<WriteRequest, WriteResponse> write;
 extern Protocol<RecoverRequest, RecoverResponse> recover;
+extern Protocol<ReadRequest, ReadResponse> read;
 
 } // namespace protocol {
 
@@ -94,6 +95,12 @@ public:
   // Updates the status of this replica.
   process::Future<bool> update(const Metadata::Status& status);
 
+  // Persists the specified learned actions (e.g., those read from
+  // other replicas during catch-up) with a single write. Actions at
+  // positions that have been truncated are skipped. Returns true on
+  // success and false otherwise.
+  process::Future<bool> learn(const std::list<Action>& actions) const;
+
   // Returns the PID associated with this replica.
   process::PID<ReplicaProcess> pid() const;
 
@@ -19,9 +19,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include <algorithm>
+#include <deque>
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <utility>
 
 #include <process/clock.hpp>
 #include <process/future.hpp>
@@ -31,6 +34,7 @@
 #include <stout/bytes.hpp>
 #include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/numify.hpp>
 #include <stout/stopwatch.hpp>
 #include <stout/strings.hpp>
 #include <stout/os/read.hpp>
@@ -44,10 +48,12 @@
 using namespace process;
 
 using std::cout;
+using std::deque;
 using std::endl;
 using std::ifstream;
 using std::ofstream;
 using std::ostringstream;
+using std::pair;
 using std::string;
 using std::vector;
 
@@ -91,6 +97,13 @@ Benchmark::Flags::Flags()
       "  random: all bits are randomly chosen\n",
       "random");
 
+  add(&Flags::windows,
+      "windows",
+      "Comma separated list of window sizes, i.e., the maximum number\n"
+      "of appends in flight at a time. The trace is replayed once for\n"
+      "each window size (e.g. 1,4,16)",
+      "1");
+
   add(&Flags::initialize,
       "initialize",
       "Whether to initialize the log",
@@ -113,7 +126,9 @@ string Benchmark::usage(const string& argv0) const
       << "replicated log. It takes a trace file of write sizes" << endl
       << "and replay that trace to measure the latency of each" << endl
       << "write. The data to be written for each write can be" << endl
-      << "specified using the '--type' flag." << endl
+      << "specified using the '--type' flag. The trace can be" << endl
+      << "replayed with multiple writes in flight using the" << endl
+      << "'--windows' flag to measure the throughput." << endl
       << endl
       << "Supported OPTIONS:" << endl
       << flags.usage();
@@ -163,6 +178,20 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
     return Error("Missing flag '--output'");
   }
 
+  vector<size_t> windows;
+  foreach (const string& token, strings::tokenize(flags.windows, ",")) {
+    Try<size_t> window = numify<size_t>(strings::trim(token));
+    if (window.isError() || window.get() == 0) {
+      return Error("Invalid window size '" + token + "'");
+    }
+
+    windows.push_back(window.get());
+  }
+
+  if (windows.empty()) {
+    return Error("Missing window sizes in flag '--windows'");
+  }
+
   // Initialize the log.
   if (flags.initialize) {
     Initialize initialize;
@@ -182,24 +211,8 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
       Seconds(10),
       flags.znode.get());
 
-  // Create the log writer.
-  Log::Writer writer(&log);
-
-  Future<Option<Log::Position> > position = writer.start();
-
-  if (!position.await(Seconds(15))) {
-    return Error("Failed to start a log writer: timed out");
-  } else if (!position.isReady()) {
-    return Error("Failed to start a log writer: " +
-                 (position.isFailed()
-                  ? position.failure()
-                  : "Discarded future"));
-  }
-
-  // Statistics to output.
+  // Sizes of the appends.
   vector<Bytes> sizes;
-  vector<Duration> durations;
-  vector<Time> timestamps;
 
   // Read sizes from the input trace file.
   ifstream input(flags.input.get().c_str());
@@ -232,43 +245,101 @@ Try<Nothing> Benchmark::execute(int argc, char** argv)
     }
   }
 
-  Stopwatch stopwatch;
-  stopwatch.start();
+  Bytes total;
+  foreach (const Bytes& size, sizes) {
+    total += size;
+  }
 
-  for (size_t i = 0; i < sizes.size(); i++) {
-    Stopwatch stopwatch;
-    stopwatch.start();
+  ofstream output(flags.output.get().c_str());
+  if (!output.is_open()) {
+    return Error("Failed to open the output file " + flags.output.get());
+  }
 
-    position = writer.append(data[i]);
+  foreach (size_t window, windows) {
+    // Every window size gets a new writer, which also demotes the
+    // writer used for the previous window size.
+    Log::Writer writer(&log, window);
 
-    if (!position.await(Seconds(10))) {
-      return Error("Failed to append: timed out");
+    Future<Option<Log::Position> > position = writer.start();
+
+    if (!position.await(Seconds(15))) {
+      return Error("Failed to start a log writer: timed out");
     } else if (!position.isReady()) {
-      return Error("Failed to append: " +
+      return Error("Failed to start a log writer: " +
                    (position.isFailed()
                     ? position.failure()
                     : "Discarded future"));
-    } else if (position.get().isNone()) {
-      return Error("Failed to append: exclusive write promise lost");
     }
 
-    durations.push_back(stopwatch.elapsed());
-    timestamps.push_back(Clock::now());
-  }
+    // Statistics to output.
+    vector<Duration> durations;
+    vector<Time> timestamps;
 
-  cout << "Total number of appends: " << sizes.size() << endl;
-  cout << "Total time used: " << stopwatch.elapsed() << endl;
+    // The appends in flight and the times at which they were issued.
+    // Since appends are waited for in order, the latency of an append
+    // includes any time it completed before an earlier append.
+    deque<pair<Future<Option<Log::Position> >, Time> > appending;
 
-  // Ouput statistics.
-  ofstream output(flags.output.get().c_str());
-  if (!output.is_open()) {
-    return Error("Failed to open the output file " + flags.output.get());
-  }
+    Stopwatch stopwatch;
+    stopwatch.start();
 
-  for (size_t i = 0; i < sizes.size(); i++) {
-    output << timestamps[i]
-           << " Appended " << sizes[i].bytes() << " bytes"
-           << " in " << durations[i].ms() << " ms" << endl;
+    size_t issued = 0;
+    while (issued < sizes.size() || !appending.empty()) {
+      if (issued < sizes.size() && appending.size() < window) {
+        appending.push_back(
+            std::make_pair(writer.append(data[issued]), Clock::now()));
+        issued++;
+        continue;
+      }
+
+      position = appending.front().first;
+
+      if (!position.await(Seconds(10))) {
+        return Error("Failed to append: timed out");
+      } else if (!position.isReady()) {
+        return Error("Failed to append: " +
+                     (position.isFailed()
+                      ? position.failure()
+                      : "Discarded future"));
+      } else if (position.get().isNone()) {
+        return Error("Failed to append: exclusive write promise lost");
+      }
+
+      timestamps.push_back(Clock::now());
+      durations.push_back(timestamps.back() - appending.front().second);
+      appending.pop_front();
+    }
+
+    Duration elapsed = stopwatch.elapsed();
+
+    vector<Duration> sorted = durations;
+    std::sort(sorted.begin(), sorted.end());
+
+    Duration sum;
+    foreach (const Duration& duration, durations) {
+      sum += duration;
+    }
+
+    cout << "Window size: " << window << endl
+         << "  Total number of appends: " << sizes.size() << endl
+         << "  Total time used: " << elapsed << endl
+         << "  Throughput: " << sizes.size() / elapsed.secs()
+         << " appends/sec, " << total / elapsed.secs() << "/sec" << endl;
+
+    if (!sorted.empty()) {
+      cout << "  Latency: mean " << sum / sorted.size()
+           << ", p50 " << sorted[sorted.size() / 2]
+           << ", p99 " << sorted[sorted.size() * 99 / 100]
+           << ", max " << sorted.back() << endl;
+    }
+
+    // Ouput statistics.
+    for (size_t i = 0; i < sizes.size(); i++) {
+      output << timestamps[i]
+             << " Appended " << sizes[i].bytes() << " bytes"
+             << " in " << durations[i].ms() << " ms"
+             << " (window " << window << ")" << endl;
+    }
   }
 
   output.close();
@@ -23,6 +23,7 @@
 #include <process/process.hpp>
 
 #include <stout/error.hpp>
+#include <stout/stopwatch.hpp>
 
 #include "log/log.hpp"
 #include "log/tool/initialize.hpp"
@@ -32,6 +33,7 @@
 
 using namespace process;
 
+using std::cout;
 using std::endl;
 using std::ostringstream;
 using std::string;
@@ -77,7 +79,10 @@ string Replica::usage(const string& argv0) const
 
   out << "Usage: " << argv0 << " " << name() << " [OPTIONS]" << endl
       << endl
-      << "This command is used to start a replica server" << endl
+      << "This command is used to start a replica server. It" << endl
+      << "reports how long it took the replica to recover (i.e.," << endl
+      << "to catch-up any positions it has missed) before it" << endl
+      << "starts serving." << endl
       << endl
       << "Supported OPTIONS:" << endl
       << flags.usage();
@@ -138,6 +143,25 @@ Try<Nothing> Replica::execute(int argc, char** argv)
       Seconds(10),
       flags.znode.get());
 
+  Stopwatch stopwatch;
+  stopwatch.start();
+
+  // Reading from the log waits for the local replica to recover. The
+  // catch-up throughput is logged by the replica while it recovers.
+  Log::Reader reader(&log);
+
+  Future<Log::Position> ending = reader.ending();
+  ending.await();
+
+  if (!ending.isReady()) {
+    return Error("Failed to recover the replica: " +
+                 (ending.isFailed()
+                  ? ending.failure()
+                  : "Discarded future"));
+  }
+
+  cout << "Replica recovered in " << stopwatch.elapsed() << endl;
+
   // Loop forever.
   Future<Nothing>().get();
 
@@ -61,6 +61,10 @@ HierarchicalDRFAllocator;
 
 // Implements the basic allocator algorithm - first pick a role by
 // some criteria, then pick one of their frameworks to allocate to.
+//
+// NOTE: Besides implementing the Sorter interface, the sorters need
+// to provide begin() and end() for iterating over their clients in
+// sort order without copying them (see DRFSorter).
 template <typename RoleSorter, typename FrameworkSorter>
 class HierarchicalAllocatorProcess : public MesosAllocatorProcess
 {
@@ -204,6 +208,9 @@ protected:
   //   Both reserved resources and unreserved resources are used
   //   in the fairness calculation. This is because reserved
   //   resources can be allocated to any framework in the role.
+  //   The shares are relative to the total resources of the
+  //   cluster, so that an allocation only changes the share of
+  //   the framework that it is made to.
   RoleSorter* roleSorter;
   hashmap<std::string, FrameworkSorter*> frameworkSorters;
 };
@@ -316,7 +323,6 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::addFramework(
   // the sorters for each slave instead.
   Resources used = Resources::sum(used_);
   roleSorter->allocated(role, used.unreserved());
-  frameworkSorters[role]->add(used);
   frameworkSorters[role]->allocated(frameworkId.value(), used);
 
   frameworks[frameworkId] = Framework();
@@ -346,7 +352,6 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::removeFramework(
       frameworkSorters[role]->allocation(frameworkId.value());
 
     roleSorter->unallocated(role, allocation.unreserved());
-    frameworkSorters[role]->remove(allocation);
     frameworkSorters[role]->remove(frameworkId.value());
   }
 
@@ -419,6 +424,10 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::addSlave(
 
   roleSorter->add(total.unreserved());
 
+  foreachvalue (FrameworkSorter* frameworkSorter, frameworkSorters) {
+    frameworkSorter->add(total);
+  }
+
   foreachpair (const FrameworkID& frameworkId,
                const Resources& allocated,
                used) {
@@ -429,7 +438,6 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::addSlave(
       // framework's role.
 
       roleSorter->allocated(role, allocated.unreserved());
-      frameworkSorters[role]->add(allocated);
       frameworkSorters[role]->allocated(frameworkId.value(), allocated);
     }
   }
@@ -465,6 +473,10 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::removeSlave(
 
   roleSorter->remove(slaves[slaveId].total.unreserved());
 
+  foreachvalue (FrameworkSorter* frameworkSorter, frameworkSorters) {
+    frameworkSorter->remove(slaves[slaveId].total);
+  }
+
   slaves.erase(slaveId);
 
   // Note that we DO NOT actually delete any filters associated with
@@ -557,22 +569,33 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::updateAllocation(
   // in turns leads to an update of the total. The available resources
   // remain unchanged.
 
-  FrameworkSorter* frameworkSorter =
-    frameworkSorters[frameworks[frameworkId].role];
+  const std::string& role = frameworks[frameworkId].role;
 
-  Resources allocation = frameworkSorter->allocation(frameworkId.value());
+  Resources allocation =
+    frameworkSorters[role]->allocation(frameworkId.value());
 
   // Update the allocated resources.
   Try<Resources> updatedAllocation = allocation.apply(operations);
   CHECK_SOME(updatedAllocation);
 
-  frameworkSorter->update(
-      frameworkId.value(),
-      allocation,
-      updatedAllocation.get());
+  // The update of the allocation changes the total resources as
+  // well, which all of the framework sorters are based on.
+  foreachpair (const std::string& name,
+               FrameworkSorter* frameworkSorter,
+               frameworkSorters) {
+    if (name == role) {
+      frameworkSorter->update(
+          frameworkId.value(),
+          allocation,
+          updatedAllocation.get());
+    } else {
+      frameworkSorter->remove(allocation);
+      frameworkSorter->add(updatedAllocation.get());
+    }
+  }
 
   roleSorter->update(
-      frameworks[frameworkId].role,
+      role,
       allocation.unreserved(),
       updatedAllocation.get().unreserved());
 
@@ -623,7 +646,6 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::recoverResources(
 
     if (frameworkSorters[role]->contains(frameworkId.value())) {
       frameworkSorters[role]->unallocated(frameworkId.value(), resources);
-      frameworkSorters[role]->remove(resources);
       roleSorter->unallocated(role, resources.unreserved());
     }
   }
@@ -778,22 +800,35 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocate(
       continue;
     }
 
-    foreach (const std::string& role, roleSorter->sort()) {
-      foreach (const std::string& frameworkId_,
-               frameworkSorters[role]->sort()) {
-        FrameworkID frameworkId;
-        frameworkId.set_value(frameworkId_);
-
-        // NOTE: Currently, frameworks are allowed to have '*' role.
-        // Calling reserved('*') returns an empty Resources object.
-        Resources resources =
-          slaves[slaveId].available.unreserved() +
-          slaves[slaveId].available.reserved(role);
+    // The frameworks (if any) that get allocated the resources of
+    // this slave, by role. We only update the sorters once we've
+    // looked at all the roles, because allocating to a client changes
+    // its position in the sort order and we iterate over the sorters
+    // directly rather than over a copy of them (see DRFSorter). Note
+    // that this does not change the allocation decisions: the order
+    // of the roles was already determined when we started iterating
+    // and a framework sorter is only looked at for its own role.
+    hashmap<std::string, FrameworkID> allocations;
+
+    foreach (const Client& role, *roleSorter) {
+      // NOTE: Currently, frameworks are allowed to have '*' role.
+      // Calling reserved('*') returns an empty Resources object.
+      //
+      // NOTE: These are the same for every framework in the role
+      // since we always allocate all of them to a single framework,
+      // see below.
+      Resources resources =
+        slaves[slaveId].available.unreserved() +
+        slaves[slaveId].available.reserved(role.name);
+
+      // If the resources are not allocatable, ignore.
+      if (!allocatable(resources)) {
+        continue;
+      }
 
-        // If the resources are not allocatable, ignore.
-        if (!allocatable(resources)) {
-          continue;
-        }
+      foreach (const Client& framework, *frameworkSorters[role.name]) {
+        FrameworkID frameworkId;
+        frameworkId.set_value(framework.name);
 
         // If the framework filters these resources, ignore.
         if (isFiltered(frameworkId, slaveId, resources)) {
@@ -805,18 +840,27 @@ HierarchicalAllocatorProcess<RoleSorter, FrameworkSorter>::allocate(
 
         // Note that we perform "coarse-grained" allocation,
         // meaning that we always allocate the entire remaining
-        // slave resources to a single framework.
+        // slave resources to a single framework. Hence there is
+        // nothing left for the other frameworks in this role.
         offerable[frameworkId][slaveId] = resources;
         slaves[slaveId].available -= resources;
 
-        // Reserved resources are only accounted for in the framework
-        // sorter, since the reserved resources are not shared across
-        // roles.
-        frameworkSorters[role]->add(resources);
-        frameworkSorters[role]->allocated(frameworkId_, resources);
-        roleSorter->allocated(role, resources.unreserved());
+        allocations[role.name] = frameworkId;
+        break;
       }
     }
+
+    foreachpair (const std::string& role,
+                 const FrameworkID& frameworkId,
+                 allocations) {
+      const Resources& resources = offerable[frameworkId][slaveId];
+
+      // Reserved resources are only accounted for in the framework
+      // sorter, since the reserved resources are not shared across
+      // roles.
+      frameworkSorters[role]->allocated(frameworkId.value(), resources);
+      roleSorter->allocated(role, resources.unreserved());
+    }
   }
 
   if (offerable.empty()) {
@@ -42,12 +42,28 @@ bool DRFComparator::operator () (const Client& client1, const Client& client2)
 }
 
 
+// Returns the sums of the scalar resources by resource name.
+static hashmap<string, double> scalarTotals(const Resources& resources)
+{
+  hashmap<string, double> result;
+
+  foreach (const Resource& resource, resources) {
+    if (resource.type() == Value::SCALAR) {
+      result[resource.name()] += resource.scalar().value();
+    }
+  }
+
+  return result;
+}
+
+
 void DRFSorter::add(const string& name, double weight)
 {
   Client client(name, 0, 0);
-  clients.insert(client);
+  insert(client);
 
   allocations[name] = Resources();
+  scalars[name] = hashmap<string, double>();
   weights[name] = weight;
 }
 
@@ -57,10 +73,11 @@ void DRFSorter::remove(const string& name)
   set<Client, DRFComparator>::iterator it = find(name);
 
   if (it != clients.end()) {
-    clients.erase(it);
+    erase(it);
   }
 
   allocations.erase(name);
+  scalars.erase(name);
   weights.erase(name);
 }
 
@@ -70,7 +87,7 @@ void DRFSorter::activate(const string& name)
   CHECK(allocations.contains(name));
 
   Client client(name, calculateShare(name), 0);
-  clients.insert(client);
+  insert(client);
 }
 
 
@@ -83,7 +100,7 @@ void DRFSorter::deactivate(const string& name)
     // because we lose information such as the number of allocations
     // for this client which means the fairness can be gamed by a
     // framework disconnecting and reconnecting.
-    clients.erase(it);
+    erase(it);
   }
 }
 
@@ -92,27 +109,33 @@ void DRFSorter::allocated(
     const string& name,
     const Resources& resources)
 {
+  allocations[name] += resources;
+
+  // Only the scalars that are allocated need to be updated.
+  foreachpair (const string& scalar,
+               double value,
+               scalarTotals(resources)) {
+    scalars[name][scalar] += value;
+  }
+
   set<Client, DRFComparator>::iterator it = find(name);
 
   if (it != clients.end()) { // TODO(benh): This should really be a CHECK.
-    // TODO(benh): Refactor 'update' to be able to reuse it here.
     Client client(*it);
 
     // Update the 'allocations' to reflect the allocator decision.
     client.allocations++;
 
-    // Remove and reinsert it to update the ordering appropriately.
-    clients.erase(it);
-    clients.insert(client);
-  }
-
-  allocations[name] += resources;
+    // If the total resources have changed, we're going to
+    // recalculate all the shares, so don't bother just
+    // updating this client.
+    if (!dirty) {
+      client.share = calculateShare(name);
+    }
 
-  // If the total resources have changed, we're going to
-  // recalculate all the shares, so don't bother just
-  // updating this client.
-  if (!dirty) {
-    update(name);
+    // Remove and reinsert it to update the ordering appropriately.
+    erase(it);
+    insert(client);
   }
 }
 
@@ -133,11 +156,13 @@ void DRFSorter::update(
 
   resources -= oldAllocation;
   resources += newAllocation;
+  totals = scalarTotals(resources);
 
   CHECK(allocations[name].contains(oldAllocation));
 
   allocations[name] -= oldAllocation;
   allocations[name] += newAllocation;
+  scalars[name] = scalarTotals(allocations[name]);
 
   // Just assume the total has changed, per the TODO above.
   dirty = true;
@@ -156,6 +181,7 @@ void DRFSorter::unallocated(
     const Resources& resources)
 {
   allocations[name] -= resources;
+  scalars[name] = scalarTotals(allocations[name]);
 
   if (!dirty) {
     update(name);
@@ -167,6 +193,13 @@ void DRFSorter::add(const Resources& _resources)
 {
   resources += _resources;
 
+  // Only the scalars that are added need to be updated.
+  foreachpair (const string& name,
+               double value,
+               scalarTotals(_resources)) {
+    totals[name] += value;
+  }
+
   // We have to recalculate all shares when the total resources
   // change, but we put it off until sort is called
   // so that if something else changes before the next allocation
@@ -178,36 +211,53 @@ void DRFSorter::add(const Resources& _resources)
 void DRFSorter::remove(const Resources& _resources)
 {
   resources -= _resources;
+
+  // NOTE: We recompute the totals rather than subtracting from them
+  // so that rounding errors don't leave behind a tiny total for a
+  // resource that is gone.
+  totals = scalarTotals(resources);
+
   dirty = true;
 }
 
 
 list<string> DRFSorter::sort()
+{
+  list<string> result;
+
+  for (const_iterator it = begin(); it != end(); it++) {
+    result.push_back((*it).name);
+  }
+
+  return result;
+}
+
+
+DRFSorter::const_iterator DRFSorter::begin()
 {
   if (dirty) {
     set<Client, DRFComparator> temp;
+    temp.swap(clients);
 
-    set<Client, DRFComparator>::iterator it;
-    for (it = clients.begin(); it != clients.end(); it++) {
-      Client client(*it);
+    positions.clear();
 
+    foreach (Client client, temp) {
       // Update the 'share' to get proper sorting.
       client.share = calculateShare(client.name);
 
-      temp.insert(client);
+      insert(client);
     }
 
-    clients = temp;
+    dirty = false;
   }
 
-  list<string> result;
+  return clients.begin();
+}
 
-  set<Client, DRFComparator>::iterator it;
-  for (it = clients.begin(); it != clients.end(); it++) {
-    result.push_back((*it).name);
-  }
 
-  return result;
+DRFSorter::const_iterator DRFSorter::end()
+{
+  return clients.end();
 }
 
 
@@ -234,8 +284,8 @@ void DRFSorter::update(const string& name)
     client.share = calculateShare(client.name);
 
     // Remove and reinsert it to update the ordering appropriately.
-    clients.erase(it);
-    clients.insert(client);
+    erase(it);
+    insert(client);
   }
 }
 
@@ -249,27 +299,16 @@ double DRFSorter::calculateShare(const string& name)
   // scalars.
 
   // Scalar resources may be spread across multiple 'Resource'
-  // objects. E.g. persistent volumes. So we first collect the names
-  // of the scalar resources, before computing the totals.
-  hashset<string> scalars;
-  foreach (const Resource& resource, resources) {
-    if (resource.type() == Value::SCALAR) {
-      scalars.insert(resource.name());
-    }
-  }
-
-  foreach (const string& scalar, scalars) {
-    Option<Value::Scalar> total = resources.get<Value::Scalar>(scalar);
+  // objects. E.g. persistent volumes. So we use the totals of the
+  // scalar resources by name (see 'totals' and 'scalars').
+  const hashmap<string, double>& allocation = scalars[name];
 
-    if (total.isSome() && total.get().value() > 0) {
-      Option<Value::Scalar> allocation =
-        allocations[name].get<Value::Scalar>(scalar);
+  foreachpair (const string& scalar, double total, totals) {
+    if (total > 0) {
+      Option<double> allocated = allocation.get(scalar);
 
-      if (allocation.isNone()) {
-        allocation = Value::Scalar();
-      }
-
-      share = std::max(share, allocation.get().value() / total.get().value());
+      share = std::max(
+          share, (allocated.isSome() ? allocated.get() : 0) / total);
     }
   }
 
@@ -279,14 +318,24 @@ double DRFSorter::calculateShare(const string& name)
 
 set<Client, DRFComparator>::iterator DRFSorter::find(const string& name)
 {
-  set<Client, DRFComparator>::iterator it;
-  for (it = clients.begin(); it != clients.end(); it++) {
-    if (name == (*it).name) {
-      break;
-    }
+  if (!positions.contains(name)) {
+    return clients.end();
   }
 
-  return it;
+  return positions[name];
+}
+
+
+void DRFSorter::insert(const Client& client)
+{
+  positions[client.name] = clients.insert(client).first;
+}
+
+
+void DRFSorter::erase(set<Client, DRFComparator>::iterator it)
+{
+  positions.erase((*it).name);
+  clients.erase(it);
 }
 
 } // namespace allocator {
@@ -63,6 +63,15 @@ struct DRFComparator
 class DRFSorter : public Sorter
 {
 public:
+  // Iterators over the active clients in the order that they should
+  // be allocated to. Unlike sort() these do not copy the clients,
+  // but note that any call which updates an allocation or the total
+  // resources may reorder the clients and invalidate the iterators.
+  typedef std::set<Client, DRFComparator>::const_iterator const_iterator;
+  typedef const_iterator iterator;
+
+  DRFSorter() : dirty(false) {}
+
   virtual ~DRFSorter() {}
 
   virtual void add(const std::string& name, double weight = 1);
@@ -91,6 +100,11 @@ public:
 
   virtual std::list<std::string> sort();
 
+  // Recalculates all the shares first if the total resources have
+  // changed since the last call, so that the clients are in order.
+  const_iterator begin();
+  const_iterator end();
+
   virtual bool contains(const std::string& name);
 
   virtual int count();
@@ -107,15 +121,34 @@ private:
   // it exists in this Sorter.
   std::set<Client, DRFComparator>::iterator find(const std::string& name);
 
-  // If true, start() will recalculate all shares.
+  // (Re)inserts the client into 'clients' and 'positions'.
+  void insert(const Client& client);
+
+  // Removes the client at the specified position.
+  void erase(std::set<Client, DRFComparator>::iterator it);
+
+  // If true, begin() will recalculate all shares.
   bool dirty;
 
   // A set of Clients (names and shares) sorted by share.
   std::set<Client, DRFComparator> clients;
 
+  // Maps the active client names to their position in 'clients' so
+  // we don't need to search the set for a client.
+  hashmap<std::string, std::set<Client, DRFComparator>::iterator> positions;
+
   // Maps client names to the resources they have been allocated.
   hashmap<std::string, Resources> allocations;
 
+  // The sums of the scalar resources in 'allocations' and 'resources'
+  // by resource name, so that calculating a share does not need to
+  // walk the resources (which matters when the total resources change
+  // and all the shares need to be recalculated). The sums are
+  // updated incrementally when resources are added or allocated and
+  // recomputed when resources are removed or unallocated.
+  hashmap<std::string, hashmap<std::string, double> > scalars;
+  hashmap<std::string, double> totals;
+
   // Maps client names to the weights that should be applied to their shares.
   hashmap<std::string, double> weights;
 
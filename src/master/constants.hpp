@@ -98,6 +98,10 @@ extern const Duration WHITELIST_WATCH_INTERVAL;
 // Default number of tasks (limit) for /master/tasks.json endpoint.
 extern const uint32_t TASK_LIMIT;
 
+// Default amount of events buffered for a subscriber of the
+// /master/events endpoint before it gets dropped.
+extern const Bytes DEFAULT_MAX_EVENT_BACKLOG;
+
 // Label used by the Leader Contender and Detector.
 extern const std::string MASTER_INFO_LABEL;
 
@@ -81,6 +81,15 @@ mesos::internal::master::Flags::Flags()
       "production yet.",
       false);
 
+  add(&Flags::registry_deltas,
+      "registry_deltas",
+      "Whether the Registrar persists the changes made by each batch of\n"
+      "operations (e.g., admitting or removing slaves) as separate,\n"
+      "small entries instead of rewriting the entire registry. The\n"
+      "entries are compacted into the registry once they get as large\n"
+      "as the registry itself.",
+      false);
+
   add(&Flags::registry_fetch_timeout,
       "registry_fetch_timeout",
       "Duration of time to wait in order to fetch data from the registry\n"
@@ -100,6 +109,14 @@ mesos::internal::master::Flags::Flags()
       "initialized when used for the very first time.",
       true);
 
+  add(&Flags::registry_checkpoint,
+      "registry_checkpoint",
+      "Whether to keep a local checkpoint of the registry read from the\n"
+      "replicated log (in the work directory) so that a newly elected\n"
+      "master only needs to read the log entries written since the\n"
+      "checkpoint rather than the entire log.",
+      false);
+
   add(&Flags::slave_reregister_timeout,
       "slave_reregister_timeout",
       "The timeout within which all slaves are expected to re-register\n"
@@ -292,6 +309,14 @@ mesos::internal::master::Flags::Flags()
       "This helps fairness when running frameworks that hold on to offers,\n"
       "or frameworks that accidentally drop offers.");
 
+  add(&Flags::max_event_backlog,
+      "max_event_backlog",
+      "Maximum amount of events (in bytes) buffered for a subscriber of\n"
+      "the /master/events stream that doesn't keep up with reading them.\n"
+      "Once exceeded, the stream of the subscriber is closed (after which\n"
+      "it can subscribe again to receive the current state).",
+      DEFAULT_MAX_EVENT_BACKLOG);
+
   // This help message for --modules flag is the same for
   // {master,slave,tests}/flags.hpp and should always be kept in
   // sync.
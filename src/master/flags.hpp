@@ -21,6 +21,7 @@
 
 #include <string>
 
+#include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/option.hpp>
 #include <stout/path.hpp>
@@ -46,9 +47,11 @@ public:
   Option<int> quorum;
   Duration zk_session_timeout;
   bool registry_strict;
+  bool registry_deltas;
   Duration registry_fetch_timeout;
   Duration registry_store_timeout;
   bool log_auto_initialize;
+  bool registry_checkpoint;
   Duration slave_reregister_timeout;
   std::string recovery_slave_removal_limit;
   Option<std::string> slave_removal_rate_limit;
@@ -66,6 +69,7 @@ public:
   Option<ACLs> acls;
   Option<RateLimits> rate_limits;
   Option<Duration> offer_timeout;
+  Bytes max_event_backlog;
   Option<Modules> modules;
   std::string authenticators;
   Option<std::string> hooks;
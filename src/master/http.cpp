@@ -16,6 +16,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <iomanip>
 #include <map>
 #include <memory>
@@ -28,13 +29,18 @@
 
 #include <mesos/type_utils.hpp>
 
+#include <process/async.hpp>
+#include <process/defer.hpp>
 #include <process/help.hpp>
 
 #include <process/metrics/metrics.hpp>
 
 #include <stout/base64.hpp>
+#include <stout/bytes.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/json.hpp>
+#include <stout/jsonify.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
 #include <stout/numify.hpp>
@@ -58,6 +64,7 @@
 
 using process::Clock;
 using process::DESCRIPTION;
+using process::defer;
 using process::Future;
 using process::HELP;
 using process::TLDR;
@@ -66,13 +73,16 @@ using process::USAGE;
 using process::http::BadRequest;
 using process::http::InternalServerError;
 using process::http::NotFound;
+using process::http::NotModified;
 using process::http::OK;
+using process::http::Pipe;
 using process::http::TemporaryRedirect;
 using process::http::Unauthorized;
 
 using process::metrics::internal::MetricsProcess;
 
 using std::map;
+using std::pair;
 using std::string;
 using std::vector;
 
@@ -82,6 +92,7 @@ namespace internal {
 namespace master {
 
 // Pull in model overrides from common.
+using mesos::internal::json;
 using mesos::internal::model;
 
 // Pull in definitions from process.
@@ -93,113 +104,197 @@ using process::http::Request;
 // it becomes available).
 
 
-// Returns a JSON object modeled on an Offer.
-JSON::Object model(const Offer& offer)
+// Writes the JSON of an Offer.
+static void json(JSON::ObjectWriter* writer, const Offer& offer)
 {
-  JSON::Object object;
-  object.values["id"] = offer.id().value();
-  object.values["framework_id"] = offer.framework_id().value();
-  object.values["slave_id"] = offer.slave_id().value();
-  object.values["resources"] = model(offer.resources());
-  return object;
+  writer->field("id", offer.id().value());
+  writer->field("framework_id", offer.framework_id().value());
+  writer->field("slave_id", offer.slave_id().value());
+  writer->field("resources", [&](JSON::ObjectWriter* writer) {
+    json(writer, Resources(offer.resources()));
+  });
 }
 
 
-// Returns a JSON object modeled on a Framework.
-JSON::Object model(const Framework& framework)
+// The parts of a Framework that get written out by the endpoints
+// below. These are copied on the master actor so that, e.g., the
+// (potentially large) /master/state.json can be written out off of
+// the master actor.
+struct FrameworkSummary
 {
-  JSON::Object object;
-  object.values["id"] = framework.id().value();
-  object.values["name"] = framework.info.name();
-  object.values["user"] = framework.info.user();
-  object.values["failover_timeout"] = framework.info.failover_timeout();
-  object.values["checkpoint"] = framework.info.checkpoint();
-  object.values["role"] = framework.info.role();
-  object.values["registered_time"] = framework.registeredTime.secs();
-  object.values["unregistered_time"] = framework.unregisteredTime.secs();
-  object.values["active"] = framework.active;
+  explicit FrameworkSummary(const Framework& framework)
+    : id(framework.id()),
+      info(framework.info),
+      active(framework.active),
+      registeredTime(framework.registeredTime),
+      reregisteredTime(framework.reregisteredTime),
+      unregisteredTime(framework.unregisteredTime) {}
 
-  // TODO(bmahler): Consider deprecating this in favor of the split
-  // used and offered resources below.
-  object.values["resources"] =
-    model(framework.totalUsedResources + framework.totalOfferedResources);
-
-  // TODO(bmahler): Use these in the webui.
-  object.values["used_resources"] = model(framework.totalUsedResources);
-  object.values["offered_resources"] = model(framework.totalOfferedResources);
-
-  object.values["hostname"] = framework.info.hostname();
-  object.values["webui_url"] = framework.info.webui_url();
+  FrameworkID id;
+  FrameworkInfo info;
+  bool active;
+  process::Time registeredTime;
+  process::Time reregisteredTime;
+  process::Time unregisteredTime;
+};
 
-  // TODO(benh): Consider making reregisteredTime an Option.
-  if (framework.registeredTime != framework.reregisteredTime) {
-    object.values["reregistered_time"] = framework.reregisteredTime.secs();
-  }
 
-  // Model all of the tasks associated with a framework.
+struct FrameworkState : FrameworkSummary
+{
+  explicit FrameworkState(const Framework& framework)
+    : FrameworkSummary(framework),
+      usedResources(framework.totalUsedResources),
+      offeredResources(framework.totalOfferedResources),
+      completedTasks(
+          framework.completedTasks.begin(),
+          framework.completedTasks.end())
   {
-    JSON::Array array;
-    array.values.reserve(
-        framework.pendingTasks.size() + framework.tasks.size()); // MESOS-2353.
-
     foreachvalue (const TaskInfo& task, framework.pendingTasks) {
-      vector<TaskStatus> statuses;
-      array.values.push_back(
-          model(task, framework.id(), TASK_STAGING, statuses));
+      pendingTasks.push_back(task);
     }
 
     foreachvalue (Task* task, framework.tasks) {
-      array.values.push_back(model(*task));
+      tasks.push_back(*task);
     }
 
-    object.values["tasks"] = std::move(array);
+    foreach (Offer* offer, framework.offers) {
+      offers.push_back(*offer);
+    }
   }
 
-  // Model all of the completed tasks of a framework.
-  {
-    JSON::Array array;
-    array.values.reserve(framework.completedTasks.size()); // MESOS-2353.
+  Resources usedResources;
+  Resources offeredResources;
+  vector<TaskInfo> pendingTasks;
+  vector<Task> tasks;
 
-    foreach (const std::shared_ptr<Task>& task, framework.completedTasks) {
-      array.values.push_back(model(*task));
-    }
+  // Completed tasks don't change anymore, hence these are shared.
+  vector<std::shared_ptr<Task>> completedTasks;
 
-    object.values["completed_tasks"] = std::move(array);
+  vector<Offer> offers;
+};
+
+
+// The parts of a Slave that get written out by the endpoints below.
+struct SlaveState
+{
+  explicit SlaveState(const Slave& slave)
+    : id(slave.id),
+      pid(slave.pid),
+      info(slave.info),
+      registeredTime(slave.registeredTime),
+      reregisteredTime(slave.reregisteredTime),
+      active(slave.active) {}
+
+  SlaveID id;
+  process::UPID pid;
+  SlaveInfo info;
+  process::Time registeredTime;
+  Option<process::Time> reregisteredTime;
+  bool active;
+};
+
+
+// Writes the JSON of a Framework, without its resources, tasks and
+// offers.
+static void summarize(
+    JSON::ObjectWriter* writer,
+    const FrameworkSummary& framework)
+{
+  writer->field("id", framework.id.value());
+  writer->field("name", framework.info.name());
+  writer->field("user", framework.info.user());
+  writer->field("failover_timeout", framework.info.failover_timeout());
+  writer->field("checkpoint", framework.info.checkpoint());
+  writer->field("role", framework.info.role());
+  writer->field("registered_time", framework.registeredTime.secs());
+  writer->field("unregistered_time", framework.unregisteredTime.secs());
+  writer->field("active", framework.active);
+  writer->field("hostname", framework.info.hostname());
+  writer->field("webui_url", framework.info.webui_url());
+
+  // TODO(benh): Consider making reregisteredTime an Option.
+  if (framework.registeredTime != framework.reregisteredTime) {
+    writer->field("reregistered_time", framework.reregisteredTime.secs());
   }
+}
 
-  // Model all of the offers associated with a framework.
-  {
-    JSON::Array array;
-    array.values.reserve(framework.offers.size()); // MESOS-2353.
 
-    foreach (Offer* offer, framework.offers) {
-      array.values.push_back(model(*offer));
+// Writes the JSON of a Framework.
+static void json(JSON::ObjectWriter* writer, const FrameworkState& framework)
+{
+  summarize(writer, framework);
+
+  // TODO(bmahler): Consider deprecating this in favor of the split
+  // used and offered resources below.
+  writer->field("resources", [&](JSON::ObjectWriter* writer) {
+    json(writer, framework.usedResources + framework.offeredResources);
+  });
+
+  // TODO(bmahler): Use these in the webui.
+  writer->field("used_resources", [&](JSON::ObjectWriter* writer) {
+    json(writer, framework.usedResources);
+  });
+
+  writer->field("offered_resources", [&](JSON::ObjectWriter* writer) {
+    json(writer, framework.offeredResources);
+  });
+
+  // Write all of the tasks associated with a framework.
+  writer->field("tasks", [&](JSON::ArrayWriter* writer) {
+    foreach (const TaskInfo& task, framework.pendingTasks) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        json(writer, task, framework.id, TASK_STAGING, vector<TaskStatus>());
+      });
     }
 
-    object.values["offers"] = std::move(array);
-  }
+    foreach (const Task& task, framework.tasks) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        json(writer, task);
+      });
+    }
+  });
 
-  return object;
+  // Write all of the completed tasks of a framework.
+  writer->field("completed_tasks", [&](JSON::ArrayWriter* writer) {
+    foreach (const std::shared_ptr<Task>& task, framework.completedTasks) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        json(writer, *task);
+      });
+    }
+  });
+
+  // Write all of the offers associated with a framework.
+  writer->field("offers", [&](JSON::ArrayWriter* writer) {
+    foreach (const Offer& offer, framework.offers) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        json(writer, offer);
+      });
+    }
+  });
 }
 
 
-// Returns a JSON object modeled after a Slave.
-JSON::Object model(const Slave& slave)
+// Writes the JSON of a Slave.
+static void json(JSON::ObjectWriter* writer, const SlaveState& slave)
 {
-  JSON::Object object;
-  object.values["id"] = slave.id.value();
-  object.values["pid"] = string(slave.pid);
-  object.values["hostname"] = slave.info.hostname();
-  object.values["registered_time"] = slave.registeredTime.secs();
+  writer->field("id", slave.id.value());
+  writer->field("pid", string(slave.pid));
+  writer->field("hostname", slave.info.hostname());
+  writer->field("registered_time", slave.registeredTime.secs());
 
   if (slave.reregisteredTime.isSome()) {
-    object.values["reregistered_time"] = slave.reregisteredTime.get().secs();
+    writer->field("reregistered_time", slave.reregisteredTime.get().secs());
   }
 
-  object.values["resources"] = model(slave.info.resources());
-  object.values["attributes"] = model(slave.info.attributes());
-  object.values["active"] = slave.active;
-  return object;
+  writer->field("resources", [&](JSON::ObjectWriter* writer) {
+    json(writer, Resources(slave.info.resources()));
+  });
+
+  writer->field("attributes", [&](JSON::ObjectWriter* writer) {
+    json(writer, Attributes(slave.info.attributes()));
+  });
+
+  writer->field("active", slave.active);
 }
 
 
@@ -225,6 +320,179 @@ JSON::Object model(const Role& role)
 }
 
 
+const string Master::Http::EVENTS_HELP = HELP(
+    TLDR(
+        "Streams the changes of the state of the master."),
+    USAGE(
+        "/master/events"),
+    DESCRIPTION(
+        "Streams newline delimited JSON objects, each of which has a",
+        "'type' field. The first object has type SNAPSHOT and holds the",
+        "'state' of the master (as served by /master/state.json), which",
+        "the subsequent objects describe changes to:",
+        "",
+        ">        TASK_ADDED, TASK_UPDATED with the 'task'.",
+        ">        SLAVE_ADDED, SLAVE_UPDATED, SLAVE_REMOVED with the 'slave'.",
+        ">        FRAMEWORK_ADDED, FRAMEWORK_UPDATED, FRAMEWORK_REMOVED with",
+        ">        the 'framework' (without its tasks and offers).",
+        "",
+        "The stream is closed if the client doesn't keep up with it (see",
+        "the --max_event_backlog flag), after which the client is expected",
+        "to subscribe again."));
+
+
+Future<Response> Master::Http::events(const Request& request)
+{
+  LOG(INFO) << "HTTP request for '" << request.path << "'";
+
+  snapshot();
+
+  Pipe pipe;
+  Pipe::Writer writer = pipe.writer();
+
+  // The events that get published until the snapshot has been
+  // written out are held back, so that the stream starts with the
+  // snapshot followed by all of the changes since.
+  const uint64_t id = master->nextSubscriberId++;
+  master->subscribers.put(id, Subscriber(writer));
+
+  master->stateSnapshot.get().json
+    .onAny(defer(
+        master->self(),
+        lambda::bind(&Master::Http::_events, this, id, lambda::_1)));
+
+  writer.readerClosed()
+    .onAny(defer(
+        master->self(),
+        lambda::bind(&Master::Http::unsubscribe, this, id)));
+
+  OK response;
+  response.type = Response::PIPE;
+  response.reader = pipe.reader();
+  response.headers["Content-Type"] = "application/json";
+
+  return response;
+}
+
+
+void Master::Http::_events(uint64_t id, const Future<string>& json)
+{
+  // The subscriber might have disconnected or been dropped already.
+  if (!master->subscribers.contains(id)) {
+    return;
+  }
+
+  Subscriber& subscriber = master->subscribers.at(id);
+
+  if (!json.isReady()) {
+    LOG(WARNING) << "Dropping subscriber " << id << " of '/"
+                 << master->self().id << "/events' since writing the"
+                 << " snapshot failed: "
+                 << (json.isFailed() ? json.failure() : "discarded");
+
+    subscriber.writer.close();
+    master->subscribers.erase(id);
+    return;
+  }
+
+  subscriber.writer.write(
+      "{\"type\":\"SNAPSHOT\",\"state\":" + json.get() + "}\n");
+
+  if (!subscriber.pending.empty()) {
+    subscriber.writer.write(subscriber.pending);
+    subscriber.pending.clear();
+  }
+
+  subscriber.ready = true;
+}
+
+
+void Master::Http::publish(const string& type, const Task& task)
+{
+  master->stateVersion++;
+
+  if (master->subscribers.empty()) {
+    return;
+  }
+
+  publish(JSON::jsonify([&](JSON::ObjectWriter* writer) {
+    writer->field("type", type);
+    writer->field("task", [&](JSON::ObjectWriter* writer) {
+      json(writer, task);
+    });
+  }));
+}
+
+
+void Master::Http::publish(const string& type, const Slave& slave)
+{
+  master->stateVersion++;
+
+  if (master->subscribers.empty()) {
+    return;
+  }
+
+  publish(JSON::jsonify([&](JSON::ObjectWriter* writer) {
+    writer->field("type", type);
+    writer->field("slave", [&](JSON::ObjectWriter* writer) {
+      json(writer, SlaveState(slave));
+    });
+  }));
+}
+
+
+void Master::Http::publish(const string& type, const Framework& framework)
+{
+  master->stateVersion++;
+
+  if (master->subscribers.empty()) {
+    return;
+  }
+
+  publish(JSON::jsonify([&](JSON::ObjectWriter* writer) {
+    writer->field("type", type);
+    writer->field("framework", [&](JSON::ObjectWriter* writer) {
+      summarize(writer, FrameworkSummary(framework));
+    });
+  }));
+}
+
+
+void Master::Http::publish(const string& event)
+{
+  const Bytes backlog = master->flags.max_event_backlog;
+
+  foreach (uint64_t id, master->subscribers.keys()) {
+    Subscriber& subscriber = master->subscribers.at(id);
+
+    const size_t size = subscriber.ready
+      ? subscriber.writer.size()
+      : subscriber.pending.size();
+
+    // Rather than buffering an unbounded amount of events for a
+    // subscriber that doesn't keep up, close its stream.
+    if (size + event.size() + 1 > backlog.bytes()) {
+      LOG(WARNING) << "Dropping subscriber " << id << " of '/"
+                   << master->self().id << "/events' with "
+                   << Bytes(size) << " of unread events";
+
+      subscriber.writer.close();
+      master->subscribers.erase(id);
+    } else if (subscriber.ready) {
+      subscriber.writer.write(event + "\n");
+    } else {
+      subscriber.pending += event + "\n";
+    }
+  }
+}
+
+
+void Master::Http::unsubscribe(uint64_t id)
+{
+  master->subscribers.erase(id);
+}
+
+
 const string Master::Http::HEALTH_HELP = HELP(
     TLDR(
         "Health check of the Master."),
@@ -392,161 +660,276 @@ const string Master::Http::SLAVES_HELP = HELP(
 Future<Response> Master::Http::slaves(const Request& request) {
   LOG(INFO) << "HTTP request for '" << request.path << "'";
 
-  JSON::Object object;
-
-  {
-    JSON::Array array;
-    array.values.reserve(master->slaves.registered.size()); // MESOS-2353.
-
-    foreachvalue (const Slave* slave, master->slaves.registered) {
-      array.values.push_back(model(*slave));
-    }
-
-    object.values["slaves"] = std::move(array);
-  }
-
-
-  return OK(object, request.query.get("jsonp"));
+  return jsonResponse(
+      JSON::jsonify([&](JSON::ObjectWriter* writer) {
+        writer->field("slaves", [&](JSON::ArrayWriter* writer) {
+          foreachvalue (const Slave* slave, master->slaves.registered) {
+            writer->element([&](JSON::ObjectWriter* writer) {
+              json(writer, SlaveState(*slave));
+            });
+          }
+        });
+      }),
+      request.query.get("jsonp"));
 }
 
 
-Future<Response> Master::Http::state(const Request& request)
+struct Master::Http::State
 {
-  LOG(INFO) << "HTTP request for '" << request.path << "'";
+  process::Time startTime;
+  Option<process::Time> electedTime;
+  string id;
+  string pid;
+  string hostname;
+  double activatedSlaves;
+  double deactivatedSlaves;
+  Option<string> cluster;
+  Option<string> leader;
+  Option<string> logDir;
+  Option<string> externalLogFile;
+  vector<pair<string, string>> flags;
+  vector<SlaveState> slaves;
+  vector<FrameworkState> frameworks;
+  vector<FrameworkState> completedFrameworks;
+  vector<Task> orphanTasks;
+  vector<FrameworkID> unregisteredFrameworks;
+};
 
-  JSON::Object object;
-  object.values["version"] = MESOS_VERSION;
 
-  if (build::GIT_SHA.isSome()) {
-    object.values["git_sha"] = build::GIT_SHA.get();
-  }
+std::shared_ptr<Master::Http::State> Master::Http::copy()
+{
+  std::shared_ptr<State> state(new State());
 
-  if (build::GIT_BRANCH.isSome()) {
-    object.values["git_branch"] = build::GIT_BRANCH.get();
-  }
+  state->startTime = master->startTime;
+  state->electedTime = master->electedTime;
+  state->id = master->info().id();
+  state->pid = string(master->self());
+  state->hostname = master->info().hostname();
+  state->activatedSlaves = master->_slaves_active();
+  state->deactivatedSlaves = master->_slaves_inactive();
+  state->cluster = master->flags.cluster;
 
-  if (build::GIT_TAG.isSome()) {
-    object.values["git_tag"] = build::GIT_TAG.get();
+  if (master->leader.isSome()) {
+    state->leader = master->leader.get().pid();
   }
 
-  object.values["build_date"] = build::DATE;
-  object.values["build_time"] = build::TIME;
-  object.values["build_user"] = build::USER;
-  object.values["start_time"] = master->startTime.secs();
+  state->logDir = master->flags.log_dir;
+  state->externalLogFile = master->flags.external_log_file;
 
-  if (master->electedTime.isSome()) {
-    object.values["elected_time"] = master->electedTime.get().secs();
+  foreachpair (const string& name, const flags::Flag& flag, master->flags) {
+    Option<string> value = flag.stringify(master->flags);
+    if (value.isSome()) {
+      state->flags.push_back(std::make_pair(name, value.get()));
+    }
   }
 
-  object.values["id"] = master->info().id();
-  object.values["pid"] = string(master->self());
-  object.values["hostname"] = master->info().hostname();
-  object.values["activated_slaves"] = master->_slaves_active();
-  object.values["deactivated_slaves"] = master->_slaves_inactive();
-
-  if (master->flags.cluster.isSome()) {
-    object.values["cluster"] = master->flags.cluster.get();
+  foreachvalue (Slave* slave, master->slaves.registered) {
+    state->slaves.push_back(SlaveState(*slave));
   }
 
-  if (master->leader.isSome()) {
-    object.values["leader"] = master->leader.get().pid();
+  foreachvalue (Framework* framework, master->frameworks.registered) {
+    state->frameworks.push_back(FrameworkState(*framework));
   }
 
-  if (master->flags.log_dir.isSome()) {
-    object.values["log_dir"] = master->flags.log_dir.get();
+  foreach (const std::shared_ptr<Framework>& framework,
+           master->frameworks.completed) {
+    state->completedFrameworks.push_back(FrameworkState(*framework));
   }
 
-  if (master->flags.external_log_file.isSome()) {
-    object.values["external_log_file"] = master->flags.external_log_file.get();
-  }
+  // Find the orphan tasks and the frameworks that are unregistered.
+  // The latter could happen when the framework has yet to
+  // re-register after master failover.
+  foreachvalue (const Slave* slave, master->slaves.registered) {
+    typedef hashmap<TaskID, Task*> TaskMap;
+    foreachpair (const FrameworkID& frameworkId,
+                 const TaskMap& tasks,
+                 slave->tasks) {
+      if (master->frameworks.registered.contains(frameworkId)) {
+        continue;
+      }
 
-  {
-    JSON::Object flags;
-    foreachpair (const string& name, const flags::Flag& flag, master->flags) {
-      Option<string> value = flag.stringify(master->flags);
-      if (value.isSome()) {
-        flags.values[name] = value.get();
+      state->unregisteredFrameworks.push_back(frameworkId);
+
+      foreachvalue (const Task* task, tasks) {
+        CHECK_NOTNULL(task);
+        state->orphanTasks.push_back(*task);
       }
     }
-    object.values["flags"] = std::move(flags);
   }
 
-  // Model all of the slaves.
-  {
-    JSON::Array array;
-    array.values.reserve(master->slaves.registered.size()); // MESOS-2353.
+  return state;
+}
 
-    foreachvalue (Slave* slave, master->slaves.registered) {
-      array.values.push_back(model(*slave));
-    }
 
-    object.values["slaves"] = std::move(array);
-  }
+string Master::Http::stateJSON(const std::shared_ptr<State>& state)
+{
+  return JSON::jsonify([&](JSON::ObjectWriter* writer) {
+    writer->field("version", MESOS_VERSION);
 
-  // Model all of the frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.registered.size()); // MESOS-2353.
+    if (build::GIT_SHA.isSome()) {
+      writer->field("git_sha", build::GIT_SHA.get());
+    }
 
-    foreachvalue (Framework* framework, master->frameworks.registered) {
-      array.values.push_back(model(*framework));
+    if (build::GIT_BRANCH.isSome()) {
+      writer->field("git_branch", build::GIT_BRANCH.get());
     }
 
-    object.values["frameworks"] = std::move(array);
-  }
+    if (build::GIT_TAG.isSome()) {
+      writer->field("git_tag", build::GIT_TAG.get());
+    }
 
-  // Model all of the completed frameworks.
-  {
-    JSON::Array array;
-    array.values.reserve(master->frameworks.completed.size()); // MESOS-2353.
+    writer->field("build_date", build::DATE);
+    writer->field("build_time", build::TIME);
+    writer->field("build_user", build::USER);
+    writer->field("start_time", state->startTime.secs());
 
-    foreach (const std::shared_ptr<Framework>& framework,
-             master->frameworks.completed) {
-      array.values.push_back(model(*framework));
+    if (state->electedTime.isSome()) {
+      writer->field("elected_time", state->electedTime.get().secs());
     }
 
-    object.values["completed_frameworks"] = std::move(array);
-  }
+    writer->field("id", state->id);
+    writer->field("pid", state->pid);
+    writer->field("hostname", state->hostname);
+    writer->field("activated_slaves", state->activatedSlaves);
+    writer->field("deactivated_slaves", state->deactivatedSlaves);
 
-  // Model all of the orphan tasks.
-  {
-    JSON::Array array;
+    if (state->cluster.isSome()) {
+      writer->field("cluster", state->cluster.get());
+    }
 
-    // Find those orphan tasks.
-    foreachvalue (const Slave* slave, master->slaves.registered) {
-      typedef hashmap<TaskID, Task*> TaskMap;
-      foreachvalue (const TaskMap& tasks, slave->tasks) {
-        foreachvalue (const Task* task, tasks) {
-          CHECK_NOTNULL(task);
-          if (!master->frameworks.registered.contains(task->framework_id())) {
-            array.values.push_back(model(*task));
-          }
-        }
-      }
+    if (state->leader.isSome()) {
+      writer->field("leader", state->leader.get());
     }
 
-    object.values["orphan_tasks"] = std::move(array);
-  }
+    if (state->logDir.isSome()) {
+      writer->field("log_dir", state->logDir.get());
+    }
 
-  // Model all currently unregistered frameworks.
-  // This could happen when the framework has yet to re-register
-  // after master failover.
-  {
-    JSON::Array array;
+    if (state->externalLogFile.isSome()) {
+      writer->field("external_log_file", state->externalLogFile.get());
+    }
 
-    // Find unregistered frameworks.
-    foreachvalue (const Slave* slave, master->slaves.registered) {
-      foreachkey (const FrameworkID& frameworkId, slave->tasks) {
-        if (!master->frameworks.registered.contains(frameworkId)) {
-          array.values.push_back(frameworkId.value());
-        }
+    writer->field("flags", [&](JSON::ObjectWriter* writer) {
+      foreachpair (const string& name, const string& value, state->flags) {
+        writer->field(name, value);
+      }
+    });
+
+    // Write all of the slaves.
+    writer->field("slaves", [&](JSON::ArrayWriter* writer) {
+      foreach (const SlaveState& slave, state->slaves) {
+        writer->element([&](JSON::ObjectWriter* writer) {
+          json(writer, slave);
+        });
+      }
+    });
+
+    // Write all of the frameworks.
+    writer->field("frameworks", [&](JSON::ArrayWriter* writer) {
+      foreach (const FrameworkState& framework, state->frameworks) {
+        writer->element([&](JSON::ObjectWriter* writer) {
+          json(writer, framework);
+        });
       }
+    });
+
+    // Write all of the completed frameworks.
+    writer->field("completed_frameworks", [&](JSON::ArrayWriter* writer) {
+      foreach (const FrameworkState& framework, state->completedFrameworks) {
+        writer->element([&](JSON::ObjectWriter* writer) {
+          json(writer, framework);
+        });
+      }
+    });
+
+    // Write all of the orphan tasks.
+    writer->field("orphan_tasks", [&](JSON::ArrayWriter* writer) {
+      foreach (const Task& task, state->orphanTasks) {
+        writer->element([&](JSON::ObjectWriter* writer) {
+          json(writer, task);
+        });
+      }
+    });
+
+    // Write all currently unregistered frameworks.
+    writer->field("unregistered_frameworks", [&](JSON::ArrayWriter* writer) {
+      foreach (const FrameworkID& frameworkId, state->unregisteredFrameworks) {
+        writer->element(frameworkId.value());
+      }
+    });
+  });
+}
+
+
+// Returns the response for the stringified /master/state.json.
+static Response _state(
+    const string& json,
+    const string& etag,
+    const Option<string>& jsonp)
+{
+  Response response = jsonResponse(json, jsonp);
+  response.headers["ETag"] = etag;
+
+  return response;
+}
+
+
+// Returns whether an 'If-None-Match' header value matches the ETag.
+static bool matches(const string& ifNoneMatch, const string& etag)
+{
+  foreach (const string& token, strings::tokenize(ifNoneMatch, ",")) {
+    const string tag = strings::trim(token);
+    if (tag == "*" || tag == etag) {
+      return true;
     }
+  }
+
+  return false;
+}
+
 
-    object.values["unregistered_frameworks"] = std::move(array);
+Future<Response> Master::Http::state(const Request& request)
+{
+  LOG(INFO) << "HTTP request for '" << request.path << "'";
+
+  // All requests for the same version of the state share the same
+  // JSON (see Http::snapshot).
+  this->snapshot();
+
+  const StateSnapshot& snapshot = master->stateSnapshot.get();
+
+  // The version is only unique for this master, hence the ID.
+  const string etag =
+    "\"" + master->info().id() + "-" + stringify(snapshot.version) + "\"";
+
+  Option<string> ifNoneMatch = request.headers.get("If-None-Match");
+
+  if (ifNoneMatch.isSome() && matches(ifNoneMatch.get(), etag)) {
+    NotModified response;
+    response.headers["ETag"] = etag;
+    return response;
   }
 
-  return OK(object, request.query.get("jsonp"));
+  return snapshot.json
+    .then(lambda::bind(&_state, lambda::_1, etag, request.query.get("jsonp")));
+}
+
+
+void Master::Http::snapshot()
+{
+  // Only (re)write the state if it has changed since the last
+  // snapshot (see 'master->stateVersion'). The state is copied here
+  // on the master actor, but written out asynchronously so that
+  // the master isn't blocked on it. Requests for the same version of
+  // the state share the result.
+  if (master->stateSnapshot.isNone() ||
+      master->stateSnapshot.get().version != master->stateVersion) {
+    StateSnapshot snapshot;
+    snapshot.version = master->stateVersion;
+    snapshot.json = process::async(&Master::Http::stateJSON, copy());
+
+    master->stateSnapshot = snapshot;
+  }
 }
 
 
@@ -680,51 +1063,82 @@ const string Master::Http::TASKS_HELP = HELP(
       "(default is " + stringify(TASK_LIMIT) + ").",
       ">        offset=VALUE         Starts task list at offset.",
       ">        order=(asc|desc)     Ascending or descending sort order "
-      "(default is descending)."
-      ""));
-
-
-struct TaskComparator
+      "(default is descending).",
+      ">        cursor=VALUE         Starts task list after the task the "
+      "cursor was returned for.",
+      ">        framework_id=VALUE   Only lists tasks of the framework.",
+      ">        slave_id=VALUE       Only lists tasks on the slave.",
+      ">        state=VALUE          Only lists tasks in the state "
+      "(e.g., TASK_RUNNING).",
+      ">        label=KEY[:VALUE]    Only lists tasks with the label.",
+      ">        fields=VALUE[,...]   Only includes the listed fields of "
+      "each task (e.g., id,state).",
+      "",
+      "Tasks are ordered by when the master learned about them.",
+      "When more tasks match than are returned, the response includes a",
+      "'next_cursor' to pass as 'cursor' for the next page. Unlike an",
+      "offset, a cursor is not shifted by tasks being added or removed",
+      "in the meantime."));
+
+
+// The position of a task in the task list: tasks are ordered by the
+// sequence number they were assigned once added to the master (see
+// Framework::sequences), with the framework and task IDs breaking
+// ties so that the order is total. Since none of these change while
+// the task is known, a cursor stays valid as tasks come, change and go.
+struct TaskKey
 {
-  static bool ascending(const Task* lhs, const Task* rhs)
+  TaskKey(const Task& task, uint64_t _sequence)
+    : sequence(_sequence),
+      frameworkId(task.framework_id().value()),
+      taskId(task.task_id().value()) {}
+
+  static Try<TaskKey> parse(const string& cursor)
   {
-    size_t lhsSize = lhs->statuses().size();
-    size_t rhsSize = rhs->statuses().size();
+    const vector<string> tokens = strings::split(cursor, ",", 3);
 
-    if ((lhsSize == 0) && (rhsSize == 0)) {
-      return false;
+    if (tokens.size() != 3) {
+      return Error("Expecting 'SEQUENCE,FRAMEWORK_ID,TASK_ID'");
     }
 
-    if (lhsSize == 0) {
-      return true;
-    }
+    TaskKey key;
 
-    if (rhsSize == 0) {
-      return false;
+    Try<uint64_t> sequence = numify<uint64_t>(tokens[0]);
+    if (sequence.isError()) {
+      return Error("Invalid sequence: " + sequence.error());
     }
 
-    return (lhs->statuses(0).timestamp() < rhs->statuses(0).timestamp());
+    key.sequence = sequence.get();
+    key.frameworkId = tokens[1];
+    key.taskId = tokens[2];
+
+    return key;
   }
 
-  static bool descending(const Task* lhs, const Task* rhs)
+  string cursor() const
   {
-    size_t lhsSize = lhs->statuses().size();
-    size_t rhsSize = rhs->statuses().size();
-
-    if ((lhsSize == 0) && (rhsSize == 0)) {
-      return false;
-    }
+    return stringify(sequence) + "," + frameworkId + "," + taskId;
+  }
 
-    if (rhsSize == 0) {
-      return true;
+  bool operator<(const TaskKey& that) const
+  {
+    if (sequence != that.sequence) {
+      return sequence < that.sequence;
     }
 
-    if (lhsSize == 0) {
-      return false;
+    if (frameworkId != that.frameworkId) {
+      return frameworkId < that.frameworkId;
     }
 
-    return (lhs->statuses(0).timestamp() > rhs->statuses(0).timestamp());
+    return taskId < that.taskId;
   }
+
+  uint64_t sequence;
+  string frameworkId;
+  string taskId;
+
+private:
+  TaskKey() {}
 };
 
 
@@ -742,51 +1156,171 @@ Future<Response> Master::Http::tasks(const Request& request)
   // TODO(nnielsen): Currently, formatting errors in offset and/or limit
   // will silently be ignored. This could be reported to the user instead.
 
-  // Construct framework list with both active and completed framwworks.
+  // Default order is descending.
+  Option<string> order = request.query.get("order");
+  bool ascending = order.isSome() && (order.get() == "asc");
+
+  Option<TaskKey> cursor;
+  if (request.query.get("cursor").isSome()) {
+    Try<TaskKey> key = TaskKey::parse(request.query.get("cursor").get());
+    if (key.isError()) {
+      return BadRequest("Failed to parse 'cursor': " + key.error() + ".\n");
+    }
+    cursor = key.get();
+  }
+
+  Option<TaskState> state;
+  if (request.query.get("state").isSome()) {
+    TaskState value;
+    if (!TaskState_Parse(request.query.get("state").get(), &value)) {
+      return BadRequest(
+          "Unknown 'state': " + request.query.get("state").get() + ".\n");
+    }
+    state = value;
+  }
+
+  Option<string> slaveId = request.query.get("slave_id");
+
+  // A label filter of the form 'KEY' or 'KEY:VALUE'.
+  Option<string> labelKey;
+  Option<string> labelValue;
+  if (request.query.get("label").isSome()) {
+    const vector<string> tokens =
+      strings::split(request.query.get("label").get(), ":", 2);
+
+    labelKey = tokens[0];
+    if (tokens.size() == 2) {
+      labelValue = tokens[1];
+    }
+  }
+
+  Option<hashset<string>> fields;
+  if (request.query.get("fields").isSome()) {
+    hashset<string> selected;
+    foreach (const string& field,
+             strings::tokenize(request.query.get("fields").get(), ",")) {
+      selected.insert(field);
+    }
+    fields = selected;
+  }
+
+  // Construct framework list with both active and completed frameworks,
+  // or just the requested one.
+  Option<string> frameworkId = request.query.get("framework_id");
+
   vector<const Framework*> frameworks;
   foreachvalue (Framework* framework, master->frameworks.registered) {
-    frameworks.push_back(framework);
+    if (frameworkId.isNone() || frameworkId.get() == framework->id().value()) {
+      frameworks.push_back(framework);
+    }
   }
   foreach (const std::shared_ptr<Framework>& framework,
            master->frameworks.completed) {
-    frameworks.push_back(framework.get());
+    if (frameworkId.isNone() || frameworkId.get() == framework->id().value()) {
+      frameworks.push_back(framework.get());
+    }
   }
 
-  // Construct task list with both running and finished tasks.
-  vector<const Task*> tasks;
-  foreach (const Framework* framework, frameworks) {
-    foreachvalue (Task* task, framework->tasks) {
-      CHECK_NOTNULL(task);
-      tasks.push_back(task);
+  auto matches = [&](const Task& task) {
+    if (state.isSome() && task.state() != state.get()) {
+      return false;
     }
-    foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
-      tasks.push_back(task.get());
+
+    if (slaveId.isSome() && task.slave_id().value() != slaveId.get()) {
+      return false;
     }
-  }
 
-  // Sort tasks by task status timestamp. Default order is descending.
-  // The earlist timestamp is chosen for comparison when multiple are present.
-  Option<string> order = request.query.get("order");
-  if (order.isSome() && (order.get() == "asc")) {
-    sort(tasks.begin(), tasks.end(), TaskComparator::ascending);
-  } else {
-    sort(tasks.begin(), tasks.end(), TaskComparator::descending);
-  }
+    if (labelKey.isSome()) {
+      bool found = false;
+      foreach (const Label& label, task.labels().labels()) {
+        if (label.key() == labelKey.get() &&
+            (labelValue.isNone() ||
+             (label.has_value() && label.value() == labelValue.get()))) {
+          found = true;
+          break;
+        }
+      }
 
-  JSON::Object object;
+      if (!found) {
+        return false;
+      }
+    }
 
-  {
-    JSON::Array array;
-    size_t end = std::min(offset + limit, tasks.size());
-    for (size_t i = offset; i < end; i++) {
-      const Task* task = tasks[i];
-      array.values.push_back(model(*task));
+    return true;
+  };
+
+  // Construct task list with both running and finished tasks, keeping
+  // only the tasks which match the filters and come after the cursor.
+  vector<pair<TaskKey, const Task*>> tasks;
+
+  auto add = [&](const Framework* framework, const Task* task) {
+    CHECK_NOTNULL(task);
+
+    if (!matches(*task)) {
+      return;
     }
 
-    object.values["tasks"] = std::move(array);
+    TaskKey key(*task, framework->sequences.at(task));
+
+    if (cursor.isSome() &&
+        (ascending ? !(cursor.get() < key) : !(key < cursor.get()))) {
+      return;
+    }
+
+    tasks.push_back(std::make_pair(key, task));
+  };
+
+  foreach (const Framework* framework, frameworks) {
+    if (state.isSome()) {
+      // Use the state index rather than scanning all active tasks.
+      if (framework->tasksByState.contains(state.get())) {
+        foreach (Task* task, framework->tasksByState.at(state.get())) {
+          add(framework, task);
+        }
+      }
+    } else {
+      foreachvalue (Task* task, framework->tasks) {
+        add(framework, task);
+      }
+    }
+
+    foreach (const std::shared_ptr<Task>& task, framework->completedTasks) {
+      add(framework, task.get());
+    }
   }
 
-  return OK(object, request.query.get("jsonp"));
+  // Only the tasks up to the end of the requested page need to be
+  // in order.
+  size_t end = std::min(offset + limit, tasks.size());
+
+  auto compare = [ascending](
+      const pair<TaskKey, const Task*>& lhs,
+      const pair<TaskKey, const Task*>& rhs) {
+    return ascending ? lhs.first < rhs.first : rhs.first < lhs.first;
+  };
+
+  std::partial_sort(tasks.begin(), tasks.begin() + end, tasks.end(), compare);
+
+  return jsonResponse(
+      JSON::jsonify([&](JSON::ObjectWriter* writer) {
+        writer->field("tasks", [&](JSON::ArrayWriter* writer) {
+          for (size_t i = offset; i < end; i++) {
+            const Task* task = tasks[i].second;
+            writer->element([&](JSON::ObjectWriter* writer) {
+              if (fields.isSome()) {
+                json(writer, *task, fields.get());
+              } else {
+                json(writer, *task);
+              }
+            });
+          }
+        });
+
+        if (offset < end && end < tasks.size()) {
+          writer->field("next_cursor", tasks[end - 1].first.cursor());
+        }
+      }),
+      request.query.get("jsonp"));
 }
 
 
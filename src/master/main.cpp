@@ -261,7 +261,12 @@ int main(int argc, char** argv)
           set<UPID>(),
           flags.log_auto_initialize);
     }
-    storage = new state::LogStorage(log);
+    Option<string> checkpoint = None();
+    if (flags.registry_checkpoint) {
+      checkpoint = path::join(flags.work_dir.get(), "registry_checkpoint");
+    }
+
+    storage = new state::LogStorage(log, 0, checkpoint);
   } else {
     EXIT(1) << "'" << flags.registry << "' is not a supported"
             << " option for registry persistence";
@@ -288,7 +288,10 @@ Master::Master(
     authorizer(_authorizer),
     authenticator(None()),
     metrics(new Metrics(*this)),
-    electedTime(None())
+    electedTime(None()),
+    stateVersion(0),
+    nextSubscriberId(0),
+    nextTaskSequence(0)
 {
   slaves.limiter = _slaveRemovalLimiter;
 
@@ -673,6 +676,9 @@ void Master::initialize()
       &StatusUpdateAcknowledgementMessage::task_id,
       &StatusUpdateAcknowledgementMessage::uuid);
 
+  install<StatusUpdateAcknowledgementsMessage>(
+      &Master::statusUpdateAcknowledgements);
+
   install<FrameworkToExecutorMessage>(
       &Master::schedulerMessage,
       &FrameworkToExecutorMessage::slave_id,
@@ -684,7 +690,8 @@ void Master::initialize()
       &Master::registerSlave,
       &RegisterSlaveMessage::slave,
       &RegisterSlaveMessage::checkpointed_resources,
-      &RegisterSlaveMessage::version);
+      &RegisterSlaveMessage::version,
+      &RegisterSlaveMessage::acknowledgement_batches);
 
   install<ReregisterSlaveMessage>(
       &Master::reregisterSlave,
@@ -693,7 +700,8 @@ void Master::initialize()
       &ReregisterSlaveMessage::executor_infos,
       &ReregisterSlaveMessage::tasks,
       &ReregisterSlaveMessage::completed_frameworks,
-      &ReregisterSlaveMessage::version);
+      &ReregisterSlaveMessage::version,
+      &ReregisterSlaveMessage::acknowledgement_batches);
 
   install<UnregisterSlaveMessage>(
       &Master::unregisterSlave,
@@ -721,6 +729,9 @@ void Master::initialize()
       &AuthenticateMessage::pid);
 
   // Setup HTTP routes.
+  route("/events",
+        Http::EVENTS_HELP,
+        lambda::bind(&Http::events, http, lambda::_1));
   route("/health",
         Http::HEALTH_HELP,
         lambda::bind(&Http::health, http, lambda::_1));
@@ -789,6 +800,13 @@ void Master::finalize()
 {
   LOG(INFO) << "Master terminating";
 
+  // End the event streams before tearing down the state below, whose
+  // removal shouldn't be published.
+  foreachvalue (Subscriber subscriber, subscribers) {
+    subscriber.writer.close();
+  }
+  subscribers.clear();
+
   // NOTE: Even though we remove the slave and framework from the
   // allocator, it is possible that offers are already dispatched to
   // this master. In tests, if a new master (with the same PID) is
@@ -1419,6 +1437,9 @@ void Master::detected(const Future<Option<MasterInfo>>& _leader)
   bool wasElected = elected();
   leader = _leader.get();
 
+  // The leader (and possibly the elected time) has changed.
+  stateVersion++;
+
   LOG(INFO) << "The newly elected leader is "
             << (leader.isSome()
                 ? (leader.get().pid() + " with id " + leader.get().id())
@@ -1715,6 +1736,7 @@ void Master::_registerFramework(
       FrameworkRegisteredMessage message;
       message.mutable_framework_id()->MergeFrom(framework->id());
       message.mutable_master_info()->MergeFrom(info_);
+      message.set_acknowledgement_batches(true);
       send(from, message);
       return;
     }
@@ -1746,6 +1768,7 @@ void Master::_registerFramework(
   FrameworkRegisteredMessage message;
   message.mutable_framework_id()->MergeFrom(framework->id());
   message.mutable_master_info()->MergeFrom(info_);
+  message.set_acknowledgement_batches(true);
   send(framework->pid, message);
 }
 
@@ -1921,11 +1944,13 @@ void Master::_reregisterFramework(
       if (!framework->active) {
         framework->active = true;
         allocator->activateFramework(framework->id());
+        http.publish("FRAMEWORK_UPDATED", *framework);
       }
 
       FrameworkReregisteredMessage message;
       message.mutable_framework_id()->MergeFrom(frameworkInfo.id());
       message.mutable_master_info()->MergeFrom(info_);
+      message.set_acknowledgement_batches(true);
       send(from, message);
       return;
     }
@@ -1941,7 +1966,7 @@ void Master::_reregisterFramework(
     // Add active tasks and executors to the framework.
     foreachvalue (Slave* slave, slaves.registered) {
       foreachvalue (Task* task, slave->tasks[framework->id()]) {
-        framework->addTask(task);
+        framework->addTask(task, nextTaskSequence++);
       }
       foreachvalue (const ExecutorInfo& executor,
                     slave->executors[framework->id()]) {
@@ -1961,6 +1986,7 @@ void Master::_reregisterFramework(
     FrameworkRegisteredMessage message;
     message.mutable_framework_id()->MergeFrom(framework->id());
     message.mutable_master_info()->MergeFrom(info_);
+    message.set_acknowledgement_batches(true);
     send(framework->pid, message);
   }
 
@@ -2064,6 +2090,8 @@ void Master::deactivate(Framework* framework)
         offer->framework_id(), offer->slave_id(), offer->resources(), None());
     removeOffer(offer, true); // Rescind.
   }
+
+  http.publish("FRAMEWORK_UPDATED", *framework);
 }
 
 
@@ -2103,6 +2131,8 @@ void Master::deactivate(Slave* slave)
 
     removeOffer(offer, true); // Rescind!
   }
+
+  http.publish("SLAVE_UPDATED", *slave);
 }
 
 
@@ -2273,7 +2303,9 @@ Resources Master::addTask(
   }
 
   slave->addTask(t);
-  framework->addTask(t);
+  framework->addTask(t, nextTaskSequence++);
+
+  http.publish("TASK_ADDED", *t);
 
   return resources;
 }
@@ -2843,6 +2875,118 @@ void Master::statusUpdateAcknowledgement(
     return;
   }
 
+  Slave* slave = acknowledge(framework, slaveId, taskId, uuid);
+
+  if (slave == NULL) {
+    return;
+  }
+
+  LOG(INFO) << "Forwarding status update acknowledgement "
+            << UUID::fromBytes(uuid) << " for task " << taskId
+            << " of framework " << *framework << " to slave " << *slave;
+
+  StatusUpdateAcknowledgementMessage message;
+  message.mutable_slave_id()->CopyFrom(slaveId);
+  message.mutable_framework_id()->CopyFrom(frameworkId);
+  message.mutable_task_id()->CopyFrom(taskId);
+  message.set_uuid(uuid);
+
+  send(slave->pid, message);
+
+  metrics->valid_status_update_acknowledgements++;
+}
+
+
+void Master::statusUpdateAcknowledgements(
+    const UPID& from,
+    const StatusUpdateAcknowledgementsMessage& message)
+{
+  metrics->messages_status_update_acknowledgements++;
+
+  const FrameworkID& frameworkId = message.framework_id();
+
+  Framework* framework = getFramework(frameworkId);
+
+  if (framework == NULL) {
+    LOG(WARNING)
+      << "Ignoring " << message.acknowledgements_size()
+      << " status update acknowledgements of framework " << frameworkId
+      << " because the framework cannot be found";
+    metrics->invalid_status_update_acknowledgements +=
+      message.acknowledgements_size();
+    return;
+  }
+
+  if (from != framework->pid) {
+    LOG(WARNING)
+      << "Ignoring " << message.acknowledgements_size()
+      << " status update acknowledgements of framework " << *framework
+      << " because they are not expected from " << from;
+    metrics->invalid_status_update_acknowledgements +=
+      message.acknowledgements_size();
+    return;
+  }
+
+  // Apply all the acknowledgements in a single pass, and forward
+  // them to each slave in a single message.
+  hashmap<SlaveID, StatusUpdateAcknowledgementsMessage> forwards;
+
+  foreach (const StatusUpdateAcknowledgementsMessage::Acknowledgement& ack,
+           message.acknowledgements()) {
+    Slave* slave = acknowledge(
+        framework, ack.slave_id(), ack.task_id(), ack.uuid());
+
+    if (slave == NULL) {
+      continue;
+    }
+
+    if (!forwards.contains(slave->id)) {
+      forwards[slave->id].mutable_framework_id()->CopyFrom(frameworkId);
+    }
+
+    forwards[slave->id].add_acknowledgements()->CopyFrom(ack);
+
+    metrics->valid_status_update_acknowledgements++;
+  }
+
+  foreachpair (const SlaveID& slaveId,
+               const StatusUpdateAcknowledgementsMessage& forward,
+               forwards) {
+    Slave* slave = CHECK_NOTNULL(getSlave(slaveId));
+
+    LOG(INFO) << "Forwarding " << forward.acknowledgements_size()
+              << " status update acknowledgements of framework "
+              << *framework << " to slave " << *slave;
+
+    // Slaves that don't advertise accepting batches only understand
+    // acknowledgements one at a time.
+    if (slave->acknowledgementBatches) {
+      send(slave->pid, forward);
+      continue;
+    }
+
+    foreach (const StatusUpdateAcknowledgementsMessage::Acknowledgement& ack,
+             forward.acknowledgements()) {
+      StatusUpdateAcknowledgementMessage message;
+      message.mutable_slave_id()->CopyFrom(slaveId);
+      message.mutable_framework_id()->CopyFrom(frameworkId);
+      message.mutable_task_id()->CopyFrom(ack.task_id());
+      message.set_uuid(ack.uuid());
+
+      send(slave->pid, message);
+    }
+  }
+}
+
+
+Slave* Master::acknowledge(
+    Framework* framework,
+    const SlaveID& slaveId,
+    const TaskID& taskId,
+    const string& uuid)
+{
+  const FrameworkID& frameworkId = framework->id();
+
   Slave* slave = getSlave(slaveId);
 
   if (slave == NULL) {
@@ -2851,7 +2995,7 @@ void Master::statusUpdateAcknowledgement(
       << " of framework " << *framework << " to slave " << slaveId
       << " because slave is not registered";
     metrics->invalid_status_update_acknowledgements++;
-    return;
+    return NULL;
   }
 
   if (!slave->connected) {
@@ -2860,7 +3004,7 @@ void Master::statusUpdateAcknowledgement(
       << " of framework " << *framework << " to slave " << *slave
       << " because slave is disconnected";
     metrics->invalid_status_update_acknowledgements++;
-    return;
+    return NULL;
   }
 
   Task* task = slave->getTask(frameworkId, taskId);
@@ -2884,7 +3028,7 @@ void Master::statusUpdateAcknowledgement(
         << " of framework " << *framework << " to slave " << *slave
         << " because it no update was sent by this master";
       metrics->invalid_status_update_acknowledgements++;
-      return;
+      return NULL;
     }
 
     // Remove the task once the terminal update is acknowledged.
@@ -2894,19 +3038,7 @@ void Master::statusUpdateAcknowledgement(
      }
   }
 
-  LOG(INFO) << "Forwarding status update acknowledgement "
-            << UUID::fromBytes(uuid) << " for task " << taskId
-            << " of framework " << *framework << " to slave " << *slave;
-
-  StatusUpdateAcknowledgementMessage message;
-  message.mutable_slave_id()->CopyFrom(slaveId);
-  message.mutable_framework_id()->CopyFrom(frameworkId);
-  message.mutable_task_id()->CopyFrom(taskId);
-  message.set_uuid(uuid);
-
-  send(slave->pid, message);
-
-  metrics->valid_status_update_acknowledgements++;
+  return slave;
 }
 
 
@@ -2974,7 +3106,8 @@ void Master::registerSlave(
     const UPID& from,
     const SlaveInfo& slaveInfo,
     const vector<Resource>& checkpointedResources,
-    const string& version)
+    const string& version,
+    bool acknowledgementBatches)
 {
   ++metrics->messages_register_slave;
 
@@ -2988,7 +3121,8 @@ void Master::registerSlave(
                      from,
                      slaveInfo,
                      checkpointedResources,
-                     version));
+                     version,
+                     acknowledgementBatches));
     return;
   }
 
@@ -3055,6 +3189,7 @@ void Master::registerSlave(
                  from,
                  checkpointedResources,
                  version,
+                 acknowledgementBatches,
                  lambda::_1));
 }
 
@@ -3064,6 +3199,7 @@ void Master::_registerSlave(
     const UPID& pid,
     const vector<Resource>& checkpointedResources,
     const string& version,
+    bool acknowledgementBatches,
     const Future<bool>& admit)
 {
   slaves.registering.erase(pid);
@@ -3094,6 +3230,8 @@ void Master::_registerSlave(
         Clock::now(),
         checkpointedResources);
 
+    slave->acknowledgementBatches = acknowledgementBatches;
+
     ++metrics->slave_registrations;
 
     addSlave(slave);
@@ -3115,7 +3253,8 @@ void Master::reregisterSlave(
     const vector<ExecutorInfo>& executorInfos,
     const vector<Task>& tasks,
     const vector<Archive::Framework>& completedFrameworks,
-    const string& version)
+    const string& version,
+    bool acknowledgementBatches)
 {
   ++metrics->messages_reregister_slave;
 
@@ -3132,7 +3271,8 @@ void Master::reregisterSlave(
                      executorInfos,
                      tasks,
                      completedFrameworks,
-                     version));
+                     version,
+                     acknowledgementBatches));
     return;
   }
 
@@ -3188,6 +3328,11 @@ void Master::reregisterSlave(
     slave->pid = from;
     link(slave->pid);
 
+    // The slave might have been upgraded (or downgraded).
+    slave->acknowledgementBatches = acknowledgementBatches;
+
+    stateVersion++;
+
     // Reconcile tasks between master and the slave.
     // NOTE: This sends the re-registered message, including tasks
     // that need to be reconciled by the slave.
@@ -3202,6 +3347,7 @@ void Master::reregisterSlave(
       dispatch(slave->observer, &SlaveObserver::reconnect);
       slave->active = true;
       allocator->activateSlave(slave->id);
+      http.publish("SLAVE_UPDATED", *slave);
     }
 
     CHECK(slave->active)
@@ -3245,6 +3391,7 @@ void Master::reregisterSlave(
                  tasks,
                  completedFrameworks,
                  version,
+                 acknowledgementBatches,
                  lambda::_1));
 }
 
@@ -3257,6 +3404,7 @@ void Master::_reregisterSlave(
     const vector<Task>& tasks,
     const vector<Archive::Framework>& completedFrameworks,
     const string& version,
+    bool acknowledgementBatches,
     const Future<bool>& readmit)
 {
   slaves.reregistering.erase(slaveInfo.id());
@@ -3288,6 +3436,8 @@ void Master::_reregisterSlave(
         executorInfos,
         tasks);
 
+    slave->acknowledgementBatches = acknowledgementBatches;
+
     slave->reregisteredTime = Clock::now();
 
     ++metrics->slave_reregistrations;
@@ -3889,6 +4039,8 @@ void Master::offer(const FrameworkID& frameworkId,
     framework->addOffer(offer);
     slave->addOffer(offer);
 
+    stateVersion++;
+
     if (flags.offer_timeout.isSome()) {
       // Rescind the offer after the timeout elapses.
       offerTimers[offer->id()] =
@@ -4270,6 +4422,8 @@ void Master::addFramework(Framework* framework)
           Owned<Metrics::Frameworks>(new Metrics::Frameworks(principal.get())));
     }
   }
+
+  http.publish("FRAMEWORK_ADDED", *framework);
 }
 
 
@@ -4305,6 +4459,7 @@ void Master::failoverFramework(Framework* framework, const UPID& newPid)
   FrameworkRegisteredMessage message;
   message.mutable_framework_id()->MergeFrom(framework->id());
   message.mutable_master_info()->MergeFrom(info_);
+  message.set_acknowledgement_batches(true);
   send(newPid, message);
 
   // Remove the framework's offers (if they weren't removed before).
@@ -4327,6 +4482,8 @@ void Master::failoverFramework(Framework* framework, const UPID& newPid)
     allocator->activateFramework(framework->id());
   }
 
+  http.publish("FRAMEWORK_UPDATED", *framework);
+
   // 'Failover' the framework's metrics. i.e., change the lookup key
   // for its metrics to 'newPid'.
   if (oldPid != newPid && frameworks.principals.contains(oldPid)) {
@@ -4342,6 +4499,8 @@ void Master::removeFramework(Framework* framework)
 
   LOG(INFO) << "Removing framework " << *framework;
 
+  http.publish("FRAMEWORK_REMOVED", *framework);
+
   if (framework->active) {
     // Tell the allocator to stop allocating resources to this framework.
     // TODO(vinod): Consider setting  framework->active to false here
@@ -4532,7 +4691,7 @@ void Master::addSlave(
     foreachvalue (Task* task, slave->tasks[frameworkId]) {
       Framework* framework = getFramework(task->framework_id());
       if (framework != NULL) { // The framework might not be re-registered yet.
-        framework->addTask(task);
+        framework->addTask(task, nextTaskSequence++);
       } else {
         // TODO(benh): We should really put a timeout on how long we
         // keep tasks running on a slave that never have frameworks
@@ -4558,7 +4717,7 @@ void Master::addSlave(
         VLOG(2) << "Re-adding completed task " << task.task_id()
                 << " of framework " << *framework
                 << " that ran on slave " << *slave;
-        framework->addCompletedTask(task);
+        framework->addCompletedTask(task, nextTaskSequence++);
       } else {
         // We could be here if the framework hasn't registered yet.
         // TODO(vinod): Revisit these semantics when we store frameworks'
@@ -4575,6 +4734,8 @@ void Master::addSlave(
       slave->info,
       slave->totalResources,
       slave->usedResources);
+
+  http.publish("SLAVE_ADDED", *slave);
 }
 
 
@@ -4584,6 +4745,8 @@ void Master::removeSlave(Slave* slave)
 
   LOG(INFO) << "Removing slave " << *slave;
 
+  http.publish("SLAVE_REMOVED", *slave);
+
   // We want to remove the slave first, to avoid the allocator
   // re-allocating the recovered resources.
   //
@@ -4735,6 +4898,8 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
     latestState = update.latest_state();
   }
 
+  const TaskState previousState = task->state();
+
   // Set 'terminated' to true if this is the first time the task
   // transitioned to terminal state. Also set the latest state.
   bool terminated;
@@ -4753,6 +4918,13 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
     task->set_state(status.state());
   }
 
+  if (task->state() != previousState) {
+    Framework* framework = getFramework(task->framework_id());
+    if (framework != NULL) {
+      framework->taskStateChanged(task, previousState);
+    }
+  }
+
   // Set the status update state and uuid for the task.
   task->set_status_update_state(status.state());
   task->set_status_update_uuid(update.uuid());
@@ -4779,6 +4951,8 @@ void Master::updateTask(Task* task, const StatusUpdate& update)
                 ? " (status update state: " + stringify(status.state()) + ")"
                 : "");
 
+  http.publish("TASK_UPDATED", *task);
+
   // Once the task becomes terminal, we recover the resources.
   if (terminated) {
     allocator->recoverResources(
@@ -4852,6 +5026,8 @@ void Master::removeTask(Task* task)
   // Remove from slave.
   slave->removeTask(task);
 
+  stateVersion++;
+
   delete task;
 }
 
@@ -4879,6 +5055,8 @@ void Master::removeExecutor(
   }
 
   slave->removeExecutor(frameworkId, executorId);
+
+  stateVersion++;
 }
 
 
@@ -4897,6 +5075,8 @@ void Master::applyOfferOperation(
 
   slave->apply(operation);
 
+  stateVersion++;
+
   LOG(INFO) << "Sending checkpointed resources "
             << slave->checkpointedResources
             << " to slave " << *slave;
@@ -4955,6 +5135,8 @@ void Master::removeOffer(Offer* offer, bool rescind)
   // Delete it.
   offers.erase(offer->id());
   delete offer;
+
+  stateVersion++;
 }
 
 
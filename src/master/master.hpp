@@ -158,6 +158,10 @@ public:
       const TaskID& taskId,
       const std::string& uuid);
 
+  void statusUpdateAcknowledgements(
+      const process::UPID& from,
+      const StatusUpdateAcknowledgementsMessage& message);
+
   void schedulerMessage(
       const process::UPID& from,
       const SlaveID& slaveId,
@@ -169,7 +173,8 @@ public:
       const process::UPID& from,
       const SlaveInfo& slaveInfo,
       const std::vector<Resource>& checkpointedResources,
-      const std::string& version);
+      const std::string& version,
+      bool acknowledgementBatches);
 
   void reregisterSlave(
       const process::UPID& from,
@@ -178,7 +183,8 @@ public:
       const std::vector<ExecutorInfo>& executorInfos,
       const std::vector<Task>& tasks,
       const std::vector<Archive::Framework>& completedFrameworks,
-      const std::string& version);
+      const std::string& version,
+      bool acknowledgementBatches);
 
   void unregisterSlave(
       const process::UPID& from,
@@ -244,6 +250,7 @@ public:
       const std::vector<Task>& tasks,
       const std::vector<Archive::Framework>& completedFrameworks,
       const std::string& version,
+      bool acknowledgementBatches,
       const process::Future<bool>& readmit);
 
   MasterInfo info() const
@@ -286,6 +293,7 @@ protected:
       const process::UPID& pid,
       const std::vector<Resource>& checkpointedResources,
       const std::string& version,
+      bool acknowledgementBatches,
       const process::Future<bool>& admit);
 
   void __reregisterSlave(
@@ -390,6 +398,16 @@ protected:
   // Removes the task.
   void removeTask(Task* task);
 
+  // Applies a status update acknowledgement of the framework to the
+  // task (i.e., removes the task once its terminal update has been
+  // acknowledged). Returns the slave to forward the acknowledgement
+  // to, or NULL if the acknowledgement should be dropped.
+  Slave* acknowledge(
+      Framework* framework,
+      const SlaveID& slaveId,
+      const TaskID& taskId,
+      const std::string& uuid);
+
   // Remove an executor and recover its resources.
   void removeExecutor(
       Slave* slave,
@@ -477,6 +495,10 @@ private:
   public:
     explicit Http(Master* _master) : master(_master) {}
 
+    // /master/events
+    process::Future<process::http::Response> events(
+        const process::http::Request& request);
+
     // /master/health
     process::Future<process::http::Response> health(
         const process::http::Request& request);
@@ -509,6 +531,14 @@ private:
     process::Future<process::http::Response> tasks(
         const process::http::Request& request);
 
+    // Publishes an event about the task, slave or framework to the
+    // subscribers of /master/events. Since each of these events is a
+    // change of the state, this also bumps 'master->stateVersion'.
+    void publish(const std::string& type, const Task& task);
+    void publish(const std::string& type, const Slave& slave);
+    void publish(const std::string& type, const Framework& framework);
+
+    const static std::string EVENTS_HELP;
     const static std::string HEALTH_HELP;
     const static std::string OBSERVE_HELP;
     const static std::string REDIRECT_HELP;
@@ -522,6 +552,32 @@ private:
     // have been given to the master), otherwise an Error.
     Result<Credential> authenticate(const process::http::Request& request);
 
+    // A copy of the state of the master which gets served by
+    // /master/state.json (see http.cpp).
+    struct State;
+
+    // Copies the state of the master, so that it can be written out
+    // off of the master actor.
+    std::shared_ptr<State> copy();
+
+    // Returns the (stringified) JSON of the copy of the state.
+    static std::string stateJSON(const std::shared_ptr<State>& state);
+
+    // Updates 'master->stateSnapshot' if the state has changed since
+    // it was taken.
+    void snapshot();
+
+    // Writes the snapshot to the subscriber once it's ready, followed
+    // by the events that got published in the meantime.
+    void _events(uint64_t id, const process::Future<std::string>& json);
+
+    // Writes the (newline terminated) event to the subscribers of
+    // /master/events, dropping the subscribers that fall behind.
+    void publish(const std::string& event);
+
+    // Removes the subscriber once its client disconnects.
+    void unsubscribe(uint64_t id);
+
     // Continuations.
     process::Future<process::http::Response> _shutdown(
         const FrameworkID& id,
@@ -733,6 +789,44 @@ private:
 
   Option<process::Time> electedTime; // Time when this master is elected.
 
+  // The version of the state exposed through /master/state.json.
+  // It gets bumped wherever this state changes, which for frameworks,
+  // slaves and tasks happens when the change is published to the
+  // subscribers of /master/events (see Http::publish).
+  uint64_t stateVersion;
+
+  // The stringified /master/state.json as of some version, which gets
+  // reused (rather than rebuilt) until 'stateVersion' changes. The
+  // state is copied on the master actor but written out
+  // asynchronously (see Http::snapshot).
+  struct StateSnapshot
+  {
+    uint64_t version;
+    process::Future<std::string> json;
+  };
+
+  Option<StateSnapshot> stateSnapshot;
+
+  // A subscriber of the event stream served by /master/events. The
+  // events that get published before the snapshot the stream starts
+  // with has been written are held back in 'pending'.
+  struct Subscriber
+  {
+    explicit Subscriber(const process::http::Pipe::Writer& _writer)
+      : writer(_writer), ready(false) {}
+
+    process::http::Pipe::Writer writer;
+    bool ready;
+    std::string pending;
+  };
+
+  hashmap<uint64_t, Subscriber> subscribers;
+  uint64_t nextSubscriberId;
+
+  // The sequence number for the next task added to a framework, see
+  // Framework::sequences.
+  uint64_t nextTaskSequence;
+
   // Validates the framework including authorization.
   // Returns None if the framework is valid.
   // Returns Error if the framework is invalid.
@@ -758,6 +852,7 @@ struct Slave
       info(_info),
       pid(_pid),
       version(_version),
+      acknowledgementBatches(false),
       registeredTime(_registeredTime),
       connected(true),
       active(true),
@@ -925,6 +1020,10 @@ struct Slave
   // TODO(bmahler): Make this required once it is always set.
   const Option<std::string> version;
 
+  // Whether the slave accepts status update acknowledgements in
+  // batches, as advertised when it (re-)registered.
+  bool acknowledgementBatches;
+
   process::Time registeredTime;
   Option<process::Time> reregisteredTime;
 
@@ -1008,13 +1107,15 @@ struct Framework
     }
   }
 
-  void addTask(Task* task)
+  void addTask(Task* task, uint64_t sequence)
   {
     CHECK(!tasks.contains(task->task_id()))
       << "Duplicate task " << task->task_id()
       << " of framework " << task->framework_id();
 
     tasks[task->task_id()] = task;
+    tasksByState[task->state()].insert(task);
+    sequences[task] = sequence;
 
     if (!protobuf::isTerminalState(task->state())) {
       totalUsedResources += task->resources();
@@ -1040,10 +1141,35 @@ struct Framework
     }
   }
 
-  void addCompletedTask(const Task& task)
+  // Notification of a task state change, for the state index.
+  void taskStateChanged(Task* task, const TaskState& previous)
   {
+    CHECK(tasks.contains(task->task_id()))
+      << "Unknown task " << task->task_id()
+      << " of framework " << task->framework_id();
+
+    if (task->state() == previous) {
+      return;
+    }
+
+    tasksByState[previous].erase(task);
+    if (tasksByState[previous].empty()) {
+      tasksByState.erase(previous);
+    }
+
+    tasksByState[task->state()].insert(task);
+  }
+
+  void addCompletedTask(const Task& task, uint64_t sequence)
+  {
+    // The oldest completed task gets dropped when the buffer is full.
+    if (completedTasks.full()) {
+      sequences.erase(completedTasks.front().get());
+    }
+
     // TODO(adam-mesos): Check if completed task already exists.
     completedTasks.push_back(std::shared_ptr<Task>(new Task(task)));
+    sequences[completedTasks.back().get()] = sequence;
   }
 
   void removeTask(Task* task)
@@ -1060,7 +1186,13 @@ struct Framework
       }
     }
 
-    addCompletedTask(*task);
+    addCompletedTask(*task, sequences[task]);
+    sequences.erase(task);
+
+    tasksByState[task->state()].erase(task);
+    if (tasksByState[task->state()].empty()) {
+      tasksByState.erase(task->state());
+    }
 
     tasks.erase(task->task_id());
   }
@@ -1205,11 +1337,21 @@ struct Framework
 
   hashmap<TaskID, Task*> tasks;
 
+  // Secondary index of 'tasks' by their latest state, so that the
+  // tasks endpoint can filter by state without scanning all tasks.
+  hashmap<TaskState, hashset<Task*>> tasksByState;
+
   // NOTE: We use a shared pointer for Task because clang doesn't like
   // Boost's implementation of circular_buffer with Task (Boost
   // attempts to do some memset's which are unsafe).
   boost::circular_buffer<std::shared_ptr<Task>> completedTasks;
 
+  // The sequence numbers of the active and completed tasks, in the
+  // order in which they were added to the master. Unlike the
+  // statuses of a task these never change, so that they can order
+  // the task list of the tasks endpoint (see Http::tasks).
+  hashmap<const Task*, uint64_t> sequences;
+
   hashset<Offer*> offers; // Active offers for framework.
 
   hashmap<SlaveID, hashmap<ExecutorID, ExecutorInfo>> executors;
@@ -95,6 +95,8 @@ Metrics::Metrics(const Master& master)
         "master/messages_kill_task"),
     messages_status_update_acknowledgement(
         "master/messages_status_update_acknowledgement"),
+    messages_status_update_acknowledgements(
+        "master/messages_status_update_acknowledgements"),
     messages_resource_request(
         "master/messages_resource_request"),
     messages_launch_tasks(
@@ -189,6 +191,7 @@ Metrics::Metrics(const Master& master)
   process::metrics::add(messages_deactivate_framework);
   process::metrics::add(messages_kill_task);
   process::metrics::add(messages_status_update_acknowledgement);
+  process::metrics::add(messages_status_update_acknowledgements);
   process::metrics::add(messages_resource_request);
   process::metrics::add(messages_launch_tasks);
   process::metrics::add(messages_decline_offers);
@@ -292,6 +295,7 @@ Metrics::~Metrics()
   process::metrics::remove(messages_deactivate_framework);
   process::metrics::remove(messages_kill_task);
   process::metrics::remove(messages_status_update_acknowledgement);
+  process::metrics::remove(messages_status_update_acknowledgements);
   process::metrics::remove(messages_resource_request);
   process::metrics::remove(messages_launch_tasks);
   process::metrics::remove(messages_decline_offers);
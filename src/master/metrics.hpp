@@ -125,6 +125,7 @@ struct Metrics
   process::metrics::Counter messages_deactivate_framework;
   process::metrics::Counter messages_kill_task;
   process::metrics::Counter messages_status_update_acknowledgement;
+  process::metrics::Counter messages_status_update_acknowledgements;
   process::metrics::Counter messages_resource_request;
   process::metrics::Counter messages_launch_tasks;
   process::metrics::Counter messages_decline_offers;
@@ -17,10 +17,14 @@
  */
 
 #include <deque>
+#include <list>
+#include <map>
+#include <set>
 #include <string>
 
 #include <mesos/type_utils.hpp>
 
+#include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/dispatch.hpp>
 #include <process/future.hpp>
@@ -30,16 +34,21 @@
 #include <process/owned.hpp>
 #include <process/process.hpp>
 
+#include <process/metrics/counter.hpp>
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/timer.hpp>
 
+#include <stout/bytes.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/lambda.hpp>
 #include <stout/none.hpp>
 #include <stout/nothing.hpp>
+#include <stout/numify.hpp>
 #include <stout/option.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/stopwatch.hpp>
+#include <stout/strings.hpp>
 
 #include "master/registrar.hpp"
 #include "master/registry.hpp"
@@ -66,10 +75,13 @@ using process::USAGE;
 
 using process::http::OK;
 
+using process::metrics::Counter;
 using process::metrics::Gauge;
 using process::metrics::Timer;
 
 using std::deque;
+using std::list;
+using std::map;
 using std::string;
 
 namespace mesos {
@@ -79,6 +91,10 @@ namespace master {
 using process::http::Response;
 using process::http::Request;
 
+// Prefix of the names of the entries holding registry deltas. The
+// prefix is followed by the sequence number of the delta.
+static const string DELTA_PREFIX = "registry_delta_";
+
 class RegistrarProcess : public Process<RegistrarProcess>
 {
 public:
@@ -87,7 +103,9 @@ public:
       metrics(*this),
       updating(false),
       flags(_flags),
-      state(_state) {}
+      state(_state),
+      deltaBytes(0),
+      nextDelta(0) {}
 
   virtual ~RegistrarProcess() {}
 
@@ -137,30 +155,50 @@ private:
         registry_size_bytes(
             "registrar/registry_size_bytes",
             defer(process, &RegistrarProcess::_registry_size_bytes)),
+        registry_deltas(
+            "registrar/registry_deltas",
+            defer(process, &RegistrarProcess::_registry_deltas)),
         state_fetch("registrar/state_fetch"),
-        state_store("registrar/state_store", Days(1))
+        state_store("registrar/state_store", Days(1)),
+        state_store_bytes("registrar/state_store_bytes"),
+        state_store_bytes_per_operation(
+            "registrar/state_store_bytes_per_operation",
+            defer(process,
+                  &RegistrarProcess::_state_store_bytes_per_operation))
     {
       process::metrics::add(queued_operations);
       process::metrics::add(registry_size_bytes);
+      process::metrics::add(registry_deltas);
 
       process::metrics::add(state_fetch);
       process::metrics::add(state_store);
+      process::metrics::add(state_store_bytes);
+      process::metrics::add(state_store_bytes_per_operation);
     }
 
     ~Metrics()
     {
       process::metrics::remove(queued_operations);
       process::metrics::remove(registry_size_bytes);
+      process::metrics::remove(registry_deltas);
 
       process::metrics::remove(state_fetch);
       process::metrics::remove(state_store);
+      process::metrics::remove(state_store_bytes);
+      process::metrics::remove(state_store_bytes_per_operation);
     }
 
     Gauge queued_operations;
     Gauge registry_size_bytes;
+    Gauge registry_deltas;
 
     Timer<Milliseconds> state_fetch;
     Timer<Milliseconds> state_store;
+
+    // Total bytes written to the state and the bytes written per
+    // operation by the most recent store.
+    Counter state_store_bytes;
+    Gauge state_store_bytes_per_operation;
   } metrics;
 
   // Gauge handlers.
@@ -178,19 +216,55 @@ private:
     return Failure("Not recovered yet");
   }
 
+  double _registry_deltas()
+  {
+    return deltas.size();
+  }
+
+  Future<double> _state_store_bytes_per_operation()
+  {
+    if (bytesPerOperation.isSome()) {
+      return bytesPerOperation.get();
+    }
+
+    return Failure("No operations stored yet");
+  }
+
   // Continuations.
   void _recover(
       const MasterInfo& info,
       const Future<Variable<Registry> >& recovery);
-  void __recover(const Future<bool>& recover);
+  void __recover(
+      const MasterInfo& info,
+      const Future<list<Variable<Registry::Delta> > >& recovery);
+  void ___recover(const Future<bool>& recover);
   Future<bool> _apply(Owned<Operation> operation);
 
+  // Helper for fetching the deltas that haven't been compacted into
+  // the registry yet, in the order they were stored.
+  Future<list<Variable<Registry::Delta> > > fetch(
+      const std::set<string>& names);
+
+  // Helper for expunging a stale delta, i.e., one that was already
+  // compacted into the registry. It is never applied so it's fine if
+  // expunging it fails.
+  void expunge(const Variable<Registry::Delta>& delta);
+
   // Helper for updating state (performing store).
   void update();
   void _update(
-      const Future<Option<Variable<Registry> > >& store,
+      const Future<bool>& store,
+      size_t bytes,
       deque<Owned<Operation> > operations);
 
+  // Continuations of storing either the entire registry or a delta.
+  Future<bool> store(const Option<Variable<Registry> >& store);
+  bool expunged(const list<Future<bool> >& expunges);
+  Future<bool> stored(
+      const Registry& registry,
+      const Option<Variable<Registry::Delta> >& store);
+  bool prefetched(const Variable<Registry::Delta>& next);
+
   // Fails all pending operations and transitions the Registrar
   // into an error state in which all subsequent operations will fail.
   // This ensures we don't attempt to re-acquire log leadership by
@@ -210,6 +284,22 @@ private:
   // When an error is encountered from abort(), we'll fail all
   // subsequent operations.
   Option<Error> error;
+
+  // Deltas stored since the registry was last stored in its
+  // entirety, in the order they were stored, and their total size.
+  deque<Variable<Registry::Delta> > deltas;
+  size_t deltaBytes;
+
+  // Sequence number of the next delta and its (not yet stored)
+  // entry. The entry is fetched ahead of time, right after recovery
+  // or the previous delta was stored, so that storing the delta
+  // fails with a version mismatch if any other writer stored it in
+  // the meantime.
+  uint64_t nextDelta;
+  Option<Variable<Registry::Delta> > next;
+
+  // Bytes stored per operation by the most recent store.
+  Option<double> bytesPerOperation;
 };
 
 
@@ -227,6 +317,84 @@ Future<T> timeout(
 }
 
 
+// Returns the changes between the registry before ('master' and
+// 'slaveIDs') and after applying a batch of operations. Note that
+// operations only ever add or remove slaves.
+Registry::Delta diff(
+    const Registry::Master& master,
+    const hashset<SlaveID>& slaveIDs,
+    const Registry& registry,
+    const hashset<SlaveID>& _slaveIDs)
+{
+  Registry::Delta delta;
+
+  // NOTE: 'master' is empty (uninitialized) until the first recovery.
+  if (registry.has_master() &&
+      registry.master().SerializeAsString() !=
+        master.SerializePartialAsString()) {
+    delta.mutable_master()->CopyFrom(registry.master());
+  }
+
+  foreach (const Registry::Slave& slave, registry.slaves().slaves()) {
+    if (!slaveIDs.contains(slave.info().id())) {
+      delta.add_admitted()->CopyFrom(slave);
+    }
+  }
+
+  foreach (const SlaveID& slaveId, slaveIDs) {
+    if (!_slaveIDs.contains(slaveId)) {
+      delta.add_removed()->CopyFrom(slaveId);
+    }
+  }
+
+  return delta;
+}
+
+
+// Applies the deltas (in order) to the registry. Only the last
+// change to each slave matters, so the slaves are rebuilt once
+// rather than once per delta.
+void patch(Registry* registry, const deque<Variable<Registry::Delta> >& deltas)
+{
+  hashmap<SlaveID, Option<Registry::Slave> > changes;
+  list<SlaveID> admitted;
+
+  foreach (const Variable<Registry::Delta>& variable, deltas) {
+    const Registry::Delta& delta = variable.get();
+
+    if (delta.has_master()) {
+      registry->mutable_master()->CopyFrom(delta.master());
+    }
+
+    foreach (const Registry::Slave& slave, delta.admitted()) {
+      changes[slave.info().id()] = slave;
+      admitted.push_back(slave.info().id());
+    }
+
+    foreach (const SlaveID& slaveId, delta.removed()) {
+      changes[slaveId] = None();
+    }
+  }
+
+  Registry::Slaves slaves;
+
+  foreach (const Registry::Slave& slave, registry->slaves().slaves()) {
+    if (!changes.contains(slave.info().id())) {
+      slaves.add_slaves()->CopyFrom(slave);
+    }
+  }
+
+  foreach (const SlaveID& slaveId, admitted) {
+    if (changes.contains(slaveId) && changes[slaveId].isSome()) {
+      slaves.add_slaves()->CopyFrom(changes[slaveId].get());
+      changes.erase(slaveId); // Only add the slave once.
+    }
+  }
+
+  registry->mutable_slaves()->CopyFrom(slaves);
+}
+
+
 // Helper for failing a deque of operations.
 void fail(deque<Owned<Operation> >* operations, const string& message)
 {
@@ -332,36 +500,142 @@ Future<Registry> RegistrarProcess::recover(const MasterInfo& info)
 void RegistrarProcess::_recover(
     const MasterInfo& info,
     const Future<Variable<Registry> >& recovery)
+{
+  CHECK(!recovery.isPending());
+
+  if (!recovery.isReady()) {
+    updating = false;
+    recovered.get()->fail("Failed to recover registrar: " +
+        (recovery.isFailed() ? recovery.failure() : "discarded"));
+    return;
+  }
+
+  // Save the registry.
+  variable = recovery.get();
+
+  // Now fetch any deltas that haven't been compacted into the
+  // registry yet. Note that we do this even if we're not storing
+  // deltas (anymore) so that none get lost.
+  state->names()
+    .then(defer(self(), &Self::fetch, lambda::_1))
+    .after(flags.registry_fetch_timeout,
+           lambda::bind(
+               &timeout<list<Variable<Registry::Delta> > >,
+               "fetch",
+               flags.registry_fetch_timeout,
+               lambda::_1))
+    .onAny(defer(self(), &Self::__recover, info, lambda::_1));
+}
+
+
+Future<list<Variable<Registry::Delta> > > RegistrarProcess::fetch(
+    const std::set<string>& names)
+{
+  CHECK_SOME(variable);
+
+  // Deltas below this sequence number were already compacted into
+  // the registry, possibly without being expunged afterwards.
+  nextDelta = variable.get().get().next_delta();
+
+  map<uint64_t, string> sorted;
+
+  foreach (const string& name, names) {
+    if (strings::startsWith(name, DELTA_PREFIX)) {
+      Try<uint64_t> sequence =
+        numify<uint64_t>(name.substr(DELTA_PREFIX.size()));
+
+      if (sequence.isError()) {
+        LOG(WARNING) << "Ignoring unknown entry '" << name << "'";
+        continue;
+      }
+
+      if (sequence.get() < nextDelta) {
+        LOG(INFO) << "Expunging stale delta '" << name << "'";
+        state->fetch<Registry::Delta>(name)
+          .onReady(defer(self(), &Self::expunge, lambda::_1));
+        continue;
+      }
+
+      sorted[sequence.get()] = name;
+    }
+  }
+
+  list<Future<Variable<Registry::Delta> > > futures;
+  foreachvalue (const string& name, sorted) {
+    futures.push_back(state->fetch<Registry::Delta>(name));
+  }
+
+  if (!sorted.empty()) {
+    nextDelta = sorted.rbegin()->first + 1;
+  }
+
+  // Also fetch the entry for the next delta, see 'next'. It is
+  // the last variable in the list.
+  futures.push_back(
+      state->fetch<Registry::Delta>(DELTA_PREFIX + stringify(nextDelta)));
+
+  return process::collect(futures);
+}
+
+
+void RegistrarProcess::expunge(const Variable<Registry::Delta>& delta)
+{
+  state->expunge(delta);
+}
+
+
+void RegistrarProcess::__recover(
+    const MasterInfo& info,
+    const Future<list<Variable<Registry::Delta> > >& recovery)
 {
   updating = false;
 
   CHECK(!recovery.isPending());
 
   if (!recovery.isReady()) {
-    recovered.get()->fail("Failed to recover registrar: " +
+    recovered.get()->fail("Failed to recover registrar: "
+        "Failed to fetch deltas: " +
         (recovery.isFailed() ? recovery.failure() : "discarded"));
-  } else {
-    Duration elapsed = metrics.state_fetch.stop();
+    return;
+  }
 
-    LOG(INFO) << "Successfully fetched the registry"
-              << " (" << Bytes(recovery.get().get().ByteSize()) << ")"
-              << " in " << elapsed;
+  Duration elapsed = metrics.state_fetch.stop();
 
-    // Save the registry.
-    variable = recovery.get();
+  list<Variable<Registry::Delta> > fetched = recovery.get();
 
-    // Perform the Recover operation to add the new MasterInfo.
-    Owned<Operation> operation(new Recover(info));
-    operations.push_back(operation);
-    operation->future()
-      .onAny(defer(self(), &Self::__recover, lambda::_1));
+  CHECK(!fetched.empty());
+  next = fetched.back();
+  fetched.pop_back();
 
-    update();
+  foreach (const Variable<Registry::Delta>& delta, fetched) {
+    deltas.push_back(delta);
+    deltaBytes += delta.get().ByteSize();
   }
+
+  CHECK_SOME(variable);
+
+  if (!deltas.empty()) {
+    Registry registry = variable.get().get();
+    patch(&registry, deltas);
+    variable = variable.get().mutate(registry);
+  }
+
+  LOG(INFO) << "Successfully fetched the registry"
+            << " (" << Bytes(variable.get().get().ByteSize()) << ")"
+            << " and " << deltas.size() << " deltas"
+            << " (" << Bytes(deltaBytes) << ") in " << elapsed;
+
+  // Perform the Recover operation to add the new MasterInfo.
+  Owned<Operation> operation(new Recover(info));
+  operations.push_back(operation);
+  operation->future()
+    .onAny(defer(self(), &Self::___recover, lambda::_1));
+
+  update();
 }
 
 
-void RegistrarProcess::__recover(const Future<bool>& recover)
+void RegistrarProcess::___recover(const Future<bool>& recover)
 {
   CHECK(!recover.isPending());
 
@@ -437,38 +711,161 @@ void RegistrarProcess::update()
     slaveIDs.insert(slave.info().id());
   }
 
+  // Keep what's needed to determine the delta of the operations.
+  const Registry::Master master = registry.master();
+  hashset<SlaveID> _slaveIDs;
+  if (flags.registry_deltas) {
+    _slaveIDs = slaveIDs;
+  }
+
   foreach (Owned<Operation> operation, operations) {
     // No need to process the result of the operation.
     (*operation)(&registry, &slaveIDs, flags.registry_strict);
   }
 
+  Registry::Delta delta;
+  if (flags.registry_deltas) {
+    delta = diff(master, _slaveIDs, registry, slaveIDs);
+  }
+
+  // Store just the delta unless the deltas would get larger than the
+  // registry itself, in which case we store the entire registry and
+  // thereby compact the deltas.
+  const size_t size = registry.ByteSize();
+  const bool compact =
+    !flags.registry_deltas || deltaBytes + delta.ByteSize() >= size;
+
+  // Record which deltas the registry includes so that they never get
+  // applied again, even if expunging them fails.
+  if (compact && nextDelta > 0) {
+    registry.set_next_delta(nextDelta);
+  }
+
+  const size_t bytes = compact ? registry.ByteSize() : delta.ByteSize();
+
   LOG(INFO) << "Applied " << operations.size() << " operations in "
-            << stopwatch.elapsed() << "; attempting to update the 'registry'";
+            << stopwatch.elapsed() << "; attempting to update the 'registry'"
+            << (compact ? "" : " with a delta of " + stringify(Bytes(bytes)));
 
   // Perform the store, and time the operation.
   metrics.state_store.start();
-  state->store(variable.get().mutate(registry))
+
+  Future<bool> store;
+  if (compact) {
+    store = state->store(variable.get().mutate(registry))
+      .then(defer(self(), &Self::store, lambda::_1));
+  } else {
+    // Store the delta as a new entry.
+    CHECK_SOME(next);
+
+    store = state->store(next.get().mutate(delta))
+      .then(defer(self(), &Self::stored, registry, lambda::_1));
+  }
+
+  store
     .after(flags.registry_store_timeout,
            lambda::bind(
-               &timeout<Option<Variable<Registry> > >,
+               &timeout<bool>,
                "store",
                flags.registry_store_timeout,
                lambda::_1))
-    .onAny(defer(self(), &Self::_update, lambda::_1, operations));
+    .onAny(defer(self(),
+                 &Self::_update,
+                 lambda::_1,
+                 bytes,
+                 operations));
 
   // Clear the operations, _update will transition the Promises!
   operations.clear();
 }
 
 
+Future<bool> RegistrarProcess::store(
+    const Option<Variable<Registry> >& store)
+{
+  if (store.isNone()) {
+    return false; // Version mismatch.
+  }
+
+  variable = store.get();
+
+  if (deltas.empty()) {
+    return true;
+  }
+
+  // The registry now includes all of the deltas (see 'next_delta')
+  // so they can be expunged. Wait for the expunges before forgetting
+  // about the deltas so that they're accounted for until then.
+  LOG(INFO) << "Expunging " << deltas.size() << " deltas"
+            << " (" << Bytes(deltaBytes) << ") compacted into the registry";
+
+  list<Future<bool> > expunges;
+  foreach (const Variable<Registry::Delta>& delta, deltas) {
+    expunges.push_back(state->expunge(delta));
+  }
+
+  return process::await(expunges)
+    .then(defer(self(), &Self::expunged, lambda::_1));
+}
+
+
+bool RegistrarProcess::expunged(const list<Future<bool> >& expunges)
+{
+  // A delta that failed to be expunged is ignored (and expunged)
+  // during the next recovery since the registry's 'next_delta' is
+  // beyond it, so we only log the failure.
+  foreach (const Future<bool>& expunge, expunges) {
+    if (!expunge.isReady()) {
+      LOG(WARNING) << "Failed to expunge a compacted delta: "
+                   << (expunge.isFailed() ? expunge.failure() : "discarded");
+    }
+  }
+
+  deltas.clear();
+  deltaBytes = 0;
+
+  return true;
+}
+
+
+Future<bool> RegistrarProcess::stored(
+    const Registry& registry,
+    const Option<Variable<Registry::Delta> >& store)
+{
+  if (store.isNone()) {
+    return false; // Version mismatch.
+  }
+
+  deltas.push_back(store.get());
+  deltaBytes += store.get().get().ByteSize();
+  nextDelta++;
+
+  // Only the in-memory registry changes, the stored registry (and
+  // thus its version) stays the same until the deltas get compacted.
+  variable = variable.get().mutate(registry);
+
+  // Fetch the entry for the next delta ahead of time, see 'next'.
+  return state->fetch<Registry::Delta>(DELTA_PREFIX + stringify(nextDelta))
+    .then(defer(self(), &Self::prefetched, lambda::_1));
+}
+
+
+bool RegistrarProcess::prefetched(const Variable<Registry::Delta>& _next)
+{
+  next = _next;
+  return true;
+}
+
+
 void RegistrarProcess::_update(
-    const Future<Option<Variable<Registry> > >& store,
+    const Future<bool>& store,
+    size_t bytes,
     deque<Owned<Operation> > applied)
 {
   updating = false;
 
   // Abort if the storage operation did not succeed.
-  if (!store.isReady() || store.get().isNone()) {
+  if (!store.isReady() || !store.get()) {
     string message = "Failed to update 'registry': ";
 
     if (store.isFailed()) {
@@ -489,7 +886,8 @@ void RegistrarProcess::_update(
 
   LOG(INFO) << "Successfully updated the 'registry' in " << elapsed;
 
-  variable = store.get().get();
+  metrics.state_store_bytes += bytes;
+  bytesPerOperation = bytes / (double) applied.size();
 
   // Remove the operations.
   while (!applied.empty()) {
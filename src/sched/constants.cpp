@@ -31,6 +31,12 @@ const Duration REGISTRATION_BACKOFF_FACTOR = Seconds(2);
 
 const Duration REGISTRATION_RETRY_INTERVAL_MAX = Minutes(1);
 
+// NOTE: Batching is disabled by default, so that the driver sends each
+// acknowledgement right away, as it always has.
+const Duration ACKNOWLEDGEMENT_BATCH_INTERVAL = Duration::zero();
+
+const size_t MAX_ACKNOWLEDGEMENT_BATCH_SIZE = 1000;
+
 const std::string DEFAULT_AUTHENTICATEE = "crammd5";
 
 } // namespace scheduler {
@@ -33,6 +33,14 @@ extern const Duration REGISTRATION_BACKOFF_FACTOR;
 // registration.
 extern const Duration REGISTRATION_RETRY_INTERVAL_MAX;
 
+// Default interval over which the scheduler driver batches up status
+// update acknowledgements (zero disables batching).
+extern const Duration ACKNOWLEDGEMENT_BATCH_INTERVAL;
+
+// Maximum number of status update acknowledgements the scheduler
+// driver sends to the master in a single batch.
+extern const size_t MAX_ACKNOWLEDGEMENT_BATCH_SIZE;
+
 // Name of the default, CRAM-MD5 authenticatee.
 extern const std::string DEFAULT_AUTHENTICATEE;
 
@@ -48,6 +48,15 @@ public:
         stringify(REGISTRATION_RETRY_INTERVAL_MAX) + ", whichever is smaller",
         REGISTRATION_BACKOFF_FACTOR);
 
+    add(&Flags::acknowledgement_batch_interval,
+        "acknowledgement_batch_interval",
+        "Interval over which the scheduler driver batches up status update\n"
+        "acknowledgements, to send up to " +
+        stringify(MAX_ACKNOWLEDGEMENT_BATCH_SIZE) + " of them to the master\n"
+        "in a single message. Acknowledgements are sent one at a time if\n"
+        "zero, or if the master doesn't accept batches",
+        ACKNOWLEDGEMENT_BATCH_INTERVAL);
+
     // This help message for --modules flag is the same for
     // {master,slave,tests,sched}/flags.hpp and should always be kept
     // in sync.
@@ -104,6 +113,7 @@ public:
   }
 
   Duration registration_backoff_factor;
+  Duration acknowledgement_batch_interval;
   Option<Modules> modules;
   std::string authenticatee;
 };
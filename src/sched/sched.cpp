@@ -50,6 +50,7 @@
 #include <process/pid.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
+#include <process/timer.hpp>
 
 #include <process/metrics/gauge.hpp>
 #include <process/metrics/metrics.hpp>
@@ -148,6 +149,7 @@ public:
       detector(_detector),
       flags(_flags),
       implicitAcknowledgements(_implicitAcknowledgements),
+      batchAcknowledgements(false),
       credential(_credential),
       authenticatee(NULL),
       authenticating(None()),
@@ -170,12 +172,14 @@ protected:
     install<FrameworkRegisteredMessage>(
         &SchedulerProcess::registered,
         &FrameworkRegisteredMessage::framework_id,
-        &FrameworkRegisteredMessage::master_info);
+        &FrameworkRegisteredMessage::master_info,
+        &FrameworkRegisteredMessage::acknowledgement_batches);
 
     install<FrameworkReregisteredMessage>(
         &SchedulerProcess::reregistered,
         &FrameworkReregisteredMessage::framework_id,
-        &FrameworkReregisteredMessage::master_info);
+        &FrameworkReregisteredMessage::master_info,
+        &FrameworkReregisteredMessage::acknowledgement_batches);
 
     install<ResourceOffersMessage>(
         &SchedulerProcess::resourceOffers,
@@ -250,6 +254,11 @@ protected:
 
     connected = false;
 
+    // Drop the acknowledgements batched up for the previous master,
+    // since the new one might not accept batches. The slaves will
+    // retry the corresponding status updates.
+    flushAcknowledgements();
+
     if (master.isSome()) {
       LOG(INFO) << "New master detected at " << master.get();
       link(master.get());
@@ -423,7 +432,8 @@ protected:
   void registered(
       const UPID& from,
       const FrameworkID& frameworkId,
-      const MasterInfo& masterInfo)
+      const MasterInfo& masterInfo,
+      bool acknowledgementBatches)
   {
     if (!running) {
       VLOG(1) << "Ignoring framework registered message because "
@@ -452,6 +462,10 @@ protected:
     connected = true;
     failover = false;
 
+    // Only batch up acknowledgements if the master advertised that
+    // it accepts them.
+    batchAcknowledgements = acknowledgementBatches;
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -465,7 +479,8 @@ protected:
   void reregistered(
       const UPID& from,
       const FrameworkID& frameworkId,
-      const MasterInfo& masterInfo)
+      const MasterInfo& masterInfo,
+      bool acknowledgementBatches)
   {
     if (!running) {
       VLOG(1) << "Ignoring framework re-registered message because "
@@ -494,6 +509,10 @@ protected:
     connected = true;
     failover = false;
 
+    // Only batch up acknowledgements if the master advertised that
+    // it accepts them.
+    batchAcknowledgements = acknowledgementBatches;
+
     Stopwatch stopwatch;
     if (FLAGS_v >= 1) {
       stopwatch.start();
@@ -732,15 +751,10 @@ protected:
         CHECK(connected);
         CHECK_SOME(master);
 
-        VLOG(2) << "Sending ACK for status update " << update
-            << " to " << master.get();
-
-        StatusUpdateAcknowledgementMessage message;
-        message.mutable_framework_id()->MergeFrom(framework.id());
-        message.mutable_slave_id()->MergeFrom(update.slave_id());
-        message.mutable_task_id()->MergeFrom(update.status().task_id());
-        message.set_uuid(update.uuid());
-        send(master.get(), message);
+        acknowledge(
+            update.slave_id(),
+            update.status().task_id(),
+            update.uuid());
       }
     }
   }
@@ -830,6 +844,9 @@ protected:
   {
     LOG(INFO) << "Stopping framework '" << framework.id() << "'";
 
+    // Send the acknowledgements requested before stopping.
+    flushAcknowledgements();
+
     // Whether or not we send an unregister message, we want to
     // terminate this process.
     terminate(self());
@@ -1122,17 +1139,7 @@ protected:
     // ensures that master-generated and driver-generated updates
     // will not have a 'uuid' set.
     if (status.has_uuid() && status.has_slave_id()) {
-      VLOG(2) << "Sending ACK for status update " << status.uuid()
-              << " of task " << status.task_id()
-              << " on slave " << status.slave_id()
-              << " to " << master.get();
-
-      StatusUpdateAcknowledgementMessage message;
-      message.mutable_framework_id()->CopyFrom(framework.id());
-      message.mutable_slave_id()->CopyFrom(status.slave_id());
-      message.mutable_task_id()->CopyFrom(status.task_id());
-      message.set_uuid(status.uuid());
-      send(master.get(), message);
+      acknowledge(status.slave_id(), status.task_id(), status.uuid());
     } else {
       VLOG(2) << "Received ACK for status update"
               << (status.has_uuid() ? " " + status.uuid() : "")
@@ -1142,6 +1149,86 @@ protected:
     }
   }
 
+  // Sends the status update acknowledgement to the master. If the
+  // master supports it, the acknowledgement is instead batched up
+  // with those that follow within 'acknowledgement_batch_interval'.
+  void acknowledge(
+      const SlaveID& slaveId,
+      const TaskID& taskId,
+      const string& uuid)
+  {
+    CHECK(connected);
+    CHECK_SOME(master);
+
+    if (!batchAcknowledgements ||
+        flags.acknowledgement_batch_interval == Duration::zero()) {
+      VLOG(2) << "Sending ACK for status update "
+              << UUID::fromBytes(uuid).toString() << " of task " << taskId
+              << " on slave " << slaveId << " to " << master.get();
+
+      StatusUpdateAcknowledgementMessage message;
+      message.mutable_framework_id()->CopyFrom(framework.id());
+      message.mutable_slave_id()->CopyFrom(slaveId);
+      message.mutable_task_id()->CopyFrom(taskId);
+      message.set_uuid(uuid);
+      send(master.get(), message);
+      return;
+    }
+
+    VLOG(2) << "Batching up ACK for status update "
+            << UUID::fromBytes(uuid).toString() << " of task " << taskId
+            << " on slave " << slaveId;
+
+    StatusUpdateAcknowledgementsMessage::Acknowledgement* acknowledgement =
+      acknowledgements.add_acknowledgements();
+
+    acknowledgement->mutable_slave_id()->CopyFrom(slaveId);
+    acknowledgement->mutable_task_id()->CopyFrom(taskId);
+    acknowledgement->set_uuid(uuid);
+
+    if (acknowledgements.acknowledgements_size() >=
+        static_cast<int>(scheduler::MAX_ACKNOWLEDGEMENT_BATCH_SIZE)) {
+      flushAcknowledgements();
+    } else if (acknowledgementTimer.isNone()) {
+      acknowledgementTimer = delay(
+          flags.acknowledgement_batch_interval,
+          self(),
+          &Self::flushAcknowledgements);
+    }
+  }
+
+  void flushAcknowledgements()
+  {
+    if (acknowledgementTimer.isSome()) {
+      Clock::cancel(acknowledgementTimer.get());
+      acknowledgementTimer = None();
+    }
+
+    if (acknowledgements.acknowledgements_size() == 0) {
+      return;
+    }
+
+    // We drop acknowledgements while we're disconnected, the slaves
+    // will retry the corresponding status updates.
+    if (!connected) {
+      VLOG(1) << "Dropping " << acknowledgements.acknowledgements_size()
+              << " status update acknowledgements because the driver is"
+              << " disconnected";
+      acknowledgements.Clear();
+      return;
+    }
+
+    CHECK_SOME(master);
+
+    VLOG(2) << "Sending " << acknowledgements.acknowledgements_size()
+            << " status update acknowledgements to " << master.get();
+
+    acknowledgements.mutable_framework_id()->CopyFrom(framework.id());
+    send(master.get(), acknowledgements);
+
+    acknowledgements.Clear();
+  }
+
   void sendFrameworkMessage(const ExecutorID& executorId,
                             const SlaveID& slaveId,
                             const string& data)
@@ -1281,6 +1368,14 @@ private:
   // is set).
   bool implicitAcknowledgements;
 
+  // Whether the master accepts batched acknowledgements.
+  bool batchAcknowledgements;
+
+  // The acknowledgements batched up to be sent to the master once
+  // the 'acknowledgementTimer' fires (or the batch is full).
+  StatusUpdateAcknowledgementsMessage acknowledgements;
+  Option<Timer> acknowledgementTimer;
+
   const Option<Credential> credential;
 
   Authenticatee* authenticatee;
@@ -46,6 +46,8 @@ const double DEFAULT_CPUS = 1;
 const Bytes DEFAULT_MEM = Gigabytes(1);
 const Bytes DEFAULT_DISK = Gigabytes(10);
 const std::string DEFAULT_PORTS = "[31000-32000]";
+const Bytes DEFAULT_FETCHER_CACHE_SIZE = Gigabytes(2);
+const size_t DEFAULT_MAX_FILE_FOLLOWERS = 100;
 #ifdef WITH_NETWORK_ISOLATOR
 const uint16_t DEFAULT_EPHEMERAL_PORTS_PER_CONTAINER = 1024;
 #endif
@@ -82,6 +82,13 @@ extern const Bytes DEFAULT_DISK;
 // Default ports range offered by the slave.
 extern const std::string DEFAULT_PORTS;
 
+// Default size of the fetcher cache.
+extern const Bytes DEFAULT_FETCHER_CACHE_SIZE;
+
+// Default maximum number of files that can be followed concurrently
+// through the '/files/follow' endpoint.
+extern const size_t DEFAULT_MAX_FILE_FOLLOWERS;
+
 // Default cpu resource given to a command executor.
 const double DEFAULT_EXECUTOR_CPUS = 0.1;
 
@@ -36,6 +36,7 @@
 #include "common/status_utils.hpp"
 
 #include "docker/docker.hpp"
+#include "docker/engine.hpp"
 
 #ifdef __linux__
 #include "linux/cgroups.hpp"
@@ -107,7 +108,10 @@ Try<DockerContainerizer*> DockerContainerizer::create(
     const Flags& flags,
     Fetcher* fetcher)
 {
-  Try<Docker*> docker = Docker::create(flags.docker);
+  Try<Docker*> docker = flags.docker_socket.isSome()
+    ? DockerEngine::create(flags.docker, flags.docker_socket.get())
+    : Docker::create(flags.docker);
+
   if (docker.isError()) {
     return Error(docker.error());
   }
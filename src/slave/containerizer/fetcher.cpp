@@ -16,20 +16,29 @@
  * limitations under the License.
  */
 
+#include <sys/stat.h>
+
 #include <mesos/fetcher/fetcher.hpp>
 
+#include <process/collect.hpp>
 #include <process/dispatch.hpp>
 #include <process/process.hpp>
 
+#include <stout/uuid.hpp>
+
 #include "slave/slave.hpp"
 
 #include "slave/containerizer/fetcher.hpp"
 
+using std::list;
 using std::map;
+using std::shared_ptr;
 using std::string;
 using std::vector;
 
 using process::Future;
+using process::Owned;
+using process::Promise;
 
 using mesos::fetcher::FetcherInfo;
 
@@ -51,7 +60,9 @@ Fetcher::~Fetcher()
 }
 
 
-map<string, string> Fetcher::environment(
+// Returns the fetcher info for the URIs of the command info, without
+// any items, i.e., all URIs bypass the cache.
+static FetcherInfo createFetcherInfo(
     const CommandInfo& commandInfo,
     const string& directory,
     const Option<string>& user,
@@ -71,6 +82,48 @@ map<string, string> Fetcher::environment(
     fetcherInfo.set_frameworks_home(flags.frameworks_home);
   }
 
+  return fetcherInfo;
+}
+
+
+// Returns the size of the (single) file in the directory of a cache
+// entry, which only exists once the file has been downloaded.
+static Try<Bytes> cachedSize(const string& directory)
+{
+  Try<list<string>> files = os::ls(directory);
+  if (files.isError()) {
+    return Error(files.error());
+  } else if (files.get().size() != 1) {
+    return Error("Expecting exactly one file in '" + directory + "'");
+  }
+
+  const string path = path::join(directory, files.get().front());
+
+  struct stat s;
+  if (::stat(path.c_str(), &s) < 0) {
+    return ErrnoError("Failed to stat '" + path + "'");
+  }
+
+  return Bytes(s.st_size);
+}
+
+
+map<string, string> Fetcher::environment(
+    const CommandInfo& commandInfo,
+    const string& directory,
+    const Option<string>& user,
+    const Flags& flags)
+{
+  return environment(
+      createFetcherInfo(commandInfo, directory, user, flags),
+      flags);
+}
+
+
+map<string, string> Fetcher::environment(
+    const FetcherInfo& fetcherInfo,
+    const Flags& flags)
+{
   map<string, string> result;
 
   if (!flags.hadoop_home.empty()) {
@@ -155,31 +208,221 @@ Future<Nothing> FetcherProcess::fetch(
   VLOG(1) << "Starting to fetch URIs for container: " << containerId
         << ", directory: " << directory;
 
-  Try<Subprocess> subprocess =
-    run(commandInfo, directory, user, flags, stdout, stderr);
+  vector<shared_ptr<CacheEntry>> entries;
+  list<Future<Nothing>> downloads;
+
+  FetcherInfo fetcherInfo =
+    prepare(commandInfo, directory, user, flags, &entries, &downloads);
+
+  pending.insert(containerId);
+
+  Future<Nothing> fetched = await(downloads)
+    .then(defer(self(),
+                &Self::launch,
+                containerId,
+                fetcherInfo,
+                entries,
+                flags,
+                stdout,
+                stderr));
+
+  // The entries get released however the fetch ends, and before it
+  // completes so that the cache is up to date by then.
+  Owned<Promise<Nothing>> promise(new Promise<Nothing>());
+
+  fetched.onAny(defer(self(),
+                      &Self::release,
+                      fetcherInfo,
+                      entries,
+                      flags,
+                      promise,
+                      lambda::_1));
+
+  return promise->future();
+}
 
-  if (subprocess.isError()) {
-    return Failure("Failed to execute mesos-fetcher: " + subprocess.error());
+
+Future<Nothing> FetcherProcess::fetch(
+    const ContainerID& containerId,
+    const CommandInfo& commandInfo,
+    const string& directory,
+    const Option<string>& user,
+    const Flags& flags)
+{
+  // Before we fetch let's make sure we create 'stdout' and 'stderr'
+  // files into which we can redirect the output of the mesos-fetcher
+  // (and later redirect the child's stdout/stderr).
+
+  // TODO(tillt): Considering updating fetcher::run to take paths
+  // instead of file descriptors and then use Subprocess::PATH()
+  // instead of Subprocess::FD(). The reason this can't easily be done
+  // today is because we not only need to open the files but also
+  // chown them.
+  Try<int> out = os::open(
+      path::join(directory, "stdout"),
+      O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (out.isError()) {
+    return Failure("Failed to create 'stdout' file: " + out.error());
   }
 
-  subprocessPids[containerId] = subprocess.get().pid();
+  // Repeat for stderr.
+  Try<int> err = os::open(
+      path::join(directory, "stderr"),
+      O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
 
-  return subprocess.get().status()
-    .then(defer(self(), &Self::_fetch, containerId, lambda::_1));
+  if (err.isError()) {
+    os::close(out.get());
+    return Failure("Failed to create 'stderr' file: " + err.error());
+  }
+
+  if (user.isSome()) {
+    Try<Nothing> chown = os::chown(user.get(), directory);
+    if (chown.isError()) {
+      os::close(out.get());
+      os::close(err.get());
+      return Failure("Failed to chown work directory");
+    }
+  }
+
+  return fetch(
+      containerId,
+      commandInfo,
+      directory,
+      user,
+      flags,
+      out.get(),
+      err.get())
+    .onAny(lambda::bind(&os::close, out.get()))
+    .onAny(lambda::bind(&os::close, err.get()));
 }
 
 
-Future<Nothing> FetcherProcess::fetch(
-    const ContainerID& containerId,
+FetcherInfo FetcherProcess::prepare(
     const CommandInfo& commandInfo,
     const string& directory,
     const Option<string>& user,
-    const Flags& flags)
+    const Flags& flags,
+    vector<shared_ptr<CacheEntry>>* entries,
+    list<Future<Nothing>>* downloads)
 {
-  VLOG(1) << "Starting to fetch URIs for container: " << containerId
-        << ", directory: " << directory;
+  FetcherInfo fetcherInfo =
+    createFetcherInfo(commandInfo, directory, user, flags);
+
+  bool cached = false;
+  foreach (const CommandInfo::URI& uri, commandInfo.uris()) {
+    cached = cached || uri.cache();
+  }
+
+  if (!cached) {
+    return fetcherInfo;
+  }
+
+  const string cacheDirectory = flags.fetcher_cache_dir.isSome()
+    ? flags.fetcher_cache_dir.get()
+    : path::join(flags.work_dir, "fetch");
+
+  // Any files already in the cache directory are left over from a
+  // previous run, so we start out with an empty directory.
+  if (!cacheDirectories.contains(cacheDirectory)) {
+    if (os::exists(cacheDirectory)) {
+      Try<Nothing> rmdir = os::rmdir(cacheDirectory);
+      if (rmdir.isError()) {
+        LOG(WARNING) << "Failed to clean up fetcher cache directory '"
+                     << cacheDirectory << "': " << rmdir.error();
+      }
+    }
+
+    cacheDirectories.insert(cacheDirectory);
+  }
+
+  Try<Nothing> mkdir = os::mkdir(cacheDirectory);
+  if (mkdir.isError()) {
+    LOG(WARNING) << "Failed to create fetcher cache directory '"
+                 << cacheDirectory << "', bypassing the cache: "
+                 << mkdir.error();
+    return fetcherInfo;
+  }
+
+  // The entries that get downloaded by this fetch, a URI might be
+  // listed more than once.
+  hashset<string> downloading;
+
+  foreach (const CommandInfo::URI& uri, commandInfo.uris()) {
+    FetcherInfo::Item* item = fetcherInfo.add_items();
+    item->mutable_uri()->CopyFrom(uri);
+
+    if (!uri.cache()) {
+      item->set_action(FetcherInfo::BYPASS_CACHE);
+      entries->push_back(shared_ptr<CacheEntry>());
+      continue;
+    }
+
+    // Files in the sandbox are owned by the user, hence the cached
+    // files are not shared between users.
+    const string key = (user.isSome() ? user.get() : "") + ":" + uri.value();
+
+    shared_ptr<CacheEntry> entry;
+
+    if (cache.contains(key)) {
+      entry = cache[key];
+      lru.splice(lru.end(), lru, entry->position);
+
+      item->set_action(FetcherInfo::RETRIEVE_FROM_CACHE);
+
+      if (!downloading.contains(key)) {
+        downloads->push_back(entry->promise.future());
+      }
+    } else {
+      entry.reset(new CacheEntry(
+          key,
+          path::join(cacheDirectory, UUID::random().toString())));
+
+      entry->position = lru.insert(lru.end(), key);
+      cache[key] = entry;
+      downloading.insert(key);
+
+      item->set_action(FetcherInfo::DOWNLOAD_AND_CACHE);
+    }
+
+    entry->references++;
+
+    item->set_cache_directory(entry->directory);
+    entries->push_back(entry);
+  }
+
+  return fetcherInfo;
+}
+
+
+Future<Nothing> FetcherProcess::launch(
+    const ContainerID& containerId,
+    FetcherInfo fetcherInfo,
+    const vector<shared_ptr<CacheEntry>>& entries,
+    const Flags& flags,
+    const Option<int>& stdout,
+    const Option<int>& stderr)
+{
+  if (!pending.contains(containerId)) {
+    return Failure("Fetching URIs for container '" +
+                   stringify(containerId) + "' was killed");
+  }
 
-  Try<Subprocess> subprocess = run(commandInfo, directory, user, flags);
+  pending.erase(containerId);
+
+  for (int i = 0; i < fetcherInfo.items_size(); i++) {
+    FetcherInfo::Item* item = fetcherInfo.mutable_items(i);
+
+    if (item->action() == FetcherInfo::RETRIEVE_FROM_CACHE &&
+        entries[i]->promise.future().isFailed()) {
+      item->set_action(FetcherInfo::BYPASS_CACHE);
+      item->clear_cache_directory();
+    }
+  }
+
+  Try<Subprocess> subprocess = run(fetcherInfo, flags, stdout, stderr);
 
   if (subprocess.isError()) {
     return Failure("Failed to execute mesos-fetcher: " + subprocess.error());
@@ -210,10 +453,93 @@ Future<Nothing> FetcherProcess::_fetch(
 }
 
 
+void FetcherProcess::release(
+    const FetcherInfo& fetcherInfo,
+    const vector<shared_ptr<CacheEntry>>& entries,
+    const Flags& flags,
+    Owned<Promise<Nothing>> promise,
+    const Future<Nothing>& future)
+{
+  for (int i = 0; i < fetcherInfo.items_size(); i++) {
+    const FetcherInfo::Item& item = fetcherInfo.items(i);
+
+    if (item.action() == FetcherInfo::BYPASS_CACHE) {
+      continue;
+    }
+
+    const shared_ptr<CacheEntry>& entry = entries[i];
+
+    entry->references--;
+
+    if (item.action() != FetcherInfo::DOWNLOAD_AND_CACHE) {
+      continue;
+    }
+
+    // The mesos-fetcher only moves the file into the directory of
+    // the entry once it has been downloaded completely.
+    Try<Bytes> size = cachedSize(entry->directory);
+
+    if (size.isSome()) {
+      VLOG(1) << "Cached '" << item.uri().value() << "' ("
+              << size.get() << ") in '" << entry->directory << "'";
+
+      entry->size = size.get();
+      cacheSize += size.get();
+      entry->promise.set(Nothing());
+    } else {
+      LOG(WARNING) << "Failed to download '" << item.uri().value()
+                   << "' into the fetcher cache: " << size.error();
+
+      entry->promise.fail(size.error());
+      remove(entry);
+    }
+  }
+
+  // Evict the least recently used entries which are not being
+  // fetched until the cache fits again.
+  list<string>::iterator it = lru.begin();
+  while (cacheSize > flags.fetcher_cache_size && it != lru.end()) {
+    const shared_ptr<CacheEntry> entry = cache[*it++];
+
+    if (entry->references == 0 && entry->size.isSome()) {
+      remove(entry);
+    }
+  }
+
+  promise->associate(future);
+}
+
+
+void FetcherProcess::remove(const shared_ptr<CacheEntry>& entry)
+{
+  VLOG(1) << "Removing '" << entry->key << "' from the fetcher cache";
+
+  if (entry->size.isSome()) {
+    cacheSize -= entry->size.get();
+  }
+
+  cache.erase(entry->key);
+  lru.erase(entry->position);
+
+  // The mesos-fetcher downloads into a temporary directory first.
+  vector<string> directories;
+  directories.push_back(entry->directory);
+  directories.push_back(entry->directory + ".tmp");
+
+  foreach (const string& directory, directories) {
+    if (os::exists(directory)) {
+      Try<Nothing> rmdir = os::rmdir(directory);
+      if (rmdir.isError()) {
+        LOG(WARNING) << "Failed to remove fetcher cache directory '"
+                     << directory << "': " << rmdir.error();
+      }
+    }
+  }
+}
+
+
 Try<Subprocess> FetcherProcess::run(
-    const CommandInfo& commandInfo,
-    const string& directory,
-    const Option<string>& user,
+    const FetcherInfo& fetcherInfo,
     const Flags& flags,
     const Option<int>& stdout,
     const Option<int>& stderr)
@@ -246,7 +572,7 @@ Try<Subprocess> FetcherProcess::run(
     stderr.isSome()
       ? Subprocess::FD(stderr.get())
       : Subprocess::PIPE(),
-    Fetcher::environment(commandInfo, directory, user, flags));
+    Fetcher::environment(fetcherInfo, flags));
 
   if (fetcherSubprocess.isError()) {
     return Error(
@@ -257,66 +583,6 @@ Try<Subprocess> FetcherProcess::run(
 }
 
 
-Try<Subprocess> FetcherProcess::run(
-    const CommandInfo& commandInfo,
-    const string& directory,
-    const Option<string>& user,
-    const Flags& flags)
-{
-  // Before we fetch let's make sure we create 'stdout' and 'stderr'
-  // files into which we can redirect the output of the mesos-fetcher
-  // (and later redirect the child's stdout/stderr).
-
-  // TODO(tillt): Considering updating fetcher::run to take paths
-  // instead of file descriptors and then use Subprocess::PATH()
-  // instead of Subprocess::FD(). The reason this can't easily be done
-  // today is because we not only need to open the files but also
-  // chown them.
-  Try<int> out = os::open(
-      path::join(directory, "stdout"),
-      O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK | O_CLOEXEC,
-      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
-
-  if (out.isError()) {
-    return Error("Failed to create 'stdout' file: " + out.error());
-  }
-
-  // Repeat for stderr.
-  Try<int> err = os::open(
-      path::join(directory, "stderr"),
-      O_WRONLY | O_CREAT | O_TRUNC | O_NONBLOCK | O_CLOEXEC,
-      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
-
-  if (err.isError()) {
-    os::close(out.get());
-    return Error("Failed to create 'stderr' file: " + err.error());
-  }
-
-  if (user.isSome()) {
-    Try<Nothing> chown = os::chown(user.get(), directory);
-    if (chown.isError()) {
-      os::close(out.get());
-      os::close(err.get());
-      return Error("Failed to chown work directory");
-    }
-  }
-
-  Try<Subprocess> subprocess = run(
-      commandInfo,
-      directory,
-      user,
-      flags,
-      out.get(),
-      err.get());
-
-  subprocess.get().status()
-    .onAny(lambda::bind(&os::close, out.get()))
-    .onAny(lambda::bind(&os::close, err.get()));
-
-  return subprocess;
-}
-
-
 void FetcherProcess::kill(const ContainerID& containerId)
 {
   if (subprocessPids.contains(containerId)) {
@@ -326,6 +592,8 @@ void FetcherProcess::kill(const ContainerID& containerId)
 
     subprocessPids.erase(containerId);
   }
+
+  pending.erase(containerId);
 }
 
 } // namespace slave {
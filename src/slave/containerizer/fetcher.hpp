@@ -19,16 +19,23 @@
 #ifndef __SLAVE_FETCHER_HPP__
 #define __SLAVE_FETCHER_HPP__
 
+#include <list>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include <mesos/mesos.hpp>
 
+#include <mesos/fetcher/fetcher.hpp>
+
 #include <process/future.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/subprocess.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 
 #include "slave/flags.hpp"
 
@@ -40,25 +47,35 @@ namespace slave {
 class FetcherProcess;
 
 // Argument passing to and invocation of the external fetcher program.
-// TODO(bernd-mesos) : Orchestration and synchronization of fetching
-// phases. Bookkeeping of executor files that are cached after
-// downloading from a URI by the fetcher program. Cache eviction.
-// There has to be exactly one fetcher with a distinct cache dir per
-// active slave. This means that the cache dir can only be fixed
-// after the slave ID has been determined by registration or recovery.
+//
+// URIs which are marked to be cached (see CommandInfo::URI) are
+// downloaded once into the fetcher cache and then hard linked (or
+// copied) from there into each sandbox, archives get extracted from
+// the sandbox as usual. Cache entries are keyed by the user and the
+// URI, and concurrent fetches of the same URI share one download.
+// Once the files in the cache exceed 'fetcher_cache_size' the least
+// recently used ones that no fetch is using get removed.
+// NOTE: There has to be exactly one fetcher per cache directory,
+// since the cache is only kept in memory and its directory gets
+// cleaned up when the fetcher first uses it.
 class Fetcher
 {
 public:
   // Builds the environment used to run mesos-fetcher. This
   // environment contains one variable with the name
   // "MESOS_FETCHER_INFO", and its value is a protobuf of type
-  // mesos::fetcher::FetcherInfo.
+  // mesos::fetcher::FetcherInfo. All URIs bypass the cache.
   static std::map<std::string, std::string> environment(
       const CommandInfo& commandInfo,
       const std::string& directory,
       const Option<std::string>& user,
       const Flags& flags);
 
+  // Same as above, but for the given fetcher info.
+  static std::map<std::string, std::string> environment(
+      const mesos::fetcher::FetcherInfo& fetcherInfo,
+      const Flags& flags);
+
   Fetcher();
 
   virtual ~Fetcher();
@@ -120,35 +137,101 @@ public:
   void kill(const ContainerID& containerId);
 
 private:
+  // A file in the fetcher cache.
+  struct CacheEntry
+  {
+    CacheEntry(const std::string& _key, const std::string& _directory)
+      : key(_key), directory(_directory), references(0) {}
+
+    const std::string key;
+
+    // The directory which holds the cached file once it has been
+    // downloaded, see mesos::fetcher::FetcherInfo::Item.
+    const std::string directory;
+
+    // Satisfied once the file has been downloaded, or failed if the
+    // download failed (in which case the entry has been removed).
+    process::Promise<Nothing> promise;
+
+    // The size of the file once it has been downloaded.
+    Option<Bytes> size;
+
+    // The number of fetches using the entry, it can't be removed
+    // while this is not zero.
+    int references;
+
+    // Where the entry is in the LRU order.
+    std::list<std::string>::iterator position;
+  };
+
+  // Determines for each URI whether it bypasses the cache, needs to
+  // be downloaded into the cache or can be retrieved from it. The
+  // entries of the cached URIs get referenced and returned in the
+  // order of the items (NULL for URIs that bypass the cache) along
+  // with the downloads of other fetches that need to complete first.
+  mesos::fetcher::FetcherInfo prepare(
+      const CommandInfo& commandInfo,
+      const std::string& directory,
+      const Option<std::string>& user,
+      const Flags& flags,
+      std::vector<std::shared_ptr<CacheEntry>>* entries,
+      std::list<process::Future<Nothing>>* downloads);
+
+  // Runs the mesos-fetcher once the downloads it depends on have
+  // completed. URIs whose download failed bypass the cache instead.
+  process::Future<Nothing> launch(
+      const ContainerID& containerId,
+      mesos::fetcher::FetcherInfo fetcherInfo,
+      const std::vector<std::shared_ptr<CacheEntry>>& entries,
+      const Flags& flags,
+      const Option<int>& stdout,
+      const Option<int>& stderr);
+
   // Check status and return an error if any.
   process::Future<Nothing> _fetch(
       const ContainerID& containerId,
       const Option<int>& status);
 
+  // Completes the downloads of the fetch, releases its entries and
+  // evicts entries until the cache fits into 'fetcher_cache_size'.
+  // Then completes the promise like the (completed) future.
+  void release(
+      const mesos::fetcher::FetcherInfo& fetcherInfo,
+      const std::vector<std::shared_ptr<CacheEntry>>& entries,
+      const Flags& flags,
+      process::Owned<process::Promise<Nothing>> promise,
+      const process::Future<Nothing>& future);
+
+  // Removes the entry from the cache, along with its directory.
+  void remove(const std::shared_ptr<CacheEntry>& entry);
+
   // Run the mesos-fetcher with custom output redirection. If
   // 'stdout' and 'stderr' file descriptors are provided then respective
   // output from the mesos-fetcher will be redirected to the file
   // descriptors. The file descriptors are duplicated (via dup) because
   // redirecting might still be occuring even after the mesos-fetcher has
   // terminated since there still might be data to be read.
-  // This method is only "public" for test purposes.
   Try<process::Subprocess> run(
-      const CommandInfo& commandInfo,
-      const std::string& directory,
-      const Option<std::string>& user,
+      const mesos::fetcher::FetcherInfo& fetcherInfo,
       const Flags& flags,
       const Option<int>& stdout,
       const Option<int>& stderr);
 
-  // Run the mesos-fetcher, creating a "stdout" and "stderr" file
-  // in the given directory and using these for output.
-  Try<process::Subprocess> run(
-      const CommandInfo& commandInfo,
-      const std::string& directory,
-      const Option<std::string>& user,
-      const Flags& flags);
-
   hashmap<ContainerID, pid_t> subprocessPids;
+
+  // Containers that are waiting for downloads of other fetches.
+  hashset<ContainerID> pending;
+
+  // The cache entries by key, and the keys from the least to the
+  // most recently used.
+  hashmap<std::string, std::shared_ptr<CacheEntry>> cache;
+  std::list<std::string> lru;
+
+  // The total size of the downloaded files in the cache.
+  Bytes cacheSize;
+
+  // The cache directories which have been cleaned up.
+  hashset<std::string> cacheDirectories;
 };
 
 } // namespace slave {
@@ -48,6 +48,8 @@
 using namespace process;
 
 using std::list;
+using std::make_pair;
+using std::pair;
 using std::set;
 using std::string;
 using std::vector;
@@ -203,7 +205,8 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::recover(
       continue;
     }
 
-    infos[containerId] = new Info(containerId, cgroup);
+    infos[containerId] = new Info(
+        containerId, cgroup, hierarchies["cpu"], hierarchies["cpuacct"]);
   }
 
   // Remove orphan cgroups.
@@ -238,7 +241,8 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::recover(
       // Known orphan cgroups will be destroyed by the containerizer
       // using the normal cleanup path. See MESOS-2367 for details.
       if (orphans.contains(containerId)) {
-        infos[containerId] = new Info(containerId, cgroup);
+        infos[containerId] = new Info(
+            containerId, cgroup, hierarchies["cpu"], hierarchies["cpuacct"]);
         continue;
       }
 
@@ -272,7 +276,10 @@ Future<Option<CommandInfo>> CgroupsCpushareIsolatorProcess::prepare(
   // called if we return a Failure, but cleanup will fail because the
   // cgroup does not exist when cgroups::destroy is called.
   Info* info = new Info(
-      containerId, path::join(flags.cgroups_root, containerId.value()));
+      containerId,
+      path::join(flags.cgroups_root, containerId.value()),
+      hierarchies["cpu"],
+      hierarchies["cpuacct"]);
 
   infos[containerId] = info;
 
@@ -379,37 +386,33 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::update(
   uint64_t shares =
     std::max((uint64_t) (CPU_SHARES_PER_CPU * cpus), MIN_CPU_SHARES);
 
-  Try<Nothing> write = cgroups::cpu::shares(
-      hierarchy.get(),
-      info->cgroup,
-      shares);
+  vector<pair<string, string>> values;
+  values.push_back(make_pair("cpu.shares", stringify(shares)));
+
+  // Set cfs quota if enabled.
+  Duration quota = std::max(CPU_CFS_PERIOD * cpus, MIN_CPU_CFS_QUOTA);
+
+  if (flags.cgroups_enable_cfs) {
+    values.push_back(make_pair(
+        "cpu.cfs_period_us",
+        stringify(static_cast<uint64_t>(CPU_CFS_PERIOD.us()))));
+
+    values.push_back(make_pair(
+        "cpu.cfs_quota_us",
+        stringify(static_cast<int64_t>(quota.us()))));
+  }
+
+  Try<Nothing> write = info->cpu.write(values);
 
   if (write.isError()) {
-    return Failure("Failed to update 'cpu.shares': " + write.error());
+    return Failure("Failed to update cpu controls: " + write.error());
   }
 
   LOG(INFO) << "Updated 'cpu.shares' to " << shares
             << " (cpus " << cpus << ")"
             << " for container " << containerId;
 
-  // Set cfs quota if enabled.
   if (flags.cgroups_enable_cfs) {
-    write = cgroups::cpu::cfs_period_us(
-        hierarchy.get(),
-        info->cgroup,
-        CPU_CFS_PERIOD);
-
-    if (write.isError()) {
-      return Failure("Failed to update 'cpu.cfs_period_us': " + write.error());
-    }
-
-    Duration quota = std::max(CPU_CFS_PERIOD * cpus, MIN_CPU_CFS_QUOTA);
-
-    write = cgroups::cpu::cfs_quota_us(hierarchy.get(), info->cgroup, quota);
-    if (write.isError()) {
-      return Failure("Failed to update 'cpu.cfs_quota_us': " + write.error());
-    }
-
     LOG(INFO) << "Updated 'cpu.cfs_period_us' to " << CPU_CFS_PERIOD
               << " and 'cpu.cfs_quota_us' to " << quota
               << " (cpus " << cpus << ")"
@@ -467,10 +470,7 @@ Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::usage(
   PCHECK(ticks > 0) << "Failed to get sysconf(_SC_CLK_TCK)";
 
   // Add the cpuacct.stat information.
-  Try<hashmap<string, uint64_t>> stat = cgroups::stat(
-      hierarchies["cpuacct"],
-      info->cgroup,
-      "cpuacct.stat");
+  Try<hashmap<string, uint64_t>> stat = info->cpuacct.stat("cpuacct.stat");
 
   if (stat.isError()) {
     return Failure("Failed to read cpuacct.stat: " + stat.error());
@@ -488,7 +488,7 @@ Future<ResourceStatistics> CgroupsCpushareIsolatorProcess::usage(
 
   // Add the cpu.stat information only if CFS is enabled.
   if (flags.cgroups_enable_cfs) {
-    stat = cgroups::stat(hierarchies["cpu"], info->cgroup, "cpu.stat");
+    stat = info->cpu.stat("cpu.stat");
     if (stat.isError()) {
       return Failure("Failed to read cpu.stat: " + stat.error());
     }
@@ -527,6 +527,11 @@ Future<Nothing> CgroupsCpushareIsolatorProcess::cleanup(
 
   Info* info = CHECK_NOTNULL(infos[containerId]);
 
+  // Don't keep the control files of the cgroup open while it is
+  // being destroyed.
+  info->cpu.close();
+  info->cpuacct.close();
+
   list<Future<Nothing>> futures;
   foreach (const string& subsystem, subsystems) {
     futures.push_back(cgroups::destroy(
@@ -83,13 +83,25 @@ private:
 
   struct Info
   {
-    Info(const ContainerID& _containerId, const std::string& _cgroup)
-      : containerId(_containerId), cgroup(_cgroup) {}
+    Info(const ContainerID& _containerId,
+         const std::string& _cgroup,
+         const std::string& cpuHierarchy,
+         const std::string& cpuacctHierarchy)
+      : containerId(_containerId),
+        cgroup(_cgroup),
+        cpu(cpuHierarchy, _cgroup),
+        cpuacct(cpuacctHierarchy, _cgroup) {}
 
     const ContainerID containerId;
     const std::string cgroup;
     Option<pid_t> pid;
 
+    // Handles on the cgroup in the 'cpu' and 'cpuacct' hierarchies,
+    // which keep the statistics and the control files open between
+    // usage and update calls.
+    cgroups::Handle cpu;
+    cgroups::Handle cpuacct;
+
     process::Promise<mesos::slave::Limitation> limitation;
   };
 
@@ -38,6 +38,7 @@
 #include <stout/lambda.hpp>
 #include <stout/nothing.hpp>
 #include <stout/stringify.hpp>
+#include <stout/strings.hpp>
 #include <stout/try.hpp>
 
 #include "linux/cgroups.hpp"
@@ -188,7 +189,7 @@ Future<Nothing> CgroupsMemIsolatorProcess::recover(
       continue;
     }
 
-    infos[containerId] = new Info(containerId, cgroup);
+    infos[containerId] = new Info(containerId, cgroup, hierarchy);
 
     oomListen(containerId);
     pressureListen(containerId);
@@ -222,7 +223,7 @@ Future<Nothing> CgroupsMemIsolatorProcess::recover(
     // Known orphan cgroups will be destroyed by the containerizer
     // using the normal cleanup path. See MESOS-2367 for details.
     if (orphans.contains(containerId)) {
-      infos[containerId] = new Info(containerId, cgroup);
+      infos[containerId] = new Info(containerId, cgroup, hierarchy);
       continue;
     }
 
@@ -251,7 +252,9 @@ Future<Option<CommandInfo>> CgroupsMemIsolatorProcess::prepare(
   // called if we return a Failure, but cleanup will fail because the
   // cgroup does not exist when cgroups::destroy is called.
   Info* info = new Info(
-      containerId, path::join(flags.cgroups_root, containerId.value()));
+      containerId,
+      path::join(flags.cgroups_root, containerId.value()),
+      hierarchy);
 
   infos[containerId] = info;
 
@@ -347,8 +350,8 @@ Future<Nothing> CgroupsMemIsolatorProcess::update(
   Bytes limit = std::max(mem, MIN_MEMORY);
 
   // Always set the soft limit.
-  Try<Nothing> write =
-    cgroups::memory::soft_limit_in_bytes(hierarchy, info->cgroup, limit);
+  Try<Nothing> write = info->memory.write(
+      "memory.soft_limit_in_bytes", stringify(limit.bytes()));
 
   if (write.isError()) {
     return Failure(
@@ -382,8 +385,8 @@ Future<Nothing> CgroupsMemIsolatorProcess::update(
   if (info->pid.isNone() || limit > currentLimit.get()) {
     // We always set limit_in_bytes first and optionally set
     // memsw.limit_in_bytes if limitSwap is true.
-    Try<Nothing> write = cgroups::memory::limit_in_bytes(
-        hierarchy, info->cgroup, limit);
+    Try<Nothing> write = info->memory.write(
+        "memory.limit_in_bytes", stringify(limit.bytes()));
 
     if (write.isError()) {
       return Failure(
@@ -425,7 +428,12 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
   // The rss from memory.stat is wrong in two dimensions:
   //   1. It does not include child cgroups.
   //   2. It does not include any file backed pages.
-  Try<Bytes> usage = cgroups::memory::usage_in_bytes(hierarchy, info->cgroup);
+  Try<string> read = info->memory.read("memory.usage_in_bytes");
+  if (read.isError()) {
+    return Failure("Failed to read memory.usage_in_bytes: " + read.error());
+  }
+
+  Try<Bytes> usage = Bytes::parse(strings::trim(read.get()) + "B");
   if (usage.isError()) {
     return Failure("Failed to parse memory.usage_in_bytes: " + usage.error());
   }
@@ -434,8 +442,7 @@ Future<ResourceStatistics> CgroupsMemIsolatorProcess::usage(
   // structure, e.g, cgroups::memory::stat.
   result.set_mem_rss_bytes(usage.get().bytes());
 
-  Try<hashmap<string, uint64_t>> stat =
-    cgroups::stat(hierarchy, info->cgroup, "memory.stat");
+  Try<hashmap<string, uint64_t>> stat = info->memory.stat("memory.stat");
 
   if (stat.isError()) {
     return Failure("Failed to read memory.stat: " + stat.error());
@@ -529,6 +536,10 @@ Future<Nothing> CgroupsMemIsolatorProcess::cleanup(
     info->oomNotifier.discard();
   }
 
+  // Don't keep the control files of the cgroup open while it is
+  // being destroyed.
+  info->memory.close();
+
   return cgroups::destroy(hierarchy, info->cgroup, cgroups::DESTROY_TIMEOUT)
     .onAny(defer(PID<CgroupsMemIsolatorProcess>(this),
                  &CgroupsMemIsolatorProcess::_cleanup,
@@ -89,13 +89,21 @@ private:
 
   struct Info
   {
-    Info(const ContainerID& _containerId, const std::string& _cgroup)
-      : containerId(_containerId), cgroup(_cgroup) {}
+    Info(const ContainerID& _containerId,
+         const std::string& _cgroup,
+         const std::string& hierarchy)
+      : containerId(_containerId),
+        cgroup(_cgroup),
+        memory(hierarchy, _cgroup) {}
 
     const ContainerID containerId;
     const std::string cgroup;
     Option<pid_t> pid;
 
+    // Handle on the cgroup, which keeps the statistics and the limit
+    // files open between usage and update calls.
+    cgroups::Handle memory;
+
     process::Promise<mesos::slave::Limitation> limitation;
 
     // Used to cancel the OOM listening.
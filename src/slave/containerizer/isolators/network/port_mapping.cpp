@@ -27,6 +27,7 @@
 
 #include <mesos/mesos.hpp>
 
+#include <process/clock.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/io.hpp>
@@ -119,6 +120,12 @@ using mesos::slave::Limitation;
 static const uint16_t MIN_EPHEMERAL_PORTS_SIZE = 16;
 
 
+// How long the statistics of all the links (see 'usage') are reused
+// for. This is well below the resource monitoring interval so that
+// each collection round still takes a fresh dump.
+static const Duration LINK_STATISTICS_TIMEOUT = Milliseconds(100);
+
+
 // The primary priority used by each type of filter.
 static const uint8_t ARP_FILTER_PRIORITY = 1;
 static const uint8_t ICMP_FILTER_PRIORITY = 2;
@@ -2339,14 +2346,35 @@ Future<ResourceStatistics> PortMappingIsolatorProcess::usage(
     return result;
   }
 
-  Result<hashmap<string, uint64_t>> stat =
-    link::statistics(veth(info->pid.get()));
+  // Dumping the links from the kernel returns all of them, so rather
+  // than dumping once per container we take a single dump and share
+  // it between the containers that get sampled at about the same
+  // time.
+  Option<hashmap<string, uint64_t>> stat = None();
 
-  if (stat.isError()) {
-    return Failure(
-        "Failed to retrieve statistics on link " +
-        veth(info->pid.get()) + ": " + stat.error());
-  } else if (stat.isNone()) {
+  if (linksSampled.isSome() &&
+      Clock::now() - linksSampled.get() < LINK_STATISTICS_TIMEOUT) {
+    stat = links.get(veth(info->pid.get()));
+  }
+
+  // Take a new dump if the shared one is stale or was taken before
+  // the link got created.
+  if (stat.isNone()) {
+    Try<hashmap<string, hashmap<string, uint64_t>>> statistics =
+      link::statistics();
+
+    if (statistics.isError()) {
+      return Failure(
+          "Failed to retrieve statistics on links: " + statistics.error());
+    }
+
+    links = statistics.get();
+    linksSampled = Clock::now();
+
+    stat = links.get(veth(info->pid.get()));
+  }
+
+  if (stat.isNone()) {
     return Failure("Failed to find link: " + veth(info->pid.get()));
   }
 
@@ -30,6 +30,7 @@
 
 #include <process/owned.hpp>
 #include <process/subprocess.hpp>
+#include <process/time.hpp>
 
 #include <process/metrics/metrics.hpp>
 #include <process/metrics/counter.hpp>
@@ -319,6 +320,13 @@ private:
   // Recovered containers from a previous run that weren't managed by
   // the network isolator.
   hashset<ContainerID> unmanaged;
+
+  // Statistics of all the links, taken with a single netlink dump
+  // and shared by the 'usage' calls of all the containers sampled
+  // together by the resource monitor, along with when they were
+  // taken.
+  Option<process::Time> linksSampled;
+  hashmap<std::string, hashmap<std::string, uint64_t>> links;
 };
 
 
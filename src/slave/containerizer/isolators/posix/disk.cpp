@@ -16,33 +16,35 @@
  * limitations under the License.
  */
 
-#include <signal.h>
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
 
-#ifdef __linux__
-#include <sys/prctl.h>
-#endif
+#include <sys/stat.h>
 #include <sys/types.h>
 
 #include <deque>
-#include <tuple>
+#include <memory>
+#include <utility>
 
 #include <glog/logging.h>
 
+#include <process/async.hpp>
 #include <process/check.hpp>
 #include <process/collect.hpp>
 #include <process/defer.hpp>
 #include <process/delay.hpp>
-#include <process/io.hpp>
-#include <process/subprocess.hpp>
 
 #include <stout/check.hpp>
+#include <stout/error.hpp>
 #include <stout/foreach.hpp>
+#include <stout/hashset.hpp>
 #include <stout/lambda.hpp>
-#include <stout/numify.hpp>
-#include <stout/strings.hpp>
+#include <stout/path.hpp>
 
+#include <stout/os/close.hpp>
 #include <stout/os/exists.hpp>
-#include <stout/os/killtree.hpp>
 
 #include "slave/containerizer/isolators/posix/disk.hpp"
 
@@ -50,6 +52,7 @@ using namespace process;
 
 using std::deque;
 using std::list;
+using std::pair;
 using std::string;
 using std::vector;
 
@@ -64,8 +67,6 @@ using mesos::slave::Limitation;
 
 Try<Isolator*> PosixDiskIsolatorProcess::create(const Flags& flags)
 {
-  // TODO(jieyu): Check the availability of command 'du'.
-
   return new Isolator(
       process::Owned<IsolatorProcess>(new PosixDiskIsolatorProcess(flags)));
 }
@@ -306,6 +307,179 @@ Future<Nothing> PosixDiskIsolatorProcess::cleanup(
 }
 
 
+static bool operator == (const struct timespec& left,
+                         const struct timespec& right)
+{
+  return left.tv_sec == right.tv_sec && left.tv_nsec == right.tv_nsec;
+}
+
+
+static const struct timespec& mtime(const struct stat& s)
+{
+#ifdef __APPLE__
+  return s.st_mtimespec;
+#else
+  return s.st_mtim;
+#endif
+}
+
+
+Try<Bytes> DiskUsageScanner::scan()
+{
+  scans++;
+
+  const time_t now = ::time(NULL);
+
+  // We count the blocks like 'du' does, i.e., in units of 512 bytes.
+  uint64_t blocks = 0;
+
+  // The files with multiple hard links that we've counted already.
+  hashset<pair<dev_t, ino_t>> links;
+
+  struct stat s;
+  if (::lstat(path.c_str(), &s) < 0) {
+    return ErrnoError("Failed to stat '" + path + "'");
+  }
+
+  blocks += s.st_blocks;
+
+  // The directories which are yet to be walked. We use a stack rather
+  // than recursion since the trees might be arbitrarily deep.
+  vector<pair<string, struct stat>> stack;
+
+  if (S_ISDIR(s.st_mode)) {
+    stack.push_back(std::make_pair(path, s));
+  }
+
+  while (!stack.empty()) {
+    const string directory = stack.back().first;
+    const struct stat stat = stack.back().second;
+    stack.pop_back();
+
+    // We stat the entries relative to the directory, which saves
+    // resolving the path of every entry.
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+    if (fd < 0) {
+      // The directory might have been removed since we listed its
+      // parent, in which case there is nothing to count.
+      if (errno == ENOENT) {
+        continue;
+      }
+      return ErrnoError("Failed to open directory '" + directory + "'");
+    }
+
+    Try<const vector<string>*> entries = list(directory, fd, stat, now);
+    if (entries.isError()) {
+      os::close(fd);
+      return Error(entries.error());
+    }
+
+    foreach (const string& name, *entries.get()) {
+      if (::fstatat(fd, name.c_str(), &s, AT_SYMLINK_NOFOLLOW) < 0) {
+        // The entry might have been removed since we listed the
+        // directory, in which case it doesn't count anymore.
+        if (errno == ENOENT) {
+          continue;
+        }
+
+        ErrnoError error(
+            "Failed to stat '" + path::join(directory, name) + "'");
+        os::close(fd);
+        return error;
+      }
+
+      if (S_ISDIR(s.st_mode)) {
+        stack.push_back(std::make_pair(path::join(directory, name), s));
+      } else if (s.st_nlink > 1 &&
+                 !links.insert(std::make_pair(s.st_dev, s.st_ino)).second) {
+        continue;
+      }
+
+      blocks += s.st_blocks;
+    }
+
+    os::close(fd);
+  }
+
+  // Forget about the directories that don't exist anymore.
+  foreach (const string& directory, directories.keys()) {
+    if (directories[directory].scan != scans) {
+      directories.erase(directory);
+    }
+  }
+
+  return Bytes(blocks * 512);
+}
+
+
+Try<const vector<string>*> DiskUsageScanner::list(
+    const string& directory,
+    int fd,
+    const struct stat& s,
+    const time_t now)
+{
+  Option<Directory*> cached;
+
+  if (directories.contains(directory)) {
+    cached = &directories[directory];
+    cached.get()->scan = scans;
+
+    if (cached.get()->stable &&
+        cached.get()->inode == s.st_ino &&
+        cached.get()->mtime == mtime(s)) {
+      return &cached.get()->entries;
+    }
+  }
+
+  // NOTE: The directory stream takes ownership of the (duplicated)
+  // file descriptor.
+  int dupped = ::dup(fd);
+  DIR* dir = dupped < 0 ? NULL : ::fdopendir(dupped);
+
+  if (dir == NULL) {
+    ErrnoError error("Failed to open directory '" + directory + "'");
+    if (dupped >= 0) {
+      os::close(dupped);
+    }
+    directories.erase(directory);
+    return error;
+  }
+
+  Directory& listed = directories[directory];
+  listed.inode = s.st_ino;
+  listed.mtime = mtime(s);
+  listed.stable = mtime(s).tv_sec < now;
+  listed.entries.clear();
+  listed.scan = scans;
+
+  // NOTE: We reset errno before each call to distinguish the end of
+  // the directory from an error.
+  struct dirent* entry;
+  while ((errno = 0, entry = ::readdir(dir)) != NULL) {
+    const string name = entry->d_name;
+    if (name != "." && name != "..") {
+      listed.entries.push_back(name);
+    }
+  }
+
+  if (errno != 0) {
+    ErrnoError error("Failed to read directory '" + directory + "'");
+    ::closedir(dir);
+    directories.erase(directory);
+    return error;
+  }
+
+  ::closedir(dir);
+
+  return &listed.entries;
+}
+
+
+// The maximum number of paths that get scanned concurrently.
+static const size_t MAX_CONCURRENT_SCANS = 4;
+
+
 class DiskUsageCollectorProcess : public Process<DiskUsageCollectorProcess>
 {
 public:
@@ -337,11 +511,9 @@ protected:
 
   void finalize()
   {
+    // NOTE: Any scans in progress run to completion but their results
+    // get dropped since we're terminating.
     foreach (const Owned<Entry>& entry, entries) {
-      if (entry->du.isSome() && entry->du.get().status().isPending()) {
-        os::killtree(entry->du.get().pid(), SIGKILL);
-      }
-
       entry->promise.fail("DiskUsageCollector is destroyed");
     }
   }
@@ -350,149 +522,125 @@ private:
   // Describe a single pending check.
   struct Entry
   {
-    explicit Entry(const string& _path) : path(_path) {}
+    explicit Entry(const string& _path) : path(_path), scanning(false) {}
 
     string path;
-    Option<Subprocess> du;
+    bool scanning;
     Promise<Bytes> promise;
   };
 
-  // This function is invoked right before each 'du' is exec'ed. Note
-  // that this function needs to be async signal safe.
-  static int setupChild()
+  // Scans the disk usage. This is run asynchronously, the scanner is
+  // shared so that it outlives the collector if need be.
+  static Try<Bytes> scan(const std::shared_ptr<DiskUsageScanner>& scanner)
   {
-#ifdef __linux__
-    // Kill the child process if the parent exits.
-    // NOTE: This function should never returns non-zero because we
-    // are passing in a valid signal.
-    return ::prctl(PR_SET_PDEATHSIG, SIGKILL);
-#else
-    return 0;
-#endif
+    return scanner->scan();
   }
 
   void discard(const string& path)
   {
     for (auto it = entries.begin(); it != entries.end(); ++it) {
-      // We only cancel those checks whose 'du' haven't been launched.
-      if ((*it)->path == path && (*it)->du.isNone()) {
+      // We only cancel those checks which haven't been started.
+      if ((*it)->path == path && !(*it)->scanning) {
         (*it)->promise.discard();
         entries.erase(it);
+
+        // NOTE: The scanner of the path is removed when the next round
+        // of scans gets scheduled (if the path isn't queued again).
         break;
       }
     }
   }
 
-  // Schedule a 'du' to be invoked. The current implementation does
-  // not allow multiple 'du's running concurrently. The minimal
-  // interval between two subsequent 'du's is controlled by 'interval'
-  // for throttling purpose.
+  // Schedule the scans of up to MAX_CONCURRENT_SCANS paths, which get
+  // scanned concurrently. The minimal interval between two subsequent
+  // rounds of scans is controlled by 'interval' for throttling
+  // purpose.
+  //
+  // NOTE: The scans are done by the slave and it will be the slave's
+  // cgroup that is charged for (a) memory to cache the fs data
+  // structures, (b) disk I/O to read those structures, and (c) the
+  // cpu time to traverse.
   void schedule()
   {
+    // Remove the scanners of the paths that nobody is interested in
+    // anymore, whether they were discarded or simply not asked for
+    // again since their last scan. This is done here rather than
+    // once a scan completes since the callers only ask for the next
+    // scan of a path after they got the result of the previous one,
+    // and the cached listings need to be kept across those scans.
+    foreach (const string& path, scanners.keys()) {
+      bool queued = false;
+      foreach (const Owned<Entry>& entry, entries) {
+        if (entry->path == path) {
+          queued = true;
+          break;
+        }
+      }
+
+      if (!queued) {
+        scanners.erase(path);
+      }
+    }
+
     if (entries.empty()) {
       delay(interval, self(), &Self::schedule);
       return;
     }
 
-    const Owned<Entry>& entry = entries.front();
-
-    // Invoke 'du' and report number of 1K-byte blocks. We fix the
-    // block size here so that we can get consistent results on all
-    // platforms (e.g., OS X uses 512 byte blocks).
-    //
-    // NOTE: The 'du' processes are run in the slave's cgroup and it
-    // will be that cgroup that is charged for (a) memory to cache the
-    // fs data structures, (b) disk I/O to read those structures, and
-    // (c) the cpu time to traverse.
-    Try<Subprocess> s = subprocess(
-        "du",
-        vector<string>({"du", "-k", "-s", entry->path}),
-        Subprocess::PATH("/dev/null"),
-        Subprocess::PIPE(),
-        Subprocess::PIPE(),
-        None(),
-        None(),
-        setupChild);
-
-    if (s.isError()) {
-      entry->promise.fail("Failed to exec 'du': " + s.error());
+    list<Future<Try<Bytes>>> scans;
 
-      entries.pop_front();
-      delay(interval, self(), &Self::schedule);
-      return;
-    }
+    for (size_t i = 0;
+         i < entries.size() && i < MAX_CONCURRENT_SCANS;
+         i++) {
+      const Owned<Entry>& entry = entries[i];
+      entry->scanning = true;
+
+      if (!scanners.contains(entry->path)) {
+        scanners[entry->path] =
+          std::make_shared<DiskUsageScanner>(entry->path);
+      }
 
-    entry->du = s.get();
+      scans.push_back(async(&Self::scan, scanners[entry->path]));
+    }
 
-    await(s.get().status(),
-          io::read(s.get().out().get()),
-          io::read(s.get().err().get()))
+    await(scans)
       .onAny(defer(self(), &Self::_schedule, lambda::_1));
   }
 
-  void _schedule(const Future<std::tuple<
-      Future<Option<int>>,
-      Future<string>,
-      Future<string>>>& future)
+  void _schedule(const Future<list<Future<Try<Bytes>>>>& future)
   {
     CHECK_READY(future);
-    CHECK(!entries.empty());
-
-    const Owned<Entry>& entry = entries.front();
-    CHECK_SOME(entry->du);
-
-    Future<Option<int>> status = std::get<0>(future.get());
-
-    if (!status.isReady()) {
-      entry->promise.fail(
-          "Failed to perform 'du': " +
-          (status.isFailed() ? status.failure() : "discarded"));
-    } else if (status.get().isNone()) {
-      entry->promise.fail("Failed to reap the status of 'du'");
-    } else if (status.get().get() != 0) {
-      Future<string> error = std::get<2>(future.get());
-      if (!error.isReady()) {
-        entry->promise.fail(
-            "Failed to perform 'du'. Reading stderr failed: " +
-            (error.isFailed() ? error.failure() : "discarded"));
-      } else {
-        entry->promise.fail("Failed to perform 'du': " + error.get());
-      }
-    } else {
-      Future<string> output = std::get<1>(future.get());
-      if (!output.isReady()) {
+
+    foreach (const Future<Try<Bytes>>& scan, future.get()) {
+      CHECK(!entries.empty());
+
+      const Owned<Entry>& entry = entries.front();
+      CHECK(entry->scanning);
+
+      if (!scan.isReady()) {
         entry->promise.fail(
-            "Failed to read stdout from 'du': " +
-            (output.isFailed() ? output.failure() : "discarded"));
+            "Failed to scan '" + entry->path + "': " +
+            (scan.isFailed() ? scan.failure() : "discarded"));
+      } else if (scan.get().isError()) {
+        entry->promise.fail(scan.get().error());
       } else {
-        // Parsing the output from 'du'. The following is a sample
-        // output. Tab is used as the delimiter between the number of
-        // blocks and the checked path.
-        // $ du /var/lib/mesos/.../runs/container_id
-        // 1024   /var/lib/mesos/.../runs/container_id
-        vector<string> tokens = strings::tokenize(output.get(), " \t");
-        if (tokens.empty()) {
-          entry->promise.fail("Unexpected output from 'du': " + output.get());
-        } else {
-          Try<size_t> value = numify<size_t>(tokens[0]);
-          if (value.isError()) {
-            entry->promise.fail("Unexpected output from 'du': " + output.get());
-          } else {
-            // Notify the callers.
-            entry->promise.set(Kilobytes(value.get()));
-          }
-        }
+        // Notify the callers.
+        entry->promise.set(scan.get().get());
       }
+
+      entries.pop_front();
     }
 
-    entries.pop_front();
     delay(interval, self(), &Self::schedule);
   }
 
   const Duration interval;
 
-  // A queue of pending checks.
+  // A queue of pending checks, the ones being scanned are in front.
   deque<Owned<Entry>> entries;
+
+  // The scanners (and hence the cached directory listings) by path.
+  hashmap<string, std::shared_ptr<DiskUsageScanner>> scanners;
 };
 
 
@@ -19,7 +19,14 @@
 #ifndef __POSIX_DISK_ISOLATOR_HPP__
 #define __POSIX_DISK_ISOLATOR_HPP__
 
+#include <stdint.h>
+#include <time.h>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
 #include <string>
+#include <vector>
 
 #include <mesos/slave/isolator.hpp>
 
@@ -28,6 +35,7 @@
 #include <stout/bytes.hpp>
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/try.hpp>
 
 #include "slave/flags.hpp"
 #include "slave/state.hpp"
@@ -40,8 +48,65 @@ namespace slave {
 class DiskUsageCollectorProcess;
 
 
+// Computes the disk usage rooted at a path in process, like 'du -s'
+// does, by summing up the blocks allocated to every file and
+// directory. Hard links are only counted once and symbolic links are
+// not followed.
+//
+// The scanner remembers the entries of the directories it has listed
+// along with their modification times, so that subsequent scans only
+// need to list the directories that have changed since. Note that the
+// files still need to be stat'ed on every scan since writing to a
+// file doesn't change the modification time of its directory.
+//
+// NOTE: A scanner is not thread-safe, but different scanners can be
+// used concurrently.
+class DiskUsageScanner
+{
+public:
+  explicit DiskUsageScanner(const std::string& _path)
+    : path(_path), scans(0) {}
+
+  Try<Bytes> scan();
+
+private:
+  struct Directory
+  {
+    ino_t inode;
+    struct timespec mtime;
+
+    // Whether the directory was listed after its modification time
+    // (at the granularity of seconds), since otherwise it might have
+    // been modified again without its modification time changing.
+    bool stable;
+
+    // The names of the entries in the directory.
+    std::vector<std::string> entries;
+
+    // The number of the last scan which saw this directory.
+    uint64_t scan;
+  };
+
+  // Returns the entries of the directory (open as 'fd'), listing it
+  // if necessary.
+  Try<const std::vector<std::string>*> list(
+      const std::string& directory,
+      int fd,
+      const struct stat& s,
+      const time_t now);
+
+  const std::string path;
+
+  // The directories that have been listed, by path.
+  hashmap<std::string, Directory> directories;
+
+  uint64_t scans;
+};
+
+
 // Responsible for collecting disk usage for paths, while ensuring
-// that an interval elapses between each collection.
+// that an interval elapses between each collection. Up to a few paths
+// get scanned concurrently (see DiskUsageScanner).
 class DiskUsageCollector
 {
 public:
@@ -60,7 +125,7 @@ private:
 // This isolator monitors the disk usage for containers, and reports
 // Limitation when a container exceeds its disk quota. This leverages
 // the DiskUsageCollector to ensure that we don't induce too much CPU
-// usage and disk caching effects from running 'du' too often.
+// usage and disk caching effects from scanning the disk too often.
 //
 // NOTE: Currently all containers are processed in the same queue,
 // which means that when a container starts, it could take many disk
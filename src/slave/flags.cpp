@@ -21,6 +21,7 @@
 #include <mesos/type_utils.hpp>
 
 #include "common/parse.hpp"
+
 #include "slave/constants.hpp"
 #include "slave/flags.hpp"
 
@@ -95,6 +96,19 @@ mesos::internal::slave::Flags::Flags()
       "frameworks_home",
       "Directory path prepended to relative executor URIs", "");
 
+  add(&Flags::fetcher_cache_dir,
+      "fetcher_cache_dir",
+      "Directory path where the fetcher keeps the files of URIs\n"
+      "that are marked to be cached (defaults to 'fetch' in the\n"
+      "work directory). Its contents are removed when the slave\n"
+      "starts using it.");
+
+  add(&Flags::fetcher_cache_size,
+      "fetcher_cache_size",
+      "Size of the fetcher cache, once it is exceeded the least\n"
+      "recently used files that are not being fetched get removed",
+      DEFAULT_FETCHER_CACHE_SIZE);
+
   add(&Flags::registration_backoff_factor,
       "registration_backoff_factor",
       "Slave initially picks a random amount of time between [0, b], where\n"
@@ -144,12 +158,26 @@ mesos::internal::slave::Flags::Flags()
       "information and sandboxes.",
       DISK_WATCH_INTERVAL);
 
+  add(&Flags::max_file_followers,
+      "max_file_followers",
+      "Maximum number of files that can be followed concurrently\n"
+      "through the '/files/follow' endpoint.",
+      DEFAULT_MAX_FILE_FOLLOWERS);
+
   add(&Flags::resource_monitoring_interval,
       "resource_monitoring_interval",
       "Periodic time interval for monitoring executor\n"
       "resource usage (e.g., 10secs, 1min, etc)",
       RESOURCE_MONITORING_INTERVAL);
 
+  add(&Flags::resource_monitoring_history,
+      "resource_monitoring_history",
+      "Number of resource usage samples to keep on disk for each\n"
+      "container, under the 'monitor' directory of the work directory.\n"
+      "The history survives slave restarts and can be queried through\n"
+      "the '/monitor/history.json' endpoint. 0 disables the history.",
+      0);
+
   add(&Flags::recover,
       "recover",
       "Whether to recover status updates and reconnect with old executors.\n"
@@ -280,6 +308,14 @@ mesos::internal::slave::Flags::Flags()
       "containerizer.\n",
       "docker");
 
+  add(&Flags::docker_socket,
+      "docker_socket",
+      "The path of the unix socket of the Docker daemon. If set, the\n"
+      "docker containerizer uses the daemon's remote API on this socket\n"
+      "to inspect, list, stop and remove containers rather than the\n"
+      "docker executable, and caches the pids of running containers.\n"
+      "(Example: /var/run/docker.sock)");
+
   add(&Flags::docker_sandbox_directory,
       "docker_sandbox_directory",
       "The absolute path for the directory in the container where the\n"
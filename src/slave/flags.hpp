@@ -49,13 +49,17 @@ public:
   std::string hadoop_home; // TODO(benh): Make an Option.
   bool switch_user;
   std::string frameworks_home;  // TODO(benh): Make an Option.
+  Option<std::string> fetcher_cache_dir;
+  Bytes fetcher_cache_size;
   Duration registration_backoff_factor;
   Duration executor_registration_timeout;
   Duration executor_shutdown_grace_period;
   Duration gc_delay;
   double gc_disk_headroom;
   Duration disk_watch_interval;
+  size_t max_file_followers;
   Duration resource_monitoring_interval;
+  size_t resource_monitoring_history;
 
   std::string recover;
   Duration recovery_timeout;
@@ -77,6 +81,7 @@ public:
   std::string containerizers;
   Option<std::string> default_container_image;
   std::string docker;
+  Option<std::string> docker_socket;
   std::string docker_sandbox_directory;
   Duration docker_remove_delay;
   Option<ContainerInfo> default_container_info;
@@ -31,6 +31,7 @@
 
 #include <stout/foreach.hpp>
 #include <stout/json.hpp>
+#include <stout/jsonify.hpp>
 #include <stout/lambda.hpp>
 #include <stout/net.hpp>
 #include <stout/numify.hpp>
@@ -71,7 +72,7 @@ namespace slave {
 
 
 // Pull in defnitions from common.
-using mesos::internal::model;
+using mesos::internal::json;
 
 // Pull in the process definitions.
 using process::http::Response;
@@ -80,152 +81,169 @@ using process::http::Request;
 
 // TODO(bmahler): Kill these in favor of automatic Proto->JSON Conversion (when
 // in becomes available).
+//
+// NOTE: These write directly into a JSON::ObjectWriter (see
+// stout/jsonify.hpp) rather than building a JSON::Object per task.
 
 
-JSON::Object model(const CommandInfo& command)
+static void json(JSON::ObjectWriter* writer, const CommandInfo& command)
 {
-  JSON::Object object;
-
   if (command.has_shell()) {
-    object.values["shell"] = command.shell();
+    writer->field("shell", command.shell());
   }
 
   if (command.has_value()) {
-    object.values["value"] = command.value();
-  }
-
-  JSON::Array argv;
-  foreach (const string& arg, command.arguments()) {
-    argv.values.push_back(arg);
+    writer->field("value", command.value());
   }
-  object.values["argv"] = argv;
 
-  if (command.has_environment()) {
-    JSON::Object environment;
-    JSON::Array variables;
-    foreach(const Environment_Variable& variable,
-            command.environment().variables()) {
-      JSON::Object variableObject;
-      variableObject.values["name"] = variable.name();
-      variableObject.values["value"] = variable.value();
-      variables.values.push_back(variableObject);
+  writer->field("argv", [&](JSON::ArrayWriter* writer) {
+    foreach (const string& arg, command.arguments()) {
+      writer->element(arg);
     }
-    environment.values["variables"] = variables;
-    object.values["environment"] = environment;
-  }
-
-  JSON::Array uris;
-  foreach(const CommandInfo_URI& uri, command.uris()) {
-    JSON::Object uriObject;
-    uriObject.values["value"] = uri.value();
-    uriObject.values["executable"] = uri.executable();
+  });
 
-    uris.values.push_back(uriObject);
+  if (command.has_environment()) {
+    writer->field("environment", [&](JSON::ObjectWriter* writer) {
+      writer->field("variables", [&](JSON::ArrayWriter* writer) {
+        foreach (const Environment_Variable& variable,
+                 command.environment().variables()) {
+          writer->element([&](JSON::ObjectWriter* writer) {
+            writer->field("name", variable.name());
+            writer->field("value", variable.value());
+          });
+        }
+      });
+    });
   }
-  object.values["uris"] = uris;
 
-  return object;
+  writer->field("uris", [&](JSON::ArrayWriter* writer) {
+    foreach (const CommandInfo_URI& uri, command.uris()) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        writer->field("value", uri.value());
+        writer->field("executable", uri.executable());
+      });
+    }
+  });
 }
 
 
-JSON::Object model(const ExecutorInfo& executorInfo)
+static void json(JSON::ObjectWriter* writer, const ExecutorInfo& executorInfo)
 {
-  JSON::Object object;
-  object.values["executor_id"] = executorInfo.executor_id().value();
-  object.values["name"] = executorInfo.name();
-  object.values["data"] = executorInfo.data();
-  object.values["framework_id"] = executorInfo.framework_id().value();
-  object.values["command"] = model(executorInfo.command());
-  object.values["resources"] = model(executorInfo.resources());
-  return object;
+  writer->field("executor_id", executorInfo.executor_id().value());
+  writer->field("name", executorInfo.name());
+  writer->field("data", executorInfo.data());
+  writer->field("framework_id", executorInfo.framework_id().value());
+
+  writer->field("command", [&](JSON::ObjectWriter* writer) {
+    json(writer, executorInfo.command());
+  });
+
+  writer->field("resources", [&](JSON::ObjectWriter* writer) {
+    json(writer, Resources(executorInfo.resources()));
+  });
 }
 
 
-JSON::Object model(const TaskInfo& task)
+static void json(JSON::ObjectWriter* writer, const TaskInfo& task)
 {
-  JSON::Object object;
-  object.values["id"] = task.task_id().value();
-  object.values["name"] = task.name();
-  object.values["slave_id"] = task.slave_id().value();
-  object.values["resources"] = model(task.resources());
-  object.values["data"] = task.data();
+  writer->field("id", task.task_id().value());
+  writer->field("name", task.name());
+  writer->field("slave_id", task.slave_id().value());
+
+  writer->field("resources", [&](JSON::ObjectWriter* writer) {
+    json(writer, Resources(task.resources()));
+  });
+
+  writer->field("data", task.data());
 
   if (task.has_command()) {
-    object.values["command"] = model(task.command());
+    writer->field("command", [&](JSON::ObjectWriter* writer) {
+      json(writer, task.command());
+    });
   }
+
   if (task.has_executor()) {
-    object.values["executor_id"] = model(task.executor());
+    writer->field("executor_id", [&](JSON::ObjectWriter* writer) {
+      json(writer, task.executor());
+    });
   }
-
-  return object;
 }
 
 
-JSON::Object model(const Executor& executor)
+static void json(JSON::ObjectWriter* writer, const Executor& executor)
 {
-  JSON::Object object;
-  object.values["id"] = executor.id.value();
-  object.values["name"] = executor.info.name();
-  object.values["source"] = executor.info.source();
-  object.values["container"] = executor.containerId.value();
-  object.values["directory"] = executor.directory;
-  object.values["resources"] = model(executor.resources);
-
-  JSON::Array tasks;
-  foreach (Task* task, executor.launchedTasks.values()) {
-    tasks.values.push_back(model(*task));
-  }
-  object.values["tasks"] = tasks;
-
-  JSON::Array queued;
-  foreach (const TaskInfo& task, executor.queuedTasks.values()) {
-    queued.values.push_back(model(task));
-  }
-  object.values["queued_tasks"] = queued;
+  writer->field("id", executor.id.value());
+  writer->field("name", executor.info.name());
+  writer->field("source", executor.info.source());
+  writer->field("container", executor.containerId.value());
+  writer->field("directory", executor.directory);
+
+  writer->field("resources", [&](JSON::ObjectWriter* writer) {
+    json(writer, executor.resources);
+  });
+
+  writer->field("tasks", [&](JSON::ArrayWriter* writer) {
+    foreach (Task* task, executor.launchedTasks.values()) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        json(writer, *task);
+      });
+    }
+  });
 
-  JSON::Array completed;
-  foreach (const std::shared_ptr<Task>& task, executor.completedTasks) {
-    completed.values.push_back(model(*task));
-  }
+  writer->field("queued_tasks", [&](JSON::ArrayWriter* writer) {
+    foreach (const TaskInfo& task, executor.queuedTasks.values()) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        json(writer, task);
+      });
+    }
+  });
 
-  // NOTE: We add 'terminatedTasks' to 'completed_tasks' for
-  // simplicity.
-  // TODO(vinod): Use foreachvalue instead once LinkedHashmap
-  // supports it.
-  foreach (Task* task, executor.terminatedTasks.values()) {
-    completed.values.push_back(model(*task));
-  }
-  object.values["completed_tasks"] = completed;
+  writer->field("completed_tasks", [&](JSON::ArrayWriter* writer) {
+    foreach (const std::shared_ptr<Task>& task, executor.completedTasks) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        json(writer, *task);
+      });
+    }
 
-  return object;
+    // NOTE: We add 'terminatedTasks' to 'completed_tasks' for
+    // simplicity.
+    // TODO(vinod): Use foreachvalue instead once LinkedHashmap
+    // supports it.
+    foreach (Task* task, executor.terminatedTasks.values()) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        json(writer, *task);
+      });
+    }
+  });
 }
 
 
-// Returns a JSON object modeled after a Framework.
-JSON::Object model(const Framework& framework)
+// Writes the JSON of a Framework.
+static void json(JSON::ObjectWriter* writer, const Framework& framework)
 {
-  JSON::Object object;
-  object.values["id"] = framework.id().value();
-  object.values["name"] = framework.info.name();
-  object.values["user"] = framework.info.user();
-  object.values["failover_timeout"] = framework.info.failover_timeout();
-  object.values["checkpoint"] = framework.info.checkpoint();
-  object.values["role"] = framework.info.role();
-  object.values["hostname"] = framework.info.hostname();
-
-  JSON::Array executors;
-  foreachvalue (Executor* executor, framework.executors) {
-    executors.values.push_back(model(*executor));
-  }
-  object.values["executors"] = executors;
-
-  JSON::Array completedExecutors;
-  foreach (const Owned<Executor>& executor, framework.completedExecutors) {
-    completedExecutors.values.push_back(model(*executor));
-  }
-  object.values["completed_executors"] = completedExecutors;
+  writer->field("id", framework.id().value());
+  writer->field("name", framework.info.name());
+  writer->field("user", framework.info.user());
+  writer->field("failover_timeout", framework.info.failover_timeout());
+  writer->field("checkpoint", framework.info.checkpoint());
+  writer->field("role", framework.info.role());
+  writer->field("hostname", framework.info.hostname());
+
+  writer->field("executors", [&](JSON::ArrayWriter* writer) {
+    foreachvalue (Executor* executor, framework.executors) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        json(writer, *executor);
+      });
+    }
+  });
 
-  return object;
+  writer->field("completed_executors", [&](JSON::ArrayWriter* writer) {
+    foreach (const Owned<Executor>& executor, framework.completedExecutors) {
+      writer->element([&](JSON::ObjectWriter* writer) {
+        json(writer, *executor);
+      });
+    }
+  });
 }
 
 
@@ -249,68 +267,85 @@ Future<Response> Slave::Http::state(const Request& request)
 {
   LOG(INFO) << "HTTP request for '" << request.path << "'";
 
-  JSON::Object object;
-  object.values["version"] = MESOS_VERSION;
-
-  if (build::GIT_SHA.isSome()) {
-    object.values["git_sha"] = build::GIT_SHA.get();
-  }
-
-  if (build::GIT_BRANCH.isSome()) {
-    object.values["git_branch"] = build::GIT_BRANCH.get();
-  }
-
-  if (build::GIT_TAG.isSome()) {
-    object.values["git_tag"] = build::GIT_TAG.get();
-  }
-
-  object.values["build_date"] = build::DATE;
-  object.values["build_time"] = build::TIME;
-  object.values["build_user"] = build::USER;
-  object.values["start_time"] = slave->startTime.secs();
-  object.values["id"] = slave->info.id().value();
-  object.values["pid"] = string(slave->self());
-  object.values["hostname"] = slave->info.hostname();
-  object.values["resources"] = model(slave->info.resources());
-  object.values["attributes"] = model(slave->info.attributes());
-
-  if (slave->master.isSome()) {
-    Try<string> hostname = net::getHostname(slave->master.get().address.ip);
-    if (hostname.isSome()) {
-      object.values["master_hostname"] = hostname.get();
-    }
-  }
-
-  if (slave->flags.log_dir.isSome()) {
-    object.values["log_dir"] = slave->flags.log_dir.get();
-  }
-
-  if (slave->flags.external_log_file.isSome()) {
-    object.values["external_log_file"] = slave->flags.external_log_file.get();
-  }
-
-  JSON::Array frameworks;
-  foreachvalue (Framework* framework, slave->frameworks) {
-    frameworks.values.push_back(model(*framework));
-  }
-  object.values["frameworks"] = frameworks;
-
-  JSON::Array completedFrameworks;
-  foreach (const Owned<Framework>& framework, slave->completedFrameworks) {
-    completedFrameworks.values.push_back(model(*framework));
-  }
-  object.values["completed_frameworks"] = completedFrameworks;
-
-  JSON::Object flags;
-  foreachpair (const string& name, const flags::Flag& flag, slave->flags) {
-    Option<string> value = flag.stringify(slave->flags);
-    if (value.isSome()) {
-      flags.values[name] = value.get();
-    }
-  }
-  object.values["flags"] = flags;
-
-  return OK(object, request.query.get("jsonp"));
+  return jsonResponse(
+      JSON::jsonify([&](JSON::ObjectWriter* writer) {
+        writer->field("version", MESOS_VERSION);
+
+        if (build::GIT_SHA.isSome()) {
+          writer->field("git_sha", build::GIT_SHA.get());
+        }
+
+        if (build::GIT_BRANCH.isSome()) {
+          writer->field("git_branch", build::GIT_BRANCH.get());
+        }
+
+        if (build::GIT_TAG.isSome()) {
+          writer->field("git_tag", build::GIT_TAG.get());
+        }
+
+        writer->field("build_date", build::DATE);
+        writer->field("build_time", build::TIME);
+        writer->field("build_user", build::USER);
+        writer->field("start_time", slave->startTime.secs());
+        writer->field("id", slave->info.id().value());
+        writer->field("pid", string(slave->self()));
+        writer->field("hostname", slave->info.hostname());
+
+        writer->field("resources", [&](JSON::ObjectWriter* writer) {
+          json(writer, Resources(slave->info.resources()));
+        });
+
+        writer->field("attributes", [&](JSON::ObjectWriter* writer) {
+          json(writer, Attributes(slave->info.attributes()));
+        });
+
+        if (slave->master.isSome()) {
+          Try<string> hostname =
+            net::getHostname(slave->master.get().address.ip);
+
+          if (hostname.isSome()) {
+            writer->field("master_hostname", hostname.get());
+          }
+        }
+
+        if (slave->flags.log_dir.isSome()) {
+          writer->field("log_dir", slave->flags.log_dir.get());
+        }
+
+        if (slave->flags.external_log_file.isSome()) {
+          writer->field(
+              "external_log_file", slave->flags.external_log_file.get());
+        }
+
+        writer->field("frameworks", [&](JSON::ArrayWriter* writer) {
+          foreachvalue (Framework* framework, slave->frameworks) {
+            writer->element([&](JSON::ObjectWriter* writer) {
+              json(writer, *framework);
+            });
+          }
+        });
+
+        writer->field("completed_frameworks", [&](JSON::ArrayWriter* writer) {
+          foreach (const Owned<Framework>& framework,
+                   slave->completedFrameworks) {
+            writer->element([&](JSON::ObjectWriter* writer) {
+              json(writer, *framework);
+            });
+          }
+        });
+
+        writer->field("flags", [&](JSON::ObjectWriter* writer) {
+          foreachpair (const string& name,
+                       const flags::Flag& flag,
+                       slave->flags) {
+            Option<string> value = flag.stringify(slave->flags);
+            if (value.isSome()) {
+              writer->field(name, value.get());
+            }
+          }
+        });
+      }),
+      request.query.get("jsonp"));
 }
 
 } // namespace slave {
@@ -199,7 +199,7 @@ int main(int argc, char** argv)
 
   LOG(INFO) << "Starting Mesos slave";
 
-  Files files;
+  Files files(flags.max_file_followers);
   GarbageCollector gc;
   StatusUpdateManager statusUpdateManager(flags);
 
@@ -16,6 +16,7 @@
  * limitations under the License.
  */
 
+#include <algorithm>
 #include <list>
 #include <map>
 #include <string>
@@ -31,13 +32,20 @@
 #include <process/http.hpp>
 #include <process/process.hpp>
 #include <process/statistics.hpp>
+#include <process/timer.hpp>
 
+#include <stout/hashset.hpp>
 #include <stout/json.hpp>
 #include <stout/lambda.hpp>
+#include <stout/numify.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
 #include <stout/protobuf.hpp>
 
 #include "slave/containerizer/containerizer.hpp"
 #include "slave/monitor.hpp"
+#include "slave/paths.hpp"
+#include "slave/usage_history.hpp"
 
 using namespace process;
 
@@ -45,6 +53,7 @@ using std::list;
 using std::make_pair;
 using std::map;
 using std::string;
+using std::vector;
 
 namespace mesos {
 namespace internal {
@@ -58,6 +67,20 @@ using process::wait; // Necessary on some OS's to disambiguate.
 const Duration MONITORING_TIME_SERIES_WINDOW = Weeks(2);
 const size_t MONITORING_TIME_SERIES_CAPACITY = 1000;
 const size_t MONITORING_ARCHIVED_TIME_SERIES = 25;
+const Duration MONITORING_USAGE_TIMEOUT = Seconds(10);
+
+
+// Discards the collection of the usage of a container that timed out.
+static Future<ResourceStatistics> timeout(
+    const ContainerID& containerId,
+    Future<ResourceStatistics> future)
+{
+  future.discard();
+
+  return Failure(
+      "Timed out after " + stringify(MONITORING_USAGE_TIMEOUT) +
+      " collecting the usage of container '" + stringify(containerId) + "'");
+}
 
 
 Future<Nothing> ResourceMonitorProcess::start(
@@ -70,12 +93,32 @@ Future<Nothing> ResourceMonitorProcess::start(
   }
 
   monitored[containerId] =
-      MonitoringInfo(executorInfo,
+      MonitoringInfo(containerId,
+                     executorInfo,
+                     interval,
                      MONITORING_TIME_SERIES_WINDOW,
                      MONITORING_TIME_SERIES_CAPACITY);
 
+  monitored[containerId].next = Clock::now() + interval;
+
+  if (workDir.isSome() && historyCapacity > 0) {
+    const string path = paths::getUsageHistoryPath(workDir.get(), containerId);
+
+    // The history of a recovered container is picked up where it was
+    // left off.
+    Try<UsageHistory*> history = UsageHistory::create(path, historyCapacity);
+
+    if (history.isError()) {
+      LOG(WARNING) << "Failed to create the usage history for container '"
+                   << containerId << "', disabling its history: "
+                   << history.error();
+    } else {
+      monitored[containerId].history.reset(history.get());
+    }
+  }
+
   // Schedule the resource collection.
-  delay(interval, self(), &Self::collect, containerId, interval);
+  schedule();
 
   return Nothing();
 }
@@ -88,6 +131,18 @@ Future<Nothing> ResourceMonitorProcess::stop(
     return Failure("Not monitored");
   }
 
+  // Remove the usage history of the container that is about to be
+  // evicted from the archive.
+  if (archive.full() && archive.front()->history) {
+    const string path = archive.front()->history->path();
+
+    Try<Nothing> rm = os::rm(path);
+    if (rm.isError()) {
+      LOG(WARNING) << "Failed to remove the usage history '" << path
+                   << "': " << rm.error();
+    }
+  }
+
   // Add the monitoring information to the archive.
   archive.push_back(
       process::Owned<MonitoringInfo>(
@@ -98,28 +153,120 @@ Future<Nothing> ResourceMonitorProcess::stop(
 }
 
 
-void ResourceMonitorProcess::collect(
-    const ContainerID& containerId,
-    const Duration& interval)
+Future<Nothing> ResourceMonitorProcess::recover(
+    const hashset<ContainerID>& containerIds)
 {
-  // Has monitoring stopped?
-  if (!monitored.contains(containerId)) {
+  if (workDir.isNone()) {
+    return Nothing();
+  }
+
+  const string directory = paths::getUsageHistoryDir(workDir.get());
+
+  if (!os::exists(directory)) {
+    return Nothing();
+  }
+
+  Try<list<string> > entries = os::ls(directory);
+  if (entries.isError()) {
+    LOG(WARNING) << "Failed to list the usage histories in '" << directory
+                 << "': " << entries.error();
+    return Nothing();
+  }
+
+  foreach (const string& entry, entries.get()) {
+    ContainerID containerId;
+    containerId.set_value(entry);
+
+    if (containerIds.contains(containerId)) {
+      continue;
+    }
+
+    const string path = path::join(directory, entry);
+
+    LOG(INFO) << "Removing the usage history '" << path << "' of container '"
+              << containerId << "' which wasn't recovered";
+
+    Try<Nothing> rm = os::rm(path);
+    if (rm.isError()) {
+      LOG(WARNING) << "Failed to remove the usage history '" << path
+                   << "': " << rm.error();
+    }
+  }
+
+  return Nothing();
+}
+
+
+void ResourceMonitorProcess::schedule()
+{
+  // The collection in progress will reschedule once it's done.
+  if (collecting) {
     return;
   }
 
-  containerizer->usage(containerId)
-    .onAny(defer(self(),
-                 &Self::_collect,
-                 lambda::_1,
-                 containerId,
-                 interval));
+  Option<Time> next = None();
+  foreachvalue (const MonitoringInfo& info, monitored) {
+    next = min(next, info.next);
+  }
+
+  if (timer.isSome()) {
+    Clock::cancel(timer.get());
+    timer = None();
+  }
+
+  if (next.isSome()) {
+    timer = delay(
+        std::max(next.get() - Clock::now(), Duration::zero()),
+        self(),
+        &Self::collect);
+  }
+}
+
+
+void ResourceMonitorProcess::collect()
+{
+  timer = None();
+
+  const Time now = Clock::now();
+
+  // Collect the usage of all the containers that are due at once.
+  // TODO(bmahler): Consider a batch usage API on the Containerizer.
+  list<Future<ResourceStatistics>> futures;
+
+  foreachpair (const ContainerID& containerId,
+               MonitoringInfo& info,
+               monitored) {
+    if (info.next <= now) {
+      // A container whose usage doesn't get collected in time (e.g.,
+      // because the docker daemon is stuck) must not hold up the
+      // collection for all the other containers.
+      Future<ResourceStatistics> future = containerizer->usage(containerId)
+        .after(MONITORING_USAGE_TIMEOUT,
+               lambda::bind(&timeout, containerId, lambda::_1));
+
+      future.onAny(defer(self(), &Self::_collect, containerId, lambda::_1));
+
+      futures.push_back(future);
+
+      info.next = now + info.interval;
+    }
+  }
+
+  if (futures.empty()) {
+    schedule();
+    return;
+  }
+
+  collecting = true;
+
+  process::await(futures)
+    .onAny(defer(self(), &Self::__collect));
 }
 
 
 void ResourceMonitorProcess::_collect(
-    const Future<ResourceStatistics>& statistics,
     const ContainerID& containerId,
-    const Duration& interval)
+    const Future<ResourceStatistics>& statistics)
 {
   // Has monitoring been stopped?
   if (!monitored.contains(containerId)) {
@@ -137,13 +284,14 @@ void ResourceMonitorProcess::_collect(
             << "' for executor '" << executorId
             << "' of framework '" << frameworkId << "'";
   } else if (statistics.isFailed()) {
-    // TODO(bmahler): Have the Containerizer discard the result when the
-    // executor was killed or completed.
+    // TODO(bmahler): Have the Containerizer discard the result when
+    // the executor was killed or completed.
     VLOG(1)
       << "Failed to collect resource usage for"
       << " container '" << containerId
       << "' for executor '" << executorId
-      << "' of framework '" << frameworkId << "': " << statistics.failure();
+      << "' of framework '" << frameworkId << "': "
+      << statistics.failure();
   } else {
     Try<Time> time = Time::create(statistics.get().timestamp());
 
@@ -151,87 +299,159 @@ void ResourceMonitorProcess::_collect(
       LOG(ERROR) << "Invalid timestamp " << statistics.get().timestamp()
                  << " for container '" << containerId
                  << "' for executor '" << executorId
-                 << "' of framework '" << frameworkId << ": " << time.error();
+                 << "' of framework '" << frameworkId << ": "
+                 << time.error();
     } else {
       // Add the statistics to the time series.
-      monitored[containerId].statistics.set(
-          statistics.get(), time.get());
+      monitored[containerId].statistics.set(statistics.get(), time.get());
+
+      if (monitored[containerId].history) {
+        Try<Nothing> append =
+          monitored[containerId].history->append(statistics.get());
+
+        if (append.isError()) {
+          VLOG(1) << "Failed to append to the usage history of"
+                  << " container '" << containerId << "': "
+                  << append.error();
+        }
+      }
     }
   }
-
-  // Schedule the next collection.
-  delay(interval, self(), &Self::collect, containerId, interval);
 }
 
 
-ResourceMonitorProcess::Usage ResourceMonitorProcess::usage(
-    const ContainerID& containerId,
-    const ExecutorInfo& executorInfo)
+void ResourceMonitorProcess::__collect()
 {
-  Usage usage;
-  usage.containerId = containerId;
-  usage.executorInfo = executorInfo;
-  usage.statistics = containerizer->usage(containerId);
+  collecting = false;
 
-  return usage;
+  // Schedule the next collection.
+  schedule();
 }
 
 
 Future<http::Response> ResourceMonitorProcess::statistics(
     const http::Request& request)
 {
-  return limiter.acquire()
-    .then(defer(self(), &Self::_statistics, request));
-}
-
-
-Future<http::Response> ResourceMonitorProcess::_statistics(
-    const http::Request& request)
-{
-  list<Usage> usages;
-  list<Future<ResourceStatistics> > futures;
+  JSON::Array result;
 
   foreachpair (const ContainerID& containerId,
                const MonitoringInfo& info,
                monitored) {
-    // TODO(bmahler): Consider a batch usage API on the Containerizer.
-    usages.push_back(usage(containerId, info.executorInfo));
-    futures.push_back(usages.back().statistics);
+    Option<TimeSeries<ResourceStatistics>::Value> latest =
+      info.statistics.latest();
+
+    // Skip containers whose usage hasn't been collected yet.
+    if (latest.isNone()) {
+      VLOG(1) << "No resource usage collected yet for container '"
+              << containerId << "'";
+      continue;
+    }
+
+    JSON::Object entry;
+    entry.values["framework_id"] = info.executorInfo.framework_id().value();
+    entry.values["executor_id"] = info.executorInfo.executor_id().value();
+    entry.values["executor_name"] = info.executorInfo.name();
+    entry.values["source"] = info.executorInfo.source();
+    entry.values["statistics"] = JSON::Protobuf(latest.get().data);
+
+    result.values.push_back(entry);
   }
 
-  return process::await(futures)
-    .then(defer(self(), &Self::__statistics, usages, request));
+  return http::OK(result, request.query.get("jsonp"));
 }
 
 
-Future<http::Response> ResourceMonitorProcess::__statistics(
-    const list<ResourceMonitorProcess::Usage>& usages,
+Future<http::Response> ResourceMonitorProcess::history(
     const http::Request& request)
 {
-  JSON::Array result;
+  Option<string> id = request.query.get("container_id");
 
-  foreach (const Usage& usage, usages) {
-    if (usage.statistics.isFailed()) {
-      LOG(WARNING) << "Failed to get resource usage for "
-                   << " container " << usage.containerId
-                   << " for executor " << usage.executorInfo.executor_id()
-                   << " of framework " << usage.executorInfo.framework_id()
-                   << ": " << usage.statistics.failure();
-      continue;
-    } else if (usage.statistics.isDiscarded()) {
-      continue;
+  if (id.isNone() || id.get().empty()) {
+    return http::BadRequest("Expecting 'container_id=value' in query.\n");
+  }
+
+  ContainerID containerId;
+  containerId.set_value(id.get());
+
+  Option<double> start = None();
+  if (request.query.get("start").isSome()) {
+    Try<double> result = numify<double>(request.query.get("start").get());
+    if (result.isError()) {
+      return http::BadRequest(
+          "Failed to parse start: " + result.error() + ".\n");
+    }
+    start = result.get();
+  }
+
+  Option<double> end = None();
+  if (request.query.get("end").isSome()) {
+    Try<double> result = numify<double>(request.query.get("end").get());
+    if (result.isError()) {
+      return http::BadRequest(
+          "Failed to parse end: " + result.error() + ".\n");
     }
+    end = result.get();
+  }
 
-    JSON::Object entry;
-    entry.values["framework_id"] = usage.executorInfo.framework_id().value();
-    entry.values["executor_id"] = usage.executorInfo.executor_id().value();
-    entry.values["executor_name"] = usage.executorInfo.name();
-    entry.values["source"] = usage.executorInfo.source();
-    entry.values["statistics"] = JSON::Protobuf(usage.statistics.get());
+  Option<Duration> resolution = None();
+  if (request.query.get("resolution").isSome()) {
+    Try<Duration> result =
+      Duration::parse(request.query.get("resolution").get());
+    if (result.isError()) {
+      return http::BadRequest(
+          "Failed to parse resolution: " + result.error() + ".\n");
+    } else if (result.get() <= Duration::zero()) {
+      return http::BadRequest("Expecting a positive resolution.\n");
+    }
+    resolution = result.get();
+  }
 
-    result.values.push_back(entry);
+  UsageHistory::Aggregate aggregate = UsageHistory::AVERAGE;
+  if (request.query.get("aggregate").isSome()) {
+    const string& value = request.query.get("aggregate").get();
+    if (value == "avg") {
+      aggregate = UsageHistory::AVERAGE;
+    } else if (value == "min") {
+      aggregate = UsageHistory::MINIMUM;
+    } else if (value == "max") {
+      aggregate = UsageHistory::MAXIMUM;
+    } else if (value == "last") {
+      aggregate = UsageHistory::LAST;
+    } else {
+      return http::BadRequest(
+          "Expecting 'aggregate' to be one of avg, min, max or last.\n");
+    }
+  }
+
+  // Only the histories of the containers known to the monitor (i.e.,
+  // monitored or archived) are served. Note that the (untrusted)
+  // container ID is never used to construct a path.
+  std::shared_ptr<UsageHistory> history;
+
+  if (monitored.contains(containerId)) {
+    history = monitored[containerId].history;
+  } else {
+    foreach (const process::Owned<MonitoringInfo>& info, archive) {
+      if (info->containerId == containerId) {
+        history = info->history;
+      }
+    }
+  }
+
+  if (!history) {
+    return http::NotFound();
   }
 
+  JSON::Array samples;
+  foreach (const ResourceStatistics& statistics,
+           history->get(start, end, resolution, aggregate)) {
+    samples.values.push_back(JSON::Protobuf(statistics));
+  }
+
+  JSON::Object result;
+  result.values["container_id"] = containerId.value();
+  result.values["statistics"] = samples;
+
   return http::OK(result, request.query.get("jsonp"));
 }
 
@@ -242,8 +462,8 @@ const string ResourceMonitorProcess::STATISTICS_HELP = HELP(
     USAGE(
         "/statistics.json"),
     DESCRIPTION(
-        "Returns the current resource consumption data for containers",
-        "running under this slave.",
+        "Returns the most recently collected resource consumption data",
+        "for containers running under this slave.",
         "",
         "Example:",
         "",
@@ -272,9 +492,46 @@ const string ResourceMonitorProcess::STATISTICS_HELP = HELP(
         "```"));
 
 
-ResourceMonitor::ResourceMonitor(Containerizer* containerizer)
+const string ResourceMonitorProcess::HISTORY_HELP = HELP(
+    TLDR(
+        "Retrieve the resource usage history of a container."),
+    USAGE(
+        "/history.json?container_id=VALUE[&start=VALUE][&end=VALUE]"
+        "[&resolution=VALUE][&aggregate=VALUE]"),
+    DESCRIPTION(
+        "Returns the resource usage samples of the container that were",
+        "collected between 'start' and 'end' (in seconds since the",
+        "Epoch), which are read from the on-disk usage history. Only",
+        "the monitored and recently terminated containers are known.",
+        "",
+        "If a 'resolution' (e.g., 1mins) is specified, the samples are",
+        "downsampled to one sample per interval, using the 'aggregate'",
+        "function ('avg' (default), 'min', 'max' or 'last').",
+        "",
+        "Example:",
+        "",
+        "```",
+        "{",
+        "    \"container_id\":\"container\",",
+        "    \"statistics\":",
+        "    [{",
+        "        \"cpus_limit\":8.25,",
+        "        \"cpus_system_time_secs\":34501.45,",
+        "        \"cpus_user_time_secs\":96348.84,",
+        "        \"mem_rss_bytes\":5105614848,",
+        "        \"timestamp\":1388534400.0",
+        "    }]",
+        "}",
+        "```"));
+
+
+ResourceMonitor::ResourceMonitor(
+    Containerizer* containerizer,
+    const Option<string>& workDir,
+    size_t historyCapacity)
 {
-  process = new ResourceMonitorProcess(containerizer);
+  process =
+    new ResourceMonitorProcess(containerizer, workDir, historyCapacity);
   spawn(process);
 }
 
@@ -307,6 +564,13 @@ Future<Nothing> ResourceMonitor::stop(
   return dispatch(process, &ResourceMonitorProcess::stop, containerId);
 }
 
+
+Future<Nothing> ResourceMonitor::recover(
+    const hashset<ContainerID>& containerIds)
+{
+  return dispatch(process, &ResourceMonitorProcess::recover, containerIds);
+}
+
 } // namespace slave {
 } // namespace internal {
 } // namespace mesos {
@@ -20,6 +20,7 @@
 #define __SLAVE_MONITOR_HPP__
 
 #include <map>
+#include <memory>
 #include <string>
 
 #include <boost/circular_buffer.hpp>
@@ -28,17 +29,21 @@
 #include <mesos/type_utils.hpp>
 
 #include <process/future.hpp>
-#include <process/limiter.hpp>
 #include <process/owned.hpp>
 #include <process/statistics.hpp>
+#include <process/time.hpp>
+#include <process/timer.hpp>
 
 #include <stout/cache.hpp>
 #include <stout/duration.hpp>
 #include <stout/hashmap.hpp>
+#include <stout/hashset.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
 #include <stout/try.hpp>
 
+#include "slave/usage_history.hpp"
+
 namespace mesos {
 namespace internal {
 namespace slave {
@@ -54,10 +59,24 @@ const extern size_t MONITORING_TIME_SERIES_CAPACITY;
 // Number of time series to maintain for completed executors.
 const extern size_t MONITORING_ARCHIVED_TIME_SERIES;
 
+// Maximum time to wait for the usage of a container, after which
+// it's skipped for that collection.
+const extern Duration MONITORING_USAGE_TIMEOUT;
+
 
 // Provides resource monitoring for containers. Resource usage time
 // series are stored using the Statistics module. Usage information
 // is also exported via a JSON endpoint.
+//
+// The usage of all the monitored containers is collected by a single
+// loop, which samples every container that is due (according to its
+// interval) in one pass. The JSON endpoint serves the most recently
+// collected usage rather than triggering a collection itself.
+//
+// When a work directory and a history capacity are given, the usage
+// of each container is also appended to an on-disk UsageHistory (see
+// slave/paths.hpp for the location), which is served (possibly
+// downsampled) by a separate range query endpoint.
 // TODO(bmahler): Forward usage information to the master.
 // TODO(bmahler): Consider pulling out the resource collection into
 // a Collector abstraction. The monitor can then become a true
@@ -69,7 +88,10 @@ const extern size_t MONITORING_ARCHIVED_TIME_SERIES;
 class ResourceMonitor
 {
 public:
-  explicit ResourceMonitor(Containerizer* containerizer);
+  explicit ResourceMonitor(
+      Containerizer* containerizer,
+      const Option<std::string>& workDir = None(),
+      size_t historyCapacity = 0);
   ~ResourceMonitor();
 
   // Starts monitoring resources for the given container.
@@ -84,6 +106,13 @@ public:
   process::Future<Nothing> stop(
       const ContainerID& containerId);
 
+  // Removes the usage histories of all containers but the given
+  // (recovered) ones, i.e., those left behind by the containers that
+  // terminated while the slave was down. Failing to remove them is
+  // only logged.
+  process::Future<Nothing> recover(
+      const hashset<ContainerID>& containerIds);
+
 private:
   ResourceMonitorProcess* process;
 };
@@ -92,10 +121,15 @@ private:
 class ResourceMonitorProcess : public process::Process<ResourceMonitorProcess>
 {
 public:
-  explicit ResourceMonitorProcess(Containerizer* _containerizer)
+  ResourceMonitorProcess(
+      Containerizer* _containerizer,
+      const Option<std::string>& _workDir,
+      size_t _historyCapacity)
     : ProcessBase("monitor"),
       containerizer(_containerizer),
-      limiter(2, Seconds(1)), // 2 permits per second.
+      workDir(_workDir),
+      historyCapacity(_historyCapacity),
+      collecting(false),
       archive(MONITORING_ARCHIVED_TIME_SERIES) {}
 
   virtual ~ResourceMonitorProcess() {}
@@ -108,6 +142,9 @@ public:
   process::Future<Nothing> stop(
       const ContainerID& containerId);
 
+  process::Future<Nothing> recover(
+      const hashset<ContainerID>& containerIds);
+
 protected:
   virtual void initialize()
   {
@@ -115,67 +152,83 @@ protected:
           STATISTICS_HELP,
           &ResourceMonitorProcess::statistics);
 
+    route("/history.json",
+          HISTORY_HELP,
+          &ResourceMonitorProcess::history);
+
     // TODO(bmahler): Add a archive.json endpoint that exposes
     // historical information, once we have path parameters for
     // routes.
   }
 
 private:
-  void collect(
-      const ContainerID& containerId,
-      const Duration& interval);
+  // (Re)schedules the collection for when the next container is due.
+  void schedule();
+
+  // Collects the usage of all the containers that are due. The usage
+  // of each container is recorded as soon as it has been collected
+  // ('_collect'), and the collection is done once all of them have
+  // been collected or timed out ('__collect').
+  void collect();
   void _collect(
-      const process::Future<ResourceStatistics>& statistics,
       const ContainerID& containerId,
-      const Duration& interval);
-
-  // This is a convenience struct for bundling usage information.
-  struct Usage
-  {
-    ContainerID containerId;
-    ExecutorInfo executorInfo;
-    process::Future<ResourceStatistics> statistics;
-  };
-
-  // Helper for returning the usage for a particular executor.
-  Usage usage(
-      const ContainerID& containerId,
-      const ExecutorInfo& executorInfo);
+      const process::Future<ResourceStatistics>& statistics);
+  void __collect();
 
   // HTTP Endpoints.
   // Returns the monitoring statistics. Requests have no parameters.
   process::Future<process::http::Response> statistics(
       const process::http::Request& request);
-  process::Future<process::http::Response> _statistics(
-      const process::http::Request& request);
-  process::Future<process::http::Response> __statistics(
-      const std::list<Usage>& usages,
+
+  // Returns the usage history of a container, see HISTORY_HELP for
+  // the parameters.
+  process::Future<process::http::Response> history(
       const process::http::Request& request);
 
   static const std::string STATISTICS_HELP;
+  static const std::string HISTORY_HELP;
 
   Containerizer* containerizer;
 
-  // Used to rate limit the statistics.json endpoint.
-  process::RateLimiter limiter;
+  const Option<std::string> workDir;
+  const size_t historyCapacity;
 
   // Monitoring information for an executor.
   struct MonitoringInfo {
     // boost::circular_buffer needs a default constructor.
     MonitoringInfo() {}
 
-    MonitoringInfo(const ExecutorInfo& _executorInfo,
+    MonitoringInfo(const ContainerID& _containerId,
+                   const ExecutorInfo& _executorInfo,
+                   const Duration& _interval,
                    const Duration& window,
                    size_t capacity)
-      : executorInfo(_executorInfo), statistics(window, capacity) {}
+      : containerId(_containerId),
+        executorInfo(_executorInfo),
+        interval(_interval),
+        statistics(window, capacity) {}
 
+    ContainerID containerId;     // Non-const for assignability.
     ExecutorInfo executorInfo;   // Non-const for assignability.
+    Duration interval;           // Non-const for assignability.
+
+    // When the usage of the container should next be collected.
+    process::Time next;
+
     process::TimeSeries<ResourceStatistics> statistics;
+
+    // The on-disk usage history, if enabled.
+    std::shared_ptr<UsageHistory> history;
   };
 
   // The monitoring info is stored for each monitored container.
   hashmap<ContainerID, MonitoringInfo> monitored;
 
+  // Whether a collection is in progress, and the timer for the next
+  // collection if one is scheduled.
+  bool collecting;
+  Option<process::Timer> timer;
+
   // Fixed-size history of monitoring information.
   boost::circular_buffer<process::Owned<MonitoringInfo>> archive;
 };
@@ -363,6 +363,21 @@ string getPersistentVolumePath(
 }
 
 
+string getUsageHistoryDir(
+    const string& rootDir)
+{
+  return path::join(rootDir, "monitor");
+}
+
+
+string getUsageHistoryPath(
+    const string& rootDir,
+    const ContainerID& containerId)
+{
+  return path::join(getUsageHistoryDir(rootDir), containerId.value());
+}
+
+
 string createExecutorDirectory(
     const string& rootDir,
     const SlaveID& slaveId,
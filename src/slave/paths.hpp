@@ -45,6 +45,9 @@ namespace paths {
 //       This includes things like persistent volumes and dynamic
 //       reservations.
 //
+//   (5) For the usage history of containers, which is kept across
+//       slave restarts (see slave/usage_history.hpp).
+//
 // The file system layout is as follows:
 //
 //   root ('--work_dir' flag)
@@ -82,6 +85,8 @@ namespace paths {
 //   |                                           |-- task.info
 //   |                                           |-- task.updates
 //   |-- boot_id
+//   |-- monitor
+//   |   |-- <container_id> (usage history)
 //   |-- resources
 //   |   |-- resources.info
 //   |-- volumes
@@ -249,6 +254,15 @@ std::string getPersistentVolumePath(
     const std::string& persistenceId);
 
 
+std::string getUsageHistoryDir(
+    const std::string& rootDir);
+
+
+std::string getUsageHistoryPath(
+    const std::string& rootDir,
+    const ContainerID& containerId);
+
+
 std::string createExecutorDirectory(
     const std::string& rootDir,
     const SlaveID& slaveId,
@@ -28,6 +28,7 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <mesos/type_utils.hpp>
@@ -88,6 +89,7 @@
 
 using std::list;
 using std::map;
+using std::pair;
 using std::set;
 using std::string;
 using std::vector;
@@ -123,7 +125,7 @@ Slave::Slave(const slave::Flags& _flags,
     files(_files),
     metrics(*this),
     gc(_gc),
-    monitor(containerizer),
+    monitor(containerizer, flags.work_dir, flags.resource_monitoring_history),
     statusUpdateManager(_statusUpdateManager),
     metaDir(paths::getMetaRootDir(flags.work_dir)),
     recoveryErrors(0),
@@ -415,6 +417,9 @@ void Slave::initialize()
       &StatusUpdateAcknowledgementMessage::task_id,
       &StatusUpdateAcknowledgementMessage::uuid);
 
+  install<StatusUpdateAcknowledgementsMessage>(
+      &Slave::statusUpdateAcknowledgements);
+
   install<RegisterExecutorMessage>(
       &Slave::registerExecutor,
       &RegisterExecutorMessage::framework_id,
@@ -978,6 +983,7 @@ void Slave::doReliableRegistration(Duration maxBackoff)
     // Registering for the first time.
     RegisterSlaveMessage message;
     message.set_version(MESOS_VERSION);
+    message.set_acknowledgement_batches(true);
     message.mutable_slave()->CopyFrom(info);
 
     // Include checkpointed resources.
@@ -988,6 +994,7 @@ void Slave::doReliableRegistration(Duration maxBackoff)
     // Re-registering, so send tasks running.
     ReregisterSlaveMessage message;
     message.set_version(MESOS_VERSION);
+    message.set_acknowledgement_batches(true);
 
     // Include checkpointed resources.
     message.mutable_checkpointed_resources()->CopyFrom(checkpointedResources);
@@ -2137,6 +2144,66 @@ void Slave::_statusUpdateAcknowledgement(
 }
 
 
+void Slave::statusUpdateAcknowledgements(
+    const UPID& from,
+    const StatusUpdateAcknowledgementsMessage& message)
+{
+  const FrameworkID& frameworkId = message.framework_id();
+
+  if (state != RUNNING) {
+    LOG(WARNING) << "Dropping " << message.acknowledgements_size()
+                 << " status update acknowledgements for " << frameworkId
+                 << " because the slave is in " << state << " state";
+    return;
+  }
+
+  // Batched acknowledgements are only ever sent by the master.
+  if (master != from) {
+    LOG(WARNING) << "Ignoring status update acknowledgements from "
+                 << from << " because it is not the expected master: "
+                 << (master.isSome() ? stringify(master.get()) : "None");
+    return;
+  }
+
+  vector<pair<TaskID, UUID>> acknowledgements;
+  foreach (const StatusUpdateAcknowledgementsMessage::Acknowledgement& ack,
+           message.acknowledgements()) {
+    acknowledgements.push_back(
+        std::make_pair(ack.task_id(), UUID::fromBytes(ack.uuid())));
+  }
+
+  statusUpdateManager->acknowledgements(frameworkId, acknowledgements)
+    .onAny(defer(self(),
+                 &Slave::_statusUpdateAcknowledgements,
+                 lambda::_1,
+                 frameworkId,
+                 acknowledgements));
+}
+
+
+void Slave::_statusUpdateAcknowledgements(
+    const Future<list<Future<bool>>>& futures,
+    const FrameworkID& frameworkId,
+    const vector<pair<TaskID, UUID>>& acknowledgements)
+{
+  CHECK_READY(futures);
+  CHECK_EQ(acknowledgements.size(), futures.get().size());
+
+  vector<pair<TaskID, UUID>>::const_iterator acknowledgement =
+    acknowledgements.begin();
+
+  foreach (const Future<bool>& future, futures.get()) {
+    _statusUpdateAcknowledgement(
+        future,
+        acknowledgement->first,
+        frameworkId,
+        acknowledgement->second);
+
+    ++acknowledgement;
+  }
+}
+
+
 void Slave::registerExecutor(
     const UPID& from,
     const FrameworkID& frameworkId,
@@ -3817,6 +3884,17 @@ Future<Nothing> Slave::_recoverContainerizer(
 
 Future<Nothing> Slave::_recover()
 {
+  // Remove the usage histories of the containers that are gone.
+  hashset<ContainerID> containerIds;
+
+  foreachvalue (Framework* framework, frameworks) {
+    foreachvalue (Executor* executor, framework->executors) {
+      containerIds.insert(executor->containerId);
+    }
+  }
+
+  monitor.recover(containerIds);
+
   foreachvalue (Framework* framework, frameworks) {
     foreachvalue (Executor* executor, framework->executors) {
       // Set up callback for executor termination.
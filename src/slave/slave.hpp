@@ -24,6 +24,7 @@
 #include <list>
 #include <memory>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/circular_buffer.hpp>
@@ -226,6 +227,15 @@ public:
       const FrameworkID& frameworkId,
       const UUID& uuid);
 
+  void statusUpdateAcknowledgements(
+      const process::UPID& from,
+      const StatusUpdateAcknowledgementsMessage& message);
+
+  void _statusUpdateAcknowledgements(
+      const process::Future<std::list<process::Future<bool>>>& futures,
+      const FrameworkID& frameworkId,
+      const std::vector<std::pair<TaskID, UUID>>& acknowledgements);
+
   void executorLaunched(
       const FrameworkID& frameworkId,
       const ExecutorID& executorId,
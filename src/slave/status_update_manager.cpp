@@ -16,11 +16,22 @@
  * limitations under the License.
  */
 
+#include <errno.h>
+#include <unistd.h>
+
+#include <list>
+#include <utility>
+#include <vector>
+
+#include <process/collect.hpp>
+#include <process/defer.hpp>
 #include <process/delay.hpp>
+#include <process/owned.hpp>
 #include <process/process.hpp>
 #include <process/timer.hpp>
 
 #include <stout/check.hpp>
+#include <stout/error.hpp>
 #include <stout/foreach.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
@@ -40,12 +51,18 @@
 
 using lambda::function;
 
+using std::list;
+using std::pair;
 using std::string;
+using std::vector;
 
 using process::wait; // Necessary on some OS's to disambiguate.
+using process::await;
 using process::Failure;
 using process::Future;
+using process::Owned;
 using process::PID;
+using process::Promise;
 using process::Timeout;
 using process::UPID;
 
@@ -60,6 +77,128 @@ using state::RunState;
 using state::TaskState;
 
 
+class StatusUpdateCheckpointerProcess
+  : public process::Process<StatusUpdateCheckpointerProcess>
+{
+public:
+  StatusUpdateCheckpointerProcess() {}
+  virtual ~StatusUpdateCheckpointerProcess() {}
+
+  Future<Nothing> write(
+      int fd,
+      const string& path,
+      const StatusUpdateRecord& record);
+
+  void close(int fd, const string& path);
+
+private:
+  // Writes and syncs the current batch of records.
+  void flush();
+
+  struct Write
+  {
+    int fd;
+    string path;
+    StatusUpdateRecord record;
+    Owned<Promise<Nothing>> promise;
+  };
+
+  // The records that are written by the next flush. These are the
+  // records that got written since the last flush was started.
+  list<Write> batch;
+};
+
+
+Future<Nothing> StatusUpdateCheckpointerProcess::write(
+    int fd,
+    const string& path,
+    const StatusUpdateRecord& record)
+{
+  Write write;
+  write.fd = fd;
+  write.path = path;
+  write.record = record;
+  write.promise.reset(new Promise<Nothing>());
+
+  Future<Nothing> future = write.promise->future();
+
+  batch.push_back(write);
+
+  // The flush gets queued up behind the writes that are already
+  // waiting to be processed, which then all end up in this batch.
+  if (batch.size() == 1) {
+    dispatch(self(), &StatusUpdateCheckpointerProcess::flush);
+  }
+
+  return future;
+}
+
+
+void StatusUpdateCheckpointerProcess::close(int fd, const string& path)
+{
+  // Make sure the records written to this file so far are durable
+  // before we close it.
+  flush();
+
+  Try<Nothing> close = os::close(fd);
+  if (close.isError()) {
+    LOG(ERROR) << "Failed to close file '" << path << "': " << close.error();
+  }
+}
+
+
+void StatusUpdateCheckpointerProcess::flush()
+{
+  if (batch.empty()) {
+    return;
+  }
+
+  VLOG(1) << "Checkpointing a batch of " << batch.size()
+          << " status update records";
+
+  // Write all of the records before syncing each of the files once.
+  // If writing to a file fails we skip any subsequent records for the
+  // file (the stream fails anyway) so that the records stay in order.
+  hashmap<int, Option<string>> errors;
+
+  foreach (const Write& write, batch) {
+    if (!errors.contains(write.fd)) {
+      errors[write.fd] = None();
+    } else if (errors[write.fd].isSome()) {
+      continue;
+    }
+
+    Try<Nothing> result = ::protobuf::write(write.fd, write.record);
+    if (result.isError()) {
+      errors[write.fd] =
+        "Failed to write to '" + write.path + "': " + result.error();
+    }
+  }
+
+  hashset<int> synced;
+
+  foreach (const Write& write, batch) {
+    Option<string>& error = errors[write.fd];
+
+    if (error.isNone() && !synced.contains(write.fd)) {
+      synced.insert(write.fd);
+
+      if (::fsync(write.fd) != 0) {
+        error = ErrnoError("Failed to sync '" + write.path + "'").message;
+      }
+    }
+
+    if (error.isSome()) {
+      write.promise->fail(error.get());
+    } else {
+      write.promise->set(Nothing());
+    }
+  }
+
+  batch.clear();
+}
+
+
 class StatusUpdateManagerProcess
   : public ProtobufProcess<StatusUpdateManagerProcess>
 {
@@ -88,6 +227,10 @@ public:
       const FrameworkID& frameworkId,
       const UUID& uuid);
 
+  Future<list<Future<bool>>> acknowledgements(
+      const FrameworkID& frameworkId,
+      const vector<pair<TaskID, UUID>>& acknowledgements);
+
   Future<Nothing> recover(
       const string& rootDir,
       const Option<SlaveState>& state);
@@ -106,6 +249,17 @@ private:
       const Option<ExecutorID>& executorId,
       const Option<ContainerID>& containerId);
 
+  // Continuations which apply the update or acknowledgement to the
+  // status update stream once they have been checkpointed.
+  Future<Nothing> __update(
+      const TaskID& taskId,
+      const FrameworkID& frameworkId);
+
+  Future<bool> _acknowledgement(
+      const TaskID& taskId,
+      const FrameworkID& frameworkId,
+      const UUID& uuid);
+
   // Status update timeout.
   void timeout(const Duration& duration);
 
@@ -138,6 +292,8 @@ private:
   const Flags flags;
   bool paused;
 
+  StatusUpdateCheckpointer checkpointer;
+
   function<void(StatusUpdate)> forward_;
 
   hashmap<FrameworkID, hashmap<TaskID, StatusUpdateStream*> > streams;
@@ -345,10 +501,46 @@ Future<Nothing> StatusUpdateManagerProcess::_update(
     return Nothing();
   }
 
-  // Forward the status update to the master if this is the first in the stream.
+  if (!stream->checkpoint) {
+    return __update(taskId, frameworkId);
+  }
+
+  // NOTE: We only forward (and the slave only acknowledges) the
+  // update once it has been checkpointed.
+  return stream->checkpointed()
+    .then(defer(self(),
+                &StatusUpdateManagerProcess::__update,
+                taskId,
+                frameworkId));
+}
+
+
+Future<Nothing> StatusUpdateManagerProcess::__update(
+    const TaskID& taskId,
+    const FrameworkID& frameworkId)
+{
+  StatusUpdateStream* stream = getStatusUpdateStream(taskId, frameworkId);
+
+  // This might happen if the stream has been cleaned up (e.g., the
+  // framework was shut down) while the update was being checkpointed.
+  // There is nothing left to forward in that case, which is not an
+  // error for the sender of the update.
+  if (stream == NULL) {
+    LOG(WARNING) << "Status update stream for task " << taskId
+                 << " of framework " << frameworkId
+                 << " was closed before the update was checkpointed";
+    return Nothing();
+  }
+
+  Try<Nothing> apply = stream->apply();
+  if (apply.isError()) {
+    return Failure(apply.error());
+  }
+
+  // Forward the status update to the master if there is no other
+  // update in flight, i.e., this is the first in the stream.
   // Subsequent status updates will get sent in 'acknowledgement()'.
-  if (!paused && stream->pending.size() == 1) {
-    CHECK(stream->timeout.isNone());
+  if (!paused && stream->timeout.isNone()) {
     const Result<StatusUpdate>& next = stream->next();
     if (next.isError()) {
       return Failure(next.error());
@@ -427,6 +619,67 @@ Future<bool> StatusUpdateManagerProcess::acknowledgement(
     return Failure("Duplicate acknowledgement");
   }
 
+  if (!stream->checkpoint) {
+    return _acknowledgement(taskId, frameworkId, uuid);
+  }
+
+  return stream->checkpointed()
+    .then(defer(self(),
+                &StatusUpdateManagerProcess::_acknowledgement,
+                taskId,
+                frameworkId,
+                uuid));
+}
+
+
+Future<list<Future<bool>>> StatusUpdateManagerProcess::acknowledgements(
+    const FrameworkID& frameworkId,
+    const vector<pair<TaskID, UUID>>& acknowledgements)
+{
+  list<Future<bool>> futures;
+
+  typedef pair<TaskID, UUID> Acknowledgement;
+  foreach (const Acknowledgement& acknowledgement, acknowledgements) {
+    futures.push_back(this->acknowledgement(
+        acknowledgement.first, frameworkId, acknowledgement.second));
+  }
+
+  // NOTE: The acknowledgements of checkpointed streams complete once
+  // their records are durable, which the checkpointer group commits.
+  return await(futures);
+}
+
+
+Future<bool> StatusUpdateManagerProcess::_acknowledgement(
+    const TaskID& taskId,
+    const FrameworkID& frameworkId,
+    const UUID& uuid)
+{
+  StatusUpdateStream* stream = getStatusUpdateStream(taskId, frameworkId);
+
+  // This might happen if the stream has been cleaned up while the
+  // acknowledgement was being checkpointed.
+  if (stream == NULL) {
+    return Failure(
+        "Status update stream for task " + stringify(taskId) +
+        " of framework " + stringify(frameworkId) +
+        " was closed before the acknowledgement (UUID: " + uuid.toString() +
+        ") was checkpointed");
+  }
+
+  // Get the corresponding update for this ACK.
+  const Result<StatusUpdate>& update = stream->next();
+  if (update.isError()) {
+    return Failure(update.error());
+  }
+
+  CHECK_SOME(update);
+
+  Try<Nothing> apply = stream->apply();
+  if (apply.isError()) {
+    return Failure(apply.error());
+  }
+
   // Reset the timeout.
   stream->timeout = None();
 
@@ -495,7 +748,14 @@ StatusUpdateStream* StatusUpdateManagerProcess::createStatusUpdateStream(
           << " of framework " << frameworkId;
 
   StatusUpdateStream* stream = new StatusUpdateStream(
-      taskId, frameworkId, slaveId, flags, checkpoint, executorId, containerId);
+      taskId,
+      frameworkId,
+      slaveId,
+      flags,
+      &checkpointer,
+      checkpoint,
+      executorId,
+      containerId);
 
   streams[frameworkId][taskId] = stream;
   return stream;
@@ -543,6 +803,39 @@ void StatusUpdateManagerProcess::cleanupStatusUpdateStream(
 }
 
 
+StatusUpdateCheckpointer::StatusUpdateCheckpointer()
+{
+  process = new StatusUpdateCheckpointerProcess();
+  spawn(process);
+}
+
+
+StatusUpdateCheckpointer::~StatusUpdateCheckpointer()
+{
+  // NOTE: We don't inject the termination so that the pending writes
+  // and closes get processed first.
+  terminate(process, false);
+  wait(process);
+  delete process;
+}
+
+
+Future<Nothing> StatusUpdateCheckpointer::write(
+    int fd,
+    const string& path,
+    const StatusUpdateRecord& record)
+{
+  return dispatch(
+      process, &StatusUpdateCheckpointerProcess::write, fd, path, record);
+}
+
+
+void StatusUpdateCheckpointer::close(int fd, const string& path)
+{
+  dispatch(process, &StatusUpdateCheckpointerProcess::close, fd, path);
+}
+
+
 StatusUpdateManager::StatusUpdateManager(const Flags& flags)
 {
   process = new StatusUpdateManagerProcess(flags);
@@ -607,6 +900,18 @@ Future<bool> StatusUpdateManager::acknowledgement(
 }
 
 
+Future<list<Future<bool>>> StatusUpdateManager::acknowledgements(
+    const FrameworkID& frameworkId,
+    const vector<pair<TaskID, UUID>>& acknowledgements)
+{
+  return dispatch(
+      process,
+      &StatusUpdateManagerProcess::acknowledgements,
+      frameworkId,
+      acknowledgements);
+}
+
+
 Future<Nothing> StatusUpdateManager::recover(
     const string& rootDir,
     const Option<SlaveState>& state)
@@ -19,13 +19,16 @@
 #ifndef __STATUS_UPDATE_MANAGER_HPP__
 #define __STATUS_UPDATE_MANAGER_HPP__
 
+#include <list>
 #include <ostream>
 #include <queue>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include <mesos/type_utils.hpp>
 
+#include <process/future.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
 #include <process/protobuf.hpp>
@@ -61,6 +64,7 @@ struct SlaveState;
 
 }
 
+class StatusUpdateCheckpointerProcess;
 class StatusUpdateManagerProcess;
 struct StatusUpdateStream;
 
@@ -113,6 +117,14 @@ public:
       const FrameworkID& frameworkId,
       const UUID& uuid);
 
+  // Handles the (task, uuid) acknowledgements of the framework in a
+  // single pass, same as 'acknowledgement()' for each of them.
+  // @return The result of each acknowledgement, in the same order,
+  //         once all of them are handled.
+  process::Future<std::list<process::Future<bool>>> acknowledgements(
+      const FrameworkID& frameworkId,
+      const std::vector<std::pair<TaskID, UUID>>& acknowledgements);
+
   // Recover status updates.
   process::Future<Nothing> recover(
       const std::string& rootDir,
@@ -138,6 +150,34 @@ private:
 };
 
 
+// StatusUpdateCheckpointer appends status update records to the files
+// of the status update streams on its own actor, so that checkpointing
+// doesn't block the StatusUpdateManager on disk I/O. The records that
+// get written while a batch is being written are batched up (i.e.,
+// group committed), so that a single fsync per file makes the whole
+// batch durable.
+class StatusUpdateCheckpointer
+{
+public:
+  StatusUpdateCheckpointer();
+  virtual ~StatusUpdateCheckpointer();
+
+  // Appends the record to the file.
+  // @return Nothing once the record is durable.
+  //         Failed if there are any errors (e.g., writing, syncing).
+  process::Future<Nothing> write(
+      int fd,
+      const std::string& path,
+      const StatusUpdateRecord& record);
+
+  // Closes the file after the records written to it so far.
+  void close(int fd, const std::string& path);
+
+private:
+  StatusUpdateCheckpointerProcess* process;
+};
+
+
 // StatusUpdateStream handles the status updates and acknowledgements
 // of a task, checkpointing them if necessary. It also holds the information
 // about received, acknowledged and pending status updates.
@@ -150,6 +190,7 @@ struct StatusUpdateStream
                      const FrameworkID& _frameworkId,
                      const SlaveID& _slaveId,
                      const Flags& _flags,
+                     StatusUpdateCheckpointer* _checkpointer,
                      bool _checkpoint,
                      const Option<ExecutorID>& executorId,
                      const Option<ContainerID>& containerId)
@@ -159,6 +200,7 @@ struct StatusUpdateStream
       frameworkId(_frameworkId),
       slaveId(_slaveId),
       flags(_flags),
+      checkpointer(_checkpointer),
       error(None())
   {
     if (checkpoint) {
@@ -181,9 +223,11 @@ struct StatusUpdateStream
       }
 
       // Open the updates file.
+      // NOTE: We don't use O_SYNC since the checkpointer syncs the
+      // file once per batch of records instead.
       Try<int> result = os::open(
           path.get(),
-          O_CREAT | O_WRONLY | O_APPEND | O_SYNC | O_CLOEXEC,
+          O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC,
           S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
 
       if (result.isError()) {
@@ -200,16 +244,16 @@ struct StatusUpdateStream
   ~StatusUpdateStream()
   {
     if (fd.isSome()) {
-      Try<Nothing> close = os::close(fd.get());
-      if (close.isError()) {
-        CHECK_SOME(path);
-        LOG(ERROR) << "Failed to close file '" << path.get() << "': "
-                   << close.error();
-      }
+      // The checkpointer closes the file once the records that are
+      // still being checkpointed (if any) have been written.
+      CHECK_SOME(path);
+      checkpointer->close(fd.get(), path.get());
     }
   }
 
   // This function handles the update, checkpointing if necessary.
+  // NOTE: The update only gets added to the pending updates once it
+  // is applied (see 'checkpointed' and 'apply').
   // @return   True if the update is successfully handled.
   //           False if the update is a duplicate.
   //           Error Any errors (e.g., checkpointing).
@@ -237,15 +281,14 @@ struct StatusUpdateStream
     }
 
     // Handle the update, checkpointing if necessary.
-    Try<Nothing> result = handle(update, StatusUpdateRecord::UPDATE);
-    if (result.isError()) {
-      return Error(result.error());
-    }
+    handle(update, StatusUpdateRecord::UPDATE);
 
     return true;
   }
 
   // This function handles the ACK, checkpointing if necessary.
+  // NOTE: The update only gets removed from the pending updates once
+  // the ACK is applied (see 'checkpointed' and 'apply').
   // @return   True if the acknowledgement is successfully handled.
   //           False if the acknowledgement is a duplicate.
   //           Error Any errors (e.g., checkpointing).
@@ -275,14 +318,55 @@ struct StatusUpdateStream
     }
 
     // Handle the ACK, checkpointing if necessary.
-    Try<Nothing> result = handle(update, StatusUpdateRecord::ACK);
-    if (result.isError()) {
-      return Error(result.error());
-    }
+    handle(update, StatusUpdateRecord::ACK);
 
     return true;
   }
 
+  // Returns a future which is satisfied once all of the updates and
+  // ACKs handled so far have been checkpointed (or failed to be).
+  process::Future<Nothing> checkpointed() const
+  {
+    if (unapplied.empty()) {
+      return Nothing();
+    }
+
+    return unapplied.back().checkpointed;
+  }
+
+  // Applies the oldest handled update or ACK that has not been
+  // applied yet, i.e., adds the update to or removes it from the
+  // pending updates. This must only be called once the update or ACK
+  // has been checkpointed, and once for each of them.
+  // @return   Nothing if the update or ACK is successfully applied.
+  //           Error Any errors (e.g., checkpointing).
+  Try<Nothing> apply()
+  {
+    if (error.isSome()) {
+      return Error(error.get());
+    }
+
+    CHECK(!unapplied.empty());
+
+    const Unapplied next = unapplied.front();
+    unapplied.pop();
+
+    CHECK(!next.checkpointed.isPending());
+
+    if (!next.checkpointed.isReady()) {
+      error = "Failed to checkpoint " + stringify(next.type) +
+              " for status update " + stringify(next.update) + ": " +
+              (next.checkpointed.isFailed()
+                 ? next.checkpointed.failure()
+                 : "discarded");
+      return Error(error.get());
+    }
+
+    _handle(next.update, next.type);
+
+    return Nothing();
+  }
+
   // Returns the next update (or none, if empty) in the queue.
   Result<StatusUpdate> next()
   {
@@ -329,18 +413,29 @@ struct StatusUpdateStream
   std::queue<StatusUpdate> pending;
 
 private:
-  // Handles the status update and writes it to disk, if necessary.
-  // TODO(vinod): The write has to be asynchronous to avoid status updates that
-  // are being checkpointed, blocking the processing of other updates.
-  // One solution is to wrap the protobuf::write inside async, but its probably
-  // too much of an overhead to spin up a new libprocess per status update?
-  // A better solution might be to be have async write capability for file io.
-  Try<Nothing> handle(
+  // An update or ACK that has been handled but not yet applied.
+  struct Unapplied
+  {
+    StatusUpdate update;
+    StatusUpdateRecord::Type type;
+    process::Future<Nothing> checkpointed;
+  };
+
+  // Handles the status update and writes it to disk (asynchronously),
+  // if necessary. The update or ACK gets applied once it has been
+  // checkpointed (see 'apply'), but we record it right away so that
+  // duplicates get detected in the meantime.
+  void handle(
       const StatusUpdate& update,
       const StatusUpdateRecord::Type& type)
   {
     CHECK(error.isNone());
 
+    Unapplied next;
+    next.update = update;
+    next.type = type;
+    next.checkpointed = Nothing();
+
     // Checkpoint the update if necessary.
     if (checkpoint) {
       LOG(INFO) << "Checkpointing " << type << " for status update " << update;
@@ -356,18 +451,16 @@ private:
         record.set_uuid(update.uuid());
       }
 
-      Try<Nothing> write = ::protobuf::write(fd.get(), record);
-      if (write.isError()) {
-        error = "Failed to write status update " + stringify(update) +
-                " to '" + path.get() + "': " + write.error();
-        return Error(error.get());
-      }
+      next.checkpointed = checkpointer->write(fd.get(), path.get(), record);
     }
 
-    // Now actually handle the update.
-    _handle(update, type);
+    if (type == StatusUpdateRecord::UPDATE) {
+      received.insert(UUID::fromBytes(update.uuid()));
+    } else {
+      acknowledged.insert(UUID::fromBytes(update.uuid()));
+    }
 
-    return Nothing();
+    unapplied.push(next);
   }
 
   void _handle(const StatusUpdate& update, const StatusUpdateRecord::Type& type)
@@ -399,9 +492,14 @@ private:
 
   const Flags flags;
 
+  StatusUpdateCheckpointer* checkpointer;
+
   hashset<UUID> received;
   hashset<UUID> acknowledged;
 
+  // The handled updates and ACKs which are yet to be applied.
+  std::queue<Unapplied> unapplied;
+
   Option<std::string> path; // File path of the update stream.
   Option<int> fd; // File descriptor to the update stream.
 
@@ -0,0 +1,628 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <glog/logging.h>
+
+#include <google/protobuf/descriptor.h>
+#include <google/protobuf/message.h>
+
+#include <stout/bytes.hpp>
+#include <stout/error.hpp>
+#include <stout/nothing.hpp>
+#include <stout/os.hpp>
+#include <stout/stringify.hpp>
+
+#include "slave/usage_history.hpp"
+
+using google::protobuf::Descriptor;
+using google::protobuf::FieldDescriptor;
+using google::protobuf::Reflection;
+
+using std::string;
+using std::vector;
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// Identifies the file format, which needs to be bumped on any change
+// to the header.
+static const char MAGIC[8] = {'M', 'E', 'S', 'O', 'S', 'U', 'S', 'E'};
+static const uint32_t FORMAT_VERSION = 1;
+
+static const size_t MAX_COLUMNS = 128;
+
+
+struct UsageHistory::Header
+{
+  char magic[8];
+  uint32_t version;
+  uint32_t columns;
+  uint64_t capacity;
+
+  // The position of the next sample and the number of samples.
+  uint64_t head;
+  uint64_t size;
+
+  // The field number of each column.
+  int32_t fields[MAX_COLUMNS];
+};
+
+
+// Returns the fields of ResourceStatistics which are stored as
+// columns, i.e., all the non-repeated numeric fields.
+static vector<const FieldDescriptor*> fields()
+{
+  vector<const FieldDescriptor*> result;
+
+  const Descriptor* descriptor = ResourceStatistics::descriptor();
+
+  for (int i = 0; i < descriptor->field_count(); i++) {
+    const FieldDescriptor* field = descriptor->field(i);
+
+    if (field->is_repeated()) {
+      continue;
+    }
+
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+      case FieldDescriptor::CPPTYPE_FLOAT:
+      case FieldDescriptor::CPPTYPE_INT32:
+      case FieldDescriptor::CPPTYPE_INT64:
+      case FieldDescriptor::CPPTYPE_UINT32:
+      case FieldDescriptor::CPPTYPE_UINT64:
+        result.push_back(field);
+        break;
+      default:
+        break;
+    }
+  }
+
+  return result;
+}
+
+
+// Allocates the disk blocks backing the first 'length' bytes of the
+// file, so that writing through a mapping of it can't fault.
+static Try<Nothing> allocate(int fd, size_t length)
+{
+#ifdef __linux__
+  // NOTE: posix_fallocate returns the error rather than setting errno.
+  int error = ::posix_fallocate(fd, 0, length);
+  if (error != 0) {
+    return Error(strerror(error));
+  }
+#else
+  // Not all platforms support posix_fallocate, so we explicitly write
+  // out the zeros beyond the current end of the file instead.
+  struct stat s;
+  if (::fstat(fd, &s) < 0) {
+    return ErrnoError();
+  }
+
+  const char zeros[4096] = {};
+
+  size_t offset = static_cast<size_t>(s.st_size);
+  while (offset < length) {
+    size_t size = std::min(sizeof(zeros), length - offset);
+
+    ssize_t written = ::pwrite(fd, zeros, size, offset);
+    if (written < 0) {
+      return ErrnoError();
+    }
+
+    offset += written;
+  }
+#endif // __linux__
+
+  return Nothing();
+}
+
+
+Option<Error> UsageHistory::validate(const Header* header, size_t length)
+{
+  if (length < sizeof(Header)) {
+    return Error("Truncated header");
+  }
+
+  if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0) {
+    return Error("Bad magic");
+  }
+
+  if (header->version != FORMAT_VERSION) {
+    return Error("Unsupported version " + stringify(header->version));
+  }
+
+  if (header->columns > MAX_COLUMNS) {
+    return Error("Too many columns (" + stringify(header->columns) + ")");
+  }
+
+  if (header->capacity == 0 ||
+      length != sizeof(Header) +
+                  header->columns * header->capacity * sizeof(double)) {
+    return Error("Unexpected size for a capacity of " +
+                 stringify(header->capacity) + " samples");
+  }
+
+  if (header->head >= header->capacity ||
+      header->size > header->capacity) {
+    return Error("Corrupted header");
+  }
+
+  for (uint32_t i = 0; i < header->columns; i++) {
+    if (header->fields[i] == ResourceStatistics::kTimestampFieldNumber) {
+      return None();
+    }
+  }
+
+  return Error("Missing the timestamp column");
+}
+
+
+Try<UsageHistory*> UsageHistory::create(
+    const string& path,
+    size_t capacity)
+{
+  CHECK_GT(capacity, 0u);
+
+  const vector<const FieldDescriptor*> fields = slave::fields();
+
+  if (fields.size() > MAX_COLUMNS) {
+    return Error("Too many columns (" + stringify(fields.size()) + ")");
+  }
+
+  Try<string> dirname = os::dirname(path);
+  if (dirname.isError()) {
+    return Error(dirname.error());
+  }
+
+  Try<Nothing> mkdir = os::mkdir(dirname.get());
+  if (mkdir.isError()) {
+    return Error("Failed to create directory '" + dirname.get() + "': " +
+                 mkdir.error());
+  }
+
+  Try<int> fd = os::open(
+      path,
+      O_RDWR | O_CREAT | O_CLOEXEC,
+      S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  const size_t length =
+    sizeof(Header) + fields.size() * capacity * sizeof(double);
+
+  struct stat s;
+  if (::fstat(fd.get(), &s) < 0) {
+    ErrnoError error("Failed to stat '" + path + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  // A history of a different size can't be reused, so we truncate it
+  // first in order to zero it out.
+  bool reset = static_cast<size_t>(s.st_size) != length;
+
+  if (reset && ::ftruncate(fd.get(), 0) < 0) {
+    ErrnoError error("Failed to truncate '" + path + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  // The file is allocated up front rather than left sparse since the
+  // samples are written through the mapping, where running out of
+  // disk space results in a SIGBUS rather than an error.
+  Try<Nothing> allocate = slave::allocate(fd.get(), length);
+
+  if (allocate.isError()) {
+    os::close(fd.get());
+
+    // Don't leave a partially allocated history behind.
+    Try<Nothing> rm = os::rm(path);
+    if (rm.isError()) {
+      LOG(WARNING) << "Failed to remove '" << path << "': " << rm.error();
+    }
+
+    return Error(
+        "Failed to allocate " + stringify(Bytes(length)) +
+        " for '" + path + "': " + allocate.error());
+  }
+
+  void* memory =
+    ::mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+
+  if (memory == MAP_FAILED) {
+    ErrnoError error("Failed to map '" + path + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  Header* header = reinterpret_cast<Header*>(memory);
+
+  if (!reset) {
+    Option<Error> error = validate(header, length);
+
+    if (error.isSome()) {
+      LOG(WARNING) << "Discarding the usage history at '" << path
+                   << "': " << error.get().message;
+      reset = true;
+    } else if (header->columns != fields.size() ||
+               header->capacity != capacity) {
+      reset = true;
+    } else {
+      for (size_t i = 0; i < fields.size(); i++) {
+        if (header->fields[i] != fields[i]->number()) {
+          reset = true;
+          break;
+        }
+      }
+    }
+  }
+
+  if (reset) {
+    memset(header, 0, sizeof(Header));
+    memcpy(header->magic, MAGIC, sizeof(MAGIC));
+    header->version = FORMAT_VERSION;
+    header->columns = fields.size();
+    header->capacity = capacity;
+    header->head = 0;
+    header->size = 0;
+
+    for (size_t i = 0; i < fields.size(); i++) {
+      header->fields[i] = fields[i]->number();
+    }
+  }
+
+  return new UsageHistory(path, fd.get(), memory, length, true);
+}
+
+
+Try<UsageHistory*> UsageHistory::open(const string& path)
+{
+  Try<int> fd = os::open(path, O_RDONLY | O_CLOEXEC);
+
+  if (fd.isError()) {
+    return Error("Failed to open '" + path + "': " + fd.error());
+  }
+
+  struct stat s;
+  if (::fstat(fd.get(), &s) < 0) {
+    ErrnoError error("Failed to stat '" + path + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  const size_t length = s.st_size;
+
+  if (length < sizeof(Header)) {
+    os::close(fd.get());
+    return Error("Invalid usage history at '" + path + "': Truncated header");
+  }
+
+  void* memory = ::mmap(NULL, length, PROT_READ, MAP_SHARED, fd.get(), 0);
+
+  if (memory == MAP_FAILED) {
+    ErrnoError error("Failed to map '" + path + "'");
+    os::close(fd.get());
+    return error;
+  }
+
+  Option<Error> error = validate(reinterpret_cast<Header*>(memory), length);
+
+  if (error.isSome()) {
+    ::munmap(memory, length);
+    os::close(fd.get());
+    return Error("Invalid usage history at '" + path + "': " +
+                 error.get().message);
+  }
+
+  return new UsageHistory(path, fd.get(), memory, length, false);
+}
+
+
+UsageHistory::UsageHistory(
+    const string& path,
+    int _fd,
+    void* _memory,
+    size_t _length,
+    bool _writable)
+  : _path(path),
+    fd(_fd),
+    memory(_memory),
+    length(_length),
+    writable(_writable),
+    header(reinterpret_cast<Header*>(_memory)),
+    columns(reinterpret_cast<double*>(
+        reinterpret_cast<char*>(_memory) + sizeof(Header))),
+    timestamps(0)
+{
+  for (uint32_t i = 0; i < header->columns; i++) {
+    if (header->fields[i] == ResourceStatistics::kTimestampFieldNumber) {
+      timestamps = i;
+      break;
+    }
+  }
+}
+
+
+UsageHistory::~UsageHistory()
+{
+  ::munmap(memory, length);
+  os::close(fd);
+}
+
+
+size_t UsageHistory::size() const
+{
+  return header->size;
+}
+
+
+Try<Nothing> UsageHistory::append(const ResourceStatistics& statistics)
+{
+  CHECK(writable);
+
+  if (header->size > 0 &&
+      statistics.timestamp() < value(timestamps, header->size - 1)) {
+    return Error("Sample at " + stringify(statistics.timestamp()) +
+                 " is older than the newest sample at " +
+                 stringify(value(timestamps, header->size - 1)));
+  }
+
+  const Descriptor* descriptor = ResourceStatistics::descriptor();
+  const Reflection* reflection = statistics.GetReflection();
+
+  const uint64_t capacity = header->capacity;
+
+  for (uint32_t i = 0; i < header->columns; i++) {
+    const FieldDescriptor* field =
+      descriptor->FindFieldByNumber(header->fields[i]);
+
+    CHECK_NOTNULL(field);
+
+    double value = std::numeric_limits<double>::quiet_NaN();
+
+    if (reflection->HasField(statistics, field)) {
+      switch (field->cpp_type()) {
+        case FieldDescriptor::CPPTYPE_DOUBLE:
+          value = reflection->GetDouble(statistics, field);
+          break;
+        case FieldDescriptor::CPPTYPE_FLOAT:
+          value = reflection->GetFloat(statistics, field);
+          break;
+        case FieldDescriptor::CPPTYPE_INT32:
+          value = reflection->GetInt32(statistics, field);
+          break;
+        case FieldDescriptor::CPPTYPE_INT64:
+          value = reflection->GetInt64(statistics, field);
+          break;
+        case FieldDescriptor::CPPTYPE_UINT32:
+          value = reflection->GetUInt32(statistics, field);
+          break;
+        case FieldDescriptor::CPPTYPE_UINT64:
+          value = reflection->GetUInt64(statistics, field);
+          break;
+        default:
+          LOG(FATAL) << "Unexpected column type for '"
+                     << field->name() << "'";
+      }
+    }
+
+    columns[i * capacity + header->head] = value;
+  }
+
+  // The sample is only made visible once all of its columns have been
+  // written.
+  header->head = (header->head + 1) % capacity;
+  header->size = std::min(header->size + 1, capacity);
+
+  return Nothing();
+}
+
+
+vector<ResourceStatistics> UsageHistory::get(
+    const Option<double>& start,
+    const Option<double>& end,
+    const Option<Duration>& resolution,
+    Aggregate aggregate) const
+{
+  vector<ResourceStatistics> result;
+
+  size_t begin = start.isSome() ? lowerBound(start.get()) : 0;
+  size_t last = header->size;
+
+  if (end.isSome()) {
+    // Find the first sample that is newer than 'end'.
+    last = lowerBound(end.get());
+    while (last < header->size && value(timestamps, last) <= end.get()) {
+      last++;
+    }
+  }
+
+  if (resolution.isNone()) {
+    vector<double> values(header->columns);
+
+    for (size_t i = begin; i < last; i++) {
+      for (uint32_t column = 0; column < header->columns; column++) {
+        values[column] = value(column, i);
+      }
+      result.push_back(sample(values));
+    }
+
+    return result;
+  }
+
+  CHECK_GT(resolution.get(), Duration::zero());
+
+  const double interval = resolution.get().secs();
+
+  // The aggregated values of the interval being processed, along
+  // with the number of samples each value was aggregated from.
+  Option<double> current = None();
+  vector<double> values(header->columns);
+  vector<size_t> counts(header->columns);
+
+  for (size_t i = begin; i <= last; i++) {
+    Option<double> bucket = None();
+    if (i < last) {
+      bucket = std::floor(value(timestamps, i) / interval) * interval;
+    }
+
+    if (current.isSome() && bucket != current) {
+      for (uint32_t column = 0; column < header->columns; column++) {
+        if (counts[column] == 0) {
+          values[column] = std::numeric_limits<double>::quiet_NaN();
+        } else if (aggregate == AVERAGE) {
+          values[column] /= counts[column];
+        }
+      }
+
+      values[timestamps] = current.get();
+      result.push_back(sample(values));
+    }
+
+    if (bucket.isNone()) {
+      break;
+    }
+
+    if (bucket != current) {
+      current = bucket;
+      std::fill(values.begin(), values.end(), 0.0);
+      std::fill(counts.begin(), counts.end(), 0);
+    }
+
+    for (uint32_t column = 0; column < header->columns; column++) {
+      const double v = value(column, i);
+
+      if (std::isnan(v)) {
+        continue;
+      }
+
+      if (counts[column] == 0) {
+        values[column] = v;
+      } else {
+        switch (aggregate) {
+          case AVERAGE: values[column] += v; break;
+          case MINIMUM: values[column] = std::min(values[column], v); break;
+          case MAXIMUM: values[column] = std::max(values[column], v); break;
+          case LAST:    values[column] = v; break;
+        }
+      }
+
+      counts[column]++;
+    }
+  }
+
+  return result;
+}
+
+
+double UsageHistory::value(size_t column, size_t i) const
+{
+  CHECK_LT(i, header->size);
+
+  const uint64_t capacity = header->capacity;
+  const uint64_t position =
+    (header->head + capacity - header->size + i) % capacity;
+
+  return columns[column * capacity + position];
+}
+
+
+size_t UsageHistory::lowerBound(double timestamp) const
+{
+  size_t low = 0;
+  size_t high = header->size;
+
+  while (low < high) {
+    const size_t middle = low + (high - low) / 2;
+
+    if (value(timestamps, middle) < timestamp) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+
+  return low;
+}
+
+
+ResourceStatistics UsageHistory::sample(const vector<double>& values) const
+{
+  ResourceStatistics statistics;
+
+  const Descriptor* descriptor = ResourceStatistics::descriptor();
+  const Reflection* reflection = statistics.GetReflection();
+
+  for (uint32_t i = 0; i < header->columns; i++) {
+    // Skip the columns written for fields that no longer exist.
+    const FieldDescriptor* field =
+      descriptor->FindFieldByNumber(header->fields[i]);
+
+    if (field == NULL || std::isnan(values[i])) {
+      continue;
+    }
+
+    const double value = values[i];
+
+    switch (field->cpp_type()) {
+      case FieldDescriptor::CPPTYPE_DOUBLE:
+        reflection->SetDouble(&statistics, field, value);
+        break;
+      case FieldDescriptor::CPPTYPE_FLOAT:
+        reflection->SetFloat(&statistics, field, value);
+        break;
+      case FieldDescriptor::CPPTYPE_INT32:
+        reflection->SetInt32(&statistics, field, std::llround(value));
+        break;
+      case FieldDescriptor::CPPTYPE_INT64:
+        reflection->SetInt64(&statistics, field, std::llround(value));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT32:
+        reflection->SetUInt32(&statistics, field, std::llround(value));
+        break;
+      case FieldDescriptor::CPPTYPE_UINT64:
+        reflection->SetUInt64(&statistics, field, std::llround(value));
+        break;
+      default:
+        break;
+    }
+  }
+
+  return statistics;
+}
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
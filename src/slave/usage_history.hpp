@@ -0,0 +1,142 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __SLAVE_USAGE_HISTORY_HPP__
+#define __SLAVE_USAGE_HISTORY_HPP__
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <mesos/mesos.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/error.hpp>
+#include <stout/nothing.hpp>
+#include <stout/option.hpp>
+#include <stout/try.hpp>
+
+namespace mesos {
+namespace internal {
+namespace slave {
+
+// A fixed-capacity, on-disk ring buffer of the ResourceStatistics
+// samples of a container. The file is memory-mapped so that both
+// appending a sample and querying a range of samples are plain memory
+// accesses, and the history survives slave restarts.
+//
+// The samples are stored in a columnar layout: the file starts with a
+// header, followed by one column of 'capacity' doubles for each
+// (non-repeated) numeric field of ResourceStatistics. The header
+// records the field number of every column so that a history written
+// by a different version of ResourceStatistics can still be read. A
+// field that is not set in a sample is stored as NaN.
+//
+// NOTE: Samples are expected to be appended in timestamp order, which
+// is what allows range queries to binary search the timestamps.
+class UsageHistory
+{
+public:
+  // How the samples within a resolution interval are aggregated.
+  enum Aggregate
+  {
+    AVERAGE,
+    MINIMUM,
+    MAXIMUM,
+    LAST,
+  };
+
+  // Opens the history at 'path', creating it with room for 'capacity'
+  // samples if it doesn't exist. An existing history with a different
+  // capacity or layout is discarded and recreated.
+  static Try<UsageHistory*> create(
+      const std::string& path,
+      size_t capacity);
+
+  // Opens an existing history at 'path' for reading only.
+  static Try<UsageHistory*> open(const std::string& path);
+
+  ~UsageHistory();
+
+  const std::string& path() const { return _path; }
+
+  // Returns the number of samples in the history.
+  size_t size() const;
+
+  // Appends the sample, overwriting the oldest one once the history
+  // is at capacity. Returns an error if the sample is older than the
+  // newest sample in the history.
+  Try<Nothing> append(const ResourceStatistics& statistics);
+
+  // Returns the samples whose timestamps (in seconds since the Epoch)
+  // fall within ['start', 'end'], oldest first. If a 'resolution' is
+  // specified, the samples are aggregated into one sample for each
+  // interval of that length (aligned to the Epoch) which contains any
+  // samples, and whose timestamp is the beginning of the interval.
+  std::vector<ResourceStatistics> get(
+      const Option<double>& start = None(),
+      const Option<double>& end = None(),
+      const Option<Duration>& resolution = None(),
+      Aggregate aggregate = AVERAGE) const;
+
+private:
+  struct Header;
+
+  UsageHistory(
+      const std::string& path,
+      int fd,
+      void* memory,
+      size_t length,
+      bool writable);
+
+  // Returns an error if the mapped memory doesn't hold a valid
+  // history.
+  static Option<Error> validate(const Header* header, size_t length);
+
+  UsageHistory(const UsageHistory&);
+  UsageHistory& operator = (const UsageHistory&);
+
+  // Returns the value of the column for the i-th oldest sample.
+  double value(size_t column, size_t i) const;
+
+  // Returns the index of the oldest sample with a timestamp of at
+  // least 'timestamp'.
+  size_t lowerBound(double timestamp) const;
+
+  // Returns the sample with the given column values.
+  ResourceStatistics sample(const std::vector<double>& values) const;
+
+  const std::string _path;
+  const int fd;
+  void* const memory;
+  const size_t length;
+  const bool writable;
+
+  Header* header;
+  double* columns;
+
+  // The column holding the timestamps.
+  size_t timestamps;
+};
+
+} // namespace slave {
+} // namespace internal {
+} // namespace mesos {
+
+#endif // __SLAVE_USAGE_HISTORY_HPP__
@@ -22,6 +22,8 @@
 #include <stout/hashmap.hpp>
 #include <stout/nothing.hpp>
 #include <stout/option.hpp>
+#include <stout/os.hpp>
+#include <stout/protobuf.hpp>
 #include <stout/svn.hpp>
 #include <stout/uuid.hpp>
 
@@ -41,6 +43,11 @@ namespace mesos {
 namespace internal {
 namespace state {
 
+// Number of operations (i.e., applied log entries, sets and expunges)
+// after which the local checkpoint (if any) gets rewritten.
+const size_t CHECKPOINT_INTERVAL = 16;
+
+
 // A storage implementation for State that uses the replicated
 // log. The log is made up of appended operations. Each state entry is
 // mapped to a log "snapshot".
@@ -57,10 +64,21 @@ namespace state {
 // read/modify/write. An alternative strategy might be to retry after
 // restarting via 'start' (and holding on to the mutex so no other
 // operations are attempted).
+//
+// If a 'checkpoint' path is provided the cached entries are also
+// periodically written to that (local) path together with the
+// position in the log they reflect. The first 'start()' then loads
+// the checkpoint and only reads the log past that position rather
+// than from the beginning of the log. A checkpoint that is missing,
+// unreadable or stale (i.e., the log has been truncated past it) is
+// ignored and the whole log is read instead.
 class LogStorageProcess : public Process<LogStorageProcess>
 {
 public:
-  LogStorageProcess(Log* log, size_t diffsBetweenSnapshots);
+  LogStorageProcess(
+      Log* log,
+      size_t diffsBetweenSnapshots,
+      const Option<string>& checkpoint);
 
   virtual ~LogStorageProcess();
 
@@ -83,6 +101,10 @@ private:
   // Helper for applying log entries.
   Future<Nothing> apply(const list<Log::Entry>& entries);
 
+  // Helpers for loading and (periodically) writing the checkpoint.
+  bool recover(const Log::Position& beginning, const Log::Position& position);
+  void checkpoint(bool force = false);
+
   // Helper for performing truncation.
   void truncate();
   Future<Nothing> _truncate();
@@ -108,12 +130,26 @@ private:
 
   Future<std::set<string> > _names();
 
+  Log* log;
+
   Log::Reader reader;
   Log::Writer writer;
 
   const size_t diffsBetweenSnapshots;
 
+  // Local path of the checkpoint, if any.
+  const Option<string> path;
+
+  // Number of operations since the checkpoint was last written.
+  size_t operations;
+
   // Used to serialize Log::Writer::append/truncate operations.
+  //
+  // NOTE: The writer is deliberately left with a window of a single
+  // write. Each DIFF is computed against the snapshot left by the
+  // previous operation (which is only known once its append
+  // completes), and the registrar never has more than one store in
+  // flight anyway, so a larger window wouldn't help here.
   Mutex mutex;
 
   // Whether or not we've started the ability to append to log.
@@ -198,10 +234,16 @@ private:
 };
 
 
-LogStorageProcess::LogStorageProcess(Log* log, size_t diffsBetweenSnapshots)
-  : reader(log),
-    writer(log),
-    diffsBetweenSnapshots(diffsBetweenSnapshots) {}
+LogStorageProcess::LogStorageProcess(
+    Log* _log,
+    size_t _diffsBetweenSnapshots,
+    const Option<string>& checkpoint)
+  : log(_log),
+    reader(_log),
+    writer(_log),
+    diffsBetweenSnapshots(_diffsBetweenSnapshots),
+    path(checkpoint),
+    operations(0) {}
 
 
 LogStorageProcess::~LogStorageProcess() {}
@@ -212,6 +254,10 @@ void LogStorageProcess::finalize()
   if (starting.isSome()) {
     Future<Nothing>(starting.get()).discard();
   }
+
+  // Don't lose the operations since the last checkpoint on a
+  // graceful shutdown.
+  checkpoint(true);
 }
 
 
@@ -277,11 +323,131 @@ Future<Nothing> LogStorageProcess::__start(
 
   truncated = beginning; // Cache for future truncations.
 
+  // Try and skip everything up to the checkpoint's position.
+  if (recover(beginning, position)) {
+    return reader.read(index.get(), position)
+      .then(defer(self(), &Self::apply, lambda::_1));
+  }
+
   return reader.read(beginning, position)
     .then(defer(self(), &Self::apply, lambda::_1));
 }
 
 
+bool LogStorageProcess::recover(
+    const Log::Position& beginning,
+    const Log::Position& position)
+{
+  if (path.isNone() || !os::exists(path.get())) {
+    return false;
+  }
+
+  Result<Checkpoint> checkpoint = ::protobuf::read<Checkpoint>(path.get());
+
+  if (!checkpoint.isSome()) {
+    LOG(WARNING) << "Ignoring checkpoint at '" << path.get() << "': "
+                 << (checkpoint.isError() ? checkpoint.error() : "empty");
+    return false;
+  }
+
+  if (checkpoint.get().position().size() != 8 ||
+      checkpoint.get().truncated().size() != 8) {
+    LOG(WARNING) << "Ignoring checkpoint at '" << path.get()
+                 << "': Malformed position";
+    return false;
+  }
+
+  const Log::Position checkpointed =
+    log->position(checkpoint.get().position());
+
+  // We can only skip to the checkpoint if every entry past it is
+  // still in the log (i.e., an expunge might have been truncated
+  // otherwise) and if the checkpoint isn't ahead of the log, e.g.,
+  // because the replica was wiped.
+  if (checkpointed < beginning || position < checkpointed) {
+    LOG(WARNING) << "Ignoring stale checkpoint at '" << path.get() << "'";
+    return false;
+  }
+
+  CHECK(snapshots.empty());
+
+  foreach (const Checkpoint::Snapshot& snapshot,
+           checkpoint.get().snapshots()) {
+    if (snapshot.position().size() != 8) {
+      LOG(WARNING) << "Ignoring checkpoint at '" << path.get()
+                   << "': Malformed snapshot position";
+      snapshots.clear();
+      return false;
+    }
+
+    snapshots.put(
+        snapshot.entry().name(),
+        Snapshot(log->position(snapshot.position()),
+                 snapshot.entry(),
+                 snapshot.diffs()));
+  }
+
+  index = checkpointed;
+
+  // Note that 'truncated' was already set to 'beginning'.
+  truncated = max(truncated, log->position(checkpoint.get().truncated()));
+
+  LOG(INFO) << "Recovered " << snapshots.size() << " entries from the"
+            << " checkpoint at '" << path.get() << "' at position "
+            << index.get().identity();
+
+  return true;
+}
+
+
+void LogStorageProcess::checkpoint(bool force)
+{
+  if (path.isNone() || index.isNone() || truncated.isNone()) {
+    return;
+  }
+
+  if (operations == 0 || (!force && operations < CHECKPOINT_INTERVAL)) {
+    return;
+  }
+
+  Checkpoint checkpoint;
+  checkpoint.set_position(index.get().identity());
+  checkpoint.set_truncated(truncated.get().identity());
+
+  foreachvalue (const Snapshot& snapshot, snapshots) {
+    Checkpoint::Snapshot* _snapshot = checkpoint.add_snapshots();
+    _snapshot->set_position(snapshot.position.identity());
+    _snapshot->mutable_entry()->CopyFrom(snapshot.entry);
+    _snapshot->set_diffs(snapshot.diffs);
+  }
+
+  // Write to a temporary file first and then rename it so that we
+  // never leave a partially written checkpoint behind.
+  const string temporary = path.get() + ".tmp";
+
+  Try<Nothing> write = ::protobuf::write(temporary, checkpoint);
+
+  if (write.isError()) {
+    LOG(WARNING) << "Failed to write checkpoint to '" << temporary << "': "
+                 << write.error();
+    return;
+  }
+
+  Try<Nothing> rename = os::rename(temporary, path.get());
+
+  if (rename.isError()) {
+    LOG(WARNING) << "Failed to rename checkpoint '" << temporary << "' to '"
+                 << path.get() << "': " << rename.error();
+    return;
+  }
+
+  VLOG(2) << "Checkpointed " << snapshots.size() << " entries at position "
+          << index.get().identity();
+
+  operations = 0;
+}
+
+
 Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
 {
   VLOG(2) << "Applying operations (" << entries.size() << " entries)";
@@ -340,9 +506,12 @@ Future<Nothing> LogStorageProcess::apply(const list<Log::Entry>& entries)
       }
 
       index = entry.position;
+      operations++;
     }
   }
 
+  checkpoint();
+
   return Nothing();
 }
 
@@ -550,6 +719,9 @@ Future<bool> LogStorageProcess::___set(
   Snapshot snapshot(position.get(), entry, diffs);
   snapshots.put(snapshot.entry.name(), snapshot);
 
+  operations++;
+  checkpoint();
+
   // And truncate the log if necessary.
   truncate();
 
@@ -613,6 +785,14 @@ Future<bool> LogStorageProcess::___expunge(
   // Remove from snapshots and truncate the log if possible.
   CHECK(snapshots.contains(entry.name()));
   snapshots.erase(entry.name());
+
+  // Update index so we don't bother reading anything before this
+  // position again (if we don't have to).
+  index = max(index, position);
+
+  operations++;
+  checkpoint();
+
   truncate();
 
   return true;
@@ -633,9 +813,12 @@ Future<std::set<string> > LogStorageProcess::_names()
 }
 
 
-LogStorage::LogStorage(Log* log, size_t diffsBetweenSnapshots)
+LogStorage::LogStorage(
+    Log* log,
+    size_t diffsBetweenSnapshots,
+    const Option<string>& checkpoint)
 {
-  process = new LogStorageProcess(log, diffsBetweenSnapshots);
+  process = new LogStorageProcess(log, diffsBetweenSnapshots, checkpoint);
   spawn(process);
 }
 
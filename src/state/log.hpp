@@ -26,7 +26,13 @@ class LogStorageProcess;
 class LogStorage : public Storage
 {
 public:
-  LogStorage(log::Log* log, size_t diffsBetweenSnapshots = 0);
+  // If 'checkpoint' is specified the storage periodically writes the
+  // materialized entries to that local path and recovers from it
+  // rather than reading the entire log (see LogStorageProcess).
+  LogStorage(
+      log::Log* log,
+      size_t diffsBetweenSnapshots = 0,
+      const Option<std::string>& checkpoint = None());
 
   virtual ~LogStorage();
 
@@ -24,8 +24,10 @@
 #include <string.h>
 #include <unistd.h>
 
+#include <iostream>
 #include <set>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <sys/mman.h>
@@ -45,6 +47,7 @@
 #include <stout/os.hpp>
 #include <stout/path.hpp>
 #include <stout/proc.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 #include <stout/strings.hpp>
 
@@ -523,6 +526,118 @@ TEST_F(CgroupsAnyHierarchyWithCpuAcctMemoryTest, ROOT_CGROUPS_Stat)
 }
 
 
+TEST_F(CgroupsAnyHierarchyWithCpuAcctMemoryTest, ROOT_CGROUPS_Handle)
+{
+  std::string hierarchy = path::join(baseHierarchy, "memory");
+  ASSERT_SOME(cgroups::create(hierarchy, TEST_CGROUPS_ROOT));
+
+  cgroups::Handle handle(hierarchy, TEST_CGROUPS_ROOT);
+
+  EXPECT_ERROR(handle.read("invalid"));
+
+  // Write several controls at once.
+  std::vector<std::pair<std::string, std::string> > values;
+  values.push_back(std::make_pair("memory.limit_in_bytes", "134217728"));
+  values.push_back(std::make_pair("memory.soft_limit_in_bytes", "67108864"));
+  ASSERT_SOME(handle.write(values));
+
+  // Reading the same control file again (from the kept open file)
+  // returns the current value.
+  Try<std::string> read = handle.read("memory.limit_in_bytes");
+  ASSERT_SOME(read);
+  EXPECT_EQ("134217728", strings::trim(read.get()));
+
+  // Writing the same control file again (to the kept open file).
+  ASSERT_SOME(handle.write("memory.limit_in_bytes", "268435456"));
+
+  read = handle.read("memory.limit_in_bytes");
+  ASSERT_SOME(read);
+  EXPECT_EQ("268435456", strings::trim(read.get()));
+
+  // A failed write doesn't affect the subsequent ones.
+  EXPECT_ERROR(handle.write("memory.limit_in_bytes", "invalid"));
+  ASSERT_SOME(handle.write("memory.limit_in_bytes", "134217728"));
+
+  read = handle.read("memory.limit_in_bytes");
+  ASSERT_SOME(read);
+  EXPECT_EQ("134217728", strings::trim(read.get()));
+
+  Try<hashmap<std::string, uint64_t> > stat = handle.stat("memory.stat");
+  ASSERT_SOME(stat);
+  EXPECT_TRUE(stat.get().contains("rss"));
+
+  handle.close();
+
+  AWAIT_READY(cgroups::destroy(hierarchy, TEST_CGROUPS_ROOT));
+}
+
+
+// Compares the cost of reading the statistics used by the cgroups
+// isolators' usage() for a number of containers, by reading the
+// control files through cgroups::read/stat versus cgroups::Handle.
+TEST_F(CgroupsAnyHierarchyWithCpuAcctMemoryTest, ROOT_CGROUPS_BENCHMARK_Usage)
+{
+  const size_t containers = 100;
+  const size_t rounds = 10;
+
+  const std::string cpuacct = path::join(baseHierarchy, "cpuacct");
+  const std::string memory = path::join(baseHierarchy, "memory");
+
+  ASSERT_SOME(cgroups::create(cpuacct, TEST_CGROUPS_ROOT));
+  ASSERT_SOME(cgroups::create(memory, TEST_CGROUPS_ROOT));
+
+  std::vector<std::string> cgroups;
+  for (size_t i = 0; i < containers; i++) {
+    const std::string cgroup = path::join(TEST_CGROUPS_ROOT, stringify(i));
+    ASSERT_SOME(cgroups::create(cpuacct, cgroup));
+    ASSERT_SOME(cgroups::create(memory, cgroup));
+    cgroups.push_back(cgroup);
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  for (size_t round = 0; round < rounds; round++) {
+    foreach (const std::string& cgroup, cgroups) {
+      ASSERT_SOME(cgroups::stat(cpuacct, cgroup, "cpuacct.stat"));
+      ASSERT_SOME(cgroups::memory::usage_in_bytes(memory, cgroup));
+      ASSERT_SOME(cgroups::stat(memory, cgroup, "memory.stat"));
+    }
+  }
+
+  std::cout << "Reading the usage through cgroups::read took "
+            << watch.elapsed() / (rounds * containers)
+            << " per container" << std::endl;
+
+  std::vector<Owned<cgroups::Handle> > handles;
+  foreach (const std::string& cgroup, cgroups) {
+    handles.push_back(Owned<cgroups::Handle>(
+        new cgroups::Handle(cpuacct, cgroup)));
+    handles.push_back(Owned<cgroups::Handle>(
+        new cgroups::Handle(memory, cgroup)));
+  }
+
+  watch.start();
+
+  for (size_t round = 0; round < rounds; round++) {
+    for (size_t i = 0; i < handles.size(); i += 2) {
+      ASSERT_SOME(handles[i]->stat("cpuacct.stat"));
+      ASSERT_SOME(handles[i + 1]->read("memory.usage_in_bytes"));
+      ASSERT_SOME(handles[i + 1]->stat("memory.stat"));
+    }
+  }
+
+  std::cout << "Reading the usage through cgroups::Handle took "
+            << watch.elapsed() / (rounds * containers)
+            << " per container" << std::endl;
+
+  handles.clear();
+
+  AWAIT_READY(cgroups::destroy(cpuacct, TEST_CGROUPS_ROOT));
+  AWAIT_READY(cgroups::destroy(memory, TEST_CGROUPS_ROOT));
+}
+
+
 TEST_F(CgroupsAnyHierarchyWithCpuMemoryTest, ROOT_CGROUPS_Listen)
 {
   std::string hierarchy = path::join(baseHierarchy, "memory");
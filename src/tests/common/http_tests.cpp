@@ -16,14 +16,22 @@
  * limitations under the License.
  */
 
+#include <unistd.h>
+
 #include <gtest/gtest.h>
 
+#include <string>
 #include <vector>
 
 #include <mesos/mesos.hpp>
+#include <mesos/resources.hpp>
 
+#include <stout/bytes.hpp>
 #include <stout/gtest.hpp>
 #include <stout/json.hpp>
+#include <stout/jsonify.hpp>
+#include <stout/os.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/stringify.hpp>
 
 #include "common/http.hpp"
@@ -31,6 +39,7 @@
 
 #include "messages/messages.hpp"
 
+using std::string;
 using std::vector;
 
 using namespace mesos;
@@ -112,3 +121,160 @@ TEST(HTTP, ModelTask)
   // Ensure both are modeled the same.
   EXPECT_EQ(object, object_);
 }
+
+
+// This test ensures that writing the JSON of a task produces the
+// same JSON as its model, for both 'Task' and 'TaskInfo'.
+TEST(HTTP, JsonTask)
+{
+  TaskID taskId;
+  taskId.set_value("t");
+
+  SlaveID slaveId;
+  slaveId.set_value("s");
+
+  FrameworkID frameworkId;
+  frameworkId.set_value("f");
+
+  TaskState state = TASK_RUNNING;
+
+  TaskStatus status;
+  status.mutable_task_id()->CopyFrom(taskId);
+  status.set_state(state);
+  status.mutable_slave_id()->CopyFrom(slaveId);
+  status.set_timestamp(1.5);
+
+  vector<TaskStatus> statuses;
+  statuses.push_back(status);
+
+  TaskInfo task;
+  task.set_name("task \"quoted\"");
+  task.mutable_task_id()->CopyFrom(taskId);
+  task.mutable_slave_id()->CopyFrom(slaveId);
+  task.mutable_command()->set_value("echo hello");
+  task.mutable_resources()->CopyFrom(
+      Resources::parse("cpus:1;mem:64;ports:[31000-31001];cpus(r):2").get());
+
+  Label* label = task.mutable_labels()->add_labels();
+  label->set_key("key");
+  label->set_value("value");
+
+  task.mutable_discovery()->set_visibility(DiscoveryInfo::FRAMEWORK);
+  task.mutable_discovery()->set_name("discovery");
+
+  Task task_ = protobuf::createTask(task, state, frameworkId);
+  task_.add_statuses()->CopyFrom(status);
+
+  Try<JSON::Value> json = JSON::parse(
+      JSON::jsonify([&](JSON::ObjectWriter* writer) {
+        mesos::internal::json(writer, task, frameworkId, state, statuses);
+      }));
+
+  Try<JSON::Value> json_ = JSON::parse(
+      JSON::jsonify([&](JSON::ObjectWriter* writer) {
+        mesos::internal::json(writer, task_);
+      }));
+
+  ASSERT_SOME(json);
+  ASSERT_SOME(json_);
+
+  EXPECT_EQ(JSON::Value(model(task, frameworkId, state, statuses)),
+            json.get());
+  EXPECT_EQ(JSON::Value(model(task_)), json_.get());
+}
+
+
+// Returns the resident set size of this process.
+static Bytes rss()
+{
+  Result<os::Process> process = os::process(getpid());
+  return process.isSome() && process.get().rss.isSome()
+    ? process.get().rss.get()
+    : Bytes(0);
+}
+
+
+// Compares writing the JSON of many tasks directly against building
+// (and then stringifying) their JSON models. The memory is measured
+// as the growth of the resident set size, hence it's approximate.
+TEST(HTTP_BENCHMARK_Test, JsonTasks)
+{
+  const size_t taskCount = 100000;
+
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework");
+
+  vector<Task> tasks;
+  tasks.reserve(taskCount);
+
+  for (size_t i = 0; i < taskCount; i++) {
+    TaskInfo info;
+    info.set_name("task-" + stringify(i));
+    info.mutable_task_id()->set_value(stringify(i));
+    info.mutable_slave_id()->set_value("slave-" + stringify(i % 1000));
+    info.mutable_resources()->CopyFrom(
+        Resources::parse("cpus:0.1;mem:32").get());
+
+    Task task = protobuf::createTask(info, TASK_RUNNING, frameworkId);
+
+    TaskStatus* status = task.add_statuses();
+    status->mutable_task_id()->CopyFrom(info.task_id());
+    status->set_state(TASK_RUNNING);
+    status->set_timestamp(i);
+
+    tasks.push_back(task);
+  }
+
+  // NOTE: We measure the writer first, so that the memory the model
+  // frees afterwards can't be reused.
+  Bytes before = rss();
+
+  Stopwatch watch;
+  watch.start();
+
+  string written = JSON::jsonify([&](JSON::ObjectWriter* writer) {
+    writer->field("tasks", [&](JSON::ArrayWriter* writer) {
+      foreach (const Task& task, tasks) {
+        writer->element([&](JSON::ObjectWriter* writer) {
+          mesos::internal::json(writer, task);
+        });
+      }
+    });
+  });
+
+  Duration elapsed = watch.elapsed();
+  Bytes after = rss();
+
+  LOG(INFO) << "Wrote the JSON of " << taskCount << " tasks in " << elapsed
+            << " using " << (after > before ? after - before : Bytes(0));
+
+  before = rss();
+
+  watch.start();
+
+  string stringified;
+
+  {
+    JSON::Object object;
+    JSON::Array array;
+    array.values.reserve(tasks.size());
+
+    foreach (const Task& task, tasks) {
+      array.values.push_back(model(task));
+    }
+
+    object.values["tasks"] = std::move(array);
+
+    stringified = stringify(object);
+
+    after = rss();
+  }
+
+  elapsed = watch.elapsed();
+
+  LOG(INFO) << "Modeled and stringified " << taskCount << " tasks in "
+            << elapsed << " using "
+            << (after > before ? after - before : Bytes(0));
+
+  EXPECT_EQ(JSON::parse(stringified).get(), JSON::parse(written).get());
+}
@@ -16,6 +16,12 @@
  * limitations under the License.
  */
 
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/time.h>
+
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -31,6 +37,8 @@
 #include <stout/gtest.hpp>
 #include <stout/os.hpp>
 #include <stout/path.hpp>
+#include <stout/stopwatch.hpp>
+#include <stout/stringify.hpp>
 
 #include "master/master.hpp"
 
@@ -54,10 +62,12 @@ using std::vector;
 
 using testing::_;
 using testing::Return;
+using testing::WithParamInterface;
 
 using mesos::internal::master::Master;
 
 using mesos::internal::slave::DiskUsageCollector;
+using mesos::internal::slave::DiskUsageScanner;
 using mesos::internal::slave::Fetcher;
 using mesos::internal::slave::MesosContainerizer;
 using mesos::internal::slave::Slave;
@@ -143,6 +153,175 @@ TEST_F(DiskUsageCollectorTest, SymbolicLink)
 }
 
 
+// This test verifies that hard links are only counted once.
+TEST_F(DiskUsageCollectorTest, HardLink)
+{
+  string file = path::join(os::getcwd(), "file");
+  ASSERT_SOME(os::write(file, string(Kilobytes(64).bytes(), 'x')));
+
+  string link = path::join(os::getcwd(), "link");
+  ASSERT_EQ(0, ::link(file.c_str(), link.c_str()));
+
+  DiskUsageCollector collector(Milliseconds(1));
+
+  Future<Bytes> usage = collector.usage(os::getcwd());
+
+  AWAIT_READY(usage);
+  EXPECT_GE(usage.get(), Kilobytes(64));
+  EXPECT_LT(usage.get(), Kilobytes(128));
+}
+
+
+// Sets the access and modification times of 'path' to 'time'.
+static void backdate(const string& path, time_t time)
+{
+  struct timeval times[2];
+  times[0].tv_sec = times[1].tv_sec = time;
+  times[0].tv_usec = times[1].tv_usec = 0;
+
+  ASSERT_EQ(0, ::utimes(path.c_str(), times))
+    << "Failed to set the times of '" << path << "'";
+}
+
+
+// This test verifies that a scanner reuses the listing of a directory
+// that hasn't been modified since it was listed, and that it picks up
+// the changes to the directories it has already listed.
+TEST_F(DiskUsageCollectorTest, Rescan)
+{
+  string dir = path::join(os::getcwd(), "dir");
+  string file1 = path::join(dir, "file1");
+  string file2 = path::join(dir, "file2");
+
+  ASSERT_SOME(os::mkdir(dir));
+  ASSERT_SOME(os::write(file1, string(Kilobytes(8).bytes(), 'x')));
+
+  // The listing of a directory is only reused if the directory was
+  // modified before the second in which it got listed, so we move
+  // its modification time into the past.
+  const time_t past = ::time(NULL) - 60;
+  backdate(dir, past);
+
+  DiskUsageScanner scanner(os::getcwd());
+
+  Try<Bytes> usage1 = scanner.scan();
+  ASSERT_SOME(usage1);
+  EXPECT_GE(usage1.get(), Kilobytes(8));
+  EXPECT_LT(usage1.get(), Kilobytes(64));
+
+  // Grow the existing file, which is picked up even though the
+  // listing of the directory is reused.
+  ASSERT_SOME(os::write(file1, string(Kilobytes(64).bytes(), 'x')));
+
+  Try<Bytes> usage2 = scanner.scan();
+  ASSERT_SOME(usage2);
+  EXPECT_GE(usage2.get(), Kilobytes(64));
+  EXPECT_LT(usage2.get(), Kilobytes(128));
+
+  // Add a new file, but restore the modification time of the
+  // directory: the scanner still reuses the listing of the directory
+  // and hence doesn't see the new file.
+  ASSERT_SOME(os::write(file2, string(Kilobytes(64).bytes(), 'y')));
+  backdate(dir, past);
+
+  Try<Bytes> usage3 = scanner.scan();
+  ASSERT_SOME(usage3);
+  EXPECT_LT(usage3.get(), Kilobytes(128));
+
+  // A different modification time invalidates the listing.
+  backdate(dir, past - 60);
+
+  Try<Bytes> usage4 = scanner.scan();
+  ASSERT_SOME(usage4);
+  EXPECT_GE(usage4.get(), Kilobytes(128));
+
+  // Remove the directory altogether.
+  ASSERT_SOME(os::rmdir(dir));
+
+  Try<Bytes> usage5 = scanner.scan();
+  ASSERT_SOME(usage5);
+  EXPECT_LT(usage5.get(), Kilobytes(8));
+}
+
+
+class DiskUsageScanner_BENCHMARK_Test
+  : public TemporaryDirectoryTest,
+    public WithParamInterface<size_t> {};
+
+
+// The benchmark is parameterized by the number of files in each of
+// the (synthetic) sandboxes.
+INSTANTIATE_TEST_CASE_P(
+    FilesPerSandbox,
+    DiskUsageScanner_BENCHMARK_Test,
+    ::testing::Values(10U, 100U, 1000U));
+
+
+// Compares scanning sandboxes (initially and once their directory
+// listings are cached) against running 'du' for each of them.
+TEST_P(DiskUsageScanner_BENCHMARK_Test, Sandboxes)
+{
+  const size_t sandboxCount = 100;
+  const size_t fileCount = GetParam();
+
+  vector<string> sandboxes;
+
+  for (size_t i = 0; i < sandboxCount; i++) {
+    const string sandbox = path::join(os::getcwd(), stringify(i));
+
+    for (size_t j = 0; j < fileCount; j++) {
+      // Spread the files over a few levels of directories.
+      const string directory =
+        path::join(sandbox, stringify(j % 10), stringify(j % 100));
+
+      ASSERT_SOME(os::mkdir(directory));
+      ASSERT_SOME(os::write(path::join(directory, stringify(j)), "data"));
+    }
+
+    sandboxes.push_back(sandbox);
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  foreach (const string& sandbox, sandboxes) {
+    std::ostringstream output;
+    Try<int> du = os::shell(&output, "du -k -s %s", sandbox.c_str());
+    ASSERT_SOME_EQ(0, du);
+  }
+
+  LOG(INFO) << "Took " << watch.elapsed() << " to run 'du' for "
+            << sandboxCount << " sandboxes with " << fileCount << " files";
+
+  vector<DiskUsageScanner*> scanners;
+  foreach (const string& sandbox, sandboxes) {
+    scanners.push_back(new DiskUsageScanner(sandbox));
+  }
+
+  watch.start();
+
+  foreach (DiskUsageScanner* scanner, scanners) {
+    ASSERT_SOME(scanner->scan());
+  }
+
+  LOG(INFO) << "Took " << watch.elapsed() << " to scan "
+            << sandboxCount << " sandboxes with " << fileCount << " files";
+
+  watch.start();
+
+  foreach (DiskUsageScanner* scanner, scanners) {
+    ASSERT_SOME(scanner->scan());
+  }
+
+  LOG(INFO) << "Took " << watch.elapsed() << " to rescan "
+            << sandboxCount << " sandboxes with " << fileCount << " files";
+
+  foreach (DiskUsageScanner* scanner, scanners) {
+    delete scanner;
+  }
+}
+
+
 class DiskQuotaTest : public MesosTest {};
 
 
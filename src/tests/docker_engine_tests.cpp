@@ -0,0 +1,564 @@
+/**
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+
+#include <gtest/gtest.h>
+
+#include <process/defer.hpp>
+#include <process/dispatch.hpp>
+#include <process/future.hpp>
+#include <process/gmock.hpp>
+#include <process/gtest.hpp>
+#include <process/io.hpp>
+#include <process/network.hpp>
+#include <process/owned.hpp>
+#include <process/process.hpp>
+#include <process/socket.hpp>
+
+#include <stout/duration.hpp>
+#include <stout/foreach.hpp>
+#include <stout/format.hpp>
+#include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
+#include <stout/json.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
+#include <stout/stringify.hpp>
+#include <stout/strings.hpp>
+
+#include "docker/engine.hpp"
+
+#include "tests/utils.hpp"
+
+using namespace process;
+
+using process::network::Socket;
+
+using std::list;
+using std::string;
+using std::vector;
+
+using testing::_;
+
+namespace mesos {
+namespace internal {
+namespace tests {
+
+
+// A fake Docker daemon that serves the parts of the remote API used
+// by DockerEngine on a unix socket, for containers that are added by
+// the test. It counts the requests and connections it gets.
+class FakeDockerDaemon : public Process<FakeDockerDaemon>
+{
+public:
+  // NOTE: The daemon listens right away, so that clients can connect
+  // even before it has been spawned.
+  explicit FakeDockerDaemon(const string& _path)
+    : path(_path), accepted(0)
+  {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+    Try<int> socket = network::socket(AF_UNIX, SOCK_STREAM, 0);
+    CHECK_SOME(socket);
+
+    s = socket.get();
+
+    CHECK_SOME(os::nonblock(s));
+    CHECK_EQ(0, ::bind(s, (struct sockaddr*) &address, sizeof(address)));
+    CHECK_EQ(0, ::listen(s, 16));
+  }
+
+  void add(const string& id, const string& name, pid_t pid)
+  {
+    containers.put(id, Container(name, pid));
+  }
+
+  // Simulates the container exiting on its own.
+  void die(const string& id)
+  {
+    CHECK(containers.contains(id));
+    containers[id].pid = 0;
+    event("die", id);
+  }
+
+  // Returns the number of requests for 'METHOD TARGET'.
+  size_t requests(const string& request)
+  {
+    return counts.contains(request) ? counts[request] : 0;
+  }
+
+  size_t connections()
+  {
+    return accepted;
+  }
+
+protected:
+  virtual void initialize()
+  {
+    accept();
+  }
+
+  virtual void finalize()
+  {
+    if (polling.isSome()) {
+      Future<short> future = polling.get();
+      future.discard();
+    }
+
+    os::close(s);
+    os::rm(path);
+
+    // Let the clients see that the connections are closed.
+    foreach (const Socket& socket, sockets) {
+      ::shutdown(socket.get(), SHUT_RDWR);
+    }
+  }
+
+private:
+  struct Container
+  {
+    Container() : pid(0) {}
+    Container(const string& _name, pid_t _pid) : name(_name), pid(_pid) {}
+
+    string name;
+    pid_t pid;
+  };
+
+  void accept()
+  {
+    polling = io::poll(s, io::READ);
+    polling.get().onReady(defer(self(), &Self::_accept));
+  }
+
+  void _accept()
+  {
+    int fd = ::accept(s, NULL, NULL);
+    CHECK_GE(fd, 0);
+    CHECK_SOME(os::nonblock(fd));
+
+    Try<Socket> socket = Socket::create(Socket::DEFAULT_KIND(), fd);
+    CHECK_SOME(socket);
+
+    accepted++;
+    sockets.push_back(socket.get());
+
+    receive(socket.get(), Owned<string>(new string()));
+    accept();
+  }
+
+  void receive(Socket socket, const Owned<string>& buffer)
+  {
+    socket.recv(None())
+      .onReady(defer(self(), &Self::_receive, socket, buffer, lambda::_1));
+  }
+
+  // NOTE: None of the requests have a body.
+  void _receive(
+      Socket socket,
+      const Owned<string>& buffer,
+      const string& data)
+  {
+    if (data.empty()) {
+      return;
+    }
+
+    buffer->append(data);
+
+    size_t end;
+    while ((end = buffer->find("\r\n\r\n")) != string::npos) {
+      vector<string> line =
+        strings::tokenize(buffer->substr(0, buffer->find("\r\n")), " ");
+      buffer->erase(0, end + 4);
+
+      CHECK_EQ(3u, line.size());
+
+      const string request = line[0] + " " + line[1];
+      counts[request]++;
+
+      handle(socket, line[0], line[1]);
+    }
+
+    receive(socket, buffer);
+  }
+
+  void handle(Socket socket, const string& method, const string& target)
+  {
+    vector<string> parts = strings::split(target, "?");
+    const string query = parts.size() > 1 ? parts[1] : "";
+
+    vector<string> tokens = strings::tokenize(parts[0], "/");
+
+    if (method == "GET" && target == "/version") {
+      JSON::Object version;
+      version.values["Version"] = "1.6.0";
+      respond(socket, "200 OK", stringify(version));
+    } else if (method == "GET" && target == "/events") {
+      socket.send("HTTP/1.1 200 OK\r\n"
+                  "Content-Type: application/json\r\n"
+                  "Transfer-Encoding: chunked\r\n"
+                  "\r\n");
+      subscribers.push_back(socket);
+    } else if (method == "GET" && parts[0] == "/containers/json") {
+      JSON::Array array;
+      foreachpair (const string& id, const Container& container, containers) {
+        if (container.pid != 0 || query == "all=1") {
+          JSON::Object object;
+          object.values["Id"] = id;
+          JSON::Array names;
+          names.values.push_back("/" + container.name);
+          object.values["Names"] = names;
+          array.values.push_back(object);
+        }
+      }
+      respond(socket, "200 OK", stringify(array));
+    } else if (tokens.size() < 2 || tokens[0] != "containers") {
+      respond(socket, "404 Not Found", "page not found");
+    } else if (lookup(tokens[1]).isNone()) {
+      respond(socket, "404 Not Found", "No such container: " + tokens[1]);
+    } else {
+      const string id = lookup(tokens[1]).get();
+      Container& container = containers[id];
+
+      if (method == "GET" && tokens.size() == 3 && tokens[2] == "json") {
+        JSON::Object state;
+        state.values["Pid"] = container.pid;
+        JSON::Object object;
+        object.values["Id"] = id;
+        object.values["Name"] = "/" + container.name;
+        object.values["State"] = state;
+        respond(socket, "200 OK", stringify(object));
+      } else if (method == "POST" &&
+                 tokens.size() == 3 &&
+                 tokens[2] == "stop") {
+        if (container.pid == 0) {
+          respond(socket, "304 Not Modified", "");
+        } else {
+          container.pid = 0;
+          event("die", id);
+          respond(socket, "204 No Content", "");
+        }
+      } else if (method == "DELETE" && tokens.size() == 2) {
+        if (container.pid != 0 && query != "force=1") {
+          respond(socket, "409 Conflict", "Container is running");
+        } else {
+          containers.erase(id);
+          event("destroy", id);
+          respond(socket, "204 No Content", "");
+        }
+      } else {
+        respond(socket, "404 Not Found", "page not found");
+      }
+    }
+  }
+
+  void respond(Socket socket, const string& status, const string& body)
+  {
+    socket.send("HTTP/1.1 " + status + "\r\n"
+                "Content-Length: " + stringify(body.size()) + "\r\n"
+                "\r\n" + body);
+  }
+
+  void event(const string& status, const string& id)
+  {
+    JSON::Object object;
+    object.values["status"] = status;
+    object.values["id"] = id;
+
+    const string data = stringify(object) + "\n";
+
+    foreach (Socket socket, subscribers) {
+      socket.send(strings::format("%zx\r\n", data.size()).get() +
+                  data + "\r\n");
+    }
+  }
+
+  Option<string> lookup(const string& container)
+  {
+    if (containers.contains(container)) {
+      return container;
+    }
+
+    foreachpair (const string& id, const Container& _container, containers) {
+      if (_container.name == container) {
+        return id;
+      }
+    }
+
+    return None();
+  }
+
+  const string path;
+  int s;
+  Option<Future<short> > polling;
+
+  size_t accepted;
+  list<Socket> sockets;
+  hashmap<string, size_t> counts;
+
+  hashmap<string, Container> containers;
+
+  list<Socket> subscribers;
+};
+
+
+class DockerEngineTest : public TemporaryDirectoryTest
+{
+protected:
+  virtual void SetUp()
+  {
+    TemporaryDirectoryTest::SetUp();
+
+    socket = path::join(os::getcwd(), "docker.sock");
+
+    daemon = Owned<FakeDockerDaemon>(new FakeDockerDaemon(socket));
+    spawn(daemon.get());
+  }
+
+  virtual void TearDown()
+  {
+    terminate(daemon.get());
+    wait(daemon.get());
+
+    TemporaryDirectoryTest::TearDown();
+  }
+
+  Owned<Docker> create()
+  {
+    Try<Docker*> docker = DockerEngine::create("docker", socket, false);
+    CHECK_SOME(docker);
+    return Owned<Docker>(docker.get());
+  }
+
+  string socket;
+  Owned<FakeDockerDaemon> daemon;
+};
+
+
+// Tests that inspecting a running container goes to the daemon only
+// once and that requests reuse the same connection.
+TEST_F(DockerEngineTest, InspectCachesRunningContainers)
+{
+  dispatch(daemon.get(), &FakeDockerDaemon::add, "1234", "mesos-1", 42);
+  dispatch(daemon.get(), &FakeDockerDaemon::add, "5678", "mesos-2", 0);
+
+  // NOTE: Requests dispatched after '__subscribe' are handled once
+  // the engine is subscribed, i.e., once running containers get
+  // cached.
+  Future<Nothing> subscribed =
+    FUTURE_DISPATCH(_, &DockerEngineProcess::__subscribe);
+
+  Owned<Docker> docker = create();
+
+  AWAIT_READY(subscribed);
+
+  for (int i = 0; i < 2; i++) {
+    Future<Docker::Container> container = docker->inspect("mesos-1");
+    AWAIT_READY(container);
+    EXPECT_EQ("1234", container.get().id);
+    EXPECT_EQ("/mesos-1", container.get().name);
+    EXPECT_SOME_EQ(42, container.get().pid);
+
+    container = docker->inspect("mesos-2");
+    AWAIT_READY(container);
+    EXPECT_NONE(container.get().pid);
+  }
+
+  // The cached container is also found by its ID.
+  AWAIT_READY(docker->inspect("1234"));
+
+  AWAIT_EXPECT_EQ(
+      1u,
+      dispatch(daemon.get(),
+               &FakeDockerDaemon::requests,
+               "GET /containers/mesos-1/json"));
+
+  AWAIT_EXPECT_EQ(
+      0u,
+      dispatch(daemon.get(),
+               &FakeDockerDaemon::requests,
+               "GET /containers/1234/json"));
+
+  // Containers that aren't running are not cached.
+  AWAIT_EXPECT_EQ(
+      2u,
+      dispatch(daemon.get(),
+               &FakeDockerDaemon::requests,
+               "GET /containers/mesos-2/json"));
+
+  // One connection for the events and one for all other requests.
+  AWAIT_EXPECT_EQ(
+      2u,
+      dispatch(daemon.get(), &FakeDockerDaemon::connections));
+
+  AWAIT_FAILED(docker->inspect("mesos-3"));
+}
+
+
+// Tests that a cached container is dropped once the daemon reports
+// that it died.
+TEST_F(DockerEngineTest, EventsInvalidateCache)
+{
+  dispatch(daemon.get(), &FakeDockerDaemon::add, "1234", "mesos-1", 42);
+
+  Future<Nothing> subscribed =
+    FUTURE_DISPATCH(_, &DockerEngineProcess::__subscribe);
+
+  Owned<Docker> docker = create();
+
+  AWAIT_READY(subscribed);
+
+  Future<Docker::Container> container = docker->inspect("mesos-1");
+  AWAIT_READY(container);
+  EXPECT_SOME_EQ(42, container.get().pid);
+
+  Future<Nothing> _events = FUTURE_DISPATCH(_, &DockerEngineProcess::_events);
+
+  dispatch(daemon.get(), &FakeDockerDaemon::die, "1234");
+
+  // The inspect below is handled after the engine received the event.
+  AWAIT_READY(_events);
+
+  container = docker->inspect("mesos-1");
+  AWAIT_READY(container);
+  EXPECT_NONE(container.get().pid);
+
+  AWAIT_EXPECT_EQ(
+      2u,
+      dispatch(daemon.get(),
+               &FakeDockerDaemon::requests,
+               "GET /containers/mesos-1/json"));
+}
+
+
+TEST_F(DockerEngineTest, StopAndRemove)
+{
+  dispatch(daemon.get(), &FakeDockerDaemon::add, "1234", "mesos-1", 42);
+  dispatch(daemon.get(), &FakeDockerDaemon::add, "5678", "mesos-2", 43);
+
+  Future<Nothing> subscribed =
+    FUTURE_DISPATCH(_, &DockerEngineProcess::__subscribe);
+
+  Owned<Docker> docker = create();
+
+  AWAIT_READY(subscribed);
+
+  Future<Docker::Container> container = docker->inspect("mesos-1");
+  AWAIT_READY(container);
+  EXPECT_SOME_EQ(42, container.get().pid);
+
+  // Stopping the container removes it from the cache right away.
+  AWAIT_READY(docker->stop("mesos-1"));
+
+  container = docker->inspect("mesos-1");
+  AWAIT_READY(container);
+  EXPECT_NONE(container.get().pid);
+
+  // Stopping a stopped container succeeds.
+  AWAIT_READY(docker->stop("mesos-1"));
+
+  AWAIT_READY(docker->rm("mesos-1"));
+  AWAIT_FAILED(docker->inspect("mesos-1"));
+
+  // Removing a running container requires 'force'.
+  AWAIT_FAILED(docker->rm("mesos-2"));
+  AWAIT_READY(docker->rm("mesos-2", true));
+
+  // A failed stop is followed by a forced remove.
+  AWAIT_FAILED(docker->stop("mesos-2", Seconds(0), true));
+
+  AWAIT_EXPECT_EQ(
+      2u,
+      dispatch(daemon.get(),
+               &FakeDockerDaemon::requests,
+               "DELETE /containers/mesos-2?force=1"));
+}
+
+
+TEST_F(DockerEngineTest, Ps)
+{
+  dispatch(daemon.get(), &FakeDockerDaemon::add, "1234", "mesos-1", 42);
+  dispatch(daemon.get(), &FakeDockerDaemon::add, "5678", "mesos-2", 0);
+  dispatch(daemon.get(), &FakeDockerDaemon::add, "9012", "other", 43);
+
+  Owned<Docker> docker = create();
+
+  Future<list<Docker::Container> > containers = docker->ps(false, "mesos-");
+  AWAIT_READY(containers);
+  ASSERT_EQ(1u, containers.get().size());
+  EXPECT_EQ("1234", containers.get().front().id);
+  EXPECT_SOME_EQ(42, containers.get().front().pid);
+
+  containers = docker->ps(true, "mesos-");
+  AWAIT_READY(containers);
+  EXPECT_EQ(2u, containers.get().size());
+
+  containers = docker->ps(true);
+  AWAIT_READY(containers);
+  EXPECT_EQ(3u, containers.get().size());
+}
+
+
+// Tests that the engine keeps working after the daemon restarted,
+// i.e., after all its connections were closed.
+TEST_F(DockerEngineTest, DaemonRestart)
+{
+  dispatch(daemon.get(), &FakeDockerDaemon::add, "1234", "mesos-1", 42);
+
+  Future<Nothing> subscribed =
+    FUTURE_DISPATCH(_, &DockerEngineProcess::__subscribe);
+
+  Owned<Docker> docker = create();
+
+  AWAIT_READY(subscribed);
+  AWAIT_READY(docker->inspect("mesos-1"));
+
+  subscribed = FUTURE_DISPATCH(_, &DockerEngineProcess::__subscribe);
+
+  terminate(daemon.get());
+  wait(daemon.get());
+
+  daemon = Owned<FakeDockerDaemon>(new FakeDockerDaemon(socket));
+  spawn(daemon.get());
+
+  dispatch(daemon.get(), &FakeDockerDaemon::add, "1234", "mesos-1", 0);
+
+  // The engine subscribes again and doesn't use the cached container
+  // from before the restart anymore.
+  AWAIT_READY(subscribed);
+
+  Future<Docker::Container> container = docker->inspect("mesos-1");
+  AWAIT_READY(container);
+  EXPECT_NONE(container.get().pid);
+}
+
+} // namespace tests {
+} // namespace internal {
+} // namespace mesos {
@@ -18,11 +18,13 @@
 
 #include <unistd.h>
 
+#include <list>
 #include <map>
 #include <string>
 
 #include <hdfs/hdfs.hpp>
 
+#include <process/collect.hpp>
 #include <process/future.hpp>
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
@@ -55,6 +57,7 @@ using process::Future;
 
 using mesos::internal::slave::Fetcher;
 
+using std::list;
 using std::string;
 using std::map;
 
@@ -791,6 +794,205 @@ TEST_F(FetcherTest, HdfsURI)
   EXPECT_TRUE(os::exists(localFile));
 }
 
+
+// Tests that a cached URI only gets fetched once, and that the file
+// in the sandbox is linked to the file in the cache.
+TEST_F(FetcherTest, CachedURI)
+{
+  string fromDir = path::join(os::getcwd(), "from");
+  ASSERT_SOME(os::mkdir(fromDir));
+  string testFile = path::join(fromDir, "test");
+  ASSERT_SOME(os::write(testFile, "data"));
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  flags.fetcher_cache_dir = path::join(os::getcwd(), "cache");
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value("file://" + testFile);
+  uri->set_cache(true);
+
+  string directory1 = path::join(os::getcwd(), "sandbox1");
+  ASSERT_SOME(os::mkdir(directory1));
+
+  string directory2 = path::join(os::getcwd(), "sandbox2");
+  ASSERT_SOME(os::mkdir(directory2));
+
+  ContainerID containerId1;
+  containerId1.set_value(UUID::random().toString());
+
+  ContainerID containerId2;
+  containerId2.set_value(UUID::random().toString());
+
+  Option<int> stdout = None();
+  Option<int> stderr = None();
+
+  // Redirect mesos-fetcher output if running the tests verbosely.
+  if (tests::flags.verbose) {
+    stdout = STDOUT_FILENO;
+    stderr = STDERR_FILENO;
+  }
+
+  Fetcher fetcher;
+
+  AWAIT_READY(fetcher.fetch(
+      containerId1, commandInfo, directory1, None(), flags, stdout, stderr));
+
+  // Changing the file behind the URI does not affect later fetches.
+  ASSERT_SOME(os::write(testFile, "changed"));
+
+  AWAIT_READY(fetcher.fetch(
+      containerId2, commandInfo, directory2, None(), flags, stdout, stderr));
+
+  EXPECT_SOME_EQ("data", os::read(path::join(directory1, "test")));
+  EXPECT_SOME_EQ("data", os::read(path::join(directory2, "test")));
+
+  Try<ino_t> inode1 = os::stat::inode(path::join(directory1, "test"));
+  Try<ino_t> inode2 = os::stat::inode(path::join(directory2, "test"));
+
+  ASSERT_SOME(inode1);
+  ASSERT_SOME(inode2);
+  EXPECT_EQ(inode1.get(), inode2.get());
+}
+
+
+class MockHttpProcess : public Process<MockHttpProcess>
+{
+public:
+  MockHttpProcess()
+  {
+    route("/file", None(), &MockHttpProcess::file);
+  }
+
+  MOCK_METHOD1(file, Future<http::Response>(const http::Request&));
+};
+
+
+// Tests that concurrent fetches of the same cached URI share one
+// download.
+TEST_F(FetcherTest, CachedConcurrentFetches)
+{
+  MockHttpProcess process;
+
+  Promise<http::Response> response;
+
+  EXPECT_CALL(process, file(_))
+    .WillOnce(Return(response.future()));
+
+  spawn(process);
+
+  string url = "http://" + net::getHostname(process.self().address.ip).get() +
+                ":" + stringify(process.self().address.port) + "/" +
+                process.self().id + "/file";
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  flags.fetcher_cache_dir = path::join(os::getcwd(), "cache");
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value(url);
+  uri->set_cache(true);
+
+  Option<int> stdout = None();
+  Option<int> stderr = None();
+
+  // Redirect mesos-fetcher output if running the tests verbosely.
+  if (tests::flags.verbose) {
+    stdout = STDOUT_FILENO;
+    stderr = STDERR_FILENO;
+  }
+
+  Fetcher fetcher;
+
+  list<string> directories;
+  list<Future<Nothing>> fetches;
+
+  for (int i = 0; i < 3; i++) {
+    string directory = path::join(os::getcwd(), "sandbox" + stringify(i));
+    ASSERT_SOME(os::mkdir(directory));
+    directories.push_back(directory);
+
+    ContainerID containerId;
+    containerId.set_value(UUID::random().toString());
+
+    fetches.push_back(fetcher.fetch(
+        containerId, commandInfo, directory, None(), flags, stdout, stderr));
+  }
+
+  response.set(http::OK("data"));
+
+  AWAIT_READY(collect(fetches));
+
+  foreach (const string& directory, directories) {
+    EXPECT_SOME_EQ("data", os::read(path::join(directory, "file")));
+  }
+
+  terminate(process);
+  wait(process);
+}
+
+
+// Tests that cached files get evicted once the cache is full, in
+// which case a URI gets fetched again.
+TEST_F(FetcherTest, CacheEviction)
+{
+  string fromDir = path::join(os::getcwd(), "from");
+  ASSERT_SOME(os::mkdir(fromDir));
+  string testFile = path::join(fromDir, "test");
+  ASSERT_SOME(os::write(testFile, "data"));
+
+  slave::Flags flags;
+  flags.launcher_dir = path::join(tests::flags.build_dir, "src");
+  flags.fetcher_cache_dir = path::join(os::getcwd(), "cache");
+  flags.fetcher_cache_size = Bytes(3);
+
+  CommandInfo commandInfo;
+  CommandInfo::URI* uri = commandInfo.add_uris();
+  uri->set_value("file://" + testFile);
+  uri->set_cache(true);
+
+  string directory1 = path::join(os::getcwd(), "sandbox1");
+  ASSERT_SOME(os::mkdir(directory1));
+
+  string directory2 = path::join(os::getcwd(), "sandbox2");
+  ASSERT_SOME(os::mkdir(directory2));
+
+  ContainerID containerId1;
+  containerId1.set_value(UUID::random().toString());
+
+  ContainerID containerId2;
+  containerId2.set_value(UUID::random().toString());
+
+  Option<int> stdout = None();
+  Option<int> stderr = None();
+
+  // Redirect mesos-fetcher output if running the tests verbosely.
+  if (tests::flags.verbose) {
+    stdout = STDOUT_FILENO;
+    stderr = STDERR_FILENO;
+  }
+
+  Fetcher fetcher;
+
+  AWAIT_READY(fetcher.fetch(
+      containerId1, commandInfo, directory1, None(), flags, stdout, stderr));
+
+  // The file does not fit into the cache.
+  Try<list<string>> cached = os::ls(flags.fetcher_cache_dir.get());
+  ASSERT_SOME(cached);
+  EXPECT_TRUE(cached.get().empty());
+
+  ASSERT_SOME(os::write(testFile, "changed"));
+
+  AWAIT_READY(fetcher.fetch(
+      containerId2, commandInfo, directory2, None(), flags, stdout, stderr));
+
+  EXPECT_SOME_EQ("data", os::read(path::join(directory1, "test")));
+  EXPECT_SOME_EQ("changed", os::read(path::join(directory2, "test")));
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -25,8 +25,10 @@
 #include <process/http.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
+#include <process/subprocess.hpp>
 
 #include <stout/gtest.hpp>
+#include <stout/hashmap.hpp>
 #include <stout/json.hpp>
 #include <stout/os.hpp>
 #include <stout/stringify.hpp>
@@ -36,11 +38,14 @@
 #include "tests/utils.hpp"
 
 using process::Future;
+using process::Subprocess;
 
 using process::http::BadRequest;
 using process::http::NotFound;
 using process::http::OK;
+using process::http::Pipe;
 using process::http::Response;
+using process::http::ServiceUnavailable;
 
 using std::string;
 
@@ -297,6 +302,75 @@ TEST_F(FilesTest, DownloadTest)
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
   AWAIT_EXPECT_RESPONSE_HEADER_EQ("image/gif", "Content-Type", response);
   AWAIT_EXPECT_RESPONSE_BODY_EQ(data, response);
+
+  // Resume the download of the file from an offset.
+  hashmap<string, string> headers;
+  headers["Range"] = "bytes=3-";
+
+  response =
+    process::http::get(upid, "download.json", "path=binary", headers);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(process::http::statuses[206], response);
+  AWAIT_EXPECT_RESPONSE_HEADER_EQ("bytes 3-16/17", "Content-Range", response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("file extension", response);
+}
+
+
+TEST_F(FilesTest, FollowTest)
+{
+  Files files(1);
+  process::UPID upid("files", process::address());
+
+  ASSERT_SOME(os::write("file", "hello\n"));
+  AWAIT_EXPECT_READY(files.attach("file", "file"));
+
+  Future<Response> response =
+    process::http::streaming::get(upid, "follow", "path=file&offset=0");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_EQ(Response::PIPE, response.get().type);
+  ASSERT_SOME(response.get().reader);
+
+  // Only one follower is allowed.
+  Future<Response> rejected =
+    process::http::get(upid, "follow", "path=file");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(ServiceUnavailable().status, rejected);
+
+  // Append to the file from another process.
+  Try<Subprocess> writer = process::subprocess(
+      "for i in 1 2 3; do echo line$i >> file; sleep 0.1; done");
+
+  ASSERT_SOME(writer);
+
+  Pipe::Reader reader = response.get().reader.get();
+
+  const string expected = "hello\nline1\nline2\nline3\n";
+
+  string data;
+  while (data.size() < expected.size()) {
+    Future<string> read = reader.read();
+    AWAIT_READY(read);
+    ASSERT_FALSE(read.get().empty()) << "Unexpected end-of-file";
+    data += read.get();
+  }
+
+  EXPECT_EQ(expected, data);
+
+  AWAIT_READY(writer.get().status());
+
+  // Removing the file closes the stream, which allows a new
+  // follower.
+  ASSERT_SOME(os::rm("file"));
+  AWAIT_EQ("", reader.read());
+
+  ASSERT_SOME(os::write("file", "hello\n"));
+
+  response = process::http::streaming::get(upid, "follow", "path=file");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  ASSERT_SOME(response.get().reader);
+
+  reader = response.get().reader.get();
+  reader.close();
 }
 
 } // namespace tests {
@@ -33,6 +33,7 @@
 #include <stout/gtest.hpp>
 #include <stout/hashmap.hpp>
 #include <stout/hashset.hpp>
+#include <stout/stopwatch.hpp>
 #include <stout/utils.hpp>
 
 #include "master/constants.hpp"
@@ -57,6 +58,8 @@ using std::queue;
 using std::string;
 using std::vector;
 
+using testing::WithParamInterface;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -205,7 +208,7 @@ TEST_F(HierarchicalAllocatorTest, UnreservedDRF)
 
   // Total cluster resources will become cpus=3, mem=1536:
   // role1 share = 0.66 (cpus=2, mem=1024)
-  //   framework1 share = 1
+  //   framework1 share = 0.66
   // role2 share = 0
   //   framework2 share = 0
   SlaveInfo slave2 = createSlaveInfo("cpus:1;mem:512;disk:0");
@@ -219,15 +222,15 @@ TEST_F(HierarchicalAllocatorTest, UnreservedDRF)
   EXPECT_EQ(slave2.resources(), Resources::sum(allocation.get().resources));
 
   // role1 share = 0.67 (cpus=2, mem=1024)
-  //   framework1 share = 1
+  //   framework1 share = 0.67
   // role2 share = 0.33 (cpus=1, mem=512)
-  //   framework2 share = 1
+  //   framework2 share = 0.33
 
   // Total cluster resources will become cpus=6, mem=3584:
   // role1 share = 0.33 (cpus=2, mem=1024)
-  //   framework1 share = 1
+  //   framework1 share = 0.33
   // role2 share = 0.16 (cpus=1, mem=512)
-  //   framework2 share = 1
+  //   framework2 share = 0.16
   SlaveInfo slave3 = createSlaveInfo("cpus:3;mem:2048;disk:0");
   allocator->addSlave(slave3.id(), slave3, slave3.resources(), EMPTY);
 
@@ -239,9 +242,9 @@ TEST_F(HierarchicalAllocatorTest, UnreservedDRF)
   EXPECT_EQ(slave3.resources(), Resources::sum(allocation.get().resources));
 
   // role1 share = 0.33 (cpus=2, mem=1024)
-  //   framework1 share = 1
+  //   framework1 share = 0.33
   // role2 share = 0.71 (cpus=4, mem=2560)
-  //   framework2 share = 1
+  //   framework2 share = 0.71
 
   FrameworkInfo framework3 = createFrameworkInfo("role1");
   allocator->addFramework(
@@ -249,10 +252,10 @@ TEST_F(HierarchicalAllocatorTest, UnreservedDRF)
 
   // Total cluster resources will become cpus=10, mem=7680:
   // role1 share = 0.2 (cpus=2, mem=1024)
-  //   framework1 share = 1
+  //   framework1 share = 0.2
   //   framework3 share = 0
   // role2 share = 0.4 (cpus=4, mem=2560)
-  //   framework2 share = 1
+  //   framework2 share = 0.4
   SlaveInfo slave4 = createSlaveInfo("cpus:4;mem:4096;disk:0");
   allocator->addSlave(slave4.id(), slave4, slave4.resources(), EMPTY);
 
@@ -265,10 +268,10 @@ TEST_F(HierarchicalAllocatorTest, UnreservedDRF)
   EXPECT_EQ(slave4.resources(), Resources::sum(allocation.get().resources));
 
   // role1 share = 0.67 (cpus=6, mem=5120)
-  //   framework1 share = 0.33 (cpus=2, mem=1024)
-  //   framework3 share = 0.8 (cpus=4, mem=4096)
+  //   framework1 share = 0.2 (cpus=2, mem=1024)
+  //   framework3 share = 0.53 (cpus=4, mem=4096)
   // role2 share = 0.4 (cpus=4, mem=2560)
-  //   framework2 share = 1
+  //   framework2 share = 0.4
 
   FrameworkInfo framework4 = createFrameworkInfo("role1");
   allocator->addFramework(
@@ -276,11 +279,11 @@ TEST_F(HierarchicalAllocatorTest, UnreservedDRF)
 
   // Total cluster resources will become cpus=11, mem=8192
   // role1 share = 0.63 (cpus=6, mem=5120)
-  //   framework1 share = 0.33 (cpus=2, mem=1024)
-  //   framework3 share = 0.8 (cpus=4, mem=4096)
+  //   framework1 share = 0.18 (cpus=2, mem=1024)
+  //   framework3 share = 0.5 (cpus=4, mem=4096)
   //   framework4 share = 0
   // role2 share = 0.36 (cpus=4, mem=2560)
-  //   framework2 share = 1
+  //   framework2 share = 0.36
   SlaveInfo slave5 = createSlaveInfo("cpus:1;mem:512;disk:0");
   allocator->addSlave(slave5.id(), slave5, slave5.resources(), EMPTY);
 
@@ -489,6 +492,60 @@ TEST_F(HierarchicalAllocatorTest, SameShareFairness)
 }
 
 
+// This test ensures that the frameworks of a role share the slaves
+// that get allocated in a single pass.
+TEST_F(HierarchicalAllocatorTest, SameRoleSinglePass)
+{
+  Clock::pause();
+
+  initialize(vector<string>{});
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  FrameworkInfo framework1 = createFrameworkInfo("*");
+  allocator->addFramework(
+      framework1.id(), framework1, hashmap<SlaveID, Resources>());
+
+  FrameworkInfo framework2 = createFrameworkInfo("*");
+  allocator->addFramework(
+      framework2.id(), framework2, hashmap<SlaveID, Resources>());
+
+  vector<SlaveInfo> slaves;
+  for (int i = 0; i < 4; i++) {
+    slaves.push_back(createSlaveInfo("cpus:2;mem:1024;disk:0"));
+    allocator->addSlave(
+        slaves.back().id(), slaves.back(), slaves.back().resources(), EMPTY);
+  }
+
+  // Recover the resources of the allocations made as the slaves got
+  // added, so that all of them are allocated in the next pass.
+  for (int i = 0; i < 4; i++) {
+    Future<Allocation> allocation = queue.get();
+    AWAIT_READY(allocation);
+
+    foreachpair (const SlaveID& slaveId,
+                 const Resources& resources,
+                 allocation.get().resources) {
+      allocator->recoverResources(
+          allocation.get().frameworkId, slaveId, resources, None());
+    }
+  }
+
+  Clock::advance(flags.allocation_interval);
+
+  hashmap<FrameworkID, size_t> counts;
+
+  for (int i = 0; i < 2; i++) {
+    Future<Allocation> allocation = queue.get();
+    AWAIT_READY(allocation);
+    counts[allocation.get().frameworkId] += allocation.get().resources.size();
+  }
+
+  EXPECT_EQ(2u, counts[framework1.id()]);
+  EXPECT_EQ(2u, counts[framework2.id()]);
+}
+
+
 // Checks that resources on a slave that are statically reserved to
 // a role are only offered to frameworks in that role.
 TEST_F(HierarchicalAllocatorTest, Reservations)
@@ -795,6 +852,104 @@ TEST_F(HierarchicalAllocatorTest, Whitelist)
   EXPECT_EQ(slave.resources(), Resources::sum(allocation.get().resources));
 }
 
+
+class HierarchicalAllocator_BENCHMARK_Test
+  : public HierarchicalAllocatorTest,
+    public WithParamInterface<std::tr1::tuple<size_t, size_t> > {};
+
+
+// The allocator benchmark tests are parameterized by the number of
+// slaves and the number of frameworks.
+INSTANTIATE_TEST_CASE_P(
+    SlaveAndFrameworkCount,
+    HierarchicalAllocator_BENCHMARK_Test,
+    ::testing::Combine(
+      ::testing::Values(1000U, 5000U, 10000U, 20000U),
+      ::testing::Values(1U, 50U, 100U, 200U, 500U, 1000U)));
+
+
+// Measures the latency of allocating the resources of each slave as
+// it gets added as well as the latency of a full allocation pass
+// across all slaves.
+TEST_P(HierarchicalAllocator_BENCHMARK_Test, AllocationLatency)
+{
+  const size_t slaveCount = std::tr1::get<0>(GetParam());
+  const size_t frameworkCount = std::tr1::get<1>(GetParam());
+
+  // Pause the clock so that the only allocations are the ones that
+  // we trigger below.
+  Clock::pause();
+
+  initialize(vector<string>{});
+
+  vector<SlaveInfo> slaves;
+  for (size_t i = 0; i < slaveCount; i++) {
+    slaves.push_back(createSlaveInfo("cpus:2;mem:1024;disk:4096"));
+  }
+
+  for (size_t i = 0; i < frameworkCount; i++) {
+    FrameworkInfo framework = createFrameworkInfo("*");
+    allocator->addFramework(
+        framework.id(), framework, hashmap<SlaveID, Resources>());
+  }
+
+  hashmap<FrameworkID, Resources> EMPTY;
+
+  Stopwatch watch;
+  watch.start();
+
+  // Each added slave gets all of its resources allocated to a single
+  // framework.
+  foreach (const SlaveInfo& slave, slaves) {
+    allocator->addSlave(slave.id(), slave, slave.resources(), EMPTY);
+  }
+
+  // Wait for the allocator to process all the slaves. We settle the
+  // clock rather than awaiting each allocation, since awaiting a
+  // pending future polls.
+  Clock::settle();
+
+  LOG(INFO) << "Added " << slaveCount << " slaves with " << frameworkCount
+            << " frameworks in " << watch.elapsed();
+
+  vector<Allocation> allocations;
+  for (size_t i = 0; i < slaveCount; i++) {
+    Future<Allocation> allocation = queue.get();
+    AWAIT_READY(allocation);
+    allocations.push_back(allocation.get());
+  }
+
+  // Now recover all the resources (without filters) so that they get
+  // offered again in the next allocation pass.
+  foreach (const Allocation& allocation, allocations) {
+    foreachpair (const SlaveID& slaveId,
+                 const Resources& resources,
+                 allocation.resources) {
+      allocator->recoverResources(
+          allocation.frameworkId, slaveId, resources, None());
+    }
+  }
+
+  // Wait for the recovered resources to be accounted for so that we
+  // only measure the allocation pass.
+  Clock::settle();
+
+  watch.start();
+
+  Clock::advance(flags.allocation_interval);
+  Clock::settle();
+
+  LOG(INFO) << "Allocated " << slaveCount << " slaves to " << frameworkCount
+            << " frameworks in " << watch.elapsed();
+
+  size_t offered = 0;
+  while (offered < slaveCount) {
+    Future<Allocation> allocation = queue.get();
+    AWAIT_READY(allocation);
+    offered += allocation.get().resources.size();
+  }
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -437,6 +437,75 @@ TEST_F(ReplicaTest, Append)
 }
 
 
+// This test verifies that a read request only returns the learned
+// actions and that the response gets cut short at the requested size.
+TEST_F(ReplicaTest, Read)
+{
+  const string path = os::getcwd() + "/.log";
+  initializer.flags.path = path;
+  initializer.execute();
+
+  Replica replica(path);
+
+  const uint64_t proposal = 1;
+
+  PromiseRequest request1;
+  request1.set_proposal(proposal);
+
+  Future<PromiseResponse> future1 =
+    protocol::promise(replica.pid(), request1);
+
+  AWAIT_READY(future1);
+  EXPECT_TRUE(future1.get().okay());
+
+  // Positions 1 and 2 are learned while position 3 is not.
+  for (uint64_t position = 1; position <= 3; position++) {
+    WriteRequest request2;
+    request2.set_proposal(proposal);
+    request2.set_position(position);
+    request2.set_learned(position < 3);
+    request2.set_type(Action::APPEND);
+    request2.mutable_append()->set_bytes(stringify(position));
+
+    Future<WriteResponse> future2 =
+      protocol::write(replica.pid(), request2);
+
+    AWAIT_READY(future2);
+    EXPECT_TRUE(future2.get().okay());
+  }
+
+  ReadRequest request3;
+  request3.set_from(1);
+  request3.set_to(5);
+
+  Future<ReadResponse> future3 = protocol::read(replica.pid(), request3);
+
+  AWAIT_READY(future3);
+
+  ReadResponse response3 = future3.get();
+  EXPECT_TRUE(response3.okay());
+  EXPECT_EQ(5u, response3.to());
+  ASSERT_EQ(2, response3.actions_size());
+  EXPECT_EQ(1u, response3.actions(0).position());
+  EXPECT_EQ("1", response3.actions(0).append().bytes());
+  EXPECT_EQ(2u, response3.actions(1).position());
+  EXPECT_EQ("2", response3.actions(1).append().bytes());
+
+  // Any single action exceeds a 1 byte response.
+  request3.set_bytes(1);
+
+  future3 = protocol::read(replica.pid(), request3);
+
+  AWAIT_READY(future3);
+
+  response3 = future3.get();
+  EXPECT_TRUE(response3.okay());
+  EXPECT_EQ(1u, response3.to());
+  ASSERT_EQ(1, response3.actions_size());
+  EXPECT_EQ(1u, response3.actions(0).position());
+}
+
+
 TEST_F(ReplicaTest, Restore)
 {
   const string path = os::getcwd() + "/.log";
@@ -1196,6 +1265,124 @@ TEST_F(CoordinatorTest, MultipleAppends)
 }
 
 
+TEST_F(CoordinatorTest, PipelinedAppends)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network(new Network(pids));
+
+  // Allow up to 4 appends in flight so that the rest get queued.
+  Coordinator coord(2, replica1, network, 4);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  list<Future<Option<uint64_t> > > appending;
+  for (uint64_t position = 1; position <= 10; position++) {
+    appending.push_back(coord.append(stringify(position)));
+  }
+
+  uint64_t position = 1;
+  foreach (const Future<Option<uint64_t> >& append, appending) {
+    AWAIT_READY(append);
+    EXPECT_SOME_EQ(position++, append.get());
+  }
+
+  {
+    Future<list<Action> > actions = replica1->read(1, 10);
+    AWAIT_READY(actions);
+    EXPECT_EQ(10u, actions.get().size());
+    foreach (const Action& action, actions.get()) {
+      ASSERT_TRUE(action.has_type());
+      ASSERT_EQ(Action::APPEND, action.type());
+      EXPECT_EQ(stringify(action.position()), action.append().bytes());
+    }
+  }
+
+  // No writes are in flight anymore, so the coordinator can be
+  // demoted at the last written position.
+  AWAIT_EXPECT_EQ(10u, coord.demote());
+}
+
+
+// This test verifies that the queued appends of a pipelining
+// coordinator return none once the coordinator gets demoted.
+TEST_F(CoordinatorTest, PipelinedAppendsDemoted)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord1(2, replica1, network1, 1);
+
+  {
+    Future<Option<uint64_t> > electing = coord1.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  Shared<Network> network2(new Network(pids));
+
+  Coordinator coord2(2, replica2, network2);
+
+  {
+    Future<Option<uint64_t> > electing = coord2.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  // The first append gets rejected by the replicas while the others
+  // are still queued behind it.
+  Future<Option<uint64_t> > appending1 = coord1.append("hello");
+  Future<Option<uint64_t> > appending2 = coord1.append("hello moto");
+  Future<Option<uint64_t> > appending3 = coord1.append("hello hello");
+
+  AWAIT_READY(appending1);
+  EXPECT_NONE(appending1.get());
+
+  AWAIT_READY(appending2);
+  EXPECT_NONE(appending2.get());
+
+  AWAIT_READY(appending3);
+  EXPECT_NONE(appending3.get());
+
+  {
+    Future<Option<uint64_t> > appending = coord2.append("hello world");
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(1u, appending.get());
+  }
+}
+
+
 TEST_F(CoordinatorTest, MultipleAppendsNotLearnedFill)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -1673,11 +1860,19 @@ TEST_F(RecoverTest, CatchupRetry)
   // promise phase even if replica1 reemerges later.
   DROP_MESSAGE(Eq(PromiseRequest().GetTypeName()), _, Eq(replica1->pid()));
 
+  // Drop the read requests so that the catch-up process has to fill
+  // the positions (rather than reading them from replica1).
+  DROP_MESSAGES(Eq(ReadRequest().GetTypeName()), _, _);
+
   Future<Nothing> catching =
     catchup(2, replica3, network2, None(), positions, Seconds(10));
 
   Clock::pause();
 
+  // Wait for the reads to time out.
+  Clock::settle();
+  Clock::advance(Seconds(10));
+
   // Wait for the retry timer in 'catchup' to be setup.
   Clock::settle();
 
@@ -1699,6 +1894,73 @@ TEST_F(RecoverTest, CatchupRetry)
 }
 
 
+// This test verifies that a replica catches-up positions that other
+// replicas have learned by reading them rather than running Paxos.
+TEST_F(RecoverTest, CatchupRead)
+{
+  const string path1 = os::getcwd() + "/.log1";
+  initializer.flags.path = path1;
+  initializer.execute();
+
+  const string path2 = os::getcwd() + "/.log2";
+  initializer.flags.path = path2;
+  initializer.execute();
+
+  const string path3 = os::getcwd() + "/.log3";
+
+  Shared<Replica> replica1(new Replica(path1));
+  Shared<Replica> replica2(new Replica(path2));
+
+  set<UPID> pids;
+  pids.insert(replica1->pid());
+  pids.insert(replica2->pid());
+
+  Shared<Network> network1(new Network(pids));
+
+  Coordinator coord(2, replica1, network1);
+
+  {
+    Future<Option<uint64_t> > electing = coord.elect();
+    AWAIT_READY(electing);
+    EXPECT_SOME_EQ(0u, electing.get());
+  }
+
+  IntervalSet<uint64_t> positions;
+
+  for (uint64_t position = 1; position <= 10; position++) {
+    Future<Option<uint64_t> > appending = coord.append(stringify(position));
+    AWAIT_READY(appending);
+    EXPECT_SOME_EQ(position, appending.get());
+    positions += position;
+  }
+
+  Shared<Replica> replica3(new Replica(path3));
+
+  pids.insert(replica3->pid());
+
+  Shared<Network> network2(new Network(pids));
+
+  // All positions have been learned by the other replicas so the
+  // catch-up should not need to fill any of them.
+  EXPECT_NO_FUTURE_MESSAGES(Eq(PromiseRequest().GetTypeName()), _, _);
+
+  Future<Nothing> catching =
+    catchup(2, replica3, network2, None(), positions, Seconds(10));
+
+  AWAIT_READY(catching);
+
+  Future<list<Action> > actions = replica3->read(1, 10);
+  AWAIT_READY(actions);
+  ASSERT_EQ(10u, actions.get().size());
+  foreach (const Action& action, actions.get()) {
+    EXPECT_TRUE(action.learned());
+    ASSERT_TRUE(action.has_type());
+    ASSERT_EQ(Action::APPEND, action.type());
+    EXPECT_EQ(stringify(action.position()), action.append().bytes());
+  }
+}
+
+
 TEST_F(RecoverTest, AutoInitialization)
 {
   const string path1 = os::getcwd() + "/.log1";
@@ -20,6 +20,7 @@
 
 #include <gmock/gmock.h>
 
+#include <algorithm>
 #include <memory>
 #include <string>
 #include <vector>
@@ -38,6 +39,7 @@
 #include <process/metrics/counter.hpp>
 #include <process/metrics/metrics.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/json.hpp>
 #include <stout/net.hpp>
 #include <stout/option.hpp>
@@ -1577,9 +1579,11 @@ TEST_F(MasterTest, MetricsInMetricsEndpoint)
 
   EXPECT_EQ(1u, snapshot.values.count("registrar/queued_operations"));
   EXPECT_EQ(1u, snapshot.values.count("registrar/registry_size_bytes"));
+  EXPECT_EQ(1u, snapshot.values.count("registrar/registry_deltas"));
 
   EXPECT_EQ(1u, snapshot.values.count("registrar/state_fetch_ms"));
   EXPECT_EQ(1u, snapshot.values.count("registrar/state_store_ms"));
+  EXPECT_EQ(1u, snapshot.values.count("registrar/state_store_bytes"));
 
   Shutdown();
 }
@@ -3071,6 +3075,735 @@ TEST_F(MasterTest, SlaveActiveEndpoint)
 }
 
 
+// This tests that state.json is only rebuilt when the state of the
+// master changed, which is exposed through the 'ETag' header so that
+// unchanged polls are answered with '304 Not Modified'.
+TEST_F(MasterTest, StateEndpointETag)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<process::Message> slaveRegisteredMessage =
+    FUTURE_MESSAGE(Eq(SlaveRegisteredMessage().GetTypeName()), _, _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // Make sure nothing changes the state between the requests below.
+  Clock::pause();
+  Clock::settle();
+
+  Future<http::Response> response = http::get(master.get(), "state.json");
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Option<string> etag = response.get().headers.get("ETag");
+  ASSERT_SOME(etag);
+
+  hashmap<string, string> headers;
+  headers["If-None-Match"] = etag.get();
+
+  // The state hasn't changed.
+  response = http::get(master.get(), "state.json", None(), headers);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::NotModified().status, response);
+  EXPECT_SOME_EQ(etag.get(), response.get().headers.get("ETag"));
+
+  // Collecting the metrics dispatches to the master but doesn't
+  // change its state.
+  Metrics();
+
+  response = http::get(master.get(), "state.json", None(), headers);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::NotModified().status, response);
+
+  Future<Nothing> deactivateSlave =
+    FUTURE_DISPATCH(_, &MesosAllocatorProcess::deactivateSlave);
+
+  // Deactivate the slave so that the state changes.
+  process::inject::exited(slaveRegisteredMessage.get().to, master.get());
+
+  AWAIT_READY(deactivateSlave);
+
+  response = http::get(master.get(), "state.json", None(), headers);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+
+  Option<string> etag2 = response.get().headers.get("ETag");
+  ASSERT_SOME(etag2);
+  EXPECT_NE(etag.get(), etag2.get());
+
+  Try<JSON::Object> parse = JSON::parse<JSON::Object>(response.get().body);
+  ASSERT_SOME(parse);
+
+  Result<JSON::Boolean> status = parse.get().find<JSON::Boolean>(
+      "slaves[0].active");
+
+  ASSERT_SOME_EQ(JSON::Boolean(false), status);
+
+  Clock::resume();
+
+  Shutdown();
+}
+
+
+// This test verifies that the master tasks endpoint filters tasks,
+// projects their fields, and pages through them with a cursor.
+TEST_F(MasterTest, TasksEndpoint)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_NE(0u, offers.get().size());
+
+  TaskInfo task1;
+  task1.set_name("");
+  task1.mutable_task_id()->set_value("1");
+  task1.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+  task1.mutable_resources()->MergeFrom(
+      Resources::parse("cpus:1;mem:256").get());
+  task1.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+
+  Label* label = task1.mutable_labels()->add_labels();
+  label->set_key("foo");
+  label->set_value("bar");
+
+  TaskInfo task2 = task1;
+  task2.mutable_task_id()->set_value("2");
+  task2.clear_labels();
+
+  vector<TaskInfo> tasks;
+  tasks.push_back(task1);
+  tasks.push_back(task2);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  EXPECT_CALL(containerizer, update(_, _))
+    .WillRepeatedly(Return(Nothing()));
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(status1);
+  EXPECT_EQ(TASK_RUNNING, status1.get().state());
+
+  AWAIT_READY(status2);
+  EXPECT_EQ(TASK_RUNNING, status2.get().state());
+
+  // Returns the tasks listed for the query.
+  auto list = [&](const string& query) -> Try<JSON::Object> {
+    Future<http::Response> response =
+      http::get(master.get(), "tasks.json", query);
+
+    if (!response.await(Seconds(15)) || !response.isReady()) {
+      return Error("Failed to get the tasks");
+    } else if (response.get().status != http::OK().status) {
+      return Error("Unexpected status '" + response.get().status + "'");
+    }
+
+    return JSON::parse<JSON::Object>(response.get().body);
+  };
+
+  Try<JSON::Object> parse = list("state=TASK_RUNNING");
+  ASSERT_SOME(parse);
+  EXPECT_EQ(2u, parse.get().find<JSON::Array>("tasks").get().values.size());
+
+  parse = list("state=TASK_STAGING");
+  ASSERT_SOME(parse);
+  EXPECT_TRUE(parse.get().find<JSON::Array>("tasks").get().values.empty());
+
+  parse = list("slave_id=" + offers.get()[0].slave_id().value());
+  ASSERT_SOME(parse);
+  EXPECT_EQ(2u, parse.get().find<JSON::Array>("tasks").get().values.size());
+
+  parse = list("label=foo:bar");
+  ASSERT_SOME(parse);
+  EXPECT_EQ(1u, parse.get().find<JSON::Array>("tasks").get().values.size());
+  EXPECT_SOME_EQ(
+      JSON::String("1"),
+      parse.get().find<JSON::String>("tasks[0].id"));
+
+  parse = list("label=foo:baz");
+  ASSERT_SOME(parse);
+  EXPECT_TRUE(parse.get().find<JSON::Array>("tasks").get().values.empty());
+
+  // Only the requested fields are included.
+  parse = list("fields=id,state");
+  ASSERT_SOME(parse);
+  EXPECT_SOME(parse.get().find<JSON::String>("tasks[0].id"));
+  EXPECT_SOME_EQ(
+      JSON::String("TASK_RUNNING"),
+      parse.get().find<JSON::String>("tasks[0].state"));
+  EXPECT_NONE(parse.get().find<JSON::Object>("tasks[0].resources"));
+
+  // Page through the tasks one at a time.
+  parse = list("order=asc&limit=1");
+  ASSERT_SOME(parse);
+  EXPECT_EQ(1u, parse.get().find<JSON::Array>("tasks").get().values.size());
+
+  Result<JSON::String> first = parse.get().find<JSON::String>("tasks[0].id");
+  ASSERT_SOME(first);
+
+  Result<JSON::String> cursor = parse.get().find<JSON::String>("next_cursor");
+  ASSERT_SOME(cursor);
+
+  parse = list("order=asc&limit=1&cursor=" + cursor.get().value);
+  ASSERT_SOME(parse);
+  EXPECT_EQ(1u, parse.get().find<JSON::Array>("tasks").get().values.size());
+
+  Result<JSON::String> second = parse.get().find<JSON::String>("tasks[0].id");
+  ASSERT_SOME(second);
+  EXPECT_NE(first.get().value, second.get().value);
+
+  // There are no more tasks after the second one.
+  EXPECT_NONE(parse.get().find<JSON::String>("next_cursor"));
+
+  Future<http::Response> response =
+    http::get(master.get(), "tasks.json", "state=BOGUS");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::BadRequest().status, response);
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This test verifies that a cursor of the master tasks endpoint
+// stays valid while the tasks receive their first status update,
+// i.e., that the pages neither skip nor repeat tasks.
+TEST_F(MasterTest, TasksEndpointCursorWhileTasksStart)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(offers);
+  ASSERT_NE(0u, offers.get().size());
+
+  TaskInfo task1;
+  task1.set_name("");
+  task1.mutable_task_id()->set_value("1");
+  task1.mutable_slave_id()->MergeFrom(offers.get()[0].slave_id());
+  task1.mutable_resources()->MergeFrom(
+      Resources::parse("cpus:1;mem:256").get());
+  task1.mutable_executor()->MergeFrom(DEFAULT_EXECUTOR_INFO);
+
+  TaskInfo task2 = task1;
+  task2.mutable_task_id()->set_value("2");
+
+  vector<TaskInfo> tasks;
+  tasks.push_back(task1);
+  tasks.push_back(task2);
+
+  ExecutorDriver* execDriver;
+  EXPECT_CALL(exec, registered(_, _, _, _))
+    .WillOnce(SaveArg<0>(&execDriver));
+
+  // The executor doesn't send any status updates by itself, so the
+  // tasks don't have a status yet.
+  Future<TaskInfo> launch1;
+  Future<TaskInfo> launch2;
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(FutureArg<1>(&launch1))
+    .WillOnce(FutureArg<1>(&launch2));
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(launch1);
+  AWAIT_READY(launch2);
+
+  // Returns the tasks listed for the query.
+  auto list = [&](const string& query) -> Try<JSON::Object> {
+    Future<http::Response> response =
+      http::get(master.get(), "tasks.json", query);
+
+    if (!response.await(Seconds(15)) || !response.isReady()) {
+      return Error("Failed to get the tasks");
+    } else if (response.get().status != http::OK().status) {
+      return Error("Unexpected status '" + response.get().status + "'");
+    }
+
+    return JSON::parse<JSON::Object>(response.get().body);
+  };
+
+  Try<JSON::Object> parse = list("order=asc&limit=1");
+  ASSERT_SOME(parse);
+  EXPECT_EQ(1u, parse.get().find<JSON::Array>("tasks").get().values.size());
+
+  Result<JSON::String> first = parse.get().find<JSON::String>("tasks[0].id");
+  ASSERT_SOME(first);
+
+  Result<JSON::String> cursor = parse.get().find<JSON::String>("next_cursor");
+  ASSERT_SOME(cursor);
+
+  // Now the tasks receive their first status update.
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  foreach (const TaskInfo& task, tasks) {
+    TaskStatus status;
+    status.mutable_task_id()->MergeFrom(task.task_id());
+    status.set_state(TASK_RUNNING);
+
+    execDriver->sendStatusUpdate(status);
+  }
+
+  AWAIT_READY(status1);
+  AWAIT_READY(status2);
+
+  // The next page has the other task, and only that one.
+  parse = list("order=asc&limit=1&cursor=" + cursor.get().value);
+  ASSERT_SOME(parse);
+  EXPECT_EQ(1u, parse.get().find<JSON::Array>("tasks").get().values.size());
+
+  Result<JSON::String> second = parse.get().find<JSON::String>("tasks[0].id");
+  ASSERT_SOME(second);
+  EXPECT_NE(first.get().value, second.get().value);
+
+  EXPECT_NONE(parse.get().find<JSON::String>("next_cursor"));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// This tests that /master/events starts with a snapshot of the state
+// of the master, followed by the changes to that state.
+TEST_F(MasterTest, EventsEndpoint)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<http::Response> response =
+    http::streaming::get(master.get(), "events");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  ASSERT_EQ(http::Response::PIPE, response.get().type);
+  ASSERT_SOME(response.get().reader);
+
+  http::Pipe::Reader reader = response.get().reader.get();
+
+  // Reads the next newline delimited event from the stream.
+  string buffer;
+  auto next = [&]() -> Try<JSON::Object> {
+    while (buffer.find('\n') == string::npos) {
+      Future<string> read = reader.read();
+      if (!read.await(Seconds(15)) || !read.isReady()) {
+        return Error("Failed to read from the stream");
+      } else if (read.get().empty()) {
+        return Error("Unexpected end-of-file");
+      }
+      buffer += read.get();
+    }
+
+    size_t index = buffer.find('\n');
+    string line = buffer.substr(0, index);
+    buffer = buffer.substr(index + 1);
+
+    return JSON::parse<JSON::Object>(line);
+  };
+
+  // Reads events from the stream until one of the specified type,
+  // skipping the events this test isn't interested in.
+  auto nextOf = [&](const string& type) -> Try<JSON::Object> {
+    while (true) {
+      Try<JSON::Object> event = next();
+      if (event.isError()) {
+        return event;
+      }
+
+      Result<JSON::String> _type = event.get().find<JSON::String>("type");
+      if (_type.isSome() && _type.get() == JSON::String(type)) {
+        return event;
+      }
+    }
+  };
+
+  Try<JSON::Object> event = next();
+  ASSERT_SOME(event);
+  EXPECT_SOME_EQ(
+      JSON::String("SNAPSHOT"),
+      event.get().find<JSON::String>("type"));
+  EXPECT_SOME_EQ(
+      JSON::Number(0),
+      event.get().find<JSON::Number>("state.activated_slaves"));
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+
+  TestContainerizer containerizer(&exec);
+
+  Future<process::Message> slaveRegisteredMessage =
+    FUTURE_MESSAGE(Eq(SlaveRegisteredMessage().GetTypeName()), _, _);
+
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  event = next();
+  ASSERT_SOME(event);
+  EXPECT_SOME_EQ(
+      JSON::String("SLAVE_ADDED"),
+      event.get().find<JSON::String>("type"));
+  EXPECT_SOME_EQ(
+      JSON::Boolean(true),
+      event.get().find<JSON::Boolean>("slave.active"));
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), DEFAULT_CREDENTIAL);
+
+  Future<FrameworkID> frameworkId;
+  EXPECT_CALL(sched, registered(&driver, _, _))
+    .WillOnce(FutureArg<1>(&frameworkId));
+
+  Future<vector<Offer>> offers;
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(FutureArg<1>(&offers))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  driver.start();
+
+  AWAIT_READY(frameworkId);
+
+  event = nextOf("FRAMEWORK_ADDED");
+  ASSERT_SOME(event);
+  EXPECT_SOME_EQ(
+      JSON::String(frameworkId.get().value()),
+      event.get().find<JSON::String>("framework.id"));
+  EXPECT_SOME_EQ(
+      JSON::Boolean(true),
+      event.get().find<JSON::Boolean>("framework.active"));
+
+  AWAIT_READY(offers);
+  EXPECT_NE(0u, offers.get().size());
+
+  TaskInfo task = createTask(offers.get()[0], "", DEFAULT_EXECUTOR_ID);
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillOnce(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  Future<TaskStatus> status;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status))
+    .WillRepeatedly(Return()); // Ignore the update for TASK_KILLED.
+
+  vector<TaskInfo> tasks;
+  tasks.push_back(task);
+
+  driver.launchTasks(offers.get()[0].id(), tasks);
+
+  AWAIT_READY(status);
+  EXPECT_EQ(TASK_RUNNING, status.get().state());
+
+  // The task gets added as staging and then transitions to running.
+  event = nextOf("TASK_ADDED");
+  ASSERT_SOME(event);
+  EXPECT_SOME_EQ(
+      JSON::String(task.task_id().value()),
+      event.get().find<JSON::String>("task.id"));
+  EXPECT_SOME_EQ(
+      JSON::String("TASK_STAGING"),
+      event.get().find<JSON::String>("task.state"));
+
+  event = nextOf("TASK_UPDATED");
+  ASSERT_SOME(event);
+  EXPECT_SOME_EQ(
+      JSON::String(task.task_id().value()),
+      event.get().find<JSON::String>("task.id"));
+  EXPECT_SOME_EQ(
+      JSON::String("TASK_RUNNING"),
+      event.get().find<JSON::String>("task.state"));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  // Removing the framework kills its tasks.
+  driver.stop();
+  driver.join();
+
+  event = nextOf("FRAMEWORK_REMOVED");
+  ASSERT_SOME(event);
+  EXPECT_SOME_EQ(
+      JSON::String(frameworkId.get().value()),
+      event.get().find<JSON::String>("framework.id"));
+
+  event = nextOf("TASK_UPDATED");
+  ASSERT_SOME(event);
+  EXPECT_SOME_EQ(
+      JSON::String(task.task_id().value()),
+      event.get().find<JSON::String>("task.id"));
+  EXPECT_SOME_EQ(
+      JSON::String("TASK_KILLED"),
+      event.get().find<JSON::String>("task.state"));
+
+  // Deactivate the slave.
+  process::inject::exited(slaveRegisteredMessage.get().to, master.get());
+
+  event = nextOf("SLAVE_UPDATED");
+  ASSERT_SOME(event);
+  EXPECT_SOME_EQ(
+      JSON::Boolean(false),
+      event.get().find<JSON::Boolean>("slave.active"));
+
+  reader.close();
+
+  Shutdown(); // Must shutdown before 'containerizer' gets deallocated.
+}
+
+
+// Ensures that the stream of a subscriber of /master/events that
+// doesn't read the events gets closed once its backlog exceeds
+// --max_event_backlog, and that it can subscribe again afterwards.
+TEST_F(MasterTest, EventsEndpointSlowSubscriber)
+{
+  master::Flags flags = CreateMasterFlags();
+  flags.max_event_backlog = Bytes(512);
+
+  Try<PID<Master>> master = StartMaster(flags);
+  ASSERT_SOME(master);
+
+  Future<http::Response> response =
+    http::streaming::get(master.get(), "events");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  ASSERT_SOME(response.get().reader);
+
+  http::Pipe::Reader reader = response.get().reader.get();
+
+  // Read the snapshot so that the backlog is empty.
+  string buffer;
+  while (buffer.find('\n') == string::npos) {
+    Future<string> read = reader.read();
+    AWAIT_READY(read);
+    ASSERT_FALSE(read.get().empty());
+    buffer += read.get();
+  }
+
+  Try<JSON::Object> snapshot =
+    JSON::parse<JSON::Object>(buffer.substr(0, buffer.find('\n')));
+
+  ASSERT_SOME(snapshot);
+  EXPECT_SOME_EQ(
+      JSON::String("SNAPSHOT"),
+      snapshot.get().find<JSON::String>("type"));
+
+  buffer = buffer.substr(buffer.find('\n') + 1);
+
+  // Without reading from the stream, add enough slaves for their
+  // events to exceed the backlog.
+  const size_t slaves = 4;
+
+  for (size_t i = 0; i < slaves; i++) {
+    Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+      FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+    Try<PID<Slave>> slave = StartSlave();
+    ASSERT_SOME(slave);
+
+    AWAIT_READY(slaveRegisteredMessage);
+  }
+
+  // The events which were buffered before the subscriber got dropped
+  // can still be read, after which the stream ends.
+  while (true) {
+    Future<string> read = reader.read();
+    AWAIT_READY(read);
+
+    if (read.get().empty()) {
+      break;
+    }
+
+    buffer += read.get();
+  }
+
+  EXPECT_LT(
+      static_cast<size_t>(std::count(buffer.begin(), buffer.end(), '\n')),
+      slaves);
+
+  // Subscribing again gets the current state.
+  response = http::streaming::get(master.get(), "events");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+  ASSERT_SOME(response.get().reader);
+
+  reader = response.get().reader.get();
+
+  buffer.clear();
+  while (buffer.find('\n') == string::npos) {
+    Future<string> read = reader.read();
+    AWAIT_READY(read);
+    ASSERT_FALSE(read.get().empty());
+    buffer += read.get();
+  }
+
+  snapshot = JSON::parse<JSON::Object>(buffer.substr(0, buffer.find('\n')));
+
+  ASSERT_SOME(snapshot);
+  EXPECT_SOME_EQ(
+      JSON::Number(slaves),
+      snapshot.get().find<JSON::Number>("state.activated_slaves"));
+
+  reader.close();
+
+  Shutdown();
+}
+
+
+// Ensures that the events published while the snapshot of a new
+// subscriber of /master/events is being written out are held back
+// and follow the snapshot, i.e., that each change is either in the
+// snapshot or in the events after it, but not in both.
+TEST_F(MasterTest, EventsEndpointSubscribeWhileChanging)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  Future<process::Message> slaveRegisteredMessage =
+    FUTURE_MESSAGE(Eq(SlaveRegisteredMessage().GetTypeName()), _, _);
+
+  Try<PID<Slave>> slave = StartSlave();
+  ASSERT_SOME(slave);
+
+  // Subscribe while the slave registers, so that the slave gets added
+  // before the snapshot of some of the subscribers, and after (or
+  // while) it's written out for others.
+  vector<Future<http::Response>> responses;
+  for (int i = 0; i < 20; i++) {
+    responses.push_back(http::streaming::get(master.get(), "events"));
+  }
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // Deactivating the slave publishes an event after all of the
+  // subscribers got their snapshots.
+  process::inject::exited(slaveRegisteredMessage.get().to, master.get());
+
+  foreach (const Future<http::Response>& response, responses) {
+    AWAIT_EXPECT_RESPONSE_STATUS_EQ(http::OK().status, response);
+    ASSERT_SOME(response.get().reader);
+
+    http::Pipe::Reader reader = response.get().reader.get();
+
+    // Reads the next newline delimited event from the stream.
+    string buffer;
+    auto next = [&]() -> Try<JSON::Object> {
+      while (buffer.find('\n') == string::npos) {
+        Future<string> read = reader.read();
+        if (!read.await(Seconds(15)) || !read.isReady()) {
+          return Error("Failed to read from the stream");
+        } else if (read.get().empty()) {
+          return Error("Unexpected end-of-file");
+        }
+        buffer += read.get();
+      }
+
+      size_t index = buffer.find('\n');
+      string line = buffer.substr(0, index);
+      buffer = buffer.substr(index + 1);
+
+      return JSON::parse<JSON::Object>(line);
+    };
+
+    Try<JSON::Object> event = next();
+    ASSERT_SOME(event);
+    EXPECT_SOME_EQ(
+        JSON::String("SNAPSHOT"),
+        event.get().find<JSON::String>("type"));
+
+    Result<JSON::Number> activated =
+      event.get().find<JSON::Number>("state.activated_slaves");
+
+    ASSERT_SOME(activated);
+
+    // If the slave isn't in the snapshot yet, its addition follows.
+    if (activated.get() == JSON::Number(0)) {
+      event = next();
+      ASSERT_SOME(event);
+      EXPECT_SOME_EQ(
+          JSON::String("SLAVE_ADDED"),
+          event.get().find<JSON::String>("type"));
+    } else {
+      EXPECT_EQ(JSON::Number(1), activated.get());
+    }
+
+    event = next();
+    ASSERT_SOME(event);
+    EXPECT_SOME_EQ(
+        JSON::String("SLAVE_UPDATED"),
+        event.get().find<JSON::String>("type"));
+    EXPECT_SOME_EQ(
+        JSON::Boolean(false),
+        event.get().find<JSON::Boolean>("slave.active"));
+
+    reader.close();
+  }
+
+  Shutdown();
+}
+
+
 // This test verifies that service info for tasks is exposed over the
 // master state endpoint.
 TEST_F(MasterTest, TaskDiscoveryInfo)
@@ -93,6 +93,8 @@ TEST_F(MetricsTest, Master)
   EXPECT_EQ(1u, stats.values.count("master/messages_kill_task"));
   EXPECT_EQ(1u, stats.values.count(
       "master/messages_status_update_acknowledgement"));
+  EXPECT_EQ(1u, stats.values.count(
+      "master/messages_status_update_acknowledgements"));
   EXPECT_EQ(1u, stats.values.count("master/messages_resource_request"));
   EXPECT_EQ(1u, stats.values.count("master/messages_launch_tasks"));
   EXPECT_EQ(1u, stats.values.count("master/messages_decline_offers"));
@@ -143,9 +145,11 @@ TEST_F(MetricsTest, Master)
 
   EXPECT_EQ(1u, stats.values.count("registrar/queued_operations"));
   EXPECT_EQ(1u, stats.values.count("registrar/registry_size_bytes"));
+  EXPECT_EQ(1u, stats.values.count("registrar/registry_deltas"));
 
   EXPECT_EQ(1u, stats.values.count("registrar/state_fetch_ms"));
   EXPECT_EQ(1u, stats.values.count("registrar/state_store_ms"));
+  EXPECT_EQ(1u, stats.values.count("registrar/state_store_bytes"));
 }
 
 
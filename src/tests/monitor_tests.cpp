@@ -16,6 +16,8 @@
  * limitations under the License.
  */
 
+#include <sys/stat.h>
+
 #include <limits>
 #include <map>
 
@@ -28,18 +30,28 @@
 #include <process/gmock.hpp>
 #include <process/gtest.hpp>
 #include <process/http.hpp>
+#include <process/owned.hpp>
 #include <process/pid.hpp>
 #include <process/process.hpp>
 
+#include <stout/gtest.hpp>
+#include <stout/hashset.hpp>
+#include <stout/json.hpp>
 #include <stout/nothing.hpp>
+#include <stout/os.hpp>
+#include <stout/path.hpp>
 
 #include "slave/constants.hpp"
 #include "slave/monitor.hpp"
+#include "slave/paths.hpp"
+#include "slave/usage_history.hpp"
 
 #include "tests/containerizer.hpp"
+#include "tests/utils.hpp"
 
 using process::Clock;
 using process::Future;
+using process::Owned;
 
 using process::http::BadRequest;
 using process::http::NotFound;
@@ -48,6 +60,9 @@ using process::http::Response;
 
 using std::numeric_limits;
 using std::string;
+using std::vector;
+
+using mesos::internal::slave::UsageHistory;
 
 using testing::_;
 using testing::DoAll;
@@ -167,6 +182,109 @@ TEST(MonitorTest, Collection)
 }
 
 
+// This test ensures that a container whose usage never gets collected
+// does not hold up the collection for the other containers, and that
+// the collection of its usage gets discarded after the timeout.
+TEST(MonitorTest, SlowUsage)
+{
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework");
+
+  ContainerID containerId1;
+  containerId1.set_value("container1");
+
+  ContainerID containerId2;
+  containerId2.set_value("container2");
+
+  ExecutorInfo executorInfo1;
+  executorInfo1.mutable_executor_id()->set_value("executor1");
+  executorInfo1.mutable_framework_id()->CopyFrom(frameworkId);
+  executorInfo1.set_name("name");
+  executorInfo1.set_source("source");
+
+  ExecutorInfo executorInfo2;
+  executorInfo2.CopyFrom(executorInfo1);
+  executorInfo2.mutable_executor_id()->set_value("executor2");
+
+  ResourceStatistics statistics;
+  statistics.set_cpus_limit(1.0);
+  statistics.set_mem_limit_bytes(2048);
+  statistics.set_timestamp(0);
+
+  TestContainerizer containerizer;
+
+  // The usage of the first container never gets collected.
+  process::Promise<ResourceStatistics> promise;
+
+  Future<Nothing> usage1, usage2;
+  EXPECT_CALL(containerizer, usage(containerId1))
+    .WillOnce(DoAll(FutureSatisfy(&usage1),
+                    Return(promise.future())))
+    .WillRepeatedly(Return(statistics));
+
+  EXPECT_CALL(containerizer, usage(containerId2))
+    .WillOnce(DoAll(FutureSatisfy(&usage2),
+                    Return(statistics)))
+    .WillRepeatedly(Return(statistics));
+
+  slave::ResourceMonitor monitor(&containerizer);
+
+  process::Clock::pause();
+
+  monitor.start(
+      containerId1,
+      executorInfo1,
+      slave::RESOURCE_MONITORING_INTERVAL);
+
+  monitor.start(
+      containerId2,
+      executorInfo2,
+      slave::RESOURCE_MONITORING_INTERVAL);
+
+  process::Clock::settle();
+
+  // Cause the collection to occur.
+  process::Clock::advance(slave::RESOURCE_MONITORING_INTERVAL);
+  process::Clock::settle();
+
+  AWAIT_READY(usage1);
+  AWAIT_READY(usage2);
+
+  process::Clock::settle();
+
+  // The usage of the second container is available even though the
+  // usage of the first container is still being collected.
+  process::UPID upid("monitor", process::address());
+
+  Future<Response> response = process::http::get(upid, "statistics.json");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+
+  Try<JSON::Array> parse = JSON::parse<JSON::Array>(response.get().body);
+  ASSERT_SOME(parse);
+  ASSERT_EQ(1u, parse.get().values.size());
+
+  Result<JSON::String> executorId =
+    parse.get().values.front().as<JSON::Object>()
+      .find<JSON::String>("executor_id");
+
+  ASSERT_SOME_EQ(JSON::String("executor2"), executorId);
+
+  // Once the timeout elapses the collection of the usage of the first
+  // container gets discarded.
+  process::Clock::advance(slave::MONITORING_USAGE_TIMEOUT);
+  process::Clock::settle();
+
+  EXPECT_TRUE(promise.future().hasDiscard());
+
+  monitor.stop(containerId1);
+  monitor.stop(containerId2);
+
+  process::Clock::settle();
+  process::Clock::resume();
+}
+
+
 TEST(MonitorTest, Statistics)
 {
   FrameworkID frameworkId;
@@ -221,13 +339,26 @@ TEST(MonitorTest, Statistics)
 
   process::UPID upid("monitor", process::address());
 
-  // Request the statistics, this will ask the isolator.
+  // Nothing has been collected yet.
   Future<Response> response = process::http::get(upid, "statistics.json");
 
-  AWAIT_READY(response);
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
+  AWAIT_EXPECT_RESPONSE_BODY_EQ("[]", response);
+
+  // Cause the collection to occur.
+  process::Clock::advance(slave::RESOURCE_MONITORING_INTERVAL);
+  process::Clock::settle();
+
+  AWAIT_READY(usage);
+
+  // Wait until the containerizer has finished returning the statistics.
+  process::Clock::settle();
 
-  // The collection should have occurred on the isolator.
-  ASSERT_TRUE(usage.isReady());
+  // Request the statistics, this returns what has been collected
+  // rather than asking the isolator again.
+  response = process::http::get(upid, "statistics.json");
+
+  AWAIT_READY(response);
 
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
   AWAIT_EXPECT_RESPONSE_HEADER_EQ(
@@ -286,10 +417,6 @@ TEST(MonitorTest, Statistics)
 
   response = process::http::get(upid, "statistics.json");
 
-  // Ensure the rate limiter acquires its permit.
-  process::Clock::advance(slave::RESOURCE_MONITORING_INTERVAL);
-  process::Clock::settle();
-
   AWAIT_EXPECT_RESPONSE_STATUS_EQ(OK().status, response);
   AWAIT_EXPECT_RESPONSE_HEADER_EQ(
       "application/json",
@@ -298,6 +425,165 @@ TEST(MonitorTest, Statistics)
   AWAIT_EXPECT_RESPONSE_BODY_EQ("[]", response);
 }
 
+
+class UsageHistoryTest : public TemporaryDirectoryTest {};
+
+
+TEST_F(UsageHistoryTest, RangeQuery)
+{
+  const string path = path::join(os::getcwd(), "monitor", "container");
+
+  Try<UsageHistory*> create = UsageHistory::create(path, 4);
+  ASSERT_SOME(create);
+
+  Owned<UsageHistory> history(create.get());
+
+  // Append more samples than the capacity, so that the oldest ones
+  // are overwritten. The memory usage is only known for every other
+  // sample.
+  for (int i = 1; i <= 6; i++) {
+    ResourceStatistics statistics;
+    statistics.set_timestamp(i);
+    statistics.set_cpus_user_time_secs(i);
+    if (i % 2 == 0) {
+      statistics.set_mem_rss_bytes(i * 1024);
+    }
+
+    ASSERT_SOME(history->append(statistics));
+  }
+
+  // Samples older than the newest one are rejected.
+  ResourceStatistics old;
+  old.set_timestamp(5);
+  EXPECT_ERROR(history->append(old));
+
+  EXPECT_EQ(4u, history->size());
+
+  vector<ResourceStatistics> samples = history->get();
+  ASSERT_EQ(4u, samples.size());
+  EXPECT_EQ(3, samples[0].timestamp());
+  EXPECT_EQ(6, samples[3].timestamp());
+  EXPECT_FALSE(samples[0].has_mem_rss_bytes());
+  EXPECT_EQ(4 * 1024u, samples[1].mem_rss_bytes());
+
+  samples = history->get(4.0, 5.0);
+  ASSERT_EQ(2u, samples.size());
+  EXPECT_EQ(4, samples[0].timestamp());
+  EXPECT_EQ(5, samples[1].timestamp());
+
+  // Downsample into intervals of 2 seconds, i.e., [2, 4), [4, 6) and
+  // [6, 8).
+  samples = history->get(None(), None(), Seconds(2), UsageHistory::AVERAGE);
+  ASSERT_EQ(3u, samples.size());
+  EXPECT_EQ(2, samples[0].timestamp());
+  EXPECT_EQ(3, samples[0].cpus_user_time_secs());
+  EXPECT_FALSE(samples[0].has_mem_rss_bytes());
+  EXPECT_EQ(4, samples[1].timestamp());
+  EXPECT_EQ(4.5, samples[1].cpus_user_time_secs());
+  EXPECT_EQ(4 * 1024u, samples[1].mem_rss_bytes());
+  EXPECT_EQ(6, samples[2].timestamp());
+  EXPECT_EQ(6, samples[2].cpus_user_time_secs());
+
+  samples = history->get(None(), None(), Seconds(2), UsageHistory::MAXIMUM);
+  ASSERT_EQ(3u, samples.size());
+  EXPECT_EQ(5, samples[1].cpus_user_time_secs());
+
+  // The history survives being reopened, both for appending and
+  // for reading only.
+  history.reset();
+
+  create = UsageHistory::create(path, 4);
+  ASSERT_SOME(create);
+  history.reset(create.get());
+  EXPECT_EQ(4u, history->size());
+
+  Try<UsageHistory*> open = UsageHistory::open(path);
+  ASSERT_SOME(open);
+
+  Owned<UsageHistory> reader(open.get());
+  samples = reader->get(5.0);
+  ASSERT_EQ(2u, samples.size());
+  EXPECT_EQ(5, samples[0].cpus_user_time_secs());
+
+  // A different capacity discards the history.
+  history.reset();
+
+  create = UsageHistory::create(path, 8);
+  ASSERT_SOME(create);
+  history.reset(create.get());
+  EXPECT_EQ(0u, history->size());
+}
+
+
+// The history is written through a shared mapping, so it needs to be
+// fully allocated up front: a write to a hole when the disk is full
+// would otherwise result in a SIGBUS.
+TEST_F(UsageHistoryTest, Allocated)
+{
+  const string path = path::join(os::getcwd(), "monitor", "container");
+
+  Try<UsageHistory*> create = UsageHistory::create(path, 1000);
+  ASSERT_SOME(create);
+
+  Owned<UsageHistory> history(create.get());
+
+  struct stat s;
+  ASSERT_EQ(0, ::stat(path.c_str(), &s));
+
+  // NOTE: 'st_blocks' is always in units of 512 bytes.
+  EXPECT_GE(s.st_blocks * 512, s.st_size);
+}
+
+
+// Only the usage histories of the recovered containers are kept, and
+// only the histories of the containers known to the monitor are
+// served.
+TEST_F(UsageHistoryTest, Recover)
+{
+  const string workDir = os::getcwd();
+
+  ContainerID recovered;
+  recovered.set_value("recovered");
+
+  ContainerID terminated;
+  terminated.set_value("terminated");
+
+  ASSERT_SOME(os::mkdir(slave::paths::getUsageHistoryDir(workDir)));
+  ASSERT_SOME(
+      os::touch(slave::paths::getUsageHistoryPath(workDir, recovered)));
+  ASSERT_SOME(
+      os::touch(slave::paths::getUsageHistoryPath(workDir, terminated)));
+
+  TestContainerizer containerizer;
+
+  slave::ResourceMonitor monitor(&containerizer, workDir, 8);
+
+  hashset<ContainerID> containerIds;
+  containerIds.insert(recovered);
+
+  AWAIT_READY(monitor.recover(containerIds));
+
+  EXPECT_TRUE(
+      os::exists(slave::paths::getUsageHistoryPath(workDir, recovered)));
+  EXPECT_FALSE(
+      os::exists(slave::paths::getUsageHistoryPath(workDir, terminated)));
+
+  process::UPID upid("monitor", process::address());
+
+  Future<Response> response =
+    process::http::get(upid, "history.json", "container_id=recovered");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(NotFound().status, response);
+
+  response = process::http::get(upid, "history.json", "container_id=../..");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(NotFound().status, response);
+
+  response = process::http::get(upid, "history.json");
+
+  AWAIT_EXPECT_RESPONSE_STATUS_EQ(BadRequest().status, response);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -83,6 +83,7 @@ using state::LogStorage;
 using state::Storage;
 
 using state::protobuf::State;
+using state::protobuf::Variable;
 
 // TODO(xujyan): This class copies code from LogStateTest. It would
 // be nice to find a common location for log related base tests when
@@ -348,6 +349,91 @@ TEST_P(RegistrarTest, bootstrap)
 }
 
 
+TEST_P(RegistrarTest, deltas)
+{
+  flags.registry_deltas = true;
+
+  SlaveID id;
+  id.set_value("2");
+
+  SlaveInfo info;
+  info.set_hostname("localhost");
+  info.mutable_id()->CopyFrom(id);
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(new AdmitSlave(slave))));
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(new AdmitSlave(info))));
+    AWAIT_EQ(true, registrar.apply(Owned<Operation>(new RemoveSlave(slave))));
+  }
+
+  // The operations should have been stored as deltas.
+  Future<std::set<string> > names = state->names();
+  AWAIT_READY(names);
+  EXPECT_LT(1u, names.get().size());
+
+  // A new registrar should recover the registry from the deltas.
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(1, registry.get().slaves().slaves().size());
+    EXPECT_EQ(info, registry.get().slaves().slaves(0).info());
+  }
+
+  // Without deltas the registry gets stored in its entirety upon
+  // recovery and the deltas get compacted (expunged).
+  flags.registry_deltas = false;
+
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(1, registry.get().slaves().slaves().size());
+    EXPECT_EQ(info, registry.get().slaves().slaves(0).info());
+  }
+
+  // Recovery completes only once the deltas have been expunged.
+  names = state->names();
+  AWAIT_READY(names);
+  ASSERT_EQ(1u, names.get().size());
+  EXPECT_EQ("registry", *names.get().begin());
+
+  Future<Variable<Registry> > registry = state->fetch<Registry>("registry");
+  AWAIT_READY(registry);
+
+  ASSERT_EQ(1, registry.get().get().slaves().slaves().size());
+  EXPECT_EQ(info, registry.get().get().slaves().slaves(0).info());
+
+  // A stale delta, e.g., one that failed to be expunged after it got
+  // compacted, must not be applied again since it would resurrect
+  // the removed slave.
+  Registry::Delta delta;
+  delta.add_admitted()->mutable_info()->CopyFrom(slave);
+
+  Future<Variable<Registry::Delta> > stale =
+    state->fetch<Registry::Delta>("registry_delta_0");
+  AWAIT_READY(stale);
+  AWAIT_READY(state->store(stale.get().mutate(delta)));
+
+  {
+    Registrar registrar(flags, state);
+
+    Future<Registry> registry = registrar.recover(master);
+    AWAIT_READY(registry);
+
+    ASSERT_EQ(1, registry.get().slaves().slaves().size());
+    EXPECT_EQ(info, registry.get().slaves().slaves(0).info());
+  }
+}
+
+
 class MockStorage : public Storage
 {
 public:
@@ -399,6 +485,9 @@ TEST_P(RegistrarTest, storeTimeout)
   EXPECT_CALL(storage, get(_))
     .WillOnce(Return(None()));
 
+  EXPECT_CALL(storage, names())
+    .WillOnce(Return(std::set<string>()));
+
   Future<Nothing> set;
   EXPECT_CALL(storage, set(_, _))
     .WillOnce(DoAll(FutureSatisfy(&set),
@@ -429,6 +518,9 @@ TEST_P(RegistrarTest, abort)
   EXPECT_CALL(storage, get(_))
     .WillOnce(Return(None()));
 
+  EXPECT_CALL(storage, names())
+    .WillOnce(Return(std::set<string>()));
+
   EXPECT_CALL(storage, set(_, _))
     .WillOnce(Return(Future<bool>(true)))              // Recovery.
     .WillOnce(Return(Future<bool>::failed("failure"))) // Failure.
@@ -528,6 +620,105 @@ TEST_P(Registrar_BENCHMARK_Test, performance)
   LOG(INFO) << "Removed " << slaveCount << " slaves in " << watch.elapsed();
 }
 
+
+class RegistrarFailover_BENCHMARK_Test
+  : public RegistrarTestBase,
+    public WithParamInterface<size_t>
+{
+protected:
+  // Simulates a master failover by replacing the log and the storage
+  // with new ones, optionally recovering from the checkpoint.
+  void failover(const Option<string>& checkpoint)
+  {
+    delete state;
+    delete storage;
+    delete log;
+
+    set<UPID> pids;
+    pids.insert(replica2->pid());
+
+    log = new Log(2, os::getcwd() + "/.log1", pids);
+    storage = new LogStorage(log, GetParam(), checkpoint);
+    state = new State(storage);
+  }
+};
+
+
+// The failover benchmark is parameterized by the number of diffs
+// between snapshots in the log.
+INSTANTIATE_TEST_CASE_P(
+    DiffsBetweenSnapshots,
+    RegistrarFailover_BENCHMARK_Test,
+    ::testing::Values(0U, 64U));
+
+
+TEST_P(RegistrarFailover_BENCHMARK_Test, failover)
+{
+  const int slaveCount = 100000;
+  const string checkpoint = path::join(os::getcwd(), "registry_checkpoint");
+
+  delete state;
+  delete storage;
+
+  storage = new LogStorage(log, GetParam(), checkpoint);
+  state = new State(storage);
+
+  {
+    Registrar registrar(flags, state);
+    AWAIT_READY(registrar.recover(master));
+
+    Attributes attributes = Attributes::parse("foo:bar;baz:quux");
+    Resources resources =
+      Resources::parse("cpus(*):1.0;mem(*):512;disk(*):2048").get();
+
+    // Admit the slaves in batches so that the registry gets written
+    // to the log many times (as it would over a master's lifetime).
+    Stopwatch watch;
+    watch.start();
+    Future<bool> result;
+    for (int i = 0; i < slaveCount; ++i) {
+      SlaveInfo info;
+      info.set_hostname("localhost");
+      info.mutable_id()->set_value(
+          std::string("201310101658-2280333834-5050-48574-") + stringify(i));
+      info.mutable_resources()->MergeFrom(resources);
+      info.mutable_attributes()->MergeFrom(attributes);
+
+      result = registrar.apply(Owned<Operation>(new AdmitSlave(info)));
+
+      if ((i + 1) % 1000 == 0) {
+        AWAIT_READY_FOR(result, Minutes(5));
+      }
+    }
+    AWAIT_READY_FOR(result, Minutes(5));
+    LOG(INFO) << "Admitted " << slaveCount << " slaves in " << watch.elapsed();
+  }
+
+  // Fail over to a storage that reads the entire log.
+  failover(None());
+
+  Stopwatch watch;
+  watch.start();
+  Future<Variable<Registry> > registry = state->fetch<Registry>("registry");
+  AWAIT_READY_FOR(registry, Minutes(5));
+  LOG(INFO) << "Recovered " << slaveCount << " slaves by reading the log in "
+            << watch.elapsed();
+
+  EXPECT_EQ(slaveCount, registry.get().get().slaves().slaves().size());
+
+  // Fail over to a storage that starts from the checkpoint.
+  ASSERT_TRUE(os::exists(checkpoint));
+  failover(checkpoint);
+
+  watch.start();
+  registry = state->fetch<Registry>("registry");
+  AWAIT_READY_FOR(registry, Minutes(5));
+  LOG(INFO) << "Recovered " << slaveCount << " slaves from a checkpoint in "
+            << watch.elapsed();
+
+  EXPECT_EQ(slaveCount, registry.get().get().slaves().slaves().size());
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
@@ -23,6 +23,7 @@
 
 #include <stout/bytes.hpp>
 #include <stout/gtest.hpp>
+#include <stout/stopwatch.hpp>
 
 #include "master/master.hpp"
 
@@ -34,6 +35,8 @@ using std::ostringstream;
 using std::pair;
 using std::string;
 
+using testing::WithParamInterface;
+
 namespace mesos {
 namespace internal {
 namespace tests {
@@ -979,6 +982,95 @@ TEST(ResourcesOperationTest, CreatePersistentVolume)
   EXPECT_ERROR(total.apply(create2));
 }
 
+
+class Resources_BENCHMARK_Test
+  : public ::testing::Test,
+    public WithParamInterface<string> {};
+
+
+// The resources benchmark tests are parameterized by the resources
+// of a slave, ranging from only scalars to fragmented ports and
+// statically reserved resources.
+INSTANTIATE_TEST_CASE_P(
+    SlaveResources,
+    Resources_BENCHMARK_Test,
+    ::testing::Values(
+        "cpus:24;mem:65536;disk:1048576",
+        "cpus:24;mem:65536;disk:1048576;ports:[31000-32000]",
+        "cpus:24;mem:65536;disk:1048576;"
+        "ports:[31000-31099,31200-31299,31400-31499,31600-31699,"
+        "31800-31899,32000-32099,32200-32299,32400-32499]",
+        "cpus:8;mem:16384;disk:524288;ports:[31000-32000];"
+        "cpus(role1):16;mem(role1):49152;disk(role1):524288"));
+
+
+// Measures the arithmetic that the allocator and the master perform
+// on the resources of each slave in an allocation cycle.
+TEST_P(Resources_BENCHMARK_Test, Arithmetic)
+{
+  const size_t iterations = 50000;
+
+  Try<Resources> parse = Resources::parse(GetParam());
+  ASSERT_SOME(parse);
+
+  const Resources total = parse.get();
+
+  // A task that takes a small slice of every scalar resource.
+  Resources task;
+  foreach (Resource resource, total) {
+    if (resource.type() == Value::SCALAR) {
+      resource.mutable_scalar()->set_value(resource.scalar().value() / 8);
+      task += resource;
+    }
+  }
+
+  Stopwatch watch;
+  watch.start();
+
+  Resources sum;
+  for (size_t i = 0; i < iterations; i++) {
+    sum += total;
+  }
+
+  LOG(INFO) << "Took " << watch.elapsed() << " to add " << iterations
+            << " times '" << total << "'";
+
+  watch.start();
+
+  for (size_t i = 0; i < iterations; i++) {
+    sum -= total;
+  }
+
+  LOG(INFO) << "Took " << watch.elapsed() << " to subtract " << iterations
+            << " times '" << total << "'";
+
+  EXPECT_TRUE(sum.empty());
+
+  watch.start();
+
+  Resources available = total;
+  for (size_t i = 0; i < iterations; i++) {
+    if (!available.contains(task)) {
+      available = total;
+    }
+    available -= task;
+  }
+
+  LOG(INFO) << "Took " << watch.elapsed() << " to check and subtract "
+            << iterations << " times '" << task << "'";
+
+  watch.start();
+
+  for (size_t i = 0; i < iterations; i++) {
+    available = total.unreserved() + total.reserved("role1");
+  }
+
+  LOG(INFO) << "Took " << watch.elapsed() << " to split by role "
+            << iterations << " times";
+
+  EXPECT_EQ(total, available);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
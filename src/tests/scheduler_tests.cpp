@@ -836,6 +836,283 @@ TEST_F(MesosSchedulerDriverTest, ExplicitAcknowledgements)
 }
 
 
+// Ensures that when the driver batches up acknowledgements, they are
+// sent to the master, and forwarded to the slave, in a single message.
+TEST_F(MesosSchedulerDriverTest, BatchedAcknowledgements)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  // The driver loads its flags from the environment when started.
+  os::setenv("MESOS_ACKNOWLEDGEMENT_BATCH_INTERVAL", "1secs");
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), false, DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 2, 1, 16, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  // Ensure that no acknowledgements are sent one at a time.
+  EXPECT_NO_FUTURE_PROTOBUFS(
+      StatusUpdateAcknowledgementMessage(), _ , master.get());
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.start();
+
+  os::unsetenv("MESOS_ACKNOWLEDGEMENT_BATCH_INTERVAL");
+
+  AWAIT_READY(status1);
+  AWAIT_READY(status2);
+
+  Future<StatusUpdateAcknowledgementsMessage> acknowledgements =
+    FUTURE_PROTOBUF(
+        StatusUpdateAcknowledgementsMessage(), _ , master.get());
+
+  Future<StatusUpdateAcknowledgementsMessage> forwarded =
+    FUTURE_PROTOBUF(
+        StatusUpdateAcknowledgementsMessage(), master.get(), slave.get());
+
+  Clock::pause();
+
+  driver.acknowledgeStatusUpdate(status1.get());
+  driver.acknowledgeStatusUpdate(status2.get());
+
+  // The acknowledgements are only sent once the batch interval
+  // elapses.
+  Clock::settle();
+  EXPECT_TRUE(acknowledgements.isPending());
+
+  Clock::advance(Seconds(1));
+
+  AWAIT_READY(acknowledgements);
+  EXPECT_EQ(2, acknowledgements.get().acknowledgements_size());
+
+  AWAIT_READY(forwarded);
+  EXPECT_EQ(2, forwarded.get().acknowledgements_size());
+
+  Clock::resume();
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// Ensures that the master splits a batch of acknowledgements into
+// single acknowledgements for a slave that didn't advertise that it
+// accepts batches when it registered.
+TEST_F(MesosSchedulerDriverTest, BatchedAcknowledgementsSplitForSlave)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  // Capture the registration of the slave (and drop its retries), so
+  // that it can be sent without 'acknowledgement_batches' below.
+  DROP_PROTOBUFS(RegisterSlaveMessage(), _, master.get());
+
+  Future<RegisterSlaveMessage> registerSlaveMessage =
+    DROP_PROTOBUF(RegisterSlaveMessage(), _, master.get());
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  AWAIT_READY(registerSlaveMessage);
+
+  RegisterSlaveMessage message = registerSlaveMessage.get();
+  message.clear_acknowledgement_batches();
+
+  Future<SlaveRegisteredMessage> slaveRegisteredMessage =
+    FUTURE_PROTOBUF(SlaveRegisteredMessage(), master.get(), _);
+
+  // Prevent this from being dropped per the DROP_PROTOBUFS above.
+  FUTURE_PROTOBUF(RegisterSlaveMessage(), slave.get(), master.get());
+
+  process::post(slave.get(), master.get(), message);
+
+  AWAIT_READY(slaveRegisteredMessage);
+
+  // The driver loads its flags from the environment when started.
+  os::setenv("MESOS_ACKNOWLEDGEMENT_BATCH_INTERVAL", "1secs");
+
+  MockScheduler sched;
+  MesosSchedulerDriver driver(
+      &sched, DEFAULT_FRAMEWORK_INFO, master.get(), false, DEFAULT_CREDENTIAL);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 2, 1, 16, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  // The master still accepts the batch, but doesn't forward it.
+  EXPECT_NO_FUTURE_PROTOBUFS(
+      StatusUpdateAcknowledgementsMessage(), master.get(), slave.get());
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.start();
+
+  os::unsetenv("MESOS_ACKNOWLEDGEMENT_BATCH_INTERVAL");
+
+  AWAIT_READY(status1);
+  AWAIT_READY(status2);
+
+  Future<StatusUpdateAcknowledgementsMessage> acknowledgements =
+    FUTURE_PROTOBUF(
+        StatusUpdateAcknowledgementsMessage(), _ , master.get());
+
+  Future<StatusUpdateAcknowledgementMessage> acknowledgement1 =
+    FUTURE_PROTOBUF(
+        StatusUpdateAcknowledgementMessage(), master.get(), slave.get());
+
+  Future<StatusUpdateAcknowledgementMessage> acknowledgement2 =
+    FUTURE_PROTOBUF(
+        StatusUpdateAcknowledgementMessage(), master.get(), slave.get());
+
+  Clock::pause();
+
+  driver.acknowledgeStatusUpdate(status1.get());
+  driver.acknowledgeStatusUpdate(status2.get());
+
+  Clock::advance(Seconds(1));
+
+  AWAIT_READY(acknowledgements);
+  EXPECT_EQ(2, acknowledgements.get().acknowledgements_size());
+
+  AWAIT_READY(acknowledgement1);
+  AWAIT_READY(acknowledgement2);
+
+  Clock::resume();
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
+// Ensures that the acknowledgements the driver batched up for a
+// master are dropped when a master is detected, since the new master
+// might not accept batches. The slave retries the status updates.
+TEST_F(MesosSchedulerDriverTest, BatchedAcknowledgementsMasterDetected)
+{
+  Try<PID<Master>> master = StartMaster();
+  ASSERT_SOME(master);
+
+  MockExecutor exec(DEFAULT_EXECUTOR_ID);
+  TestContainerizer containerizer(&exec);
+  Try<PID<Slave>> slave = StartSlave(&containerizer);
+  ASSERT_SOME(slave);
+
+  // The driver loads its flags from the environment when started.
+  os::setenv("MESOS_ACKNOWLEDGEMENT_BATCH_INTERVAL", "1secs");
+
+  MockScheduler sched;
+  StandaloneMasterDetector detector(master.get());
+  TestingMesosSchedulerDriver driver(
+      &sched, &detector, DEFAULT_FRAMEWORK_INFO, false);
+
+  EXPECT_CALL(sched, registered(&driver, _, _));
+
+  EXPECT_CALL(sched, resourceOffers(&driver, _))
+    .WillOnce(LaunchTasks(DEFAULT_EXECUTOR_INFO, 2, 1, 16, "*"))
+    .WillRepeatedly(Return()); // Ignore subsequent offers.
+
+  Future<TaskStatus> status1;
+  Future<TaskStatus> status2;
+  EXPECT_CALL(sched, statusUpdate(&driver, _))
+    .WillOnce(FutureArg<1>(&status1))
+    .WillOnce(FutureArg<1>(&status2));
+
+  EXPECT_CALL(exec, registered(_, _, _, _));
+
+  EXPECT_CALL(exec, launchTask(_, _))
+    .WillRepeatedly(SendStatusUpdateFromTask(TASK_RUNNING));
+
+  EXPECT_CALL(exec, shutdown(_))
+    .Times(AtMost(1));
+
+  driver.start();
+
+  os::unsetenv("MESOS_ACKNOWLEDGEMENT_BATCH_INTERVAL");
+
+  AWAIT_READY(status1);
+  AWAIT_READY(status2);
+
+  EXPECT_NO_FUTURE_PROTOBUFS(
+      StatusUpdateAcknowledgementsMessage(), _ , master.get());
+
+  EXPECT_NO_FUTURE_PROTOBUFS(
+      StatusUpdateAcknowledgementMessage(), _ , master.get());
+
+  Clock::pause();
+
+  driver.acknowledgeStatusUpdate(status1.get());
+  driver.acknowledgeStatusUpdate(status2.get());
+
+  Clock::settle();
+
+  EXPECT_CALL(sched, disconnected(&driver));
+
+  Future<Nothing> reregistered;
+  EXPECT_CALL(sched, reregistered(&driver, _))
+    .WillOnce(FutureSatisfy(&reregistered));
+
+  // Simulate a new master detected event to the driver.
+  detector.appoint(master.get());
+
+  AWAIT_READY(reregistered);
+
+  // Nothing is sent once the batch interval elapses.
+  Clock::advance(Seconds(1));
+  Clock::settle();
+
+  Clock::resume();
+
+  driver.stop();
+  driver.join();
+
+  Shutdown();
+}
+
+
 // This test ensures that when explicit acknowledgements are enabled,
 // acknowledgements for master-generated updates are dropped by the
 // driver. We test this by creating an invalid task that uses no
@@ -26,10 +26,12 @@
 
 #include <mesos/resources.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/gtest.hpp>
 
 #include "master/allocator/sorter/drf/sorter.hpp"
 
+using mesos::internal::master::allocator::Client;
 using mesos::internal::master::allocator::DRFSorter;
 
 using std::list;
@@ -231,6 +233,64 @@ TEST(SorterTest, Update)
   EXPECT_EQ(newAllocation.get(), sorter.allocation("a"));
 }
 
+
+// Iterating over the sorter should visit the clients in the same
+// order as returned by sort(), including after the total resources
+// have changed (which requires recalculating all the shares).
+TEST(SorterTest, Iterate)
+{
+  DRFSorter sorter;
+
+  sorter.add(Resources::parse("cpus:100;mem:100").get());
+
+  sorter.add("a");
+  sorter.allocated("a", Resources::parse("cpus:5;mem:1").get());
+
+  sorter.add("b");
+  sorter.allocated("b", Resources::parse("cpus:1;mem:4").get());
+
+  // shares: a = .05, b = .04
+  list<string> clients;
+  foreach (const Client& client, sorter) {
+    clients.push_back(client.name);
+  }
+
+  EXPECT_EQ(list<string>({"b", "a"}), clients);
+  EXPECT_EQ(sorter.sort(), clients);
+
+  sorter.add(Resources::parse("mem:100").get());
+
+  // shares: a = .05, b = .02
+  clients.clear();
+  foreach (const Client& client, sorter) {
+    clients.push_back(client.name);
+  }
+
+  EXPECT_EQ(list<string>({"b", "a"}), clients);
+
+  sorter.remove(Resources::parse("cpus:90").get());
+
+  // shares: a = .5, b = .1
+  clients.clear();
+  foreach (const Client& client, sorter) {
+    clients.push_back(client.name);
+  }
+
+  EXPECT_EQ(list<string>({"b", "a"}), clients);
+  EXPECT_EQ(sorter.sort(), clients);
+
+  sorter.allocated("b", Resources::parse("cpus:5").get());
+
+  // shares: a = .5, b = .6
+  clients.clear();
+  foreach (const Client& client, sorter) {
+    clients.push_back(client.name);
+  }
+
+  EXPECT_EQ(list<string>({"a", "b"}), clients);
+  EXPECT_EQ(sorter.sort(), clients);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {
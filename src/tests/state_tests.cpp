@@ -72,6 +72,7 @@ namespace mesos {
 namespace internal {
 namespace tests {
 
+using state::Checkpoint;
 using state::LevelDBStorage;
 using state::Operation;
 using state::Storage;
@@ -686,6 +687,75 @@ TEST_F(LogStateTest, Diff)
 }
 
 
+TEST_F(LogStateTest, Checkpoint)
+{
+  const string checkpoint = path::join(os::getcwd(), "checkpoint");
+
+  delete state;
+  delete storage;
+
+  storage = new state::LogStorage(log, 1024, checkpoint);
+  state = new State(storage);
+
+  Future<Variable<Slaves> > future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  Variable<Slaves> variable = future1.get();
+
+  Slaves slaves = variable.get();
+  slaves.add_slaves()->mutable_info()->set_hostname("localhost");
+
+  variable = variable.mutate(slaves);
+
+  Future<Option<Variable<Slaves> > > future2 = state->store(variable);
+  AWAIT_READY(future2);
+  ASSERT_SOME(future2.get());
+
+  // Destroying the storage writes the checkpoint.
+  delete state;
+  delete storage;
+
+  Result<Checkpoint> read = ::protobuf::read<Checkpoint>(checkpoint);
+  ASSERT_SOME(read);
+  ASSERT_EQ(1, read.get().snapshots_size());
+  EXPECT_EQ("slaves", read.get().snapshots(0).entry().name());
+
+  // Change the value in the checkpoint so we can tell whether or not
+  // the storage recovered from it rather than from the log.
+  Checkpoint modified = read.get();
+
+  slaves.mutable_slaves(0)->mutable_info()->set_hostname("checkpoint");
+  modified.mutable_snapshots(0)->mutable_entry()->set_value(
+      slaves.SerializeAsString());
+
+  ASSERT_SOME(::protobuf::write(checkpoint, modified));
+
+  storage = new state::LogStorage(log, 1024, checkpoint);
+  state = new State(storage);
+
+  future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  ASSERT_EQ(1, future1.get().get().slaves().size());
+  EXPECT_EQ("checkpoint", future1.get().get().slaves(0).info().hostname());
+
+  // Without the checkpoint the value is read from the log.
+  delete state;
+  delete storage;
+
+  ASSERT_SOME(os::rm(checkpoint));
+
+  storage = new state::LogStorage(log, 1024, checkpoint);
+  state = new State(storage);
+
+  future1 = state->fetch<Slaves>("slaves");
+  AWAIT_READY(future1);
+
+  ASSERT_EQ(1, future1.get().get().slaves().size());
+  EXPECT_EQ("localhost", future1.get().get().slaves(0).info().hostname());
+}
+
+
 #ifdef MESOS_HAS_JAVA
 class ZooKeeperStateTest : public tests::ZooKeeperTest
 {
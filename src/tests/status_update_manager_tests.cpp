@@ -30,18 +30,23 @@
 #include <process/gmock.hpp>
 #include <process/pid.hpp>
 
+#include <stout/foreach.hpp>
 #include <stout/none.hpp>
 #include <stout/os.hpp>
 #include <stout/protobuf.hpp>
 #include <stout/result.hpp>
+#include <stout/stringify.hpp>
 #include <stout/try.hpp>
 
+#include "common/protobuf_utils.hpp"
+
 #include "master/master.hpp"
 
 #include "slave/constants.hpp"
 #include "slave/paths.hpp"
 #include "slave/slave.hpp"
 #include "slave/state.hpp"
+#include "slave/status_update_manager.hpp"
 
 #include "messages/messages.hpp"
 
@@ -50,6 +55,8 @@
 using mesos::internal::master::Master;
 
 using mesos::internal::slave::Slave;
+using mesos::internal::slave::StatusUpdateCheckpointer;
+using mesos::internal::slave::StatusUpdateManager;
 
 using process::Clock;
 using process::Future;
@@ -846,6 +853,113 @@ TEST_F(StatusUpdateManagerTest, LatestTaskState)
   Shutdown();
 }
 
+
+// This test verifies that the checkpointer makes the records durable
+// in the order they get written, when they are written to multiple
+// files concurrently (and hence get batched up).
+TEST_F(StatusUpdateManagerTest, CheckpointerPreservesOrder)
+{
+  const size_t count = 1000;
+
+  const vector<string> paths = {"updates1", "updates2"};
+
+  vector<int> fds;
+  foreach (const string& path, paths) {
+    Try<int> fd = os::open(
+        path,
+        O_CREAT | O_WRONLY | O_APPEND | O_CLOEXEC,
+        S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+
+    ASSERT_SOME(fd);
+    fds.push_back(fd.get());
+  }
+
+  {
+    StatusUpdateCheckpointer checkpointer;
+
+    list<Future<Nothing> > futures;
+    for (size_t i = 0; i < count; i++) {
+      StatusUpdateRecord record;
+      record.set_type(StatusUpdateRecord::ACK);
+      record.set_uuid(stringify(i));
+
+      const size_t file = i % fds.size();
+      futures.push_back(checkpointer.write(fds[file], paths[file], record));
+    }
+
+    foreach (const Future<Nothing>& future, futures) {
+      AWAIT_READY(future);
+    }
+
+    for (size_t i = 0; i < fds.size(); i++) {
+      checkpointer.close(fds[i], paths[i]);
+    }
+
+    // Destroying the checkpointer waits for the files to be closed.
+  }
+
+  for (size_t i = 0; i < paths.size(); i++) {
+    Try<int> fd = os::open(paths[i], O_RDONLY | O_CLOEXEC);
+    ASSERT_SOME(fd);
+
+    for (size_t j = i; j < count; j += paths.size()) {
+      Result<StatusUpdateRecord> record =
+        ::protobuf::read<StatusUpdateRecord>(fd.get());
+
+      ASSERT_SOME(record);
+      EXPECT_EQ(stringify(j), record.get().uuid());
+    }
+
+    EXPECT_NONE(::protobuf::read<StatusUpdateRecord>(fd.get()));
+
+    os::close(fd.get());
+  }
+}
+
+
+// This test verifies that cleaning up a framework while one of its
+// status updates is still being checkpointed doesn't fail the update
+// (which the slave would treat as fatal).
+TEST_F(StatusUpdateManagerTest, CleanupWhileCheckpointing)
+{
+  slave::Flags flags = CreateSlaveFlags();
+
+  StatusUpdateManager manager(flags);
+  manager.initialize([](StatusUpdate) {});
+
+  SlaveID slaveId;
+  slaveId.set_value("slave");
+
+  FrameworkID frameworkId;
+  frameworkId.set_value("framework");
+
+  TaskID taskId;
+  taskId.set_value("task");
+
+  ContainerID containerId;
+  containerId.set_value("container");
+
+  StatusUpdate update = protobuf::createStatusUpdate(
+      frameworkId,
+      slaveId,
+      taskId,
+      TASK_RUNNING,
+      TaskStatus::SOURCE_EXECUTOR,
+      "",
+      None(),
+      DEFAULT_EXECUTOR_ID);
+
+  // The cleanup gets dispatched before the continuation that runs
+  // once the update is checkpointed, so the stream is always gone
+  // by the time the update would be forwarded.
+  Future<Nothing> future =
+    manager.update(update, slaveId, DEFAULT_EXECUTOR_ID, containerId);
+
+  manager.cleanup(frameworkId);
+
+  AWAIT_READY(future);
+}
+
 } // namespace tests {
 } // namespace internal {
 } // namespace mesos {